@@ -0,0 +1,174 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace bench
+  {
+    //! one line of the report, fields that don't apply to a suite are left at 0 / empty
+    struct result
+    {
+      std::string suite;
+      std::string hashType;
+      std::string implementation;
+      std::string input;               //!< buffer, stream, generator, ...
+      std::uint64_t size = 0;          //!< bytes hashed per operation (by all threads)
+      std::uint64_t blockSize = 0;     //!< hash::config::processingBlockSize
+      std::uint64_t chunkSize = 0;     //!< the size of the add_data calls
+      std::uint64_t threads = 0;
+      std::uint64_t iterations = 0;    //!< pbkdf2 iterations
+      std::uint64_t operations = 0;    //!< operations measured in total (all samples)
+      double nsPerOp = 0;              //!< median of the samples
+      double nsPerOpMin = 0;           //!< fastest sample
+      double megabytesPerSecond = 0;   //!< 10^6 bytes per second, from the median
+    };
+
+
+    //! how long and how often a case is measured
+    struct settings
+    {
+      std::chrono::milliseconds minSampleTime = std::chrono::milliseconds( 100 );
+      size_t numSamples = 3;
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! run op_ in samples of at least minSampleTime and fill the timing fields of result_
+    //! the number of operations per sample is calibrated by the first run, so fast operations are timed in
+    //! batches and slow ones once per sample
+    template < typename op_t >
+    void measure( const settings& settings_, result& result_, op_t op_ )
+    {
+      typedef std::chrono::steady_clock clock;
+
+      auto start = clock::now();
+      op_();
+      auto elapsed = std::chrono::duration< double >( clock::now() - start ).count();
+
+      auto minTime = std::chrono::duration< double >( settings_.minSampleTime ).count();
+      auto opsPerSample
+        = static_cast< std::uint64_t >( std::max( 1.0, minTime / std::max( elapsed, 1e-9 ) ) );
+
+      std::vector< double > samples;
+      for ( size_t i = 0; i < std::max( settings_.numSamples, size_t( 1 ) ); ++i )
+      {
+        start = clock::now();
+        for ( std::uint64_t n = 0; n < opsPerSample; ++n )
+          op_();
+        elapsed = std::chrono::duration< double >( clock::now() - start ).count();
+        samples.push_back( elapsed * 1e9 / opsPerSample );
+      }
+
+      std::sort( samples.begin(), samples.end() );
+      result_.operations = opsPerSample * samples.size();
+      result_.nsPerOp = samples[samples.size() / 2];
+      result_.nsPerOpMin = samples.front();
+      result_.megabytesPerSecond = result_.nsPerOp > 0 ? double( result_.size ) / result_.nsPerOp * 1e3 : 0;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! an input stream over a memory block, so the stream path is measured without a copy of the input
+    class memory_streambuf : public std::streambuf
+    {
+    public:
+      memory_streambuf( const std::uint8_t* pBuffer_, size_t sz_ )
+      {
+        auto p = reinterpret_cast< char* >( const_cast< std::uint8_t* >( pBuffer_ ) );
+        setg( p, p, p + sz_ );
+      }
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+    // report
+    // -------------------------------------------------------------------------------------------------------
+
+    inline std::string json_escape( const std::string& v_ )
+    {
+      std::string escaped;
+      for ( auto c : v_ )
+      {
+        if ( c == '"' || c == '\\' )
+          escaped += '\\';
+        escaped += c;
+      }
+      return escaped;
+    }
+
+    inline void write_csv( std::ostream& out_, const std::vector< result >& results_ )
+    {
+      out_ << std::fixed << std::setprecision( 1 );
+      out_ << "suite,hash_type,implementation,input,size,block_size,chunk_size,threads,iterations,operations,"
+              "ns_per_op,ns_per_op_min,mb_per_s\n";
+      for ( const auto& r : results_ )
+      {
+        out_ << r.suite << ',' << r.hashType << ',' << r.implementation << ',' << r.input << ',' << r.size
+             << ',' << r.blockSize << ',' << r.chunkSize << ',' << r.threads << ',' << r.iterations << ','
+             << r.operations << ',' << r.nsPerOp << ',' << r.nsPerOpMin << ',' << r.megabytesPerSecond
+             << '\n';
+      }
+    }
+
+    //! the results together with the environment they were measured in (key / value pairs)
+    inline void write_json( std::ostream& out_,
+                            const std::vector< std::pair< std::string, std::string > >& environment_,
+                            const std::vector< result >& results_ )
+    {
+      out_ << std::fixed << std::setprecision( 1 );
+      out_ << "{\n  \"environment\": {";
+      for ( size_t i = 0; i < environment_.size(); ++i )
+      {
+        out_ << ( i > 0 ? "," : "" ) << "\n    \"" << json_escape( environment_[i].first ) << "\": \""
+             << json_escape( environment_[i].second ) << '"';
+      }
+      out_ << "\n  },\n  \"results\": [";
+
+      for ( size_t i = 0; i < results_.size(); ++i )
+      {
+        const auto& r = results_[i];
+        out_ << ( i > 0 ? "," : "" ) << "\n    { \"suite\": \"" << r.suite << "\", \"hash_type\": \""
+             << r.hashType << "\", \"implementation\": \"" << r.implementation << "\", \"input\": \""
+             << r.input << "\", \"size\": " << r.size << ", \"block_size\": " << r.blockSize
+             << ", \"chunk_size\": " << r.chunkSize << ", \"threads\": " << r.threads
+             << ", \"iterations\": " << r.iterations << ", \"operations\": " << r.operations
+             << ", \"ns_per_op\": " << r.nsPerOp << ", \"ns_per_op_min\": " << r.nsPerOpMin
+             << ", \"mb_per_s\": " << r.megabytesPerSecond << " }";
+      }
+      out_ << "\n  ]\n}\n";
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,452 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <crypto/hash.h>
+#include <crypto/password.h>
+#include <crypto/version.h>
+
+#include "benchmark.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace bench
+  {
+    namespace
+    {
+      const std::vector< hash::type > kHashTypes = {
+        hash::type::md4,      hash::type::md5,      hash::type::sha1,     hash::type::sha256,
+        hash::type::sha384,   hash::type::sha512,   hash::type::blake3,   hash::type::sha3_256,
+        hash::type::sha3_512, hash::type::shake128, hash::type::shake256, hash::type::crc32c,
+        hash::type::xxh3_64,  hash::type::xxh3_128
+      };
+
+      //! the message sizes of the buffer and stream suites, from 16 bytes to 1 GiB (capped by --max-size)
+      const std::vector< std::uint64_t > kMessageSizes = {
+        16,          64,          256,         1 << 10,     4 << 10,     16 << 10,
+        64 << 10,    256 << 10,   1 << 20,     16 << 20,    256 << 20,   1 << 30
+      };
+
+      const char* const kSuites[] = { "buffer", "stream", "generator", "block_size", "threads", "pbkdf2" };
+
+
+      struct options
+      {
+        settings timing;
+        std::vector< std::string > suites;  //!< empty runs all suites
+        std::string format = "json";
+        std::string outputPath;             //!< empty writes to stdout
+        std::uint64_t maxSize = 64 << 20;
+        size_t maxThreads = std::max( std::thread::hardware_concurrency(), 1u );
+        bool calibrate = false;  //!< calibrate the automatic block size before measuring
+      };
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      void print_usage()
+      {
+        std::cerr << "usage: ll_crypto_bench [options]\n"
+                     "  --suite <name>      run only this suite (repeatable): buffer, stream, generator,\n"
+                     "                      block_size, threads, pbkdf2\n"
+                     "  --format json|csv   report format (default json)\n"
+                     "  --output <path>     write the report to a file instead of stdout\n"
+                     "  --max-size <n>      largest message in bytes with K / M / G suffixes, up to 1G\n"
+                     "                      (default 64M)\n"
+                     "  --min-time <ms>     minimum duration of a sample (default 100)\n"
+                     "  --samples <n>       samples per case, the median is reported (default 3)\n"
+                     "  --max-threads <n>   upper end of the thread scaling suite (default: all cores)\n"
+                     "  --calibrate         calibrate the automatic processing block size first\n";
+      }
+
+      std::uint64_t parse_size( const std::string& v_ )
+      {
+        std::size_t pos = 0;
+        auto value = std::stoull( v_, &pos );
+        auto suffix = v_.substr( pos );
+        if ( suffix == "K" || suffix == "k" )
+          return value << 10;
+        if ( suffix == "M" || suffix == "m" )
+          return value << 20;
+        if ( suffix == "G" || suffix == "g" )
+          return value << 30;
+        if ( !suffix.empty() )
+          throw std::invalid_argument( "invalid size: " + v_ );
+        return value;
+      }
+
+      bool parse_options( int argc_, char* argv_[], options& options_ )
+      {
+        for ( int i = 1; i < argc_; ++i )
+        {
+          std::string arg = argv_[i];
+          if ( arg == "--help" || arg == "-h" )
+            return false;
+          if ( arg == "--calibrate" )
+          {
+            options_.calibrate = true;
+            continue;
+          }
+          if ( i + 1 >= argc_ )
+          {
+            std::cerr << "missing value for " << arg << "\n";
+            return false;
+          }
+
+          std::string value = argv_[++i];
+          if ( arg == "--suite" )
+          {
+            if ( std::find( std::begin( kSuites ), std::end( kSuites ), value ) == std::end( kSuites ) )
+            {
+              std::cerr << "unknown suite: " << value << "\n";
+              return false;
+            }
+            options_.suites.push_back( value );
+          }
+          else if ( arg == "--format" && ( value == "json" || value == "csv" ) )
+            options_.format = value;
+          else if ( arg == "--output" )
+            options_.outputPath = value;
+          else if ( arg == "--max-size" )
+            options_.maxSize = std::max( parse_size( value ), std::uint64_t( 16 ) );
+          else if ( arg == "--min-time" )
+            options_.timing.minSampleTime = std::chrono::milliseconds( std::stoul( value ) );
+          else if ( arg == "--samples" )
+            options_.timing.numSamples = std::max( std::stoul( value ), 1ul );
+          else if ( arg == "--max-threads" )
+            options_.maxThreads = std::max( std::stoul( value ), 1ul );
+          else
+          {
+            std::cerr << "invalid option: " << arg << " " << value << "\n";
+            return false;
+          }
+        }
+        return true;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      class runner
+      {
+      public:
+        explicit runner( const options& options_ )
+          : m_options( options_ )
+          , m_input( static_cast< size_t >( options_.maxSize ) )
+        {
+          // incompressible input, so no kernel benefits from patterns
+          std::mt19937_64 rng( 42 );
+          for ( size_t i = 0; i + 8 <= m_input.size(); i += 8 )
+          {
+            auto v = rng();
+            std::memcpy( &m_input[i], &v, 8 );
+          }
+        }
+
+        bool enabled( const std::string& suite_ ) const
+        {
+          return m_options.suites.empty()
+                 || std::find( m_options.suites.begin(), m_options.suites.end(), suite_ )
+                      != m_options.suites.end();
+        }
+
+        const std::vector< result >& results() const { return m_results; }
+
+        // ---------------------------------------------------------------------------------------------------
+
+        //! get_hash of a memory buffer for every type and message size
+        void run_buffer()
+        {
+          for ( auto type : kHashTypes )
+          {
+            for ( auto sz : sizes( 16 ) )
+            {
+              auto r = make_result( "buffer", type, "buffer", sz );
+              run( r, [&]() { get_hash( m_input.data(), static_cast< size_t >( sz ), type ); } );
+            }
+          }
+        }
+
+        //! get_hash of a std::istream (read in processingBlockSize blocks) for every type and message size
+        void run_stream()
+        {
+          for ( auto type : kHashTypes )
+          {
+            for ( auto sz : sizes( 1 << 10 ) )
+            {
+              auto r = make_result( "stream", type, "stream", sz );
+              r.blockSize = get_processing_block_size( type, hash::source::stream );
+              run( r, [&]() {
+                memory_streambuf buffer( m_input.data(), static_cast< size_t >( sz ) );
+                std::istream stream( &buffer );
+                get_hash( stream, type );
+              } );
+            }
+          }
+        }
+
+        //! a hash_generator fed in chunks of different sizes
+        void run_generator()
+        {
+          const std::uint64_t chunkSizes[] = { 64, 4 << 10, 64 << 10, 1 << 20 };
+          auto sz = std::min( m_options.maxSize, std::uint64_t( 16 << 20 ) );
+
+          for ( auto type : kHashTypes )
+          {
+            hash_generator generator( type );
+            for ( auto chunkSize : chunkSizes )
+            {
+              auto r = make_result( "generator", type, "generator", sz );
+              r.chunkSize = chunkSize;
+              run( r, [&]() {
+                for ( std::uint64_t pos = 0; pos < sz; pos += chunkSize )
+                  generator.add_data( &m_input[static_cast< size_t >( pos )],
+                                      static_cast< size_t >( std::min( chunkSize, sz - pos ) ) );
+                generator.retrieve_digest();
+                generator.reset();
+              } );
+            }
+          }
+        }
+
+        //! the stream path with a sweep of processingBlockSize (starting with the automatic size), with and
+        //! without read-ahead
+        void run_block_size()
+        {
+          const hash::type types[]
+            = { hash::type::md5, hash::type::sha256, hash::type::blake3, hash::type::xxh3_64 };
+          const std::uint64_t blockSizes[] = {
+            hash::config::autoBlockSize, 4 << 10, 16 << 10, 64 << 10, 100000, 256 << 10, 1 << 20, 4 << 20
+          };
+          auto sz = std::min( m_options.maxSize, std::uint64_t( 64 << 20 ) );
+
+          for ( auto type : types )
+          {
+            for ( auto blockSize : blockSizes )
+            {
+              for ( size_t numReadAheadBuffers : { 0, 2 } )
+              {
+                hash::config cfg;
+                cfg.processingBlockSize = static_cast< size_t >( blockSize );
+                cfg.numReadAheadBuffers = numReadAheadBuffers;
+
+                auto isAuto = ( blockSize == hash::config::autoBlockSize );
+                auto input = numReadAheadBuffers ? ( isAuto ? "stream_read_ahead_auto" : "stream_read_ahead" )
+                                                 : ( isAuto ? "stream_auto" : "stream" );
+                auto r = make_result( "block_size", type, input, sz );
+                r.blockSize = get_processing_block_size( type, hash::source::stream, cfg );
+                run( r, [&]() {
+                  memory_streambuf buffer( m_input.data(), static_cast< size_t >( sz ) );
+                  std::istream stream( &buffer );
+                  get_hash( stream, type, cfg );
+                } );
+              }
+            }
+          }
+        }
+
+        //! independent get_hash calls on 1, 2, 4, ... threads (aggregate throughput) and blake3 hashing a
+        //! single buffer with 1, 2, 4, ... subtree threads
+        void run_threads()
+        {
+          const hash::type types[] = { hash::type::sha256, hash::type::blake3, hash::type::xxh3_64 };
+          auto sz = static_cast< size_t >( std::min( m_options.maxSize, std::uint64_t( 16 << 20 ) ) );
+
+          for ( auto type : types )
+          {
+            for ( size_t numThreads = 1; numThreads <= m_options.maxThreads; numThreads *= 2 )
+            {
+              auto r = make_result( "threads", type, "independent", sz * numThreads );
+              r.threads = numThreads;
+              run( r, [&]() {
+                std::vector< std::thread > threads;
+                for ( size_t i = 0; i < numThreads; ++i )
+                  threads.emplace_back( [&]() { get_hash( m_input.data(), sz, type ); } );
+                for ( auto& t : threads )
+                  t.join();
+              } );
+            }
+          }
+
+          auto szSubtrees = static_cast< size_t >( m_options.maxSize );
+          for ( size_t numThreads = 1; numThreads <= m_options.maxThreads; numThreads *= 2 )
+          {
+            auto r = make_result( "threads", hash::type::blake3, "subtrees", szSubtrees );
+            r.threads = numThreads;
+
+            hash::config cfg;
+            cfg.numHashThreads = numThreads;
+            run( r, [&]() { get_hash( m_input.data(), szSubtrees, hash::type::blake3, cfg ); } );
+          }
+        }
+
+        //! pbkdf2 latency for different iteration counts
+        void run_pbkdf2()
+        {
+          const hash::type types[] = { hash::type::sha1, hash::type::sha256, hash::type::sha512 };
+          const std::uint64_t iterationCounts[] = { 1000, 10000, 100000 };
+
+          for ( auto type : types )
+          {
+            for ( auto iterations : iterationCounts )
+            {
+              // pbkdf2 is computed by the platform library, not by the hash implementations of the library
+              auto r = make_result( "pbkdf2", type, "password", 0 );
+              r.implementation.clear();
+              r.iterations = iterations;
+
+              pbk::config cfg;
+              cfg.numIterations = static_cast< size_t >( iterations );
+              run( r, [&]() { pbkdf2( "correct horse battery staple", "0123456789abcdef", type, cfg ); } );
+            }
+          }
+        }
+
+      private:
+        std::vector< std::uint64_t > sizes( std::uint64_t min_ ) const
+        {
+          std::vector< std::uint64_t > result;
+          for ( auto sz : kMessageSizes )
+            if ( sz >= min_ && sz <= m_options.maxSize )
+              result.push_back( sz );
+          return result;
+        }
+
+        result make_result( const char* suite_,
+                            hash::type type_,
+                            const char* input_,
+                            std::uint64_t sz_ ) const
+        {
+          result r;
+          r.suite = suite_;
+          r.hashType = to_string( type_ );
+          r.implementation = get_implementation( type_ );
+          r.input = input_;
+          r.size = sz_;
+          r.threads = 1;
+          return r;
+        }
+
+        template < typename op_t >
+        void run( result& result_, op_t op_ )
+        {
+          std::cerr << result_.suite << " " << result_.hashType << " " << result_.input << " "
+                    << result_.size;
+          measure( m_options.timing, result_, op_ );
+          std::cerr << ": " << result_.nsPerOp << " ns/op\n";
+          m_results.push_back( result_ );
+        }
+
+        const options& m_options;
+        std::vector< std::uint8_t > m_input;
+        std::vector< result > m_results;
+      };
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      std::vector< std::pair< std::string, std::string > > environment( const options& options_ )
+      {
+        std::vector< std::pair< std::string, std::string > > env;
+
+        std::ostringstream version;
+        version << libraryVersionMajor << "." << libraryVersionMinor << "." << libraryVersionMicro;
+        env.emplace_back( "library_version", version.str() );
+        env.emplace_back( "hardware_concurrency", std::to_string( std::thread::hardware_concurrency() ) );
+        env.emplace_back( "min_sample_time_ms", std::to_string( options_.timing.minSampleTime.count() ) );
+        env.emplace_back( "calibrated", options_.calibrate ? "true" : "false" );
+        env.emplace_back( "samples", std::to_string( options_.timing.numSamples ) );
+        for ( auto type : kHashTypes )
+          env.emplace_back( "implementation." + to_string( type ), get_implementation( type ) );
+        return env;
+      }
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
+
+
+// -----------------------------------------------------------------------------------------------------------
+
+int main( int argc, char* argv[] )
+{
+  using namespace ll::crypto::bench;
+
+  options opts;
+  try
+  {
+    if ( !parse_options( argc, argv, opts ) )
+    {
+      print_usage();
+      return 1;
+    }
+  }
+  catch ( const std::exception& e )
+  {
+    std::cerr << e.what() << "\n";
+    print_usage();
+    return 1;
+  }
+
+  if ( opts.calibrate )
+    ll::crypto::calibrate_processing_block_size();
+
+  runner r( opts );
+  if ( r.enabled( "buffer" ) )
+    r.run_buffer();
+  if ( r.enabled( "stream" ) )
+    r.run_stream();
+  if ( r.enabled( "generator" ) )
+    r.run_generator();
+  if ( r.enabled( "block_size" ) )
+    r.run_block_size();
+  if ( r.enabled( "threads" ) )
+    r.run_threads();
+  if ( r.enabled( "pbkdf2" ) )
+    r.run_pbkdf2();
+
+  std::ofstream file;
+  if ( !opts.outputPath.empty() )
+  {
+    file.open( opts.outputPath, std::ios::out | std::ios::trunc );
+    if ( !file )
+    {
+      std::cerr << "can't write " << opts.outputPath << "\n";
+      return 1;
+    }
+  }
+  std::ostream& out = opts.outputPath.empty() ? std::cout : file;
+
+  if ( opts.format == "csv" )
+    write_csv( out, r.results() );
+  else
+    write_json( out, environment( opts ), r.results() );
+
+  return 0;
+}
@@ -0,0 +1,50 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! the settings of the platform library the library delegates to (OpenSSL >= 3 only at the moment)
+  struct backend_config
+  {
+    //! the providers loaded into a library context of its own, e.g. { "fips" } or { "default", "legacy" }
+    //! empty uses the default library context of the process
+    std::vector< std::string > providers;
+
+    //! the property query the algorithms are fetched with, e.g. "fips=yes" or "provider=default"
+    std::string properties;
+  };
+
+  //! select the providers and properties the algorithms are fetched with, before the first md4 / md5 /
+  //! pbkdf2 call (the algorithms are fetched once per process, so this throws error::invalid_request
+  //! afterwards). Throws error::invalid_parameter if a provider can't be loaded, and error::invalid_request
+  //! for a non-empty config on platforms without providers
+  //! without a call, the default library context is used (md4 comes from the legacy provider, which the
+  //! library loads into a library context of its own)
+  void init_backend( const backend_config& cfg_ );
+
+}  // namespace crypto
+}  // namespace ll
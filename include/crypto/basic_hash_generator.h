@@ -0,0 +1,390 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../support/environment.h"
+
+#include "crypto/hash.h"
+#include "crypto/exception.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace detail
+  {
+    //! the platform specific implementation of a hash type, operating on the context storage provided by
+    //! basic_hash_generator (the storage size is checked against the native context in the backend)
+    //! copy initializes the (uninitialized) target storage with the state of an in-flight source context
+    //! export_state writes the portable native state (at most maxNativeStateSize bytes) and returns its size,
+    //! import_state restores it into an initialized context
+    template < hash::type type_ >
+    struct hash_backend;
+
+// BCrypt keeps the hash object in caller provided memory, but its size is only known at runtime
+#if LL_IS_WINDOWS()
+#define LL_NATIVE_CONTEXT_SIZE( size_ ) 1024
+#else
+#define LL_NATIVE_CONTEXT_SIZE( size_ ) size_
+#endif
+
+#define LL_DECLARE_HASH_BACKEND( type_, digestSize_, blockSize_, contextSize_ )              \
+  template <>                                                                              \
+  struct hash_backend< type_ >                                                             \
+  {                                                                                        \
+    static LL_CONSTEXPR size_t digestSize = digestSize_;                                   \
+    static LL_CONSTEXPR size_t blockSize = blockSize_;                                     \
+    static LL_CONSTEXPR size_t contextSize = contextSize_;                                 \
+                                                                                           \
+    static void init( void* pContext_ );                                                   \
+    static void update( void* pContext_, const std::uint8_t* pBuffer_, size_t sz_ );       \
+    static void final( void* pContext_, std::uint8_t* pDigest_ );                          \
+    static void copy( void* pTarget_, const void* pSource_ );                              \
+    static size_t export_state( const void* pContext_, std::uint8_t* pState_ );            \
+    static void import_state( void* pContext_,                                             \
+                              const std::uint8_t* pState_,                                 \
+                              size_t sz_,                                                  \
+                              std::uint64_t inputSize_ );                                  \
+    static void destroy( void* pContext_ ) LL_NOEXCEPT;                                    \
+  };
+
+    LL_DECLARE_HASH_BACKEND( hash::type::md4, 16, 64, LL_NATIVE_CONTEXT_SIZE( 128 ) )
+    LL_DECLARE_HASH_BACKEND( hash::type::md5, 16, 64, LL_NATIVE_CONTEXT_SIZE( 128 ) )
+
+    // implemented in the library on all platforms, the compression function is selected per cpu
+    LL_DECLARE_HASH_BACKEND( hash::type::sha1, 20, 64, 104 )
+    LL_DECLARE_HASH_BACKEND( hash::type::sha256, 32, 64, 104 )
+    LL_DECLARE_HASH_BACKEND( hash::type::sha384, 48, 128, 200 )
+    LL_DECLARE_HASH_BACKEND( hash::type::sha512, 64, 128, 200 )
+
+    // implemented in the library on all platforms (the context is mostly the chaining value stack)
+    LL_DECLARE_HASH_BACKEND( hash::type::blake3, 32, 64, 1920 )
+
+    // keccak sponges (in the library on all platforms), the block size is the rate
+    LL_DECLARE_HASH_BACKEND( hash::type::sha3_256, 32, 136, 208 )
+    LL_DECLARE_HASH_BACKEND( hash::type::sha3_512, 64, 72, 208 )
+    LL_DECLARE_HASH_BACKEND( hash::type::shake128, 32, 168, 208 )
+    LL_DECLARE_HASH_BACKEND( hash::type::shake256, 64, 136, 208 )
+
+    // checksums (in the library on all platforms), the block size is the natural input granularity
+    LL_DECLARE_HASH_BACKEND( hash::type::crc32c, 4, 8, 8 )
+    LL_DECLARE_HASH_BACKEND( hash::type::xxh3_64, 8, 64, 336 )
+    LL_DECLARE_HASH_BACKEND( hash::type::xxh3_128, 16, 64, 336 )
+
+#undef LL_DECLARE_HASH_BACKEND
+#undef LL_NATIVE_CONTEXT_SIZE
+
+
+    //! extendable-output functions can be finalized with an arbitrary output size
+    template < hash::type type_ >
+    struct xof_backend
+    {
+      static LL_CONSTEXPR bool isXof = false;
+    };
+
+#define LL_DECLARE_XOF_BACKEND( type_ )                                          \
+  template <>                                                                    \
+  struct xof_backend< type_ >                                                    \
+  {                                                                              \
+    static LL_CONSTEXPR bool isXof = true;                                       \
+                                                                                 \
+    static void final( void* pContext_, std::uint8_t* pOutput_, size_t sz_ );    \
+  };
+
+    LL_DECLARE_XOF_BACKEND( hash::type::shake128 )
+    LL_DECLARE_XOF_BACKEND( hash::type::shake256 )
+
+#undef LL_DECLARE_XOF_BACKEND
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! lowercase hex representation of a binary digest
+    std::string to_hex_string( const std::vector< std::uint8_t >& binary_ );
+
+    //! the native state is the chaining value plus the buffered bytes of an incomplete block
+    //! (for blake3 the chunk state plus the chaining value stack of the tree)
+    const size_t maxNativeStateSize = 2048;
+
+    //! wrap the native state of a generator into the versioned state format
+    std::vector< std::uint8_t > encode_state( hash::type type_,
+                                              std::uint64_t inputSize_,
+                                              const std::uint8_t* pNativeState_,
+                                              size_t sz_ );
+
+    //! validate a state and locate the native state in it, throws if the state doesn't belong to type_
+    void decode_state( hash::type type_,
+                       const void* pState_,
+                       size_t sz_,
+                       std::uint64_t& inputSize_,
+                       const std::uint8_t*& pNativeState_,
+                       size_t& nativeStateSize_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! hash generator for a hash type known at compile time
+  //! the digest context is held inline and the native functions are called directly, so constructing and
+  //! feeding the generator doesn't allocate (only the convenience retrieve_hash does)
+  template < hash::type type_ >
+  class basic_hash_generator
+  {
+    typedef detail::hash_backend< type_ > backend_t;
+
+  public:
+    static LL_CONSTEXPR hash::type hashType = type_;
+    static LL_CONSTEXPR size_t digestSize = backend_t::digestSize;  //!< size of the binary digest in bytes
+    static LL_CONSTEXPR size_t blockSize = backend_t::blockSize;    //!< size of a compression block in bytes
+
+    //! extendable-output types (shake) can be finalized with an arbitrary output size
+    static LL_CONSTEXPR bool isXof = detail::xof_backend< type_ >::isXof;
+
+    basic_hash_generator() { backend_t::init( &m_context ); }
+    ~basic_hash_generator() { backend_t::destroy( &m_context ); }
+
+    //! duplicate the in-flight state (e.g. after a common prefix), both generators continue independently
+    //! the native context may refer to its own address, so it is copied by the backend
+    basic_hash_generator( const basic_hash_generator& other_ )
+      : m_inputSize( other_.m_inputSize )
+      , m_finalized( other_.m_finalized )
+    {
+      copy_context( other_ );
+    }
+
+    basic_hash_generator& operator=( const basic_hash_generator& other_ )
+    {
+      if ( this != &other_ )
+      {
+        backend_t::destroy( &m_context );
+        m_finalized = true;  // stays finalized if the copy throws
+        copy_context( other_ );
+        m_inputSize = other_.m_inputSize;
+        m_finalized = other_.m_finalized;
+      }
+      return *this;
+    }
+
+    void add_data( const std::uint8_t* pBuffer_, size_t sz_ )
+    {
+      if ( m_finalized )
+        throw exception( error::invalid_request );
+
+      backend_t::update( &m_context, pBuffer_, sz_ );
+      m_inputSize += sz_;
+    }
+
+    //! add a message held in non-contiguous segments (e.g. an array of struct iovec cast to buffer_ref)
+    //! segments smaller than a block are coalesced into full blocks before they are passed on, so chains of
+    //! small fragments don't cost a backend call each
+    void add_segments( const buffer_ref* pSegments_, size_t numSegments_ )
+    {
+      if ( m_finalized )
+        throw exception( error::invalid_request );
+
+      std::uint8_t pending[coalesceSize];
+      size_t numPending = 0;
+
+      for ( size_t i = 0; i < numSegments_; ++i )
+      {
+        auto pData = static_cast< const std::uint8_t* >( pSegments_[i].pBuffer );
+        auto sz = pSegments_[i].szBufferInBytes;
+        if ( sz == 0 )
+          continue;
+
+        if ( sz < blockSize )
+        {
+          if ( numPending + sz > coalesceSize )
+            flush( pending, numPending );
+          std::memcpy( pending + numPending, pData, sz );
+          numPending += sz;
+          continue;
+        }
+
+        // complete the block the pending bytes started, so the segment is passed on block aligned
+        if ( numPending > 0 )
+        {
+          auto fill = ( blockSize - ( m_inputSize + numPending ) % blockSize ) % blockSize;
+          if ( numPending + fill <= coalesceSize )
+          {
+            std::memcpy( pending + numPending, pData, fill );
+            numPending += fill;
+            pData += fill;
+            sz -= fill;
+          }
+          flush( pending, numPending );
+        }
+
+        backend_t::update( &m_context, pData, sz );
+        m_inputSize += sz;
+      }
+
+      flush( pending, numPending );
+    }
+
+    //! write the binary digest (digestSize bytes) to pDigest_, the generator is finalized afterwards
+    void retrieve_digest( std::uint8_t* pDigest_ )
+    {
+      if ( m_finalized )
+        throw exception( error::invalid_request );
+
+      m_finalized = true;
+      backend_t::final( &m_context, pDigest_ );
+    }
+
+    //! the digest as a fixed-size value, the generator is finalized afterwards
+    digest retrieve_digest()
+    {
+      static_assert( digestSize <= digest::maxSize, "digest type too small for this hash type" );
+
+      digest d;
+      d.hashType = type_;
+      d.size = static_cast< std::uint8_t >( digestSize );
+      retrieve_digest( d.bytes.data() );
+      return d;
+    }
+
+    hash retrieve_hash()
+    {
+      hash h;
+      h.hashType = type_;
+      h.inputSize = m_inputSize;
+      h.binary.resize( digestSize );
+      retrieve_digest( h.binary.data() );
+      h.string = detail::to_hex_string( h.binary );
+      return h;
+    }
+
+    //! extendable-output types only: write sz_ bytes of output to pOutput_, the generator is finalized
+    //! afterwards
+    void retrieve_output( std::uint8_t* pOutput_, size_t sz_ )
+    {
+      static_assert( isXof, "only extendable-output hash types support a variable output size" );
+
+      if ( m_finalized )
+        throw exception( error::invalid_request );
+
+      m_finalized = true;
+      detail::xof_backend< type_ >::final( &m_context, pOutput_, sz_ );
+    }
+
+    //! extendable-output types only: the hash with outputSize_ bytes of output
+    hash retrieve_hash( size_t outputSize_ )
+    {
+      hash h;
+      h.hashType = type_;
+      h.inputSize = m_inputSize;
+      h.binary.resize( outputSize_ );
+      retrieve_output( h.binary.data(), outputSize_ );
+      h.string = detail::to_hex_string( h.binary );
+      return h;
+    }
+
+    //! reinitialize the context in place, so the generator can be used for the next message
+    void reset()
+    {
+      backend_t::destroy( &m_context );
+      m_finalized = true;  // stays finalized if init throws
+      backend_t::init( &m_context );
+      m_finalized = false;
+      m_inputSize = 0;
+    }
+
+    //! the number of bytes added so far
+    std::uint64_t input_size() const LL_NOEXCEPT { return m_inputSize; }
+
+    //! serialize the in-flight state (see hash_generator::export_state for the format)
+    std::vector< std::uint8_t > export_state() const
+    {
+      if ( m_finalized )
+        throw exception( error::invalid_request );
+
+      std::uint8_t nativeState[detail::maxNativeStateSize];
+      auto sz = backend_t::export_state( &m_context, nativeState );
+      return detail::encode_state( type_, m_inputSize, nativeState, sz );
+    }
+
+    //! continue from a state exported by a generator of the same type
+    void import_state( const void* pState_, size_t sz_ )
+    {
+      std::uint64_t inputSize = 0;
+      const std::uint8_t* pNativeState = nullptr;
+      size_t nativeStateSize = 0;
+      detail::decode_state( type_, pState_, sz_, inputSize, pNativeState, nativeStateSize );
+
+      reset();
+      m_finalized = true;  // stays finalized if the import throws
+      backend_t::import_state( &m_context, pNativeState, nativeStateSize, inputSize );
+      m_finalized = false;
+      m_inputSize = inputSize;
+    }
+
+  private:
+    //! the coalescing buffer of add_segments, whole blocks of about 1K
+    static LL_CONSTEXPR size_t coalesceSize = ( blockSize < 1024 ) ? 1024 / blockSize * blockSize : blockSize;
+
+    void flush( const std::uint8_t* pPending_, size_t& numPending_ )
+    {
+      if ( numPending_ == 0 )
+        return;
+
+      backend_t::update( &m_context, pPending_, numPending_ );
+      m_inputSize += numPending_;
+      numPending_ = 0;
+    }
+
+    void copy_context( const basic_hash_generator& other_ )
+    {
+      // the state of a finalized context is meaningless (and can't be duplicated by every backend)
+      if ( other_.m_finalized )
+        backend_t::init( &m_context );
+      else
+        backend_t::copy( &m_context, &other_.m_context );
+    }
+
+    typename std::aligned_storage< backend_t::contextSize, 16 >::type m_context;
+    std::uint64_t m_inputSize = 0;
+    bool m_finalized = false;
+  };
+
+
+  template < hash::type type_ >
+  LL_CONSTEXPR hash::type basic_hash_generator< type_ >::hashType;
+
+  template < hash::type type_ >
+  LL_CONSTEXPR size_t basic_hash_generator< type_ >::digestSize;
+
+  template < hash::type type_ >
+  LL_CONSTEXPR size_t basic_hash_generator< type_ >::blockSize;
+
+  template < hash::type type_ >
+  LL_CONSTEXPR bool basic_hash_generator< type_ >::isXof;
+
+  template < hash::type type_ >
+  LL_CONSTEXPR size_t basic_hash_generator< type_ >::coalesceSize;
+
+}  // namespace crypto
+}  // namespace ll
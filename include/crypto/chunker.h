@@ -0,0 +1,118 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  // Content-defined chunking (FastCDC) splits the input at positions determined by the content itself, so an
+  // insertion or deletion only changes the chunks around it and identical content in different inputs yields
+  // identical chunks (and digests):
+  //
+  //  - the first minSize bytes of a chunk are skipped, then a gear rolling hash is updated for every byte:
+  //    fp = ( fp << 1 ) + gear[byte]
+  //  - a chunk ends after the first byte for which the masked fingerprint is zero, the mask has
+  //    log2( avgSize ) + 2 bits below avgSize and log2( avgSize ) - 2 bits above (normalized chunking),
+  //    the mask bits are the topmost bits of the fingerprint
+  //  - a chunk ends after maxSize bytes at the latest
+  //
+  // The gear table is generated from a fixed seed, so the boundaries are stable across platforms and
+  // versions, and the boundaries of a given configuration don't depend on how the input is fed.
+
+  struct chunker_config
+  {
+    size_t minSize = 2 * 1024;   //!< minimum chunk size in bytes (except for the last chunk)
+    size_t avgSize = 8 * 1024;   //!< targeted average chunk size in bytes (rounded down to a power of 2)
+    size_t maxSize = 64 * 1024;  //!< maximum chunk size in bytes
+
+    hash::type hashType = hash::type::sha256;  //!< the digest of every chunk
+
+    //! number of threads hashing the chunks while the boundaries of the next ones are detected,
+    //! 0 hashes every chunk on the calling thread right after its boundary was found (buffer input only)
+    size_t numHashThreads = 0;
+
+    //! the configuration for reading streams and files (block size and read-ahead)
+    hash::config streamConfig;
+  };
+
+
+  struct chunk
+  {
+    std::uint64_t offset = 0;  //!< the position of the chunk in the input
+    std::uint64_t size = 0;    //!< the size of the chunk in bytes
+    digest chunkDigest;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! chunks input that is fed block by block and reports every chunk as soon as it is complete
+  class content_chunker
+  {
+  public:
+    typedef std::function< void( const chunk& ) > chunk_handler;
+
+    content_chunker( const chunker_config& cfg_, chunk_handler onChunk_ );
+    ~content_chunker();
+
+    content_chunker( content_chunker&& other_ );
+    content_chunker& operator=( content_chunker&& other_ );
+
+    content_chunker( const content_chunker& other_ ) = delete;
+    content_chunker& operator=( const content_chunker& other_ ) = delete;
+
+    void add_data( const std::uint8_t* pBuffer_, size_t sz_ );
+
+    //! report the remaining chunks at the end of the input
+    void finish();
+
+  private:
+    class impl;
+
+    std::unique_ptr< impl > m_pImpl;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! get the chunks of a binary buffer
+  std::vector< chunk > get_chunks( const void* pBuffer_,
+                                   size_t szBufferInBytes_,
+                                   const chunker_config& cfg_ = chunker_config() );
+
+  //! get the chunks of the data from a stream (from the current position to end)
+  std::vector< chunk > get_chunks( std::istream& stream_, const chunker_config& cfg_ = chunker_config() );
+
+  //! get the chunks of a file
+  std::vector< chunk > get_file_chunks( const std::string& path_,
+                                        const chunker_config& cfg_ = chunker_config() );
+
+}  // namespace crypto
+}  // namespace ll
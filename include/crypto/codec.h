@@ -0,0 +1,100 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  // Hex and base64 (RFC 4648) codecs for digests and other binary data. All functions work on caller-provided
+  // buffers and don't allocate, the output is not null-terminated. Invalid input yields an exception with
+  // error::invalid_parameter. SSSE3 / AVX2 kernels are selected at runtime where the cpu supports them.
+
+  enum class base64_alphabet
+  {
+    standard,  //!< '+' and '/', padded with '='
+    url        //!< '-' and '_', not padded
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the number of characters hex_encode writes for szIn_ bytes
+  inline size_t hex_encoded_size( size_t szIn_ ) LL_NOEXCEPT { return 2 * szIn_; }
+
+  //! write the (lowercase) hex representation of szIn_ bytes to pOut_
+  void hex_encode( const void* pIn_, size_t szIn_, char* pOut_ );
+
+  //! decode szIn_ hex characters (upper- or lowercase) to pOut_, returns the number of bytes written
+  size_t hex_decode( const char* pIn_, size_t szIn_, void* pOut_ );
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the number of characters base64_encode writes for szIn_ bytes
+  size_t base64_encoded_size( size_t szIn_,
+                              base64_alphabet alphabet_ = base64_alphabet::standard ) LL_NOEXCEPT;
+
+  //! the maximum number of bytes base64_decode writes for szIn_ characters
+  inline size_t base64_max_decoded_size( size_t szIn_ ) LL_NOEXCEPT { return ( ( szIn_ + 3 ) / 4 ) * 3; }
+
+  //! write the base64 representation of szIn_ bytes to pOut_, returns the number of characters written
+  size_t base64_encode( const void* pIn_,
+                        size_t szIn_,
+                        char* pOut_,
+                        base64_alphabet alphabet_ = base64_alphabet::standard );
+
+  //! decode szIn_ base64 characters to pOut_, returns the number of bytes written
+  //! the padding is optional for both alphabets, but has to be correct if present
+  size_t base64_decode( const char* pIn_,
+                        size_t szIn_,
+                        void* pOut_,
+                        base64_alphabet alphabet_ = base64_alphabet::standard );
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // bulk variants: digest i is encoded to / decoded from pOut_ + i * stride_ resp. pIn_ + i * stride_
+  // the stride has to be at least the encoded size, the characters in between are neither written nor read
+  // (e.g. for fixed-width manifest records)
+  // ---------------------------------------------------------------------------------------------------------
+
+  void hex_encode( const digest* pDigests_, size_t numDigests_, char* pOut_, size_t stride_ );
+
+  void hex_decode( const char* pIn_, size_t stride_, size_t numDigests_, hash::type type_, digest* pOut_ );
+
+  void base64_encode( const digest* pDigests_,
+                      size_t numDigests_,
+                      char* pOut_,
+                      size_t stride_,
+                      base64_alphabet alphabet_ = base64_alphabet::standard );
+
+  void base64_decode( const char* pIn_,
+                      size_t stride_,
+                      size_t numDigests_,
+                      hash::type type_,
+                      digest* pOut_,
+                      base64_alphabet alphabet_ = base64_alphabet::standard );
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,141 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  // A digest cache lets file hashing skip files that haven't changed since they were hashed last. The entries
+  // are keyed by the identity of the file (device, inode, size, modification time in ns) and the hash type,
+  // any change of the identity invalidates the entry. To be safe against modifications that don't change
+  // the identity, a digest is only stored if
+  //
+  //  - the identity of the file is the same before and after hashing and
+  //  - the file was last modified at least kRacyIntervalNs before hashing started, so a later modification
+  //    within the timestamp granularity of the file system can't keep the modification time.
+  //
+  // Empty and non-regular files (pipes, procfs, ...) are never cached. Use hash::config::digestCache to
+  // enable the cache for get_file_hash (and directory hashing), and verifyCachedDigests to hash anyway and
+  // detect content changes that kept the identity (e.g. silent corruption).
+
+  struct file_identity
+  {
+    std::uint64_t device = 0;
+    std::uint64_t inode = 0;  //!< the file index on windows
+    std::uint64_t size = 0;
+    std::int64_t modificationTimeNs = 0;  //!< since the unix epoch
+  };
+
+  inline bool operator==( const file_identity& lhs_, const file_identity& rhs_ )
+  {
+    return ( lhs_.device == rhs_.device ) && ( lhs_.inode == rhs_.inode ) && ( lhs_.size == rhs_.size )
+           && ( lhs_.modificationTimeNs == rhs_.modificationTimeNs );
+  }
+
+  inline bool operator!=( const file_identity& lhs_, const file_identity& rhs_ )
+  {
+    return !( lhs_ == rhs_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the interface of the digest caches, implementations have to be thread safe
+  class digest_cache
+  {
+  public:
+    //! files modified less than this interval before hashing started aren't cached
+    static LL_CONSTEXPR std::int64_t kRacyIntervalNs = 2000000000;
+
+    virtual ~digest_cache() {}
+
+    //! get the cached digest of the given type for the file, returns false if there is no valid entry
+    virtual bool lookup( const std::string& path_,
+                         const file_identity& identity_,
+                         hash::type type_,
+                         digest& digest_ ) = 0;
+
+    //! store the digest of the file, replaces an existing entry of the same hash type
+    virtual void store( const std::string& path_, const file_identity& identity_, const digest& digest_ ) = 0;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! stores the digests with the files themselves: in user extended attributes (posix) or in alternate
+  //! data streams (windows), so they follow renames and are invalidated by copies
+  //! files without support or write permission are silently not cached
+  class attribute_digest_cache : public digest_cache
+  {
+  public:
+    bool lookup( const std::string& path_,
+                 const file_identity& identity_,
+                 hash::type type_,
+                 digest& digest_ ) override;
+
+    void store( const std::string& path_, const file_identity& identity_, const digest& digest_ ) override;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! stores the digests in a compact binary database file, which is loaded on construction and written
+  //! on flush (and destruction), so read-only files and file systems without extended attributes can be
+  //! cached as well
+  class sidecar_digest_cache : public digest_cache
+  {
+  public:
+    //! a missing database file is created on the first flush
+    explicit sidecar_digest_cache( const std::string& databasePath_ );
+
+    //! writes the changes, errors are ignored (call flush to handle them)
+    ~sidecar_digest_cache();
+
+    sidecar_digest_cache( const sidecar_digest_cache& ) = delete;
+    sidecar_digest_cache& operator=( const sidecar_digest_cache& ) = delete;
+
+    bool lookup( const std::string& path_,
+                 const file_identity& identity_,
+                 hash::type type_,
+                 digest& digest_ ) override;
+
+    void store( const std::string& path_, const file_identity& identity_, const digest& digest_ ) override;
+
+    //! write the database if there are changes (atomically replaces the file)
+    void flush();
+
+    //! the number of entries
+    size_t size() const;
+
+  private:
+    class impl;
+
+    std::unique_ptr< impl > m_pImpl;
+  };
+
+}  // namespace crypto
+}  // namespace ll
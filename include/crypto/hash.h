@@ -18,9 +18,13 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <memory>
 
 #include "../support/environment.h"
@@ -30,6 +34,9 @@ namespace ll
 {
 namespace crypto
 {
+  class digest_cache;
+
+
   struct hash
   {
     enum class type
@@ -40,12 +47,56 @@ namespace crypto
       sha1,
       sha256,
       sha384,
-      sha512
+      sha512,
+      blake3,
+      sha3_256,
+      sha3_512,
+      shake128,  //!< extendable output, 32 bytes by default (see hash_generator::retrieve_hash)
+      shake256,  //!< extendable output, 64 bytes by default
+      crc32c,    //!< checksum, not cryptographic (see is_cryptographic)
+      xxh3_64,   //!< checksum, not cryptographic
+      xxh3_128   //!< checksum, not cryptographic
+    };
+
+    //! where the input of a hash comes from, the automatic block size depends on it
+    enum class source
+    {
+      memory,  //!< buffers and memory-mapped files, hashed in place
+      stream   //!< std::istream and files that are read, copied into the block buffer before hashing
     };
 
     struct config
     {
-      size_t processingBlockSize = 100000;  //!< size of the internal block buffer for processing in bytes
+      //! processingBlockSize value that selects the size from the cache geometry of the cpu, the hash type
+      //! and the input source (see get_processing_block_size)
+      static LL_CONSTEXPR size_t autoBlockSize = 0;
+
+      //! size of the internal block buffer for processing in bytes
+      size_t processingBlockSize = autoBlockSize;
+
+      //! number of processingBlockSize buffers a background thread reads ahead when hashing a stream,
+      //! 0 reads and hashes on the calling thread only
+      size_t numReadAheadBuffers = 0;
+
+      //! multi-hash only: run every algorithm on its own worker thread
+      bool useWorkerThreads = false;
+
+      //! blake3 buffers only: number of threads hashing the subtrees of large buffers in parallel,
+      //! 0 or 1 hashes on the calling thread only
+      size_t numHashThreads = 0;
+
+      //! file hashing only: unchanged files get their digest from this cache without being read, freshly
+      //! computed digests are stored in it (see crypto/digest_cache.h)
+      std::shared_ptr< digest_cache > digestCache;
+
+      //! file hashing only: hash the file even if the cache holds a valid digest for it,
+      //! a mismatch updates the cache and throws an exception
+      bool verifyCachedDigests = false;
+
+      //! file hashing only: hash regular files in place through a memory mapping, false reads them
+      //! on posix, a file that another process truncates while it is mapped raises SIGBUS in the hashing
+      //! thread (see get_file_hash), so turn this off for files that may shrink while they are hashed
+      bool mapFiles = true;
     };
 
 
@@ -57,6 +108,60 @@ namespace crypto
   };
 
 
+  //! a fixed-size binary digest: trivially copyable, comparable and hashable, without any allocation
+  //! (the hex representation is only created on demand by to_string)
+  struct digest
+  {
+    static LL_CONSTEXPR size_t maxSize = 64;  //!< sized for the largest digest (sha-512)
+
+    hash::type hashType = hash::type::unknown;
+    std::uint8_t size = 0;  //!< the number of valid bytes
+    std::array< std::uint8_t, maxSize > bytes = { {} };
+
+    const std::uint8_t* data() const LL_NOEXCEPT { return bytes.data(); }
+  };
+
+
+  inline bool operator==( const digest& lhs_, const digest& rhs_ ) LL_NOEXCEPT
+  {
+    return ( lhs_.hashType == rhs_.hashType ) && ( lhs_.size == rhs_.size )
+           && ( std::memcmp( lhs_.data(), rhs_.data(), lhs_.size ) == 0 );
+  }
+
+  inline bool operator!=( const digest& lhs_, const digest& rhs_ ) LL_NOEXCEPT
+  {
+    return !( lhs_ == rhs_ );
+  }
+
+  inline bool operator<( const digest& lhs_, const digest& rhs_ ) LL_NOEXCEPT
+  {
+    if ( lhs_.hashType != rhs_.hashType )
+      return lhs_.hashType < rhs_.hashType;
+    if ( lhs_.size != rhs_.size )
+      return lhs_.size < rhs_.size;
+    return std::memcmp( lhs_.data(), rhs_.data(), lhs_.size ) < 0;
+  }
+
+
+  //! a reference to a contiguous block of input data (layout compatible with struct iovec)
+  struct buffer_ref
+  {
+    const void* pBuffer;
+    size_t szBufferInBytes;
+  };
+
+
+  //! the binary digests of a batch of independent messages
+  struct hash_batch
+  {
+    hash::type hashType = hash::type::unknown;
+    size_t digestSize = 0;  //!< the size of a single digest in bytes
+
+    //! all digests in input order, digest i starts at binary[i * digestSize]
+    std::vector< std::uint8_t > binary;
+  };
+
+
   // ---------------------------------------------------------------------------------------------------------
 
   //! translate the hash type from a string to the enum
@@ -65,6 +170,43 @@ namespace crypto
   //! translate the hash type from the enum to the (lowercase) string
   std::string to_string( hash::type type_ ) LL_NOEXCEPT;
 
+  //! false for the checksum types (crc32c, xxh3): they detect accidental corruption, but offer no resistance
+  //! against deliberate collisions, so they must not be used for signatures, passwords or deduplication of
+  //! untrusted data
+  bool is_cryptographic( hash::type type_ ) LL_NOEXCEPT;
+
+  //! the block size the hash functions use for cfg_: cfg_.processingBlockSize, or the automatic size if it is
+  //! hash::config::autoBlockSize
+  //! the automatic size keeps copied blocks within the L2 cache (half of it for the slower algorithms, so the
+  //! hash state and tables stay resident), input that is hashed in place is only split into large slices
+  size_t get_processing_block_size( hash::type type_,
+                                    hash::source source_,
+                                    const hash::config& cfg_ = hash::config() );
+
+  //! measure the stream path once with a few block sizes around the L2 size and use the fastest ones for
+  //! hash::config::autoBlockSize from then on (takes some tens of milliseconds, thread-safe)
+  //! without calibration the automatic size is derived from the cache geometry alone
+  void calibrate_processing_block_size();
+
+  //! the implementation computing a hash type on this machine, i.e. the platform library for md4 / md5 and
+  //! the kernel selected from the cpu features for the types implemented in the library (e.g. "sha-ni")
+  std::string get_implementation( hash::type type_ );
+
+  //! the implementations that can compute a hash type on this machine, the one selected by default first
+  std::vector< std::string > get_implementations( hash::type type_ );
+
+  //! replaces the implementation of a hash type for the whole process, e.g. to compare or test the kernels
+  //! sha-384 and sha-512 share their kernels, so they switch together. Generators hashing in other threads
+  //! pick up the new kernel with their next update (the kernels share the state). Throws
+  //! error::invalid_parameter if the implementation isn't one of get_implementations( type_ )
+  void set_implementation( hash::type type_, const std::string& name_ );
+
+  //! the (lowercase) hex representation of a digest
+  std::string to_string( const digest& digest_ );
+
+  //! the compact representation of a hash
+  digest to_digest( const hash& hash_ );
+
 
   // ---------------------------------------------------------------------------------------------------------
 
@@ -82,11 +224,51 @@ namespace crypto
     hash_generator& operator= ( const hash_generator& other_ ) = delete;
 
     virtual void add_data( const std::uint8_t* pBuffer_, size_t sz_ );
+
+    //! add a message held in non-contiguous segments (e.g. struct iovec), small segments are coalesced
+    //! into full blocks, so chains of fragments can be hashed in place with a single call
+    //! throws error::invalid_parameter if a segment has no buffer but a size
+    virtual void add_segments( const buffer_ref* pSegments_, size_t numSegments_ );
+
     virtual hash retrieve_hash();
 
+    //! like retrieve_hash, but without allocating or hex encoding
+    virtual digest retrieve_digest();
+
+    //! extendable-output types (shake128, shake256) only: finalize with outputSize_ bytes of output
+    //! other types throw error::invalid_request
+    virtual hash retrieve_hash( size_t outputSize_ );
+
+    //! like retrieve_hash( outputSize_ ), but writing the output to pOutput_ without allocating
+    virtual void retrieve_output( std::uint8_t* pOutput_, size_t outputSize_ );
+
+    //! reinitialize the generator in place (also after retrieve_hash), so it can be used for the next message
+    virtual void reset();
+
+    //! duplicate the in-flight state, e.g. to hash a common prefix once and fork it for many suffixes
+    //! the clone continues independently of this generator
+    hash_generator clone() const;
+
+    //! serialize the in-flight state, so hashing can be resumed later or by another process
+    //! the format is versioned and compact (all integers little endian):
+    //!   "LLHS", version (1 byte), hash type (1 byte), input size (8 bytes),
+    //!   chaining value, buffered bytes of the incomplete block (input size modulo block size)
+    //! md4 and md5 aren't supported by the BCrypt and CommonCrypto backends and by OpenSSL built with
+    //! LL_CRYPTO_OPENSSL_EVP (throws error::invalid_request, the same for import_state and from_state)
+    virtual std::vector< std::uint8_t > export_state() const;
+
+    //! continue from an exported state of the same hash type
+    virtual void import_state( const void* pState_, size_t sz_ );
+
+    //! create a generator that continues from an exported state
+    static hash_generator from_state( const void* pState_, size_t sz_ );
+
   private:
+    template < hash::type type_ >
     class concrete_hash_generator;
 
+    virtual std::unique_ptr< hash_generator > clone_impl() const;
+
     hash_generator() {}
 
     std::unique_ptr< hash_generator > m_pImpl;
@@ -106,12 +288,76 @@ namespace crypto
                  hash::type type_ = hash::type::md5,
                  const hash::config& cfg_ = hash::config() );
 
+  //! convenience: get the hash of a single message held in non-contiguous segments (e.g. struct iovec)
+  //! unlike get_hashes, the segments are concatenated into one message
+  //! (not an overload of get_hash, which would make get_hash( nullptr, ... ) ambiguous)
+  hash get_segmented_hash( const buffer_ref* pSegments_,
+                           size_t numSegments_,
+                           hash::type type_ = hash::type::md5 );
+
   //! convenience: get the hash of data from a stream (from the current position to end)
   hash get_hash( std::istream& stream_,
                  hash::type type_ = hash::type::md5,
                  const hash::config& cfg_ = hash::config() );
 
-  
+
+  //! convenience: get the digest of a binary buffer (without allocating)
+  digest get_digest( const void* pBuffer_,
+                     size_t szBufferInBytes_,
+                     hash::type type_ = hash::type::md5,
+                     const hash::config& cfg_ = hash::config() );
+
+  //! convenience: get the hash of a file
+  //! regular files are memory-mapped and hashed in place, other files (pipes, procfs, ...) are read
+  //! files modified within the last two seconds are read as well, and a file whose size or modification
+  //! time changed while it was mapped is hashed again by reading it
+  //!
+  //! WARNING: on posix, a file that another process truncates while it is mapped raises SIGBUS in the
+  //! hashing thread, which terminates the process unless the application handles the signal. Set
+  //! hash::config::mapFiles to false for files that may shrink concurrently (e.g. logs that get rotated)
+  hash get_file_hash( const std::string& path_,
+                      hash::type type_ = hash::type::md5,
+                      const hash::config& cfg_ = hash::config() );
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! get the hashes of many independent (short) messages in one call
+  //! md5, sha-1 and sha-256 are processed in interleaved SIMD lanes where the cpu supports it, sha-3 and
+  //! shake in four interleaved keccak states (avx2)
+  hash_batch get_hashes( const buffer_ref* pBuffers_,
+                         size_t numBuffers_,
+                         hash::type type_ = hash::type::md5 );
+
+  //! convenience: get the hashes of many independent messages in one call
+  hash_batch get_hashes( const std::vector< buffer_ref >& buffers_, hash::type type_ = hash::type::md5 );
+
+  //! the kernels get_hashes can use for a hash type on this machine, the one selected by default first
+  //! ("single" hashes the messages one by one, the default for the types without a multi-buffer kernel)
+  std::vector< std::string > get_batch_implementations( hash::type type_ );
+
+  //! makes get_hashes use one of get_batch_implementations( type_ ) for the whole process, e.g. to compare
+  //! or test the kernels. Throws error::invalid_parameter if the implementation isn't available
+  void set_batch_implementation( hash::type type_, const std::string& name_ );
+
+
 
 }  // namespace crypto
 }  // namespace ll
+
+
+namespace std
+{
+  template <>
+  struct hash< ll::crypto::digest >
+  {
+    size_t operator()( const ll::crypto::digest& digest_ ) const LL_NOEXCEPT
+    {
+      // the digest bytes are uniformly distributed already, so the leading bytes make a good hash value
+      size_t result = static_cast< size_t >( digest_.hashType );
+      size_t leading = 0;
+      std::memcpy( &leading, digest_.data(), std::min( sizeof( leading ), size_t( digest_.size ) ) );
+      return result ^ leading;
+    }
+  };
+}
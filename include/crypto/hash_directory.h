@@ -0,0 +1,110 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <cstdint>
+#include <vector>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  // Directory hashing walks a tree and hashes every regular file on a pool of worker threads. Symbolic links
+  // and other special files are skipped, paths in the manifest are relative to the root and use '/' as
+  // separator (UTF-8 on Windows).
+  //
+  // The text form of a manifest starts with the line "ll_crypto_manifest 1 <hash type>", followed by one line
+  // per file: "<hex digest> <size> <path>" (the path is the rest of the line, so it may contain spaces but no
+  // line breaks).
+
+  struct directory_hash_config
+  {
+    size_t numThreads = 0;     //!< number of worker threads, 0 = number of cores
+    hash::config hashConfig;   //!< the configuration for hashing the single files
+  };
+
+
+  struct manifest_entry
+  {
+    std::string path;         //!< relative to the root
+    std::uint64_t size = 0;   //!< file size in bytes
+    digest fileDigest;
+  };
+
+
+  struct manifest
+  {
+    hash::type hashType = hash::type::unknown;
+    std::vector< manifest_entry > entries;  //!< sorted by path
+    //! the files and directories that couldn't be read (sorted, not written out)
+    std::vector< std::string > unreadable;
+  };
+
+
+  struct manifest_mismatch
+  {
+    enum class kind
+    {
+      missing,     //!< in the manifest, but not in the tree
+      unexpected,  //!< in the tree, but not in the manifest
+      modified,    //!< size or digest differ
+      unreadable   //!< the file (or a directory above it) couldn't be read
+    };
+
+    kind mismatchKind = kind::modified;
+    std::string path;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! hash all files below root_ in parallel and return the sorted manifest
+  //! the files are scheduled largest first, so a single large file doesn't delay the end of the run
+  //! a file or subdirectory that can't be read doesn't stop the run, it is listed in manifest::unreadable
+  //! instead (only an unreadable root_ throws)
+  //! the files are hashed with get_file_hash, which maps them: set cfg_.hashConfig.mapFiles to false for trees
+  //! whose files may be truncated while they are hashed (see get_file_hash)
+  manifest hash_directory( const std::string& root_,
+                           hash::type type_ = hash::type::sha256,
+                           const directory_hash_config& cfg_ = directory_hash_config() );
+
+  //! check the tree below root_ against a manifest in parallel, returns the mismatches sorted by path
+  //! (an empty result means the tree matches the manifest). A subdirectory that can't be listed is reported
+  //! as unreadable, together with the manifest entries below it
+  std::vector< manifest_mismatch > verify_manifest(
+    const std::string& root_,
+    const manifest& manifest_,
+    const directory_hash_config& cfg_ = directory_hash_config() );
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! write the text form of a manifest
+  void write_manifest( std::ostream& stream_, const manifest& manifest_ );
+
+  //! read the text form of a manifest
+  manifest read_manifest( std::istream& stream_ );
+
+}  // namespace crypto
+}  // namespace ll
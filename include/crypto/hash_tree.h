@@ -0,0 +1,66 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  // Tree hashing splits the input into leaves of a fixed size and combines their hashes into a Merkle root,
+  // which allows the leaves to be hashed on several cores. The result differs from the plain digest of the
+  // input. The format follows RFC 6962 (with H being the selected hash type):
+  //
+  //  - the input is split into consecutive leaves of leafSize bytes, the last leaf may be shorter
+  //    (an empty input is a single empty leaf)
+  //  - leaf hash:  H( 0x00 || leaf data )
+  //  - node hash:  H( 0x01 || left child hash || right child hash )
+  //  - each level pairs up the hashes from left to right, an unpaired last hash is promoted unchanged
+  //    to the next level, until a single root hash remains
+  //
+  // The root depends on the leaf size, so digests are only comparable if they were created with the same
+  // leaf size.
+
+  struct tree_hash_config
+  {
+    size_t leafSize = 1024 * 1024;  //!< size of a leaf in bytes (part of the format)
+    size_t numThreads = 0;          //!< number of threads hashing the leaves, 0 = number of cores
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! get the Merkle tree hash of a binary buffer
+  hash get_tree_hash( const void* pBuffer_,
+                      size_t szBufferInBytes_,
+                      hash::type type_ = hash::type::sha256,
+                      const tree_hash_config& cfg_ = tree_hash_config() );
+
+  //! convenience: get the Merkle tree hash of a std::string
+  hash get_tree_hash( const std::string& v_,
+                      hash::type type_ = hash::type::sha256,
+                      const tree_hash_config& cfg_ = tree_hash_config() );
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,126 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! a key prepared for HMAC (RFC 2104) with one of the sha types (sha-1, sha-2 and fixed size sha-3)
+  //! the key blocks xor'ed with ipad and opad are compressed once on construction, every message starts
+  //! from copies of these keyed states, so signing a short message costs two compressions less than the
+  //! textbook construction and doesn't allocate
+  //! the const member functions can be called from several threads concurrently
+  class hmac_key
+  {
+  public:
+    hmac_key( hash::type type_, const void* pKey_, size_t szKey_ );
+    hmac_key( hash::type type_, const std::string& key_ );
+    ~hmac_key();
+
+    hmac_key( hmac_key&& other_ );
+    hmac_key& operator=( hmac_key&& other_ );
+
+    hmac_key( const hmac_key& other_ ) = delete;
+    hmac_key& operator=( const hmac_key& other_ ) = delete;
+
+    hash::type hash_type() const LL_NOEXCEPT;
+    size_t digest_size() const LL_NOEXCEPT;
+
+    //! the mac of a single message
+    digest sign( const void* pMessage_, size_t szMessage_ ) const;
+
+    //! compare the mac of the message with an expected mac in constant time
+    //! macs of a different hash type or size never match
+    bool verify( const void* pMessage_, size_t szMessage_, const digest& mac_ ) const;
+
+    //! verify a batch of messages against their expected macs (pMacs_[i] belongs to pMessages_[i])
+    //! returns the result per message in input order
+    std::vector< bool > verify( const buffer_ref* pMessages_,
+                                const digest* pMacs_,
+                                size_t numMessages_ ) const;
+
+  private:
+    friend class hmac_generator;
+
+    class impl;
+
+    template < hash::type type_ >
+    class keyed_hash;
+
+    std::unique_ptr< impl > m_pImpl;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! streaming HMAC generator, starts from the keyed states of a prepared key
+  class hmac_generator
+  {
+  public:
+    explicit hmac_generator( const hmac_key& key_ );
+    hmac_generator( hash::type type_, const void* pKey_, size_t szKey_ );
+    ~hmac_generator();
+
+    hmac_generator( hmac_generator&& other_ );
+    hmac_generator& operator=( hmac_generator&& other_ );
+
+    hmac_generator( const hmac_generator& other_ ) = delete;
+    hmac_generator& operator=( const hmac_generator& other_ ) = delete;
+
+    void add_data( const std::uint8_t* pBuffer_, size_t sz_ );
+
+    //! the mac of the message (hash::inputSize is the size of the message)
+    hash retrieve_hash();
+
+    //! like retrieve_hash, but without allocating or hex encoding
+    digest retrieve_digest();
+
+    //! start the next message with the same key (also after retrieve_hash)
+    void reset();
+
+  private:
+    std::unique_ptr< hmac_key::impl > m_pImpl;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! convenience: get the mac of a binary buffer
+  hash get_hmac( const void* pKey_,
+                 size_t szKey_,
+                 const void* pMessage_,
+                 size_t szMessage_,
+                 hash::type type_ = hash::type::sha256 );
+
+  //! convenience: get the mac of a std::string
+  hash get_hmac( const std::string& key_,
+                 const std::string& message_,
+                 hash::type type_ = hash::type::sha256 );
+
+}  // namespace crypto
+}  // namespace ll
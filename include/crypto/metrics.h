@@ -0,0 +1,106 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crypto/hash.h"
+
+// the registry is compiled in with the cmake option LL_CRYPTO_ENABLE_METRICS, code including this header
+// from outside the build should define LL_CRYPTO_METRICS the same way (it only affects metrics_enabled)
+#ifndef LL_CRYPTO_METRICS
+#define LL_CRYPTO_METRICS 0
+#endif
+
+
+namespace ll
+{
+namespace crypto
+{
+  // The metrics registry counts calls, bytes and time per hash type and entry point, and collects latency
+  // histograms for pbkdf2. Only the outermost instrumented call on a thread is counted, e.g. get_hash for a
+  // string is one call of entry_point::get_hash and not an additional hash_generator call. Generators used
+  // directly (this includes the ones of multi_hash_generator) are counted as entry_point::hash_generator,
+  // with one call per retrieved message.
+  //
+  // The counters are sharded per thread and updated with relaxed atomics, so recording doesn't contend.
+  // Without LL_CRYPTO_METRICS nothing is recorded and the snapshot is empty.
+
+  namespace metrics
+  {
+    enum class entry_point
+    {
+      get_hash,         //!< get_hash for buffers and strings
+      get_hash_stream,  //!< get_hash for streams
+      get_digest,
+      get_hashes,
+      get_file_hash,
+      hash_generator,
+      pbkdf2
+    };
+
+    static LL_CONSTEXPR size_t kNumEntryPoints = static_cast< size_t >( entry_point::pbkdf2 ) + 1;
+
+    struct counter
+    {
+      entry_point entryPoint = entry_point::get_hash;
+      hash::type hashType = hash::type::unknown;
+
+      std::uint64_t calls = 0;
+      std::uint64_t bytes = 0;        //!< the size of the input (0 for pbkdf2)
+      std::uint64_t nanoseconds = 0;  //!< the wall time spent in the calls
+    };
+
+    //! log-linear buckets: every power of two from 1 us on is split into 4 linear buckets
+    struct histogram
+    {
+      hash::type hashType = hash::type::unknown;
+
+      std::uint64_t count = 0;
+      std::uint64_t sumNanoseconds = 0;
+
+      //! the (inclusive) upper bounds of the buckets in ns, the last one is the maximum of std::uint64_t
+      std::vector< std::uint64_t > upperBounds;
+      std::vector< std::uint64_t > counts;  //!< per bucket, not cumulative
+    };
+
+    struct snapshot
+    {
+      bool enabled = false;  //!< false if the library was built without LL_CRYPTO_METRICS
+
+      std::vector< counter > counters;           //!< only the combinations that have been called
+      std::vector< histogram > pbkdf2Latencies;  //!< only the hash types that have been used
+    };
+
+    //! true if the library was built with LL_CRYPTO_METRICS
+    bool metrics_enabled() LL_NOEXCEPT;
+
+    //! sums up the shards, calls running concurrently may be partially included
+    snapshot get_snapshot();
+
+    //! sets all counters to 0, calls running concurrently may be partially included afterwards
+    void reset();
+
+    std::string to_string( entry_point entryPoint_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
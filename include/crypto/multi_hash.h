@@ -0,0 +1,74 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <memory>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! calculates several hashes of the same input in a single pass
+  //! every block of input is fed to all requested algorithms, optionally on one worker thread per algorithm
+  //! (hash::config::useWorkerThreads), which pays off for large blocks
+  class multi_hash_generator
+  {
+  public:
+    multi_hash_generator( const std::vector< hash::type >& types_, const hash::config& cfg_ = hash::config() );
+    ~multi_hash_generator();
+
+    multi_hash_generator( multi_hash_generator&& other_ );
+    multi_hash_generator& operator=( multi_hash_generator&& other_ );
+
+    multi_hash_generator( const multi_hash_generator& other_ ) = delete;
+    multi_hash_generator& operator=( const multi_hash_generator& other_ ) = delete;
+
+    void add_data( const std::uint8_t* pBuffer_, size_t sz_ );
+
+    //! the hashes in the order of the types passed to the constructor
+    std::vector< hash > retrieve_hashes();
+
+  private:
+    class impl;
+
+    std::unique_ptr< impl > m_pImpl;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! convenience: get several hashes of a binary buffer (in the order of types_)
+  std::vector< hash > get_multi_hash( const void* pBuffer_,
+                                      size_t szBufferInBytes_,
+                                      const std::vector< hash::type >& types_,
+                                      const hash::config& cfg_ = hash::config() );
+
+  //! convenience: get several hashes of data from a stream in a single pass (in the order of types_)
+  std::vector< hash > get_multi_hash( std::istream& stream_,
+                                      const std::vector< hash::type >& types_,
+                                      const hash::config& cfg_ = hash::config() );
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,766 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "blake3.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "crypto/basic_hash_generator.h"
+#include "crypto/exception.h"
+#include "cpu_features.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace blake3
+  {
+    const std::uint32_t kIV[8]
+      = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+    const std::uint8_t kMessageSchedule[7][16] = {
+      { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+      { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+      { 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+      { 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+      { 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+      { 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+      { 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 },
+    };
+
+    namespace
+    {
+      //! subtrees smaller than this are not worth a thread of their own
+      const size_t kMinParallelSize = 256 * 1024;
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      // blake3 is little endian like the platforms we run on
+
+      inline std::uint32_t load_le32( const std::uint8_t* p_ )
+      {
+        std::uint32_t v;
+        std::memcpy( &v, p_, 4 );
+        return v;
+      }
+
+      inline void store_le32( std::uint8_t* p_, std::uint32_t v_ )
+      {
+        std::memcpy( p_, &v_, 4 );
+      }
+
+      inline void store_cv( std::uint8_t* p_, const std::uint32_t* pCv_ )
+      {
+        for ( size_t i = 0; i < 8; ++i )
+          store_le32( p_ + 4 * i, pCv_[i] );
+      }
+
+      inline std::uint32_t rotr( std::uint32_t v_, int n_ )
+      {
+        return ( v_ >> n_ ) | ( v_ << ( 32 - n_ ) );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+      // portable compression function
+      // -----------------------------------------------------------------------------------------------------
+
+      inline void g(
+        std::uint32_t* v_, size_t a_, size_t b_, size_t c_, size_t d_, std::uint32_t x_, std::uint32_t y_ )
+      {
+        v_[a_] = v_[a_] + v_[b_] + x_;
+        v_[d_] = rotr( v_[d_] ^ v_[a_], 16 );
+        v_[c_] = v_[c_] + v_[d_];
+        v_[b_] = rotr( v_[b_] ^ v_[c_], 12 );
+        v_[a_] = v_[a_] + v_[b_] + y_;
+        v_[d_] = rotr( v_[d_] ^ v_[a_], 8 );
+        v_[c_] = v_[c_] + v_[d_];
+        v_[b_] = rotr( v_[b_] ^ v_[c_], 7 );
+      }
+
+      //! the 16 word state after the 7 rounds, the output is derived from it
+      void compress_pre( std::uint32_t* v_,
+                         const std::uint32_t* pCv_,
+                         const std::uint8_t* pBlock_,
+                         std::uint8_t blockSize_,
+                         std::uint64_t counter_,
+                         std::uint8_t flags_ )
+      {
+        std::uint32_t m[16];
+        for ( size_t i = 0; i < 16; ++i )
+          m[i] = load_le32( pBlock_ + 4 * i );
+
+        std::copy( pCv_, pCv_ + 8, v_ );
+        std::copy( kIV, kIV + 4, v_ + 8 );
+        v_[12] = static_cast< std::uint32_t >( counter_ );
+        v_[13] = static_cast< std::uint32_t >( counter_ >> 32 );
+        v_[14] = blockSize_;
+        v_[15] = flags_;
+
+        for ( size_t r = 0; r < 7; ++r )
+        {
+          const auto& s = kMessageSchedule[r];
+          g( v_, 0, 4, 8, 12, m[s[0]], m[s[1]] );
+          g( v_, 1, 5, 9, 13, m[s[2]], m[s[3]] );
+          g( v_, 2, 6, 10, 14, m[s[4]], m[s[5]] );
+          g( v_, 3, 7, 11, 15, m[s[6]], m[s[7]] );
+          g( v_, 0, 5, 10, 15, m[s[8]], m[s[9]] );
+          g( v_, 1, 6, 11, 12, m[s[10]], m[s[11]] );
+          g( v_, 2, 7, 8, 13, m[s[12]], m[s[13]] );
+          g( v_, 3, 4, 9, 14, m[s[14]], m[s[15]] );
+        }
+      }
+
+      void compress_in_place( std::uint32_t* pCv_,
+                              const std::uint8_t* pBlock_,
+                              std::uint8_t blockSize_,
+                              std::uint64_t counter_,
+                              std::uint8_t flags_ )
+      {
+        std::uint32_t v[16];
+        compress_pre( v, pCv_, pBlock_, blockSize_, counter_, flags_ );
+        for ( size_t i = 0; i < 8; ++i )
+          pCv_[i] = v[i] ^ v[i + 8];
+      }
+
+      //! the extended output of a block (used for the root)
+      void compress_xof( const std::uint32_t* pCv_,
+                         const std::uint8_t* pBlock_,
+                         std::uint8_t blockSize_,
+                         std::uint64_t counter_,
+                         std::uint8_t flags_,
+                         std::uint8_t* pOut_ )
+      {
+        std::uint32_t v[16];
+        compress_pre( v, pCv_, pBlock_, blockSize_, counter_, flags_ );
+        for ( size_t i = 0; i < 8; ++i )
+        {
+          store_le32( pOut_ + 4 * i, v[i] ^ v[i + 8] );
+          store_le32( pOut_ + 32 + 4 * i, v[i + 8] ^ pCv_[i] );
+        }
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      size_t hash_many_portable( const std::uint8_t* const* pInputs_,
+                                 size_t numInputs_,
+                                 size_t numBlocks_,
+                                 const std::uint32_t* pKey_,
+                                 std::uint64_t counter_,
+                                 bool incrementCounter_,
+                                 std::uint8_t flags_,
+                                 std::uint8_t flagsStart_,
+                                 std::uint8_t flagsEnd_,
+                                 std::uint8_t* pOut_ )
+      {
+        for ( size_t i = 0; i < numInputs_; ++i )
+        {
+          std::uint32_t cv[8];
+          std::copy( pKey_, pKey_ + 8, cv );
+
+          std::uint8_t blockFlags = flags_ | flagsStart_;
+          for ( size_t b = 0; b < numBlocks_; ++b )
+          {
+            if ( b + 1 == numBlocks_ )
+              blockFlags |= flagsEnd_;
+            compress_in_place( cv, pInputs_[i] + b * kBlockSize, kBlockSize, counter_, blockFlags );
+            blockFlags = flags_;
+          }
+
+          store_cv( pOut_ + i * kOutSize, cv );
+          if ( incrementCounter_ )
+            ++counter_;
+        }
+        return numInputs_;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      //! the number of chunks hash_many processes at once with the best kernel available
+      size_t simd_degree()
+      {
+        const auto& features = get_cpu_features();
+#if LL_HAS_AVX512()
+        if ( features.avx512f )
+          return 16;
+#endif
+        if ( features.avx2 )
+          return 8;
+        if ( features.sse41 )
+          return 4;
+        return 1;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+      // chunks
+      // -----------------------------------------------------------------------------------------------------
+
+      //! the inputs of the last compression of a chunk or parent node, the root is compressed differently
+      struct output
+      {
+        std::uint32_t inputCv[8];
+        std::uint8_t block[kBlockSize];
+        std::uint8_t blockSize;
+        std::uint64_t counter;
+        std::uint8_t flags;
+      };
+
+      void output_chaining_value( const output& o_, std::uint8_t* pCv_ )
+      {
+        std::uint32_t cv[8];
+        std::copy( o_.inputCv, o_.inputCv + 8, cv );
+        compress_in_place( cv, o_.block, o_.blockSize, o_.counter, o_.flags );
+        store_cv( pCv_, cv );
+      }
+
+      void output_root_bytes( const output& o_, std::uint8_t* pOut_, size_t outSize_ )
+      {
+        std::uint64_t counter = 0;
+        std::uint8_t block[2 * kOutSize];
+        while ( outSize_ > 0 )
+        {
+          compress_xof( o_.inputCv, o_.block, o_.blockSize, counter++, o_.flags | root, block );
+          auto n = std::min( outSize_, sizeof( block ) );
+          std::memcpy( pOut_, block, n );
+          pOut_ += n;
+          outSize_ -= n;
+        }
+      }
+
+      output parent_output( const std::uint8_t* pBlock_ )
+      {
+        output o;
+        std::copy( kIV, kIV + 8, o.inputCv );
+        std::memcpy( o.block, pBlock_, kBlockSize );
+        o.blockSize = kBlockSize;
+        o.counter = 0;
+        o.flags = parent;
+        return o;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      void chunk_reset( chunk_state& c_, std::uint64_t chunkCounter_ )
+      {
+        std::copy( kIV, kIV + 8, c_.cv );
+        c_.chunkCounter = chunkCounter_;
+        std::memset( c_.buffer, 0, kBlockSize );
+        c_.bufferSize = 0;
+        c_.blocksCompressed = 0;
+      }
+
+      size_t chunk_size( const chunk_state& c_ )
+      {
+        return kBlockSize * c_.blocksCompressed + c_.bufferSize;
+      }
+
+      std::uint8_t chunk_start_flag( const chunk_state& c_ )
+      {
+        return c_.blocksCompressed == 0 ? chunk_start : 0;
+      }
+
+      void chunk_update( chunk_state& c_, const std::uint8_t* pBuffer_, size_t sz_ )
+      {
+        // the last block of a chunk is compressed with different flags, so a full buffer is only
+        // compressed once more input follows
+        if ( c_.bufferSize > 0 )
+        {
+          auto n = std::min( kBlockSize - c_.bufferSize, sz_ );
+          std::memcpy( c_.buffer + c_.bufferSize, pBuffer_, n );
+          c_.bufferSize += static_cast< std::uint8_t >( n );
+          pBuffer_ += n;
+          sz_ -= n;
+
+          if ( sz_ > 0 )
+          {
+            compress_in_place( c_.cv, c_.buffer, kBlockSize, c_.chunkCounter, chunk_start_flag( c_ ) );
+            ++c_.blocksCompressed;
+            c_.bufferSize = 0;
+            std::memset( c_.buffer, 0, kBlockSize );
+          }
+        }
+
+        while ( sz_ > kBlockSize )
+        {
+          compress_in_place( c_.cv, pBuffer_, kBlockSize, c_.chunkCounter, chunk_start_flag( c_ ) );
+          ++c_.blocksCompressed;
+          pBuffer_ += kBlockSize;
+          sz_ -= kBlockSize;
+        }
+
+        std::memcpy( c_.buffer + c_.bufferSize, pBuffer_, sz_ );
+        c_.bufferSize += static_cast< std::uint8_t >( sz_ );
+      }
+
+      output chunk_output( const chunk_state& c_ )
+      {
+        output o;
+        std::copy( c_.cv, c_.cv + 8, o.inputCv );
+        std::memcpy( o.block, c_.buffer, kBlockSize );
+        o.blockSize = c_.bufferSize;
+        o.counter = c_.chunkCounter;
+        o.flags = chunk_start_flag( c_ ) | chunk_end;
+        return o;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+      // subtrees
+      // -----------------------------------------------------------------------------------------------------
+
+      std::uint64_t round_down_to_power_of_2( std::uint64_t v_ )
+      {
+        std::uint64_t result = 1;
+        while ( ( result << 1 ) <= v_ )
+          result <<= 1;
+        return result;
+      }
+
+      //! the size of the left subtree: the largest power of 2 of chunks that leaves at least one byte
+      size_t left_size( size_t sz_ )
+      {
+        auto fullChunks = ( sz_ - 1 ) / kChunkSize;
+        return static_cast< size_t >( round_down_to_power_of_2( fullChunks ) ) * kChunkSize;
+      }
+
+      //! hash up to simd_degree() chunks into their chaining values, returns their number
+      size_t compress_chunks_parallel( const std::uint8_t* pBuffer_,
+                                       size_t sz_,
+                                       std::uint64_t chunkCounter_,
+                                       std::uint8_t* pOut_ )
+      {
+        const std::uint8_t* chunks[kMaxLanes];
+        size_t numChunks = 0;
+        size_t pos = 0;
+        for ( ; sz_ - pos >= kChunkSize; pos += kChunkSize )
+          chunks[numChunks++] = pBuffer_ + pos;
+
+        hash_many( chunks, numChunks, kChunkSize / kBlockSize, kIV, chunkCounter_, true, 0, chunk_start,
+                   chunk_end, pOut_ );
+
+        if ( pos == sz_ )
+          return numChunks;
+
+        chunk_state c;
+        chunk_reset( c, chunkCounter_ + numChunks );
+        chunk_update( c, pBuffer_ + pos, sz_ - pos );
+        output_chaining_value( chunk_output( c ), pOut_ + numChunks * kOutSize );
+        return numChunks + 1;
+      }
+
+      //! combine pairs of chaining values into their parents, an odd one is passed on
+      size_t compress_parents_parallel( const std::uint8_t* pChildCvs_, size_t numCvs_, std::uint8_t* pOut_ )
+      {
+        const std::uint8_t* parents[kMaxLanes];
+        size_t numParents = 0;
+        for ( ; numCvs_ - 2 * numParents >= 2; ++numParents )
+          parents[numParents] = pChildCvs_ + 2 * numParents * kOutSize;
+
+        hash_many( parents, numParents, 1, kIV, 0, false, parent, 0, 0, pOut_ );
+
+        if ( numCvs_ == 2 * numParents )
+          return numParents;
+
+        std::memcpy( pOut_ + numParents * kOutSize, pChildCvs_ + 2 * numParents * kOutSize, kOutSize );
+        return numParents + 1;
+      }
+
+      //! hash a subtree into at most max( simd_degree(), 2 ) chaining values (the remaining levels are
+      //! combined by the caller), the two halves are hashed on separate threads if there are enough of them
+      size_t compress_subtree_wide( const std::uint8_t* pBuffer_,
+                                    size_t sz_,
+                                    std::uint64_t chunkCounter_,
+                                    size_t numThreads_,
+                                    std::uint8_t* pOut_ )
+      {
+        auto degree = simd_degree();
+        if ( sz_ <= degree * kChunkSize )
+          return compress_chunks_parallel( pBuffer_, sz_, chunkCounter_, pOut_ );
+
+        auto leftSize = left_size( sz_ );
+        auto rightCounter = chunkCounter_ + leftSize / kChunkSize;
+
+        // the left subtree yields exactly degree chaining values, at least 2 since it is larger than a chunk
+        degree = std::max< size_t >( degree, 2 );
+        std::uint8_t cvs[2 * kMaxLanes * kOutSize];
+        auto pRightCvs = cvs + degree * kOutSize;
+
+        size_t numLeft = 0;
+        size_t numRight = 0;
+        if ( ( numThreads_ > 1 ) && ( sz_ >= kMinParallelSize ) )
+        {
+          auto numLeftThreads = numThreads_ / 2;
+          auto hashLeft = [&]()
+          {
+            numLeft = compress_subtree_wide( pBuffer_, leftSize, chunkCounter_, numLeftThreads, cvs );
+          };
+
+          std::thread left( hashLeft );
+          numRight = compress_subtree_wide(
+            pBuffer_ + leftSize, sz_ - leftSize, rightCounter, numThreads_ - numLeftThreads, pRightCvs );
+          left.join();
+        }
+        else
+        {
+          numLeft = compress_subtree_wide( pBuffer_, leftSize, chunkCounter_, 1, cvs );
+          numRight = compress_subtree_wide( pBuffer_ + leftSize, sz_ - leftSize, rightCounter, 1, pRightCvs );
+        }
+
+        // without simd the left subtree is a single parent, it must not be combined here
+        if ( numLeft == 1 )
+        {
+          std::memcpy( pOut_, cvs, 2 * kOutSize );
+          return 2;
+        }
+
+        return compress_parents_parallel( cvs, numLeft + numRight, pOut_ );
+      }
+
+      //! hash a subtree of more than one chunk into the two chaining values of its root node
+      void compress_subtree_to_parent_node( const std::uint8_t* pBuffer_,
+                                            size_t sz_,
+                                            std::uint64_t chunkCounter_,
+                                            size_t numThreads_,
+                                            std::uint8_t* pOut_ )
+      {
+        std::uint8_t cvs[2 * kMaxLanes * kOutSize];
+        auto numCvs = compress_subtree_wide( pBuffer_, sz_, chunkCounter_, numThreads_, cvs );
+
+        std::uint8_t parentCvs[kMaxLanes * kOutSize];
+        while ( numCvs > 2 )
+        {
+          numCvs = compress_parents_parallel( cvs, numCvs, parentCvs );
+          std::memcpy( cvs, parentCvs, numCvs * kOutSize );
+        }
+        std::memcpy( pOut_, cvs, 2 * kOutSize );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+      // chaining value stack
+      // -----------------------------------------------------------------------------------------------------
+
+      size_t popcount( std::uint64_t v_ )
+      {
+        size_t n = 0;
+        for ( ; v_ != 0; v_ &= v_ - 1 )
+          ++n;
+        return n;
+      }
+
+      //! merge completed subtrees, the stack holds one entry per 1 bit of the number of chunks so far
+      //! (the merge is deferred until more input arrives, as the last entry might become the root)
+      void merge_cv_stack( hasher& h_, std::uint64_t totalChunks_ )
+      {
+        auto targetSize = popcount( totalChunks_ );
+        while ( h_.cvStackSize > targetSize )
+        {
+          auto pParentNode = h_.cvStack + ( h_.cvStackSize - 2 ) * kOutSize;
+          output_chaining_value( parent_output( pParentNode ), pParentNode );
+          --h_.cvStackSize;
+        }
+      }
+
+      void push_cv( hasher& h_, const std::uint8_t* pCv_, std::uint64_t chunkCounter_ )
+      {
+        merge_cv_stack( h_, chunkCounter_ );
+        std::memcpy( h_.cvStack + h_.cvStackSize * kOutSize, pCv_, kOutSize );
+        ++h_.cvStackSize;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void hash_many( const std::uint8_t* const* pInputs_,
+                    size_t numInputs_,
+                    size_t numBlocks_,
+                    const std::uint32_t* pKey_,
+                    std::uint64_t counter_,
+                    bool incrementCounter_,
+                    std::uint8_t flags_,
+                    std::uint8_t flagsStart_,
+                    std::uint8_t flagsEnd_,
+                    std::uint8_t* pOut_ )
+    {
+      const auto& features = get_cpu_features();
+
+      // every kernel takes as many inputs as fill its lanes, the rest is left to the narrower ones
+      size_t done = 0;
+      auto run = [&]( decltype( &hash_many_portable ) fnKernel_ )
+      {
+        done += fnKernel_( pInputs_ + done,
+                           numInputs_ - done,
+                           numBlocks_,
+                           pKey_,
+                           counter_ + ( incrementCounter_ ? done : 0 ),
+                           incrementCounter_,
+                           flags_,
+                           flagsStart_,
+                           flagsEnd_,
+                           pOut_ + done * kOutSize );
+      };
+
+#if LL_HAS_AVX512()
+      if ( features.avx512f )
+        run( hash_many_avx512 );
+#endif
+      if ( features.avx2 )
+        run( hash_many_avx2 );
+      if ( features.sse41 )
+        run( hash_many_sse41 );
+      run( hash_many_portable );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void init( hasher& hasher_ )
+    {
+      chunk_reset( hasher_.chunk, 0 );
+      hasher_.cvStackSize = 0;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void update( hasher& hasher_, const std::uint8_t* pBuffer_, size_t sz_, size_t numThreads_ )
+    {
+      if ( sz_ == 0 )
+        return;
+
+      auto& chunk = hasher_.chunk;
+
+      // complete the current chunk first
+      if ( chunk_size( chunk ) > 0 )
+      {
+        auto n = std::min( kChunkSize - chunk_size( chunk ), sz_ );
+        chunk_update( chunk, pBuffer_, n );
+        pBuffer_ += n;
+        sz_ -= n;
+
+        if ( sz_ == 0 )
+          return;
+
+        std::uint8_t cv[kOutSize];
+        output_chaining_value( chunk_output( chunk ), cv );
+        push_cv( hasher_, cv, chunk.chunkCounter );
+        chunk_reset( chunk, chunk.chunkCounter + 1 );
+      }
+
+      // then hash the largest subtrees the position allows at once, keeping at least one byte for the
+      // chunk state, as the last chunk might be the root
+      while ( sz_ > kChunkSize )
+      {
+        auto subtreeSize = static_cast< size_t >( round_down_to_power_of_2( sz_ ) );
+        auto position = chunk.chunkCounter * kChunkSize;
+        while ( ( ( subtreeSize - 1 ) & position ) != 0 )
+          subtreeSize /= 2;
+
+        auto subtreeChunks = subtreeSize / kChunkSize;
+        if ( subtreeSize <= kChunkSize )
+        {
+          chunk_state c;
+          chunk_reset( c, chunk.chunkCounter );
+          chunk_update( c, pBuffer_, subtreeSize );
+
+          std::uint8_t cv[kOutSize];
+          output_chaining_value( chunk_output( c ), cv );
+          push_cv( hasher_, cv, c.chunkCounter );
+        }
+        else
+        {
+          std::uint8_t cvPair[2 * kOutSize];
+          compress_subtree_to_parent_node( pBuffer_, subtreeSize, chunk.chunkCounter, numThreads_, cvPair );
+          push_cv( hasher_, cvPair, chunk.chunkCounter );
+          push_cv( hasher_, cvPair + kOutSize, chunk.chunkCounter + subtreeChunks / 2 );
+        }
+
+        chunk.chunkCounter += subtreeChunks;
+        pBuffer_ += subtreeSize;
+        sz_ -= subtreeSize;
+      }
+
+      if ( sz_ > 0 )
+      {
+        chunk_update( chunk, pBuffer_, sz_ );
+        merge_cv_stack( hasher_, chunk.chunkCounter );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void finalize( const hasher& hasher_, std::uint8_t* pOut_, size_t outSize_ )
+    {
+      if ( hasher_.cvStackSize == 0 )
+      {
+        output_root_bytes( chunk_output( hasher_.chunk ), pOut_, outSize_ );
+        return;
+      }
+
+      // the current chunk (or the top of the stack) is merged with the stack entries from right to left
+      size_t remaining = 0;
+      output o;
+      if ( chunk_size( hasher_.chunk ) > 0 )
+      {
+        remaining = hasher_.cvStackSize;
+        o = chunk_output( hasher_.chunk );
+      }
+      else
+      {
+        remaining = hasher_.cvStackSize - 2;
+        o = parent_output( hasher_.cvStack + remaining * kOutSize );
+      }
+
+      while ( remaining > 0 )
+      {
+        --remaining;
+        std::uint8_t parentBlock[kBlockSize];
+        std::memcpy( parentBlock, hasher_.cvStack + remaining * kOutSize, kOutSize );
+        output_chaining_value( o, parentBlock + kOutSize );
+        o = parent_output( parentBlock );
+      }
+
+      output_root_bytes( o, pOut_, outSize_ );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    const char* kernel_name()
+    {
+      switch ( simd_degree() )
+      {
+        case 16:
+          return "avx512";
+        case 8:
+          return "avx2";
+        case 4:
+          return "sse4.1";
+        default:
+          return "portable";
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // hash backend
+  // the exported state is the chunk state (chaining value, counter, buffered block and number of compressed
+  // blocks) followed by the chaining value stack
+  // ---------------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    const size_t kChunkStateSize = 32 + 8 + blake3::kBlockSize + 2;
+  }
+
+  static_assert( sizeof( blake3::hasher ) <= detail::hash_backend< hash::type::blake3 >::contextSize,
+                 "context storage too small for blake3::hasher" );
+
+  static_assert( kChunkStateSize + 1 + blake3::kMaxDepth * blake3::kOutSize <= detail::maxNativeStateSize,
+                 "native state too small for blake3" );
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void detail::hash_backend< hash::type::blake3 >::init( void* pContext_ )
+  {
+    blake3::init( *static_cast< blake3::hasher* >( pContext_ ) );
+  }
+
+  void detail::hash_backend< hash::type::blake3 >::update( void* pContext_,
+                                                           const std::uint8_t* pBuffer_,
+                                                           size_t sz_ )
+  {
+    blake3::update( *static_cast< blake3::hasher* >( pContext_ ), pBuffer_, sz_ );
+  }
+
+  void detail::hash_backend< hash::type::blake3 >::final( void* pContext_, std::uint8_t* pDigest_ )
+  {
+    blake3::finalize( *static_cast< blake3::hasher* >( pContext_ ), pDigest_, digestSize );
+  }
+
+  void detail::hash_backend< hash::type::blake3 >::copy( void* pTarget_, const void* pSource_ )
+  {
+    std::memcpy( pTarget_, pSource_, sizeof( blake3::hasher ) );
+  }
+
+  size_t detail::hash_backend< hash::type::blake3 >::export_state( const void* pContext_,
+                                                                   std::uint8_t* pState_ )
+  {
+    const auto& h = *static_cast< const blake3::hasher* >( pContext_ );
+
+    for ( size_t i = 0; i < 8; ++i )
+      blake3::store_le32( pState_ + 4 * i, h.chunk.cv[i] );
+    for ( size_t i = 0; i < 8; ++i )
+      pState_[32 + i] = static_cast< std::uint8_t >( h.chunk.chunkCounter >> ( 8 * i ) );
+    std::memcpy( pState_ + 40, h.chunk.buffer, blake3::kBlockSize );
+    pState_[104] = h.chunk.bufferSize;
+    pState_[105] = h.chunk.blocksCompressed;
+
+    pState_[kChunkStateSize] = h.cvStackSize;
+    std::memcpy( pState_ + kChunkStateSize + 1, h.cvStack, h.cvStackSize * blake3::kOutSize );
+    return kChunkStateSize + 1 + h.cvStackSize * blake3::kOutSize;
+  }
+
+  void detail::hash_backend< hash::type::blake3 >::import_state( void* pContext_,
+                                                                 const std::uint8_t* pState_,
+                                                                 size_t sz_,
+                                                                 std::uint64_t inputSize_ )
+  {
+    if ( sz_ < kChunkStateSize + 1 )
+      throw exception( error::invalid_parameter, "invalid hash state" );
+
+    blake3::hasher h;
+    for ( size_t i = 0; i < 8; ++i )
+      h.chunk.cv[i] = blake3::load_le32( pState_ + 4 * i );
+    h.chunk.chunkCounter = 0;
+    for ( size_t i = 0; i < 8; ++i )
+      h.chunk.chunkCounter |= std::uint64_t( pState_[32 + i] ) << ( 8 * i );
+    std::memcpy( h.chunk.buffer, pState_ + 40, blake3::kBlockSize );
+    h.chunk.bufferSize = pState_[104];
+    h.chunk.blocksCompressed = pState_[105];
+    h.cvStackSize = pState_[kChunkStateSize];
+
+    // the position in the tree has to match the input size
+    if ( ( h.chunk.bufferSize > blake3::kBlockSize ) || ( h.cvStackSize > blake3::kMaxDepth )
+         || ( blake3::chunk_size( h.chunk ) > blake3::kChunkSize )
+         || ( h.chunk.chunkCounter * blake3::kChunkSize + blake3::chunk_size( h.chunk ) != inputSize_ )
+         || ( sz_ != kChunkStateSize + 1 + h.cvStackSize * blake3::kOutSize ) )
+      throw exception( error::invalid_parameter, "invalid hash state" );
+
+    std::memcpy( h.cvStack, pState_ + kChunkStateSize + 1, h.cvStackSize * blake3::kOutSize );
+    std::memcpy( pContext_, &h, sizeof( h ) );
+  }
+
+  void detail::hash_backend< hash::type::blake3 >::destroy( void* ) LL_NOEXCEPT
+  {
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,129 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include "../support/environment.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ll
+{
+namespace crypto
+{
+  // BLAKE3 splits the input into 1 KiB chunks, which are hashed independently into chaining values, and
+  // combines them in a binary tree (the left subtree always holds the largest power of 2 of chunks). So
+  // many chunks can be hashed at once in SIMD lanes, and large subtrees on several threads.
+
+  namespace blake3
+  {
+    const size_t kBlockSize = 64;
+    const size_t kChunkSize = 1024;
+    const size_t kOutSize = 32;    //!< the size of a chaining value and of the default digest
+    const size_t kMaxDepth = 54;   //!< the depth of the tree for 2^64 bytes of input
+    const size_t kMaxLanes = 16;   //!< the widest SIMD kernel (avx-512)
+
+    enum flags : std::uint8_t
+    {
+      chunk_start = 1 << 0,
+      chunk_end = 1 << 1,
+      parent = 1 << 2,
+      root = 1 << 3,
+    };
+
+    extern const std::uint32_t kIV[8];
+    extern const std::uint8_t kMessageSchedule[7][16];
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the state of the chunk currently being hashed
+    struct chunk_state
+    {
+      std::uint32_t cv[8];
+      std::uint64_t chunkCounter;
+      std::uint8_t buffer[kBlockSize];
+      std::uint8_t bufferSize;
+      std::uint8_t blocksCompressed;
+    };
+
+    //! the incremental hasher, the chaining values of completed subtrees wait on a stack until they can be
+    //! merged with their right sibling
+    struct hasher
+    {
+      chunk_state chunk;
+      std::uint8_t cvStackSize;
+      std::uint8_t cvStack[( kMaxDepth + 1 ) * kOutSize];
+    };
+
+    void init( hasher& hasher_ );
+
+    //! large inputs are split into subtrees that are hashed by up to numThreads_ threads
+    void update( hasher& hasher_, const std::uint8_t* pBuffer_, size_t sz_, size_t numThreads_ = 1 );
+
+    //! write the root output, the hasher isn't modified
+    void finalize( const hasher& hasher_, std::uint8_t* pOut_, size_t outSize_ );
+
+    //! the name of the hash_many kernel used on this cpu
+    const char* kernel_name();
+
+
+    // -------------------------------------------------------------------------------------------------------
+    // kernels
+    // -------------------------------------------------------------------------------------------------------
+
+    //! hash numInputs_ inputs of numBlocks_ blocks each into one chaining value per input
+    //! the counter is incremented from input to input if incrementCounter_ is set (chunks), flagsStart_ is
+    //! added for the first and flagsEnd_ for the last block of every input
+    //! the simd kernels process a multiple of their lane count and return the number of inputs processed
+    void hash_many( const std::uint8_t* const* pInputs_,
+                    size_t numInputs_,
+                    size_t numBlocks_,
+                    const std::uint32_t* pKey_,
+                    std::uint64_t counter_,
+                    bool incrementCounter_,
+                    std::uint8_t flags_,
+                    std::uint8_t flagsStart_,
+                    std::uint8_t flagsEnd_,
+                    std::uint8_t* pOut_ );
+
+#define LL_DECLARE_BLAKE3_KERNEL( name_ )                   \
+  size_t name_( const std::uint8_t* const* pInputs_,        \
+                size_t numInputs_,                          \
+                size_t numBlocks_,                          \
+                const std::uint32_t* pKey_,                 \
+                std::uint64_t counter_,                     \
+                bool incrementCounter_,                     \
+                std::uint8_t flags_,                        \
+                std::uint8_t flagsStart_,                   \
+                std::uint8_t flagsEnd_,                     \
+                std::uint8_t* pOut_ );
+
+    LL_DECLARE_BLAKE3_KERNEL( hash_many_sse41 )
+    LL_DECLARE_BLAKE3_KERNEL( hash_many_avx2 )
+#if LL_HAS_AVX512()
+    LL_DECLARE_BLAKE3_KERNEL( hash_many_avx512 )
+#endif
+
+#undef LL_DECLARE_BLAKE3_KERNEL
+  }
+
+}  // namespace crypto
+}  // namespace ll
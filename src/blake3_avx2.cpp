@@ -0,0 +1,139 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "blake3.h"
+
+#include <immintrin.h>
+
+#include <cstring>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    typedef __m256i vec_t;
+    const size_t kNumLanes = 8;
+
+    inline vec_t set1( std::uint32_t v_ ) { return _mm256_set1_epi32( static_cast< int >( v_ ) ); }
+
+    inline vec_t load( const std::uint32_t* p_ )
+    {
+      return _mm256_loadu_si256( reinterpret_cast< const vec_t* >( p_ ) );
+    }
+
+    inline void store( std::uint32_t* p_, vec_t v_ )
+    {
+      _mm256_storeu_si256( reinterpret_cast< vec_t* >( p_ ), v_ );
+    }
+
+    inline vec_t add( vec_t a_, vec_t b_ ) { return _mm256_add_epi32( a_, b_ ); }
+    inline vec_t xor_( vec_t a_, vec_t b_ ) { return _mm256_xor_si256( a_, b_ ); }
+
+    template < int n_ >
+    inline vec_t rotr( vec_t v_ )
+    {
+      return _mm256_or_si256( _mm256_srli_epi32( v_, n_ ), _mm256_slli_epi32( v_, 32 - n_ ) );
+    }
+
+    // rotations by whole bytes are a single shuffle
+    template <>
+    inline vec_t rotr< 16 >( vec_t v_ )
+    {
+      return _mm256_shuffle_epi8( v_,
+                                  _mm256_setr_epi8( 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                                    2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 ) );
+    }
+
+    template <>
+    inline vec_t rotr< 8 >( vec_t v_ )
+    {
+      return _mm256_shuffle_epi8( v_,
+                                  _mm256_setr_epi8( 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+                                                    1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12 ) );
+    }
+
+    //! 8x8 transpose of the 32bit words, in 32bit, 64bit and 128bit steps
+    inline void load_message( const std::uint8_t* const* pInputs_, size_t offset_, vec_t* pMsg_ )
+    {
+      for ( size_t i = 0; i < 16; i += 8 )
+      {
+        vec_t v[8];
+        for ( size_t lane = 0; lane < 8; ++lane )
+        {
+          auto p = pInputs_[lane] + offset_ + 4 * i;
+          v[lane] = _mm256_loadu_si256( reinterpret_cast< const vec_t* >( p ) );
+        }
+
+        vec_t t[8];
+        for ( size_t j = 0; j < 8; j += 2 )
+        {
+          t[j] = _mm256_unpacklo_epi32( v[j], v[j + 1] );
+          t[j + 1] = _mm256_unpackhi_epi32( v[j], v[j + 1] );
+        }
+
+        vec_t u[8];
+        for ( size_t j = 0; j < 8; j += 4 )
+        {
+          u[j] = _mm256_unpacklo_epi64( t[j], t[j + 2] );
+          u[j + 1] = _mm256_unpackhi_epi64( t[j], t[j + 2] );
+          u[j + 2] = _mm256_unpacklo_epi64( t[j + 1], t[j + 3] );
+          u[j + 3] = _mm256_unpackhi_epi64( t[j + 1], t[j + 3] );
+        }
+
+        for ( size_t j = 0; j < 4; ++j )
+        {
+          pMsg_[i + j] = _mm256_permute2x128_si256( u[j], u[j + 4], 0x20 );
+          pMsg_[i + j + 4] = _mm256_permute2x128_si256( u[j], u[j + 4], 0x31 );
+        }
+      }
+    }
+
+#include "blake3_kernels.h"
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t blake3::hash_many_avx2( const std::uint8_t* const* pInputs_,
+                                 size_t numInputs_,
+                                 size_t numBlocks_,
+                                 const std::uint32_t* pKey_,
+                                 std::uint64_t counter_,
+                                 bool incrementCounter_,
+                                 std::uint8_t flags_,
+                                 std::uint8_t flagsStart_,
+                                 std::uint8_t flagsEnd_,
+                                 std::uint8_t* pOut_ )
+  {
+    return b3::hash_many( pInputs_,
+                          numInputs_,
+                          numBlocks_,
+                          pKey_,
+                          counter_,
+                          incrementCounter_,
+                          flags_,
+                          flagsStart_,
+                          flagsEnd_,
+                          pOut_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
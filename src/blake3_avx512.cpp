@@ -0,0 +1,120 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "blake3.h"
+
+#if LL_HAS_AVX512()
+
+#include <immintrin.h>
+
+#include <cstring>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    typedef __m512i vec_t;
+    const size_t kNumLanes = 16;
+
+    inline vec_t set1( std::uint32_t v_ ) { return _mm512_set1_epi32( static_cast< int >( v_ ) ); }
+    inline vec_t load( const std::uint32_t* p_ ) { return _mm512_loadu_si512( p_ ); }
+    inline void store( std::uint32_t* p_, vec_t v_ ) { _mm512_storeu_si512( p_, v_ ); }
+    inline vec_t add( vec_t a_, vec_t b_ ) { return _mm512_add_epi32( a_, b_ ); }
+    inline vec_t xor_( vec_t a_, vec_t b_ ) { return _mm512_xor_si512( a_, b_ ); }
+
+    template < int n_ >
+    inline vec_t rotr( vec_t v_ )
+    {
+      return _mm512_ror_epi32( v_, n_ );
+    }
+
+    //! 16x16 transpose of the 32bit words: the 32bit and 64bit steps transpose groups of 4 inputs within
+    //! the 128bit lanes, the two 128bit lane shuffles gather the lanes of the 4 groups
+    inline void load_message( const std::uint8_t* const* pInputs_, size_t offset_, vec_t* pMsg_ )
+    {
+      vec_t v[16];
+      for ( size_t lane = 0; lane < 16; ++lane )
+        v[lane] = _mm512_loadu_si512( pInputs_[lane] + offset_ );
+
+      vec_t t[16];
+      for ( size_t j = 0; j < 16; j += 2 )
+      {
+        t[j] = _mm512_unpacklo_epi32( v[j], v[j + 1] );
+        t[j + 1] = _mm512_unpackhi_epi32( v[j], v[j + 1] );
+      }
+
+      // u[4 * group + k] holds word 4 * lane + k of the inputs of the group in its 128bit lane
+      vec_t u[16];
+      for ( size_t j = 0; j < 16; j += 4 )
+      {
+        u[j] = _mm512_unpacklo_epi64( t[j], t[j + 2] );
+        u[j + 1] = _mm512_unpackhi_epi64( t[j], t[j + 2] );
+        u[j + 2] = _mm512_unpacklo_epi64( t[j + 1], t[j + 3] );
+        u[j + 3] = _mm512_unpackhi_epi64( t[j + 1], t[j + 3] );
+      }
+
+      for ( size_t k = 0; k < 4; ++k )
+      {
+        vec_t lo01 = _mm512_shuffle_i32x4( u[k], u[k + 4], 0x44 );
+        vec_t hi01 = _mm512_shuffle_i32x4( u[k], u[k + 4], 0xee );
+        vec_t lo23 = _mm512_shuffle_i32x4( u[k + 8], u[k + 12], 0x44 );
+        vec_t hi23 = _mm512_shuffle_i32x4( u[k + 8], u[k + 12], 0xee );
+
+        pMsg_[k] = _mm512_shuffle_i32x4( lo01, lo23, 0x88 );
+        pMsg_[k + 4] = _mm512_shuffle_i32x4( lo01, lo23, 0xdd );
+        pMsg_[k + 8] = _mm512_shuffle_i32x4( hi01, hi23, 0x88 );
+        pMsg_[k + 12] = _mm512_shuffle_i32x4( hi01, hi23, 0xdd );
+      }
+    }
+
+#include "blake3_kernels.h"
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t blake3::hash_many_avx512( const std::uint8_t* const* pInputs_,
+                                   size_t numInputs_,
+                                   size_t numBlocks_,
+                                   const std::uint32_t* pKey_,
+                                   std::uint64_t counter_,
+                                   bool incrementCounter_,
+                                   std::uint8_t flags_,
+                                   std::uint8_t flagsStart_,
+                                   std::uint8_t flagsEnd_,
+                                   std::uint8_t* pOut_ )
+  {
+    return b3::hash_many( pInputs_,
+                          numInputs_,
+                          numBlocks_,
+                          pKey_,
+                          counter_,
+                          incrementCounter_,
+                          flags_,
+                          flagsStart_,
+                          flagsEnd_,
+                          pOut_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
+
+#endif  // LL_HAS_AVX512()
@@ -0,0 +1,160 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+// blake3 kernels hashing one chunk (or parent node) per SIMD lane, shared by the instruction set specific
+// translation units
+//
+// This header is meant to be included (once, inside an anonymous namespace) by a translation unit that is
+// compiled for a specific instruction set. Before including it, the translation unit has to provide
+//   - the vector type vec_t holding kNumLanes 32bit lanes
+//   - set1, load, store, add and xor_ for vec_t
+//   - rotr< n >( vec_t )
+//   - load_message( pInputs, offset, pMsg ), which transposes the 16 words of the block at offset of the
+//     first kNumLanes inputs into pMsg (word i of every input in pMsg[i])
+// Keeping everything at internal linkage ensures that the instantiations for different instruction sets
+// don't get merged by the linker.
+
+namespace b3
+{
+  inline void g( vec_t& a_, vec_t& b_, vec_t& c_, vec_t& d_, vec_t x_, vec_t y_ )
+  {
+    a_ = add( add( a_, b_ ), x_ );
+    d_ = rotr< 16 >( xor_( d_, a_ ) );
+    c_ = add( c_, d_ );
+    b_ = rotr< 12 >( xor_( b_, c_ ) );
+    a_ = add( add( a_, b_ ), y_ );
+    d_ = rotr< 8 >( xor_( d_, a_ ) );
+    c_ = add( c_, d_ );
+    b_ = rotr< 7 >( xor_( b_, c_ ) );
+  }
+
+  inline void round( vec_t* v_, const vec_t* m_, size_t r_ )
+  {
+    const auto& s = blake3::kMessageSchedule[r_];
+    g( v_[0], v_[4], v_[8], v_[12], m_[s[0]], m_[s[1]] );
+    g( v_[1], v_[5], v_[9], v_[13], m_[s[2]], m_[s[3]] );
+    g( v_[2], v_[6], v_[10], v_[14], m_[s[4]], m_[s[5]] );
+    g( v_[3], v_[7], v_[11], v_[15], m_[s[6]], m_[s[7]] );
+    g( v_[0], v_[5], v_[10], v_[15], m_[s[8]], m_[s[9]] );
+    g( v_[1], v_[6], v_[11], v_[12], m_[s[10]], m_[s[11]] );
+    g( v_[2], v_[7], v_[8], v_[13], m_[s[12]], m_[s[13]] );
+    g( v_[3], v_[4], v_[9], v_[14], m_[s[14]], m_[s[15]] );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! hash kNumLanes inputs at once, see blake3::hash_many
+  void hash_lanes( const std::uint8_t* const* pInputs_,
+                   size_t numBlocks_,
+                   const std::uint32_t* pKey_,
+                   std::uint64_t counter_,
+                   bool incrementCounter_,
+                   std::uint8_t flags_,
+                   std::uint8_t flagsStart_,
+                   std::uint8_t flagsEnd_,
+                   std::uint8_t* pOut_ )
+  {
+    vec_t h[8];
+    for ( size_t i = 0; i < 8; ++i )
+      h[i] = set1( pKey_[i] );
+
+    std::uint32_t counterLow[kNumLanes];
+    std::uint32_t counterHigh[kNumLanes];
+    for ( size_t lane = 0; lane < kNumLanes; ++lane )
+    {
+      auto counter = counter_ + ( incrementCounter_ ? lane : 0 );
+      counterLow[lane] = static_cast< std::uint32_t >( counter );
+      counterHigh[lane] = static_cast< std::uint32_t >( counter >> 32 );
+    }
+
+    std::uint8_t blockFlags = flags_ | flagsStart_;
+    for ( size_t b = 0; b < numBlocks_; ++b )
+    {
+      if ( b + 1 == numBlocks_ )
+        blockFlags |= flagsEnd_;
+
+      vec_t m[16];
+      load_message( pInputs_, b * blake3::kBlockSize, m );
+
+      vec_t v[16] = { h[0],
+                      h[1],
+                      h[2],
+                      h[3],
+                      h[4],
+                      h[5],
+                      h[6],
+                      h[7],
+                      set1( blake3::kIV[0] ),
+                      set1( blake3::kIV[1] ),
+                      set1( blake3::kIV[2] ),
+                      set1( blake3::kIV[3] ),
+                      load( counterLow ),
+                      load( counterHigh ),
+                      set1( static_cast< std::uint32_t >( blake3::kBlockSize ) ),
+                      set1( blockFlags ) };
+
+      for ( size_t r = 0; r < 7; ++r )
+        round( v, m, r );
+
+      for ( size_t i = 0; i < 8; ++i )
+        h[i] = xor_( v[i], v[i + 8] );
+
+      blockFlags = flags_;
+    }
+
+    // the chaining values are tiny compared to the input, so they are transposed back in memory
+    std::uint32_t words[8][kNumLanes];
+    for ( size_t i = 0; i < 8; ++i )
+      store( words[i], h[i] );
+
+    for ( size_t lane = 0; lane < kNumLanes; ++lane )
+      for ( size_t i = 0; i < 8; ++i )
+        std::memcpy( pOut_ + lane * blake3::kOutSize + 4 * i, &words[i][lane], 4 );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t hash_many( const std::uint8_t* const* pInputs_,
+                    size_t numInputs_,
+                    size_t numBlocks_,
+                    const std::uint32_t* pKey_,
+                    std::uint64_t counter_,
+                    bool incrementCounter_,
+                    std::uint8_t flags_,
+                    std::uint8_t flagsStart_,
+                    std::uint8_t flagsEnd_,
+                    std::uint8_t* pOut_ )
+  {
+    size_t done = 0;
+    for ( ; numInputs_ - done >= kNumLanes; done += kNumLanes )
+    {
+      hash_lanes( pInputs_ + done,
+                  numBlocks_,
+                  pKey_,
+                  counter_ + ( incrementCounter_ ? done : 0 ),
+                  incrementCounter_,
+                  flags_,
+                  flagsStart_,
+                  flagsEnd_,
+                  pOut_ + done * blake3::kOutSize );
+    }
+    return done;
+  }
+}
@@ -0,0 +1,120 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "blake3.h"
+
+#include <smmintrin.h>
+
+#include <cstring>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    typedef __m128i vec_t;
+    const size_t kNumLanes = 4;
+
+    inline vec_t set1( std::uint32_t v_ ) { return _mm_set1_epi32( static_cast< int >( v_ ) ); }
+
+    inline vec_t load( const std::uint32_t* p_ )
+    {
+      return _mm_loadu_si128( reinterpret_cast< const vec_t* >( p_ ) );
+    }
+
+    inline void store( std::uint32_t* p_, vec_t v_ )
+    {
+      _mm_storeu_si128( reinterpret_cast< vec_t* >( p_ ), v_ );
+    }
+
+    inline vec_t add( vec_t a_, vec_t b_ ) { return _mm_add_epi32( a_, b_ ); }
+    inline vec_t xor_( vec_t a_, vec_t b_ ) { return _mm_xor_si128( a_, b_ ); }
+
+    template < int n_ >
+    inline vec_t rotr( vec_t v_ )
+    {
+      return _mm_or_si128( _mm_srli_epi32( v_, n_ ), _mm_slli_epi32( v_, 32 - n_ ) );
+    }
+
+    // rotations by whole bytes are a single shuffle
+    template <>
+    inline vec_t rotr< 16 >( vec_t v_ )
+    {
+      return _mm_shuffle_epi8( v_, _mm_setr_epi8( 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 ) );
+    }
+
+    template <>
+    inline vec_t rotr< 8 >( vec_t v_ )
+    {
+      return _mm_shuffle_epi8( v_, _mm_setr_epi8( 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12 ) );
+    }
+
+    inline void load_message( const std::uint8_t* const* pInputs_, size_t offset_, vec_t* pMsg_ )
+    {
+      for ( size_t i = 0; i < 16; i += 4 )
+      {
+        vec_t a = _mm_loadu_si128( reinterpret_cast< const vec_t* >( pInputs_[0] + offset_ + 4 * i ) );
+        vec_t b = _mm_loadu_si128( reinterpret_cast< const vec_t* >( pInputs_[1] + offset_ + 4 * i ) );
+        vec_t c = _mm_loadu_si128( reinterpret_cast< const vec_t* >( pInputs_[2] + offset_ + 4 * i ) );
+        vec_t d = _mm_loadu_si128( reinterpret_cast< const vec_t* >( pInputs_[3] + offset_ + 4 * i ) );
+
+        vec_t ab01 = _mm_unpacklo_epi32( a, b );
+        vec_t ab23 = _mm_unpackhi_epi32( a, b );
+        vec_t cd01 = _mm_unpacklo_epi32( c, d );
+        vec_t cd23 = _mm_unpackhi_epi32( c, d );
+
+        pMsg_[i] = _mm_unpacklo_epi64( ab01, cd01 );
+        pMsg_[i + 1] = _mm_unpackhi_epi64( ab01, cd01 );
+        pMsg_[i + 2] = _mm_unpacklo_epi64( ab23, cd23 );
+        pMsg_[i + 3] = _mm_unpackhi_epi64( ab23, cd23 );
+      }
+    }
+
+#include "blake3_kernels.h"
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t blake3::hash_many_sse41( const std::uint8_t* const* pInputs_,
+                                  size_t numInputs_,
+                                  size_t numBlocks_,
+                                  const std::uint32_t* pKey_,
+                                  std::uint64_t counter_,
+                                  bool incrementCounter_,
+                                  std::uint8_t flags_,
+                                  std::uint8_t flagsStart_,
+                                  std::uint8_t flagsEnd_,
+                                  std::uint8_t* pOut_ )
+  {
+    return b3::hash_many( pInputs_,
+                          numInputs_,
+                          numBlocks_,
+                          pKey_,
+                          counter_,
+                          incrementCounter_,
+                          flags_,
+                          flagsStart_,
+                          flagsEnd_,
+                          pOut_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,444 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/chunker.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "crypto/exception.h"
+#include "generator_pool.h"
+#include "processing_block.h"
+#include "read_ahead_reader.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    //! the seed of the gear table (part of the chunk format)
+    const std::uint64_t kGearSeed = 0x6c6c5f6372797074;
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the random values of the gear rolling hash, generated with splitmix64
+    struct gear_table
+    {
+      gear_table()
+      {
+        std::uint64_t state = kGearSeed;
+        for ( auto& v : values )
+        {
+          state += 0x9e3779b97f4a7c15;
+          std::uint64_t z = state;
+          z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9;
+          z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111eb;
+          v = z ^ ( z >> 31 );
+        }
+      }
+
+      std::uint64_t values[256];
+    };
+
+    const std::uint64_t* get_gear_table()
+    {
+      static const gear_table s_table;
+      return s_table.values;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the topmost numBits_ bits, they depend on the longest history of input bytes
+    std::uint64_t top_bits_mask( unsigned numBits_ )
+    {
+      return ~std::uint64_t( 0 ) << ( 64 - numBits_ );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the boundary detection of FastCDC, fed segment by segment (see chunker.h for the algorithm)
+    class chunk_scanner
+    {
+    public:
+      chunk_scanner( const chunker_config& cfg_ )
+        : m_minSize( cfg_.minSize )
+        , m_avgSize( cfg_.avgSize )
+        , m_maxSize( cfg_.maxSize )
+        , m_pGear( get_gear_table() )
+      {
+        if ( ( cfg_.minSize == 0 ) || ( cfg_.avgSize < cfg_.minSize ) || ( cfg_.maxSize < cfg_.avgSize )
+             || ( cfg_.avgSize < 64 ) )
+          throw exception( error::invalid_parameter, "invalid chunk sizes" );
+
+        unsigned bits = 0;
+        while ( ( size_t( 2 ) << bits ) <= cfg_.avgSize )
+          ++bits;
+
+        m_strictMask = top_bits_mask( bits + 2 );
+        m_looseMask = top_bits_mask( bits - 2 );
+      }
+
+      //! advance the current chunk over the segment, returns the number of bytes of the segment belonging
+      //! to the chunk, complete_ is set if the chunk ends with them
+      size_t advance( const std::uint8_t* pData_, size_t sz_, bool& complete_ )
+      {
+        complete_ = false;
+        size_t used = 0;
+
+        // the first minSize bytes can't contain a boundary, so they are skipped
+        if ( m_position < m_minSize )
+        {
+          auto skip = std::min( sz_, m_minSize - m_position );
+          used += skip;
+          m_position += skip;
+        }
+
+        // normalized chunking: a strict mask below the average size, a loose one above
+        if ( ( used < sz_ ) && ( m_position < m_avgSize ) )
+        {
+          auto len = std::min( sz_ - used, m_avgSize - m_position );
+          auto i = find( pData_ + used, len, m_strictMask );
+          if ( i < len )
+            return finish( used + i + 1, complete_ );
+
+          used += len;
+          m_position += len;
+        }
+
+        if ( ( used < sz_ ) && ( m_position < m_maxSize ) )
+        {
+          auto len = std::min( sz_ - used, m_maxSize - m_position );
+          auto i = find( pData_ + used, len, m_looseMask );
+          if ( i < len )
+            return finish( used + i + 1, complete_ );
+
+          used += len;
+          m_position += len;
+        }
+
+        if ( m_position == m_maxSize )
+          return finish( used, complete_ );
+
+        return used;
+      }
+
+    private:
+      //! the gear table lookups form a serial dependency chain, a vectorized scan didn't beat this loop
+      size_t find( const std::uint8_t* pData_, size_t sz_, std::uint64_t mask_ )
+      {
+        for ( size_t i = 0; i < sz_; ++i )
+        {
+          m_fingerprint = ( m_fingerprint << 1 ) + m_pGear[pData_[i]];
+          if ( !( m_fingerprint & mask_ ) )
+            return i;
+        }
+        return sz_;
+      }
+
+      size_t finish( size_t used_, bool& complete_ )
+      {
+        complete_ = true;
+        m_position = 0;
+        m_fingerprint = 0;
+        return used_;
+      }
+
+      size_t m_minSize;
+      size_t m_avgSize;
+      size_t m_maxSize;
+      std::uint64_t m_strictMask = 0;
+      std::uint64_t m_looseMask = 0;
+      const std::uint64_t* m_pGear;
+
+      size_t m_position = 0;  //!< the number of bytes of the current chunk scanned so far
+      std::uint64_t m_fingerprint = 0;
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the chunks of a buffer, the boundaries are detected on the calling thread while the worker threads
+    //! hash the chunks found so far
+    std::vector< chunk > get_chunks_overlapped( const std::uint8_t* pBuffer_,
+                                                size_t szBufferInBytes_,
+                                                const chunker_config& cfg_ )
+    {
+      chunk_scanner scanner( cfg_ );
+
+      // a deque keeps the references stable while chunks are appended
+      std::deque< chunk > chunks;
+      size_t nextToHash = 0;
+      bool detectionDone = false;
+      std::mutex mutex;
+      std::condition_variable chunkAvailable;
+
+      std::exception_ptr pError;
+
+      auto worker = [&]()
+      {
+        try
+        {
+          for ( ;; )
+          {
+            chunk* pChunk = nullptr;
+            {
+              std::unique_lock< std::mutex > lock( mutex );
+              chunkAvailable.wait( lock, [&]() { return detectionDone || ( nextToHash < chunks.size() ); } );
+              if ( nextToHash == chunks.size() )
+                return;
+              pChunk = &chunks[nextToHash++];
+            }
+
+            pooled_hash_generator calculator( cfg_.hashType );
+            calculator->add_data( pBuffer_ + pChunk->offset, static_cast< size_t >( pChunk->size ) );
+            pChunk->chunkDigest = calculator->retrieve_digest();
+          }
+        }
+        catch ( ... )
+        {
+          std::lock_guard< std::mutex > lock( mutex );
+          if ( !pError )
+            pError = std::current_exception();
+          nextToHash = chunks.size();
+        }
+      };
+
+      std::vector< std::thread > threads;
+      for ( size_t i = 0; i < cfg_.numHashThreads; ++i )
+        threads.emplace_back( worker );
+
+      size_t offset = 0;
+      while ( offset < szBufferInBytes_ )
+      {
+        bool complete = false;
+        auto sz = scanner.advance( pBuffer_ + offset, szBufferInBytes_ - offset, complete );
+
+        chunk c;
+        c.offset = offset;
+        c.size = sz;
+        {
+          std::lock_guard< std::mutex > lock( mutex );
+          chunks.push_back( c );
+        }
+        chunkAvailable.notify_one();
+        offset += sz;
+      }
+
+      {
+        std::lock_guard< std::mutex > lock( mutex );
+        detectionDone = true;
+      }
+      chunkAvailable.notify_all();
+
+      for ( auto& t : threads )
+        t.join();
+
+      if ( pError )
+        std::rethrow_exception( pError );
+
+      return std::vector< chunk >( chunks.begin(), chunks.end() );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // content_chunker::impl
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the current chunk is hashed piece by piece right after its boundary detection, while it is in the cache
+  class content_chunker::impl
+  {
+  public:
+    impl( const chunker_config& cfg_, chunk_handler onChunk_ )
+      : m_scanner( cfg_ )
+      , m_generator( cfg_.hashType )
+      , m_onChunk( onChunk_ )
+    {
+    }
+
+    void add_data( const std::uint8_t* pBuffer_, size_t sz_ )
+    {
+      while ( sz_ > 0 )
+      {
+        bool complete = false;
+        auto used = m_scanner.advance( pBuffer_, sz_, complete );
+
+        m_generator.add_data( pBuffer_, used );
+        m_size += used;
+        pBuffer_ += used;
+        sz_ -= used;
+
+        if ( complete )
+          emit();
+      }
+    }
+
+    void finish()
+    {
+      if ( m_size > 0 )
+        emit();
+    }
+
+  private:
+    void emit()
+    {
+      chunk c;
+      c.offset = m_offset;
+      c.size = m_size;
+      c.chunkDigest = m_generator.retrieve_digest();
+
+      m_offset += m_size;
+      m_size = 0;
+      m_generator.reset();
+
+      m_onChunk( c );
+    }
+
+    chunk_scanner m_scanner;
+    hash_generator m_generator;
+    chunk_handler m_onChunk;
+
+    std::uint64_t m_offset = 0;  //!< the input position of the current chunk
+    std::uint64_t m_size = 0;    //!< the number of bytes of the current chunk so far
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // content_chunker Implementation
+  // ---------------------------------------------------------------------------------------------------------
+
+  content_chunker::content_chunker( const chunker_config& cfg_, chunk_handler onChunk_ )
+    : m_pImpl( new impl( cfg_, onChunk_ ) )
+  {
+  }
+
+  content_chunker::~content_chunker() = default;
+
+  content_chunker::content_chunker( content_chunker&& other_ ) : m_pImpl( std::move( other_.m_pImpl ) )
+  {
+  }
+
+  content_chunker& content_chunker::operator=( content_chunker&& other_ )
+  {
+    m_pImpl = std::move( other_.m_pImpl );
+    return *this;
+  }
+
+  void content_chunker::add_data( const std::uint8_t* pBuffer_, size_t sz_ )
+  {
+    if ( !pBuffer_ && ( sz_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    m_pImpl->add_data( pBuffer_, sz_ );
+  }
+
+  void content_chunker::finish()
+  {
+    m_pImpl->finish();
+  }
+
+
+  // -----------------------------------------------------------------------------------------------------------
+  // chunking functions implementation
+  // -----------------------------------------------------------------------------------------------------------
+
+  std::vector< chunk > get_chunks( const void* pBuffer_, size_t szBufferInBytes_, const chunker_config& cfg_ )
+  {
+    if ( !pBuffer_ && ( szBufferInBytes_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    if ( cfg_.hashType == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    auto pBuffer = static_cast< const std::uint8_t* >( pBuffer_ );
+    if ( cfg_.numHashThreads > 0 )
+      return get_chunks_overlapped( pBuffer, szBufferInBytes_, cfg_ );
+
+    std::vector< chunk > chunks;
+    content_chunker chunker( cfg_, [&]( const chunk& c_ ) { chunks.push_back( c_ ); } );
+    chunker.add_data( pBuffer, szBufferInBytes_ );
+    chunker.finish();
+    return chunks;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< chunk > get_chunks( std::istream& stream_, const chunker_config& cfg_ )
+  {
+    if ( !stream_ )
+      throw exception( error::invalid_parameter, "invalid stream" );
+
+    if ( cfg_.hashType == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    std::vector< chunk > chunks;
+    content_chunker chunker( cfg_, [&]( const chunk& c_ ) { chunks.push_back( c_ ); } );
+
+    const auto& streamCfg = cfg_.streamConfig;
+    auto blockSize = get_processing_block_size( cfg_.hashType, hash::source::stream, streamCfg );
+    if ( streamCfg.numReadAheadBuffers > 0 )
+    {
+      read_ahead_reader reader( stream_, streamCfg.numReadAheadBuffers, blockSize );
+
+      const std::uint8_t* pData = nullptr;
+      size_t sz = 0;
+      while ( reader.acquire( pData, sz ) )
+      {
+        chunker.add_data( pData, sz );
+        reader.release();
+      }
+    }
+    else
+    {
+      pooled_block_buffer data( blockSize );
+      while ( stream_.good() )
+      {
+        stream_.read( reinterpret_cast< char* >( data.data() ), data.size() );
+        chunker.add_data( data.data(), static_cast< size_t >( stream_.gcount() ) );
+      }
+    }
+
+    chunker.finish();
+    return chunks;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< chunk > get_file_chunks( const std::string& path_, const chunker_config& cfg_ )
+  {
+    std::ifstream file( path_, std::ios::in | std::ios::binary );
+    if ( !file )
+      throw exception( error::invalid_parameter, "can't open file " + path_ );
+
+    return get_chunks( file, cfg_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,359 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/codec.h"
+
+#include "crypto/exception.h"
+#include "codec_kernels.h"
+#include "cpu_features.h"
+#include "internal_utils.h"
+
+#include "../support/debug_helpers.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    const char kHexTable[17] = "0123456789abcdef";
+    const char kBase64Table[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const char kBase64UrlTable[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+
+    inline int hex_value( char c_ )
+    {
+      if ( ( c_ >= '0' ) && ( c_ <= '9' ) )
+        return c_ - '0';
+      if ( ( c_ >= 'a' ) && ( c_ <= 'f' ) )
+        return c_ - 'a' + 10;
+      if ( ( c_ >= 'A' ) && ( c_ <= 'F' ) )
+        return c_ - 'A' + 10;
+      return -1;
+    }
+
+    inline std::uint32_t base64_value( char c_, bool url_ )
+    {
+      if ( ( c_ >= 'A' ) && ( c_ <= 'Z' ) )
+        return static_cast< std::uint32_t >( c_ - 'A' );
+      if ( ( c_ >= 'a' ) && ( c_ <= 'z' ) )
+        return static_cast< std::uint32_t >( c_ - 'a' + 26 );
+      if ( ( c_ >= '0' ) && ( c_ <= '9' ) )
+        return static_cast< std::uint32_t >( c_ - '0' + 52 );
+      if ( c_ == ( url_ ? '-' : '+' ) )
+        return 62;
+      if ( c_ == ( url_ ? '_' : '/' ) )
+        return 63;
+
+      throw exception( error::invalid_parameter, "invalid base64 character" );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    // the AVX2 kernels process the bulk, the SSSE3 kernels the remaining 16 byte blocks
+
+    size_t hex_encode_simd( const std::uint8_t* pIn_, size_t szIn_, char* pOut_ )
+    {
+      const auto& features = get_cpu_features();
+
+      size_t consumed = 0;
+      if ( features.avx2 )
+        consumed = hex_encode_avx2( pIn_, szIn_, pOut_ );
+      if ( features.ssse3 )
+        consumed += hex_encode_ssse3( pIn_ + consumed, szIn_ - consumed, pOut_ + 2 * consumed );
+      return consumed;
+    }
+
+    size_t hex_decode_simd( const char* pIn_, size_t szIn_, std::uint8_t* pOut_ )
+    {
+      const auto& features = get_cpu_features();
+
+      size_t consumed = 0;
+      if ( features.avx2 )
+        consumed = hex_decode_avx2( pIn_, szIn_, pOut_ );
+      if ( features.ssse3 )
+        consumed += hex_decode_ssse3( pIn_ + consumed, szIn_ - consumed, pOut_ + consumed / 2 );
+      return consumed;
+    }
+
+    size_t base64_encode_simd( const std::uint8_t* pIn_, size_t szIn_, char* pOut_, bool url_ )
+    {
+      const auto& features = get_cpu_features();
+
+      size_t consumed = 0;
+      if ( features.avx2 )
+        consumed = base64_encode_avx2( pIn_, szIn_, pOut_, url_ );
+      if ( features.ssse3 )
+        consumed +=
+          base64_encode_ssse3( pIn_ + consumed, szIn_ - consumed, pOut_ + ( consumed / 3 ) * 4, url_ );
+      return consumed;
+    }
+
+    size_t base64_decode_simd( const char* pIn_, size_t szIn_, std::uint8_t* pOut_, bool url_ )
+    {
+      const auto& features = get_cpu_features();
+
+      size_t consumed = 0;
+      if ( features.avx2 )
+        consumed = base64_decode_avx2( pIn_, szIn_, pOut_, url_ );
+      if ( features.ssse3 )
+        consumed +=
+          base64_decode_ssse3( pIn_ + consumed, szIn_ - consumed, pOut_ + ( consumed / 4 ) * 3, url_ );
+      return consumed;
+    }
+  }
+
+
+  // -----------------------------------------------------------------------------------------------------------
+  // hex
+  // -----------------------------------------------------------------------------------------------------------
+
+  void hex_encode( const void* pIn_, size_t szIn_, char* pOut_ )
+  {
+    LL_PRECONDITION( ( ( pIn_ != nullptr ) && ( pOut_ != nullptr ) ) || ( szIn_ == 0 ) );
+
+    auto pIn = static_cast< const std::uint8_t* >( pIn_ );
+    auto consumed = hex_encode_simd( pIn, szIn_, pOut_ );
+
+    for ( size_t i = consumed; i < szIn_; ++i )
+    {
+      pOut_[2 * i] = kHexTable[( pIn[i] >> 4 ) & 0xf];
+      pOut_[2 * i + 1] = kHexTable[pIn[i] & 0xf];
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t hex_decode( const char* pIn_, size_t szIn_, void* pOut_ )
+  {
+    if ( ( !pIn_ || !pOut_ ) && ( szIn_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    if ( szIn_ % 2 != 0 )
+      throw exception( error::invalid_parameter, "invalid hex string length" );
+
+    auto pOut = static_cast< std::uint8_t* >( pOut_ );
+    auto consumed = hex_decode_simd( pIn_, szIn_, pOut );
+
+    for ( size_t i = consumed; i < szIn_; i += 2 )
+    {
+      auto hi = hex_value( pIn_[i] );
+      auto lo = hex_value( pIn_[i + 1] );
+      if ( ( hi < 0 ) || ( lo < 0 ) )
+        throw exception( error::invalid_parameter, "invalid hex character" );
+
+      pOut[i / 2] = static_cast< std::uint8_t >( ( hi << 4 ) | lo );
+    }
+
+    return szIn_ / 2;
+  }
+
+
+  // -----------------------------------------------------------------------------------------------------------
+  // base64
+  // -----------------------------------------------------------------------------------------------------------
+
+  size_t base64_encoded_size( size_t szIn_, base64_alphabet alphabet_ ) LL_NOEXCEPT
+  {
+    if ( alphabet_ == base64_alphabet::url )
+      return ( szIn_ / 3 ) * 4 + ( ( szIn_ % 3 ) ? ( szIn_ % 3 ) + 1 : 0 );
+
+    return ( ( szIn_ + 2 ) / 3 ) * 4;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t base64_encode( const void* pIn_, size_t szIn_, char* pOut_, base64_alphabet alphabet_ )
+  {
+    LL_PRECONDITION( ( ( pIn_ != nullptr ) && ( pOut_ != nullptr ) ) || ( szIn_ == 0 ) );
+
+    const bool url = ( alphabet_ == base64_alphabet::url );
+    const char* pTable = url ? kBase64UrlTable : kBase64Table;
+
+    auto pIn = static_cast< const std::uint8_t* >( pIn_ );
+    auto consumed = base64_encode_simd( pIn, szIn_, pOut_, url );
+
+    auto pOut = pOut_ + ( consumed / 3 ) * 4;
+    size_t i = consumed;
+    for ( ; i + 3 <= szIn_; i += 3 )
+    {
+      std::uint32_t v = ( std::uint32_t( pIn[i] ) << 16 ) | ( std::uint32_t( pIn[i + 1] ) << 8 ) | pIn[i + 2];
+      *pOut++ = pTable[( v >> 18 ) & 0x3f];
+      *pOut++ = pTable[( v >> 12 ) & 0x3f];
+      *pOut++ = pTable[( v >> 6 ) & 0x3f];
+      *pOut++ = pTable[v & 0x3f];
+    }
+
+    const size_t remaining = szIn_ - i;
+    if ( remaining > 0 )
+    {
+      std::uint32_t v = std::uint32_t( pIn[i] ) << 16;
+      if ( remaining > 1 )
+        v |= std::uint32_t( pIn[i + 1] ) << 8;
+
+      *pOut++ = pTable[( v >> 18 ) & 0x3f];
+      *pOut++ = pTable[( v >> 12 ) & 0x3f];
+      if ( remaining > 1 )
+        *pOut++ = pTable[( v >> 6 ) & 0x3f];
+      else if ( !url )
+        *pOut++ = '=';
+      if ( !url )
+        *pOut++ = '=';
+    }
+
+    return static_cast< size_t >( pOut - pOut_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t base64_decode( const char* pIn_, size_t szIn_, void* pOut_, base64_alphabet alphabet_ )
+  {
+    if ( ( !pIn_ || !pOut_ ) && ( szIn_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    const bool url = ( alphabet_ == base64_alphabet::url );
+
+    // strip the padding, it's only valid for complete quads
+    size_t sz = szIn_;
+    if ( ( sz % 4 == 0 ) && ( sz > 0 ) && ( pIn_[sz - 1] == '=' ) )
+    {
+      --sz;
+      if ( pIn_[sz - 1] == '=' )
+        --sz;
+    }
+
+    if ( sz % 4 == 1 )
+      throw exception( error::invalid_parameter, "invalid base64 string length" );
+
+    auto pOut = static_cast< std::uint8_t* >( pOut_ );
+    auto consumed = base64_decode_simd( pIn_, sz, pOut, url );
+    pOut += ( consumed / 4 ) * 3;
+
+    size_t i = consumed;
+    for ( ; i + 4 <= sz; i += 4 )
+    {
+      std::uint32_t v = ( base64_value( pIn_[i], url ) << 18 ) | ( base64_value( pIn_[i + 1], url ) << 12 )
+                        | ( base64_value( pIn_[i + 2], url ) << 6 ) | base64_value( pIn_[i + 3], url );
+      *pOut++ = static_cast< std::uint8_t >( v >> 16 );
+      *pOut++ = static_cast< std::uint8_t >( v >> 8 );
+      *pOut++ = static_cast< std::uint8_t >( v );
+    }
+
+    const size_t remaining = sz - i;
+    if ( remaining > 0 )
+    {
+      std::uint32_t v = ( base64_value( pIn_[i], url ) << 18 ) | ( base64_value( pIn_[i + 1], url ) << 12 );
+      if ( remaining > 2 )
+        v |= base64_value( pIn_[i + 2], url ) << 6;
+
+      // reject non-canonical encodings (the unused bits of the last character have to be zero)
+      if ( ( v & ( ( remaining > 2 ) ? 0xff : 0xffff ) ) != 0 )
+        throw exception( error::invalid_parameter, "invalid base64 string" );
+
+      *pOut++ = static_cast< std::uint8_t >( v >> 16 );
+      if ( remaining > 2 )
+        *pOut++ = static_cast< std::uint8_t >( v >> 8 );
+    }
+
+    return static_cast< size_t >( pOut - static_cast< std::uint8_t* >( pOut_ ) );
+  }
+
+
+  // -----------------------------------------------------------------------------------------------------------
+  // bulk variants
+  // -----------------------------------------------------------------------------------------------------------
+
+  void hex_encode( const digest* pDigests_, size_t numDigests_, char* pOut_, size_t stride_ )
+  {
+    for ( size_t i = 0; i < numDigests_; ++i )
+    {
+      LL_PRECONDITION( hex_encoded_size( pDigests_[i].size ) <= stride_ );
+      hex_encode( pDigests_[i].data(), pDigests_[i].size, pOut_ + i * stride_ );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void hex_decode( const char* pIn_, size_t stride_, size_t numDigests_, hash::type type_, digest* pOut_ )
+  {
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    const auto digestSize = digest_size( type_ );
+    const auto encodedSize = hex_encoded_size( digestSize );
+    if ( stride_ < encodedSize )
+      throw exception( error::invalid_parameter, "invalid stride" );
+
+    for ( size_t i = 0; i < numDigests_; ++i )
+    {
+      pOut_[i].hashType = type_;
+      pOut_[i].size = static_cast< std::uint8_t >( digestSize );
+      hex_decode( pIn_ + i * stride_, encodedSize, pOut_[i].bytes.data() );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void base64_encode( const digest* pDigests_,
+                      size_t numDigests_,
+                      char* pOut_,
+                      size_t stride_,
+                      base64_alphabet alphabet_ )
+  {
+    for ( size_t i = 0; i < numDigests_; ++i )
+    {
+      LL_PRECONDITION( base64_encoded_size( pDigests_[i].size, alphabet_ ) <= stride_ );
+      base64_encode( pDigests_[i].data(), pDigests_[i].size, pOut_ + i * stride_, alphabet_ );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void base64_decode( const char* pIn_,
+                      size_t stride_,
+                      size_t numDigests_,
+                      hash::type type_,
+                      digest* pOut_,
+                      base64_alphabet alphabet_ )
+  {
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    const auto digestSize = digest_size( type_ );
+    const auto encodedSize = base64_encoded_size( digestSize, alphabet_ );
+    if ( stride_ < encodedSize )
+      throw exception( error::invalid_parameter, "invalid stride" );
+
+    for ( size_t i = 0; i < numDigests_; ++i )
+    {
+      pOut_[i].hashType = type_;
+      pOut_[i].size = static_cast< std::uint8_t >( digestSize );
+      base64_decode( pIn_ + i * stride_, encodedSize, pOut_[i].bytes.data(), alphabet_ );
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
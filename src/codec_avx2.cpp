@@ -0,0 +1,233 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "codec_kernels.h"
+
+#include <immintrin.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    inline __m256i in_range( __m256i v_, char lo_, char hi_ )
+    {
+      return _mm256_and_si256( _mm256_cmpgt_epi8( v_, _mm256_set1_epi8( static_cast< char >( lo_ - 1 ) ) ),
+                               _mm256_cmpgt_epi8( _mm256_set1_epi8( static_cast< char >( hi_ + 1 ) ), v_ ) );
+    }
+
+    inline __m256i select( __m256i mask_, char v_ )
+    {
+      return _mm256_and_si256( mask_, _mm256_set1_epi8( v_ ) );
+    }
+
+    inline __m256i load( const void* p_ )
+    {
+      return _mm256_loadu_si256( reinterpret_cast< const __m256i* >( p_ ) );
+    }
+
+    inline void store( void* p_, __m256i v_ )
+    {
+      _mm256_storeu_si256( reinterpret_cast< __m256i* >( p_ ), v_ );
+    }
+
+    //! the same 16 byte table in both 128 bit lanes (the byte shuffles work per lane)
+    inline __m256i lane_table( __m128i table_ ) { return _mm256_broadcastsi128_si256( table_ ); }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! translate hex characters to their values, returns false if a character is not a hex digit
+    inline bool hex_values( __m256i chars_, __m256i& values_ )
+    {
+      const __m256i digit = in_range( chars_, '0', '9' );
+      const __m256i lower = in_range( chars_, 'a', 'f' );
+      const __m256i upper = in_range( chars_, 'A', 'F' );
+
+      const __m256i valid = _mm256_or_si256( digit, _mm256_or_si256( lower, upper ) );
+      if ( _mm256_movemask_epi8( valid ) != -1 )
+        return false;
+
+      const __m256i shift = _mm256_or_si256(
+        select( digit, -'0' ), _mm256_or_si256( select( lower, 10 - 'a' ), select( upper, 10 - 'A' ) ) );
+      values_ = _mm256_add_epi8( chars_, shift );
+      return true;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! translate 6 bit values to base64 characters
+    inline __m256i base64_chars( __m256i values_, bool url_ )
+    {
+      // reduce the values to an index into the shift table:
+      // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+      __m256i index = _mm256_subs_epu8( values_, _mm256_set1_epi8( 51 ) );
+      index = _mm256_or_si256( index, select( _mm256_cmpgt_epi8( _mm256_set1_epi8( 26 ), values_ ), 13 ) );
+
+      const char c62 = url_ ? '-' : '+';
+      const char c63 = url_ ? '_' : '/';
+      const __m256i shiftTable =
+        lane_table( _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                   '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                   static_cast< char >( c62 - 62 ), static_cast< char >( c63 - 63 ),
+                                   'A', 0, 0 ) );
+
+      return _mm256_add_epi8( values_, _mm256_shuffle_epi8( shiftTable, index ) );
+    }
+
+
+    //! translate base64 characters to 6 bit values, returns false if a character is not in the alphabet
+    inline bool base64_values( __m256i chars_, bool url_, __m256i& values_ )
+    {
+      const char c62 = url_ ? '-' : '+';
+      const char c63 = url_ ? '_' : '/';
+
+      const __m256i upper = in_range( chars_, 'A', 'Z' );
+      const __m256i lower = in_range( chars_, 'a', 'z' );
+      const __m256i digit = in_range( chars_, '0', '9' );
+      const __m256i is62 = _mm256_cmpeq_epi8( chars_, _mm256_set1_epi8( c62 ) );
+      const __m256i is63 = _mm256_cmpeq_epi8( chars_, _mm256_set1_epi8( c63 ) );
+
+      const __m256i valid = _mm256_or_si256( _mm256_or_si256( upper, lower ),
+                                             _mm256_or_si256( digit, _mm256_or_si256( is62, is63 ) ) );
+      if ( _mm256_movemask_epi8( valid ) != -1 )
+        return false;
+
+      const __m256i shift = _mm256_or_si256(
+        _mm256_or_si256( select( upper, -'A' ), select( lower, 26 - 'a' ) ),
+        _mm256_or_si256( select( digit, 52 - '0' ),
+                         _mm256_or_si256( select( is62, static_cast< char >( 62 - c62 ) ),
+                                          select( is63, static_cast< char >( 63 - c63 ) ) ) ) );
+      values_ = _mm256_add_epi8( chars_, shift );
+      return true;
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t hex_encode_avx2( const std::uint8_t* pIn_, size_t szIn_, char* pOut_ )
+  {
+    const __m256i table = lane_table( _mm_setr_epi8( '0', '1', '2', '3', '4', '5', '6', '7',
+                                                     '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' ) );
+    const __m256i mask = _mm256_set1_epi8( 0x0f );
+
+    size_t i = 0;
+    for ( ; i + 32 <= szIn_; i += 32 )
+    {
+      const __m256i v = load( pIn_ + i );
+      const __m256i hi = _mm256_shuffle_epi8( table, _mm256_and_si256( _mm256_srli_epi16( v, 4 ), mask ) );
+      const __m256i lo = _mm256_shuffle_epi8( table, _mm256_and_si256( v, mask ) );
+
+      // the unpacks work per lane: bytes 0..7 | 16..23 and 8..15 | 24..31
+      const __m256i a = _mm256_unpacklo_epi8( hi, lo );
+      const __m256i b = _mm256_unpackhi_epi8( hi, lo );
+
+      store( pOut_ + 2 * i, _mm256_permute2x128_si256( a, b, 0x20 ) );
+      store( pOut_ + 2 * i + 32, _mm256_permute2x128_si256( a, b, 0x31 ) );
+    }
+
+    return i;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t hex_decode_avx2( const char* pIn_, size_t szIn_, std::uint8_t* pOut_ )
+  {
+    // combines the pairs of nibbles (the first one is the high nibble)
+    const __m256i weights = _mm256_set1_epi16( 0x0110 );
+
+    size_t i = 0;
+    for ( ; i + 64 <= szIn_; i += 64 )
+    {
+      __m256i v0, v1;
+      if ( !hex_values( load( pIn_ + i ), v0 ) || !hex_values( load( pIn_ + i + 32 ), v1 ) )
+        break;
+
+      // the pack works per lane, so the 64 bit groups have to be reordered afterwards
+      const __m256i bytes =
+        _mm256_packus_epi16( _mm256_maddubs_epi16( v0, weights ), _mm256_maddubs_epi16( v1, weights ) );
+      store( pOut_ + i / 2, _mm256_permute4x64_epi64( bytes, 0xd8 ) );
+    }
+
+    return i;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t base64_encode_avx2( const std::uint8_t* pIn_, size_t szIn_, char* pOut_, bool url_ )
+  {
+    // spread 3 input bytes over 4 bytes (as bytes 1, 0, 2, 1) so the 6 bit groups can be shifted into place
+    const __m256i spread = lane_table( _mm_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 ) );
+
+    // each lane processes 12 input bytes, the upper lane reads up to byte 28
+    size_t i = 0;
+    for ( ; i + 28 <= szIn_; i += 24 )
+    {
+      const __m128i lo = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pIn_ + i ) );
+      const __m128i hi = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pIn_ + i + 12 ) );
+      __m256i v = _mm256_inserti128_si256( _mm256_castsi128_si256( lo ), hi, 1 );
+      v = _mm256_shuffle_epi8( v, spread );
+
+      const __m256i ac = _mm256_mulhi_epu16( _mm256_and_si256( v, _mm256_set1_epi32( 0x0fc0fc00 ) ),
+                                             _mm256_set1_epi32( 0x04000040 ) );
+      const __m256i bd = _mm256_mullo_epi16( _mm256_and_si256( v, _mm256_set1_epi32( 0x003f03f0 ) ),
+                                             _mm256_set1_epi32( 0x01000010 ) );
+
+      store( pOut_ + ( i / 3 ) * 4, base64_chars( _mm256_or_si256( ac, bd ), url_ ) );
+    }
+
+    return i;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t base64_decode_avx2( const char* pIn_, size_t szIn_, std::uint8_t* pOut_, bool url_ )
+  {
+    const __m256i gather =
+      lane_table( _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 ) );
+    const __m256i compact = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 7, 7 );
+
+    // each block writes 32 bytes, but only 24 of them are valid, so at least 12 more input characters
+    // (8 more output bytes) are required behind the block
+    size_t i = 0;
+    for ( ; i + 44 <= szIn_; i += 32 )
+    {
+      __m256i values;
+      if ( !base64_values( load( pIn_ + i ), url_, values ) )
+        break;
+
+      // merge the 6 bit values to 24 bit groups and store them in big endian order
+      const __m256i pairs = _mm256_maddubs_epi16( values, _mm256_set1_epi32( 0x01400140 ) );
+      const __m256i groups = _mm256_madd_epi16( pairs, _mm256_set1_epi32( 0x00011000 ) );
+
+      store( pOut_ + ( i / 4 ) * 3,
+             _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( groups, gather ), compact ) );
+    }
+
+    return i;
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,45 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace ll
+{
+namespace crypto
+{
+  // instruction set specific codec kernels (only to be called if the cpu supports the instruction set)
+  // they process whole blocks from the start of the input and return the number of input bytes consumed,
+  // the caller handles the remaining tail. The decoders stop in front of the first block with an invalid
+  // character, so the scalar code reports the error.
+
+  size_t hex_encode_ssse3( const std::uint8_t* pIn_, size_t szIn_, char* pOut_ );
+  size_t hex_decode_ssse3( const char* pIn_, size_t szIn_, std::uint8_t* pOut_ );
+  size_t base64_encode_ssse3( const std::uint8_t* pIn_, size_t szIn_, char* pOut_, bool url_ );
+  size_t base64_decode_ssse3( const char* pIn_, size_t szIn_, std::uint8_t* pOut_, bool url_ );
+
+  size_t hex_encode_avx2( const std::uint8_t* pIn_, size_t szIn_, char* pOut_ );
+  size_t hex_decode_avx2( const char* pIn_, size_t szIn_, std::uint8_t* pOut_ );
+  size_t base64_encode_avx2( const std::uint8_t* pIn_, size_t szIn_, char* pOut_, bool url_ );
+  size_t base64_decode_avx2( const char* pIn_, size_t szIn_, std::uint8_t* pOut_, bool url_ );
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,211 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "codec_kernels.h"
+
+#include <tmmintrin.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    inline __m128i in_range( __m128i v_, char lo_, char hi_ )
+    {
+      return _mm_and_si128( _mm_cmpgt_epi8( v_, _mm_set1_epi8( static_cast< char >( lo_ - 1 ) ) ),
+                            _mm_cmpgt_epi8( _mm_set1_epi8( static_cast< char >( hi_ + 1 ) ), v_ ) );
+    }
+
+    inline __m128i select( __m128i mask_, char v_ ) { return _mm_and_si128( mask_, _mm_set1_epi8( v_ ) ); }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! translate hex characters to their values, returns false if a character is not a hex digit
+    inline bool hex_values( __m128i chars_, __m128i& values_ )
+    {
+      const __m128i digit = in_range( chars_, '0', '9' );
+      const __m128i lower = in_range( chars_, 'a', 'f' );
+      const __m128i upper = in_range( chars_, 'A', 'F' );
+
+      const __m128i valid = _mm_or_si128( digit, _mm_or_si128( lower, upper ) );
+      if ( _mm_movemask_epi8( valid ) != 0xffff )
+        return false;
+
+      const __m128i shift = _mm_or_si128(
+        select( digit, -'0' ), _mm_or_si128( select( lower, 10 - 'a' ), select( upper, 10 - 'A' ) ) );
+      values_ = _mm_add_epi8( chars_, shift );
+      return true;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! translate 6 bit values to base64 characters
+    inline __m128i base64_chars( __m128i values_, bool url_ )
+    {
+      // reduce the values to an index into the shift table:
+      // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+      __m128i index = _mm_subs_epu8( values_, _mm_set1_epi8( 51 ) );
+      index = _mm_or_si128( index, select( _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), values_ ), 13 ) );
+
+      const char c62 = url_ ? '-' : '+';
+      const char c63 = url_ ? '_' : '/';
+      const __m128i shiftTable =
+        _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                       '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                       static_cast< char >( c62 - 62 ), static_cast< char >( c63 - 63 ),
+                       'A', 0, 0 );
+
+      return _mm_add_epi8( values_, _mm_shuffle_epi8( shiftTable, index ) );
+    }
+
+
+    //! translate base64 characters to 6 bit values, returns false if a character is not in the alphabet
+    inline bool base64_values( __m128i chars_, bool url_, __m128i& values_ )
+    {
+      const char c62 = url_ ? '-' : '+';
+      const char c63 = url_ ? '_' : '/';
+
+      const __m128i upper = in_range( chars_, 'A', 'Z' );
+      const __m128i lower = in_range( chars_, 'a', 'z' );
+      const __m128i digit = in_range( chars_, '0', '9' );
+      const __m128i is62 = _mm_cmpeq_epi8( chars_, _mm_set1_epi8( c62 ) );
+      const __m128i is63 = _mm_cmpeq_epi8( chars_, _mm_set1_epi8( c63 ) );
+
+      const __m128i valid =
+        _mm_or_si128( _mm_or_si128( upper, lower ), _mm_or_si128( digit, _mm_or_si128( is62, is63 ) ) );
+      if ( _mm_movemask_epi8( valid ) != 0xffff )
+        return false;
+
+      const __m128i shift = _mm_or_si128(
+        _mm_or_si128( select( upper, -'A' ), select( lower, 26 - 'a' ) ),
+        _mm_or_si128( select( digit, 52 - '0' ),
+                      _mm_or_si128( select( is62, static_cast< char >( 62 - c62 ) ),
+                                    select( is63, static_cast< char >( 63 - c63 ) ) ) ) );
+      values_ = _mm_add_epi8( chars_, shift );
+      return true;
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t hex_encode_ssse3( const std::uint8_t* pIn_, size_t szIn_, char* pOut_ )
+  {
+    const __m128i table = _mm_setr_epi8( '0', '1', '2', '3', '4', '5', '6', '7',
+                                         '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' );
+    const __m128i mask = _mm_set1_epi8( 0x0f );
+
+    size_t i = 0;
+    for ( ; i + 16 <= szIn_; i += 16 )
+    {
+      const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pIn_ + i ) );
+      const __m128i hi = _mm_shuffle_epi8( table, _mm_and_si128( _mm_srli_epi16( v, 4 ), mask ) );
+      const __m128i lo = _mm_shuffle_epi8( table, _mm_and_si128( v, mask ) );
+
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pOut_ + 2 * i ), _mm_unpacklo_epi8( hi, lo ) );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pOut_ + 2 * i + 16 ), _mm_unpackhi_epi8( hi, lo ) );
+    }
+
+    return i;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t hex_decode_ssse3( const char* pIn_, size_t szIn_, std::uint8_t* pOut_ )
+  {
+    // combines the pairs of nibbles (the first one is the high nibble)
+    const __m128i weights = _mm_set1_epi16( 0x0110 );
+
+    size_t i = 0;
+    for ( ; i + 32 <= szIn_; i += 32 )
+    {
+      __m128i v0, v1;
+      if ( !hex_values( _mm_loadu_si128( reinterpret_cast< const __m128i* >( pIn_ + i ) ), v0 )
+           || !hex_values( _mm_loadu_si128( reinterpret_cast< const __m128i* >( pIn_ + i + 16 ) ), v1 ) )
+        break;
+
+      const __m128i bytes =
+        _mm_packus_epi16( _mm_maddubs_epi16( v0, weights ), _mm_maddubs_epi16( v1, weights ) );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pOut_ + i / 2 ), bytes );
+    }
+
+    return i;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t base64_encode_ssse3( const std::uint8_t* pIn_, size_t szIn_, char* pOut_, bool url_ )
+  {
+    // spread 3 input bytes over 4 bytes (as bytes 1, 0, 2, 1) so the 6 bit groups can be shifted into place
+    const __m128i spread = _mm_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 );
+
+    // each block reads 16 input bytes, but only consumes 12
+    size_t i = 0;
+    for ( ; i + 16 <= szIn_; i += 12 )
+    {
+      __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pIn_ + i ) );
+      v = _mm_shuffle_epi8( v, spread );
+
+      const __m128i ac = _mm_mulhi_epu16( _mm_and_si128( v, _mm_set1_epi32( 0x0fc0fc00 ) ),
+                                          _mm_set1_epi32( 0x04000040 ) );
+      const __m128i bd = _mm_mullo_epi16( _mm_and_si128( v, _mm_set1_epi32( 0x003f03f0 ) ),
+                                          _mm_set1_epi32( 0x01000010 ) );
+
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pOut_ + ( i / 3 ) * 4 ),
+                        base64_chars( _mm_or_si128( ac, bd ), url_ ) );
+    }
+
+    return i;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t base64_decode_ssse3( const char* pIn_, size_t szIn_, std::uint8_t* pOut_, bool url_ )
+  {
+    const __m128i gather = _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 );
+
+    // each block writes 16 bytes, but only 12 of them are valid, so at least 8 more input characters
+    // (6 more output bytes) are required behind the block
+    size_t i = 0;
+    for ( ; i + 24 <= szIn_; i += 16 )
+    {
+      __m128i values;
+      const __m128i chars = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pIn_ + i ) );
+      if ( !base64_values( chars, url_, values ) )
+        break;
+
+      // merge the 6 bit values to 24 bit groups and store them in big endian order
+      const __m128i pairs = _mm_maddubs_epi16( values, _mm_set1_epi32( 0x01400140 ) );
+      const __m128i groups = _mm_madd_epi16( pairs, _mm_set1_epi32( 0x00011000 ) );
+
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pOut_ + ( i / 4 ) * 3 ),
+                        _mm_shuffle_epi8( groups, gather ) );
+    }
+
+    return i;
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,221 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include "../support/environment.h"
+
+#if LL_COMPILER == LL_MSVC
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! the instruction set extensions relevant for the internal kernels
+  struct cpu_features
+  {
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool sse42 = false;
+    bool pclmul = false;
+    bool avx2 = false;
+    bool bmi2 = false;
+    bool avx512f = false;
+    bool sha = false;  //!< the x86 SHA extensions (SHA-NI)
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  namespace detail
+  {
+    inline static void cpuid( std::uint32_t leaf_, std::uint32_t subleaf_, std::uint32_t ( &regs_ )[4] )
+    {
+#if LL_COMPILER == LL_MSVC
+      int r[4];
+      __cpuidex( r, static_cast< int >( leaf_ ), static_cast< int >( subleaf_ ) );
+      for ( int i = 0; i < 4; ++i )
+        regs_[i] = static_cast< std::uint32_t >( r[i] );
+#else
+      __cpuid_count( leaf_, subleaf_, regs_[0], regs_[1], regs_[2], regs_[3] );
+#endif
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the register state enabled by the os (XCR0), only valid if OSXSAVE is set
+    inline static std::uint64_t xgetbv()
+    {
+#if LL_COMPILER == LL_MSVC
+      return _xgetbv( 0 );
+#else
+      std::uint32_t eax = 0, edx = 0;
+      __asm__ __volatile__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+      return ( static_cast< std::uint64_t >( edx ) << 32 ) | eax;
+#endif
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    inline static cpu_features detect_cpu_features()
+    {
+      cpu_features f;
+
+      std::uint32_t regs[4] = { 0, 0, 0, 0 };
+      cpuid( 0, 0, regs );
+      auto maxLeaf = regs[0];
+      if ( maxLeaf < 1 )
+        return f;
+
+      cpuid( 1, 0, regs );
+      f.ssse3 = ( regs[2] & ( 1u << 9 ) ) != 0;
+      f.sse41 = ( regs[2] & ( 1u << 19 ) ) != 0;
+      f.sse42 = ( regs[2] & ( 1u << 20 ) ) != 0;
+      f.pclmul = ( regs[2] & ( 1u << 1 ) ) != 0;
+
+      // the wide registers are only usable if the os saves them on context switches
+      bool osxsave = ( regs[2] & ( 1u << 27 ) ) != 0;
+      std::uint64_t xcr0 = osxsave ? xgetbv() : 0;
+      bool ymmEnabled = ( xcr0 & 0x6 ) == 0x6;
+      bool zmmEnabled = ( xcr0 & 0xe6 ) == 0xe6;
+
+      if ( maxLeaf >= 7 )
+      {
+        cpuid( 7, 0, regs );
+        f.avx2 = ymmEnabled && ( ( regs[1] & ( 1u << 5 ) ) != 0 );
+        f.bmi2 = ( regs[1] & ( 1u << 8 ) ) != 0;
+        f.avx512f = zmmEnabled && ( ( regs[1] & ( 1u << 16 ) ) != 0 );
+        f.sha = ( regs[1] & ( 1u << 29 ) ) != 0;
+      }
+
+      return f;
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the features of the cpu we are running on (detected once per process)
+  inline const cpu_features& get_cpu_features()
+  {
+    static const cpu_features s_features = detail::detect_cpu_features();
+    return s_features;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the data cache sizes of one core in bytes, 0 if the cpu doesn't report them
+  struct cache_geometry
+  {
+    size_t lineSize = 0;
+    size_t l1d = 0;
+    size_t l2 = 0;
+    size_t l3 = 0;  //!< shared between the cores
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  namespace detail
+  {
+    //! the deterministic cache parameters (leaf 4 on intel, leaf 0x8000001d on amd), the legacy amd leaves
+    //! 0x80000005 / 0x80000006 if neither is available
+    inline static cache_geometry detect_cache_geometry()
+    {
+      cache_geometry g;
+
+      std::uint32_t regs[4] = { 0, 0, 0, 0 };
+      cpuid( 0, 0, regs );
+      auto maxLeaf = regs[0];
+      cpuid( 0x80000000, 0, regs );
+      auto maxExtendedLeaf = regs[0];
+
+      std::uint32_t cacheLeaf = 0;
+      if ( maxLeaf >= 4 )
+      {
+        cpuid( 4, 0, regs );
+        if ( ( regs[0] & 0x1f ) != 0 )
+          cacheLeaf = 4;
+      }
+      if ( ( cacheLeaf == 0 ) && ( maxExtendedLeaf >= 0x8000001d ) )
+        cacheLeaf = 0x8000001d;
+
+      for ( std::uint32_t i = 0; ( cacheLeaf != 0 ) && ( i < 16 ); ++i )
+      {
+        cpuid( cacheLeaf, i, regs );
+        auto cacheType = regs[0] & 0x1f;  // 1 data, 2 instruction, 3 unified
+        if ( cacheType == 0 )
+          break;
+        if ( cacheType == 2 )
+          continue;
+
+        auto level = ( regs[0] >> 5 ) & 0x7;
+        size_t ways = ( ( regs[1] >> 22 ) & 0x3ff ) + 1;
+        size_t partitions = ( ( regs[1] >> 12 ) & 0x3ff ) + 1;
+        size_t lineSize = ( regs[1] & 0xfff ) + 1;
+        size_t sets = size_t( regs[2] ) + 1;
+        size_t size = ways * partitions * lineSize * sets;
+
+        if ( level == 1 )
+        {
+          g.l1d = size;
+          g.lineSize = lineSize;
+        }
+        else if ( level == 2 )
+          g.l2 = size;
+        else if ( level == 3 )
+          g.l3 = size;
+      }
+
+      if ( ( g.l2 == 0 ) && ( maxExtendedLeaf >= 0x80000006 ) )
+      {
+        cpuid( 0x80000005, 0, regs );
+        g.l1d = size_t( regs[2] >> 24 ) << 10;
+        g.lineSize = regs[2] & 0xff;
+        cpuid( 0x80000006, 0, regs );
+        g.l2 = size_t( regs[2] >> 16 ) << 10;
+        g.l3 = size_t( regs[3] >> 18 ) << 19;
+      }
+
+      return g;
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the cache sizes of the cpu we are running on (detected once per process)
+  inline const cache_geometry& get_cache_geometry()
+  {
+    static const cache_geometry s_geometry = detail::detect_cache_geometry();
+    return s_geometry;
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,227 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crc32c.h"
+
+#include <cstring>
+
+#include "crypto/basic_hash_generator.h"
+#include "cpu_features.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace crc32c
+  {
+    namespace
+    {
+      //! the tables of the portable slicing-by-8 implementation
+      struct crc_tables
+      {
+        crc_tables()
+        {
+          for ( std::uint32_t i = 0; i < 256; ++i )
+          {
+            auto crc = i;
+            for ( int bit = 0; bit < 8; ++bit )
+              crc = ( crc & 1 ) ? ( crc >> 1 ) ^ kPolynomial : ( crc >> 1 );
+            values[0][i] = crc;
+          }
+
+          for ( std::uint32_t i = 0; i < 256; ++i )
+          {
+            for ( size_t t = 1; t < 8; ++t )
+              values[t][i] = ( values[t - 1][i] >> 8 ) ^ values[0][values[t - 1][i] & 0xff];
+          }
+        }
+
+        std::uint32_t values[8][256];
+      };
+
+      const crc_tables& get_tables()
+      {
+        static const crc_tables s_tables;
+        return s_tables;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      std::uint32_t update_portable( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t sz_ )
+      {
+        const auto& t = get_tables().values;
+
+        // the crc register is little endian like the platforms we run on
+        while ( sz_ >= 8 )
+        {
+          std::uint32_t lo, hi;
+          std::memcpy( &lo, pBuffer_, 4 );
+          std::memcpy( &hi, pBuffer_ + 4, 4 );
+          lo ^= crc_;
+          crc_ = t[7][lo & 0xff] ^ t[6][( lo >> 8 ) & 0xff] ^ t[5][( lo >> 16 ) & 0xff] ^ t[4][lo >> 24]
+                 ^ t[3][hi & 0xff] ^ t[2][( hi >> 8 ) & 0xff] ^ t[1][( hi >> 16 ) & 0xff] ^ t[0][hi >> 24];
+          pBuffer_ += 8;
+          sz_ -= 8;
+        }
+
+        while ( sz_-- > 0 )
+          crc_ = ( crc_ >> 8 ) ^ t[0][( crc_ ^ *pBuffer_++ ) & 0xff];
+
+        return crc_;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      //! a * b mod P for bit reflected polynomials (the most significant bit is x^0)
+      std::uint32_t multiply_mod( std::uint32_t a_, std::uint32_t b_ )
+      {
+        std::uint32_t result = 0;
+        for ( std::uint32_t m = 0x80000000u; m != 0; m >>= 1 )
+        {
+          if ( a_ & m )
+            result ^= b_;
+          b_ = ( b_ & 1 ) ? ( b_ >> 1 ) ^ kPolynomial : ( b_ >> 1 );
+        }
+        return result;
+      }
+
+      //! x^n_ mod P (bit reflected)
+      std::uint32_t x_pow_mod( std::uint64_t n_ )
+      {
+        std::uint32_t result = 0x80000000u;
+        std::uint32_t square = 0x40000000u;
+        for ( ; n_ != 0; n_ >>= 1 )
+        {
+          if ( n_ & 1 )
+            result = multiply_mod( result, square );
+          square = multiply_mod( square, square );
+        }
+        return result;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    std::uint32_t shift_constant( size_t numBytes_ )
+    {
+      return x_pow_mod( 8 * static_cast< std::uint64_t >( numBytes_ ) - 33 );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    std::uint32_t update( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t sz_ )
+    {
+      const auto& features = get_cpu_features();
+
+      if ( features.sse42 && features.pclmul )
+        return update_sse42_pclmul( crc_, pBuffer_, sz_ );
+
+      if ( features.sse42 )
+        return update_sse42( crc_, pBuffer_, sz_ );
+
+      return update_portable( crc_, pBuffer_, sz_ );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    const char* kernel_name()
+    {
+      const auto& features = get_cpu_features();
+
+      if ( features.sse42 && features.pclmul )
+        return "sse4.2+pclmul";
+
+      if ( features.sse42 )
+        return "sse4.2";
+
+      return "portable";
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // backend
+  // ---------------------------------------------------------------------------------------------------------
+
+  static_assert( sizeof( std::uint32_t ) <= detail::hash_backend< hash::type::crc32c >::contextSize,
+                 "context storage too small for crc32c" );
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void detail::hash_backend< hash::type::crc32c >::init( void* pContext_ )
+  {
+    *static_cast< std::uint32_t* >( pContext_ ) = 0xffffffff;
+  }
+
+  void detail::hash_backend< hash::type::crc32c >::update( void* pContext_,
+                                                           const std::uint8_t* pBuffer_,
+                                                           size_t sz_ )
+  {
+    auto& crc = *static_cast< std::uint32_t* >( pContext_ );
+    crc = crc32c::update( crc, pBuffer_, sz_ );
+  }
+
+  void detail::hash_backend< hash::type::crc32c >::final( void* pContext_, std::uint8_t* pDigest_ )
+  {
+    // the checksum is conventionally written as a big endian number
+    auto crc = ~*static_cast< const std::uint32_t* >( pContext_ );
+    for ( size_t i = 0; i < 4; ++i )
+      pDigest_[i] = static_cast< std::uint8_t >( crc >> ( 24 - 8 * i ) );
+  }
+
+  void detail::hash_backend< hash::type::crc32c >::copy( void* pTarget_, const void* pSource_ )
+  {
+    std::memcpy( pTarget_, pSource_, sizeof( std::uint32_t ) );
+  }
+
+  size_t detail::hash_backend< hash::type::crc32c >::export_state( const void* pContext_,
+                                                                   std::uint8_t* pState_ )
+  {
+    auto crc = *static_cast< const std::uint32_t* >( pContext_ );
+    for ( size_t i = 0; i < 4; ++i )
+      pState_[i] = static_cast< std::uint8_t >( crc >> ( 8 * i ) );
+    return 4;
+  }
+
+  void detail::hash_backend< hash::type::crc32c >::import_state( void* pContext_,
+                                                                 const std::uint8_t* pState_,
+                                                                 size_t sz_,
+                                                                 std::uint64_t )
+  {
+    if ( sz_ != 4 )
+      throw exception( error::invalid_parameter, "invalid hash state" );
+
+    std::uint32_t crc = 0;
+    for ( size_t i = 0; i < 4; ++i )
+      crc |= std::uint32_t( pState_[i] ) << ( 8 * i );
+    *static_cast< std::uint32_t* >( pContext_ ) = crc;
+  }
+
+  void detail::hash_backend< hash::type::crc32c >::destroy( void* ) LL_NOEXCEPT
+  {
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,61 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include "../support/environment.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ll
+{
+namespace crypto
+{
+  // CRC32C (Castagnoli), the checksum computed by the SSE4.2 crc32 instruction. The register is kept without
+  // the final inversion, so it can be updated incrementally.
+
+  namespace crc32c
+  {
+    const std::uint32_t kPolynomial = 0x82f63b78;  //!< bit reflected
+
+    //! update the crc register with sz_ bytes, using the fastest kernel the cpu supports
+    std::uint32_t update( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t sz_ );
+
+    //! the name of the kernel update uses on this cpu
+    const char* kernel_name();
+
+    //! the multiplier that shifts a crc register over numBytes_ zero bytes when multiplied with pclmul
+    //! and reduced by the crc32 instruction: x^(8 * numBytes_ - 33) mod P (bit reflected)
+    std::uint32_t shift_constant( size_t numBytes_ );
+
+
+    // -------------------------------------------------------------------------------------------------------
+    // kernels (only to be called if the cpu supports the instruction set)
+    // -------------------------------------------------------------------------------------------------------
+
+    //! one stream of crc32 instructions
+    std::uint32_t update_sse42( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t sz_ );
+
+    //! three interleaved streams of crc32 instructions, combined with carry-less multiplications
+    std::uint32_t update_sse42_pclmul( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t sz_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
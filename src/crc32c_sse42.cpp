@@ -0,0 +1,128 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crc32c.h"
+
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+
+#include <cstring>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    // the streams of a block are hashed independently to hide the latency of the crc32 instruction (three
+    // cycles at a throughput of one) and combined afterwards, long blocks amortize the combination
+    const size_t kLongStreamSize = 8192;
+    const size_t kShortStreamSize = 256;
+
+    inline std::uint64_t load_le64( const std::uint8_t* p_ )
+    {
+      std::uint64_t v;
+      std::memcpy( &v, p_, 8 );
+      return v;
+    }
+
+    inline std::uint32_t crc_words( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t numWords_ )
+    {
+      std::uint64_t crc = crc_;
+      for ( size_t i = 0; i < numWords_; ++i )
+        crc = _mm_crc32_u64( crc, load_le64( pBuffer_ + 8 * i ) );
+      return static_cast< std::uint32_t >( crc );
+    }
+
+    inline std::uint32_t crc_tail( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t sz_ )
+    {
+      crc_ = crc_words( crc_, pBuffer_, sz_ / 8 );
+      for ( size_t i = sz_ & ~size_t( 7 ); i < sz_; ++i )
+        crc_ = _mm_crc32_u8( crc_, pBuffer_[i] );
+      return crc_;
+    }
+
+    //! shift the crc register over the number of zero bytes the constant was computed for
+    inline std::uint32_t shift( std::uint32_t crc_, std::uint32_t constant_ )
+    {
+      auto product = _mm_clmulepi64_si128( _mm_cvtsi32_si128( static_cast< int >( crc_ ) ),
+                                           _mm_cvtsi32_si128( static_cast< int >( constant_ ) ),
+                                           0 );
+      return static_cast< std::uint32_t >(
+        _mm_crc32_u64( 0, static_cast< std::uint64_t >( _mm_cvtsi128_si64( product ) ) ) );
+    }
+
+    //! the crc of three consecutive streams of streamSize_ bytes each
+    inline std::uint32_t crc_streams( std::uint32_t crc_,
+                                      const std::uint8_t* pBuffer_,
+                                      size_t streamSize_,
+                                      std::uint32_t shiftConstant_ )
+    {
+      std::uint64_t crc0 = crc_;
+      std::uint64_t crc1 = 0;
+      std::uint64_t crc2 = 0;
+      for ( size_t offset = 0; offset < streamSize_; offset += 8 )
+      {
+        crc0 = _mm_crc32_u64( crc0, load_le64( pBuffer_ + offset ) );
+        crc1 = _mm_crc32_u64( crc1, load_le64( pBuffer_ + streamSize_ + offset ) );
+        crc2 = _mm_crc32_u64( crc2, load_le64( pBuffer_ + 2 * streamSize_ + offset ) );
+      }
+
+      // crc( a | b ) = shift( crc( a ), size( b ) ) ^ crc( b ) for the raw register
+      auto crc = shift( static_cast< std::uint32_t >( crc0 ), shiftConstant_ );
+      crc = shift( crc ^ static_cast< std::uint32_t >( crc1 ), shiftConstant_ );
+      return crc ^ static_cast< std::uint32_t >( crc2 );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::uint32_t crc32c::update_sse42( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t sz_ )
+  {
+    return crc_tail( crc_, pBuffer_, sz_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::uint32_t crc32c::update_sse42_pclmul( std::uint32_t crc_, const std::uint8_t* pBuffer_, size_t sz_ )
+  {
+    static const std::uint32_t s_longShift = shift_constant( kLongStreamSize );
+    static const std::uint32_t s_shortShift = shift_constant( kShortStreamSize );
+
+    while ( sz_ >= 3 * kLongStreamSize )
+    {
+      crc_ = crc_streams( crc_, pBuffer_, kLongStreamSize, s_longShift );
+      pBuffer_ += 3 * kLongStreamSize;
+      sz_ -= 3 * kLongStreamSize;
+    }
+
+    while ( sz_ >= 3 * kShortStreamSize )
+    {
+      crc_ = crc_streams( crc_, pBuffer_, kShortStreamSize, s_shortShift );
+      pBuffer_ += 3 * kShortStreamSize;
+      sz_ -= 3 * kShortStreamSize;
+    }
+
+    return crc_tail( crc_, pBuffer_, sz_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
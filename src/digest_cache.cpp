@@ -0,0 +1,359 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/digest_cache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "crypto/exception.h"
+#include "file_hash_cache.h"
+#include "internal_utils.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    const char kDatabaseMagic[4] = { 'L', 'L', 'D', 'C' };
+    const std::uint8_t kDatabaseVersion = 1;
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void store_le( std::uint64_t v_, std::uint8_t* p_ )
+    {
+      for ( int i = 0; i < 8; ++i )
+        p_[i] = static_cast< std::uint8_t >( v_ >> ( 8 * i ) );
+    }
+
+    std::uint64_t load_le( const std::uint8_t* p_ )
+    {
+      std::uint64_t v = 0;
+      for ( int i = 7; i >= 0; --i )
+        v = ( v << 8 ) | p_[i];
+      return v;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    std::int64_t now_ns()
+    {
+      return std::chrono::duration_cast< std::chrono::nanoseconds >(
+               std::chrono::system_clock::now().time_since_epoch() )
+        .count();
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // cache records
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t encode_cache_record( const file_identity& identity_, const digest& digest_, std::uint8_t* pRecord_ )
+  {
+    store_le( identity_.device, pRecord_ );
+    store_le( identity_.inode, pRecord_ + 8 );
+    store_le( identity_.size, pRecord_ + 16 );
+    store_le( static_cast< std::uint64_t >( identity_.modificationTimeNs ), pRecord_ + 24 );
+    pRecord_[32] = static_cast< std::uint8_t >( digest_.hashType );
+    pRecord_[33] = digest_.size;
+    std::memcpy( pRecord_ + 34, digest_.data(), digest_.size );
+    return 34 + digest_.size;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  size_t decode_cache_record( const std::uint8_t* pRecord_,
+                              size_t sz_,
+                              file_identity& identity_,
+                              digest& digest_ )
+  {
+    if ( sz_ < 34 )
+      return 0;
+
+    auto type = static_cast< hash::type >( pRecord_[32] );
+    if ( ( type == hash::type::unknown ) || ( to_string( type ) == "unknown" ) )
+      return 0;
+
+    size_t digestSize = pRecord_[33];
+    if ( ( digestSize != digest_size( type ) ) || ( sz_ < 34 + digestSize ) )
+      return 0;
+
+    identity_.device = load_le( pRecord_ );
+    identity_.inode = load_le( pRecord_ + 8 );
+    identity_.size = load_le( pRecord_ + 16 );
+    identity_.modificationTimeNs = static_cast< std::int64_t >( load_le( pRecord_ + 24 ) );
+
+    digest_ = digest();
+    digest_.hashType = type;
+    digest_.size = static_cast< std::uint8_t >( digestSize );
+    std::memcpy( digest_.bytes.data(), pRecord_ + 34, digestSize );
+    return 34 + digestSize;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // cached_file_hash Implementation
+  // ---------------------------------------------------------------------------------------------------------
+
+  LL_CONSTEXPR std::int64_t digest_cache::kRacyIntervalNs;
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  cached_file_hash::cached_file_hash( const std::string& path_, hash::type type_, const hash::config& cfg_ )
+    : m_path( path_ )
+    , m_type( type_ )
+    , m_pCache( cfg_.digestCache.get() )
+    , m_verify( cfg_.verifyCachedDigests )
+  {
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool cached_file_hash::lookup( const file_identity& identity_, bool valid_, hash& result_ )
+  {
+    // empty files are skipped as procfs & co. report a size of 0 for files with content
+    m_valid = enabled() && valid_ && ( identity_.size > 0 );
+    if ( !m_valid )
+      return false;
+
+    m_identity = identity_;
+    m_startTimeNs = now_ns();
+    m_hasCachedDigest = m_pCache->lookup( m_path, identity_, m_type, m_cachedDigest )
+                        && ( m_cachedDigest.hashType == m_type );
+    if ( !m_hasCachedDigest || m_verify )
+      return false;
+
+    result_ = hash();
+    result_.hashType = m_type;
+    result_.inputSize = identity_.size;
+    result_.binary.assign( m_cachedDigest.data(), m_cachedDigest.data() + m_cachedDigest.size );
+    result_.string = string_from_binary( result_.binary );
+    return true;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void cached_file_hash::store( const file_identity& identityAfter_, bool valid_, const hash& hash_ )
+  {
+    if ( !m_valid || !valid_ || ( identityAfter_ != m_identity ) )
+      return;
+
+    auto fresh = to_digest( hash_ );
+    if ( m_hasCachedDigest && ( fresh == m_cachedDigest ) )
+      return;
+
+    // a file modified right before hashing could be modified again without changing its identity
+    if ( m_identity.modificationTimeNs <= m_startTimeNs - digest_cache::kRacyIntervalNs )
+      m_pCache->store( m_path, m_identity, fresh );
+
+    if ( m_verify && m_hasCachedDigest )
+      throw exception( error::internal, "the content of " + m_path + " doesn't match the cached digest" );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // sidecar_digest_cache::impl
+  // ---------------------------------------------------------------------------------------------------------
+
+  class sidecar_digest_cache::impl
+  {
+  public:
+    explicit impl( const std::string& databasePath_ ) : m_path( databasePath_ ) { load(); }
+
+    bool lookup( const file_identity& identity_, hash::type type_, digest& digest_ )
+    {
+      std::lock_guard< std::mutex > lock( m_mutex );
+
+      auto it = m_entries.find( make_key( identity_, type_ ) );
+      if ( ( it == m_entries.end() ) || ( it->second.identity != identity_ ) )
+        return false;
+
+      digest_ = it->second.entryDigest;
+      return true;
+    }
+
+    void store( const file_identity& identity_, const digest& digest_ )
+    {
+      std::lock_guard< std::mutex > lock( m_mutex );
+
+      auto& e = m_entries[make_key( identity_, digest_.hashType )];
+      e.identity = identity_;
+      e.entryDigest = digest_;
+      m_modified = true;
+    }
+
+    void flush()
+    {
+      std::lock_guard< std::mutex > lock( m_mutex );
+      if ( !m_modified )
+        return;
+
+      std::vector< std::uint8_t > data( kDatabaseMagic, kDatabaseMagic + sizeof( kDatabaseMagic ) );
+      data.push_back( kDatabaseVersion );
+
+      std::uint8_t record[kMaxCacheRecordSize];
+      for ( const auto& e : m_entries )
+      {
+        auto sz = encode_cache_record( e.second.identity, e.second.entryDigest, record );
+        data.insert( data.end(), record, record + sz );
+      }
+
+      // write a temporary file and replace the database, so it's never left half written
+      auto tempPath = m_path + ".tmp";
+      {
+        std::ofstream file( tempPath, std::ios::out | std::ios::binary | std::ios::trunc );
+        file.write( reinterpret_cast< const char* >( data.data() ), data.size() );
+        file.close();
+        if ( !file )
+          throw exception( error::internal, "can't write " + tempPath );
+      }
+
+#if LL_IS_WINDOWS()
+      auto replaced = ::MoveFileExW(
+        to_wide_string( tempPath ).c_str(), to_wide_string( m_path ).c_str(), MOVEFILE_REPLACE_EXISTING );
+#else
+      auto replaced = std::rename( tempPath.c_str(), m_path.c_str() ) == 0;
+#endif
+      if ( !replaced )
+      {
+        std::remove( tempPath.c_str() );
+        throw exception( error::internal, "can't replace " + m_path );
+      }
+
+      m_modified = false;
+    }
+
+    size_t size() const
+    {
+      std::lock_guard< std::mutex > lock( m_mutex );
+      return m_entries.size();
+    }
+
+  private:
+    typedef std::tuple< std::uint64_t, std::uint64_t, hash::type > key;
+
+    struct entry
+    {
+      file_identity identity;
+      digest entryDigest;
+    };
+
+    static key make_key( const file_identity& identity_, hash::type type_ )
+    {
+      return key( identity_.device, identity_.inode, type_ );
+    }
+
+    void load()
+    {
+      std::ifstream file( m_path, std::ios::in | std::ios::binary );
+      if ( !file )
+        return;
+
+      std::vector< std::uint8_t > data( ( std::istreambuf_iterator< char >( file ) ),
+                                        std::istreambuf_iterator< char >() );
+      if ( data.empty() )
+        return;
+
+      if ( ( data.size() < sizeof( kDatabaseMagic ) + 1 )
+           || !std::equal( kDatabaseMagic, kDatabaseMagic + sizeof( kDatabaseMagic ), data.begin() ) )
+        throw exception( error::invalid_parameter, m_path + " is not a digest cache database" );
+
+      // a database of another version is dropped and rebuilt
+      if ( data[sizeof( kDatabaseMagic )] != kDatabaseVersion )
+        return;
+
+      // a damaged record ends the database, the remaining files are simply hashed again
+      size_t pos = sizeof( kDatabaseMagic ) + 1;
+      entry e;
+      while ( auto sz
+              = decode_cache_record( data.data() + pos, data.size() - pos, e.identity, e.entryDigest ) )
+      {
+        m_entries[make_key( e.identity, e.entryDigest.hashType )] = e;
+        pos += sz;
+      }
+    }
+
+    std::string m_path;
+
+    mutable std::mutex m_mutex;
+    std::map< key, entry > m_entries;
+    bool m_modified = false;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // sidecar_digest_cache Implementation
+  // ---------------------------------------------------------------------------------------------------------
+
+  sidecar_digest_cache::sidecar_digest_cache( const std::string& databasePath_ )
+    : m_pImpl( new impl( databasePath_ ) )
+  {
+  }
+
+  sidecar_digest_cache::~sidecar_digest_cache()
+  {
+    try
+    {
+      m_pImpl->flush();
+    }
+    catch ( ... )
+    {
+    }
+  }
+
+  bool sidecar_digest_cache::lookup( const std::string&,
+                                     const file_identity& identity_,
+                                     hash::type type_,
+                                     digest& digest_ )
+  {
+    return m_pImpl->lookup( identity_, type_, digest_ );
+  }
+
+  void sidecar_digest_cache::store( const std::string&,
+                                    const file_identity& identity_,
+                                    const digest& digest_ )
+  {
+    m_pImpl->store( identity_, digest_ );
+  }
+
+  void sidecar_digest_cache::flush()
+  {
+    m_pImpl->flush();
+  }
+
+  size_t sidecar_digest_cache::size() const
+  {
+    return m_pImpl->size();
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,92 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/digest_cache.h"
+
+#include <sys/types.h>
+#include <sys/xattr.h>
+
+#include "file_hash_cache.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    const std::uint8_t kAttributeVersion = 1;
+
+    //! one attribute per hash type, so the digests of different types don't replace each other
+    std::string attribute_name( hash::type type_ )
+    {
+#if LL_IS_OSX()
+      return "ll_crypto." + to_string( type_ );
+#else
+      return "user.ll_crypto." + to_string( type_ );
+#endif
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool attribute_digest_cache::lookup( const std::string& path_,
+                                       const file_identity& identity_,
+                                       hash::type type_,
+                                       digest& digest_ )
+  {
+    std::uint8_t value[1 + kMaxCacheRecordSize];
+#if LL_IS_OSX()
+    auto sz = ::getxattr( path_.c_str(), attribute_name( type_ ).c_str(), value, sizeof( value ), 0, 0 );
+#else
+    auto sz = ::getxattr( path_.c_str(), attribute_name( type_ ).c_str(), value, sizeof( value ) );
+#endif
+    if ( ( sz < 1 ) || ( value[0] != kAttributeVersion ) )
+      return false;
+
+    // copies of the file keep the attribute, but not the identity
+    file_identity identity;
+    if ( !decode_cache_record( value + 1, static_cast< size_t >( sz ) - 1, identity, digest_ ) )
+      return false;
+
+    return ( identity == identity_ ) && ( digest_.hashType == type_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void attribute_digest_cache::store( const std::string& path_,
+                                      const file_identity& identity_,
+                                      const digest& digest_ )
+  {
+    std::uint8_t value[1 + kMaxCacheRecordSize];
+    value[0] = kAttributeVersion;
+    auto sz = 1 + encode_cache_record( identity_, digest_, value + 1 );
+
+    // setting the attribute fails without write permission or file system support, the file is just not
+    // cached then
+#if LL_IS_OSX()
+    ::setxattr( path_.c_str(), attribute_name( digest_.hashType ).c_str(), value, sz, 0, 0 );
+#else
+    ::setxattr( path_.c_str(), attribute_name( digest_.hashType ).c_str(), value, sz, 0 );
+#endif
+  }
+
+}  // namespace crypto
+}  // namespace ll
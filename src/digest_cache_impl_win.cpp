@@ -0,0 +1,117 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/digest_cache.h"
+
+#include "file_hash_cache.h"
+#include "internal_utils.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    const std::uint8_t kAttributeVersion = 1;
+
+    //! one alternate data stream per hash type, so the digests of different types don't replace each other
+    std::wstring stream_path( const std::string& path_, hash::type type_ )
+    {
+      return to_wide_string( path_ + ":ll_crypto." + to_string( type_ ) );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    class handle
+    {
+    public:
+      explicit handle( HANDLE h_ ) : m_handle( h_ ) {}
+      ~handle()
+      {
+        if ( valid() )
+          ::CloseHandle( m_handle );
+      }
+
+      handle( const handle& ) = delete;
+      handle& operator=( const handle& ) = delete;
+
+      bool valid() const { return m_handle != INVALID_HANDLE_VALUE; }
+      HANDLE get() const { return m_handle; }
+
+    private:
+      HANDLE m_handle;
+    };
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool attribute_digest_cache::lookup( const std::string& path_,
+                                       const file_identity& identity_,
+                                       hash::type type_,
+                                       digest& digest_ )
+  {
+    handle stream( ::CreateFileW( stream_path( path_, type_ ).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL ) );
+    if ( !stream.valid() )
+      return false;
+
+    std::uint8_t value[1 + kMaxCacheRecordSize];
+    DWORD sz = 0;
+    if ( !::ReadFile( stream.get(), value, sizeof( value ), &sz, NULL ) || ( sz < 1 )
+         || ( value[0] != kAttributeVersion ) )
+      return false;
+
+    // copies of the file keep the stream, but not the identity
+    file_identity identity;
+    if ( !decode_cache_record( value + 1, sz - 1, identity, digest_ ) )
+      return false;
+
+    return ( identity == identity_ ) && ( digest_.hashType == type_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void attribute_digest_cache::store( const std::string& path_,
+                                      const file_identity& identity_,
+                                      const digest& digest_ )
+  {
+    std::uint8_t value[1 + kMaxCacheRecordSize];
+    value[0] = kAttributeVersion;
+    auto sz = static_cast< DWORD >( 1 + encode_cache_record( identity_, digest_, value + 1 ) );
+
+    // opening the stream fails without write permission or on file systems other than NTFS, the file is
+    // just not cached then
+    handle stream( ::CreateFileW( stream_path( path_, digest_.hashType ).c_str(), GENERIC_WRITE, 0, NULL,
+                                  CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL ) );
+    if ( !stream.valid() )
+      return;
+
+    // writing a stream updates the last write time of the file, which would invalidate the entry right away
+    FILETIME keep = { 0xffffffff, 0xffffffff };
+    ::SetFileTime( stream.get(), NULL, NULL, &keep );
+
+    DWORD written = 0;
+    ::WriteFile( stream.get(), value, sz, &written, NULL );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,48 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace ll
+{
+namespace crypto
+{
+  struct directory_entry
+  {
+    std::string path;        //!< relative to the root, '/' separated
+    std::uint64_t size = 0;
+  };
+
+
+  //! append all regular files below root_ (recursively) to entries_, without following symbolic links
+  //! the order is unspecified. Subdirectories and entries that can't be read (e.g. for lack of permission)
+  //! are skipped and appended to unreadable_ (relative paths), only an unreadable root_ throws
+  void list_files( const std::string& root_,
+                   std::vector< directory_entry >& entries_,
+                   std::vector< std::string >& unreadable_ );
+
+  //! the path of a file below root_ for the platform file API
+  std::string join_path( const std::string& root_, const std::string& relativePath_ );
+
+}  // namespace crypto
+}  // namespace ll
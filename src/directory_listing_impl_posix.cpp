@@ -0,0 +1,157 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "directory_listing.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "crypto/exception.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    class directory_stream
+    {
+    public:
+      explicit directory_stream( DIR* pDir_ ) : m_pDir( pDir_ ) {}
+      ~directory_stream()
+      {
+        if ( m_pDir )
+          ::closedir( m_pDir );
+      }
+
+      directory_stream( const directory_stream& ) = delete;
+      directory_stream& operator=( const directory_stream& ) = delete;
+
+      DIR* get() const { return m_pDir; }
+
+    private:
+      DIR* m_pDir;
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! list the directory opened as dirFd_ (takes ownership of the descriptor)
+    //! the entries are resolved relative to the directory descriptor, so the paths are never re-parsed
+    void list_directory( int dirFd_,
+                         const std::string& prefix_,
+                         std::vector< directory_entry >& entries_,
+                         std::vector< std::string >& unreadable_ )
+    {
+      // the root (empty prefix) has to be readable, a subdirectory is reported without the trailing '/'
+      auto directory_unreadable = [&]( error error_, const char* pWhat_ )
+      {
+        if ( prefix_.empty() )
+          throw exception( error_, pWhat_ );
+        unreadable_.push_back( prefix_.substr( 0, prefix_.size() - 1 ) );
+      };
+
+      directory_stream dir( ::fdopendir( dirFd_ ) );
+      if ( !dir.get() )
+      {
+        ::close( dirFd_ );
+        directory_unreadable( error::invalid_parameter, "can't open directory" );
+        return;
+      }
+
+      for ( ;; )
+      {
+        errno = 0;
+        auto pEntry = ::readdir( dir.get() );
+        if ( !pEntry )
+        {
+          if ( errno != 0 )
+            directory_unreadable( error::internal, "can't read directory" );
+          break;
+        }
+
+        const char* pName = pEntry->d_name;
+        if ( ( std::strcmp( pName, "." ) == 0 ) || ( std::strcmp( pName, ".." ) == 0 ) )
+          continue;
+
+        auto path = prefix_ + pName;
+
+        struct stat st;
+        if ( ::fstatat( ::dirfd( dir.get() ), pName, &st, AT_SYMLINK_NOFOLLOW ) != 0 )
+        {
+          // entries removed in the meantime are skipped silently
+          if ( errno != ENOENT )
+            unreadable_.push_back( path );
+          continue;
+        }
+
+        if ( S_ISREG( st.st_mode ) )
+        {
+          directory_entry entry;
+          entry.path = path;
+          entry.size = static_cast< std::uint64_t >( st.st_size );
+          entries_.push_back( entry );
+        }
+        else if ( S_ISDIR( st.st_mode ) )
+        {
+          auto fd = ::openat( ::dirfd( dir.get() ), pName, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC );
+          if ( fd < 0 )
+          {
+            if ( errno != ENOENT )
+              unreadable_.push_back( path );
+            continue;
+          }
+
+          list_directory( fd, path + '/', entries_, unreadable_ );
+        }
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void list_files( const std::string& root_,
+                   std::vector< directory_entry >& entries_,
+                   std::vector< std::string >& unreadable_ )
+  {
+    auto fd = ::open( root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+    if ( fd < 0 )
+      throw exception( error::invalid_parameter, "can't open directory " + root_ );
+
+    list_directory( fd, std::string(), entries_, unreadable_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::string join_path( const std::string& root_, const std::string& relativePath_ )
+  {
+    if ( root_.empty() || ( root_.back() == '/' ) )
+      return root_ + relativePath_;
+    return root_ + '/' + relativePath_;
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,133 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "directory_listing.h"
+
+#include <Windows.h>
+
+#include "crypto/exception.h"
+#include "internal_utils.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    class find_handle
+    {
+    public:
+      explicit find_handle( HANDLE handle_ ) : m_handle( handle_ ) {}
+      ~find_handle()
+      {
+        if ( m_handle != INVALID_HANDLE_VALUE )
+          ::FindClose( m_handle );
+      }
+
+      find_handle( const find_handle& ) = delete;
+      find_handle& operator=( const find_handle& ) = delete;
+
+      HANDLE get() const { return m_handle; }
+
+    private:
+      HANDLE m_handle;
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void list_directory( const std::wstring& directory_,
+                         const std::string& prefix_,
+                         std::vector< directory_entry >& entries_,
+                         std::vector< std::string >& unreadable_ )
+    {
+      // the root (empty prefix) has to be readable, a subdirectory is reported without the trailing '/'
+      auto directory_unreadable = [&]( error error_, const char* pWhat_ )
+      {
+        if ( prefix_.empty() )
+          throw exception( error_, pWhat_ );
+        unreadable_.push_back( prefix_.substr( 0, prefix_.size() - 1 ) );
+      };
+
+      WIN32_FIND_DATAW data;
+      find_handle find( ::FindFirstFileExW( ( directory_ + L"\\*" ).c_str(), FindExInfoBasic, &data,
+                                            FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH ) );
+      if ( find.get() == INVALID_HANDLE_VALUE )
+      {
+        if ( ::GetLastError() != ERROR_FILE_NOT_FOUND )
+          directory_unreadable( error::invalid_parameter, "can't open directory" );
+        return;
+      }
+
+      do
+      {
+        const std::wstring name = data.cFileName;
+        if ( ( name == L"." ) || ( name == L".." ) )
+          continue;
+
+        // symbolic links and junctions are not followed
+        if ( data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT )
+          continue;
+
+        auto path = prefix_ + to_utf8_string( name );
+        if ( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+        {
+          list_directory( directory_ + L"\\" + name, path + '/', entries_, unreadable_ );
+        }
+        else if ( !( data.dwFileAttributes & FILE_ATTRIBUTE_DEVICE ) )
+        {
+          directory_entry entry;
+          entry.path = path;
+          entry.size = ( static_cast< std::uint64_t >( data.nFileSizeHigh ) << 32 ) | data.nFileSizeLow;
+          entries_.push_back( entry );
+        }
+      } while ( ::FindNextFileW( find.get(), &data ) );
+
+      if ( ::GetLastError() != ERROR_NO_MORE_FILES )
+        directory_unreadable( error::internal, "can't read directory" );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void list_files( const std::string& root_,
+                   std::vector< directory_entry >& entries_,
+                   std::vector< std::string >& unreadable_ )
+  {
+    auto attributes = ::GetFileAttributesW( to_wide_string( root_ ).c_str() );
+    if ( ( attributes == INVALID_FILE_ATTRIBUTES ) || !( attributes & FILE_ATTRIBUTE_DIRECTORY ) )
+      throw exception( error::invalid_parameter, "can't open directory " + root_ );
+
+    list_directory( to_wide_string( root_ ), std::string(), entries_, unreadable_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::string join_path( const std::string& root_, const std::string& relativePath_ )
+  {
+    // the Windows file API accepts '/' as separator as well
+    if ( root_.empty() || ( root_.back() == '/' ) || ( root_.back() == '\\' ) )
+      return root_ + relativePath_;
+    return root_ + '/' + relativePath_;
+  }
+
+}  // namespace crypto
+}  // namespace ll
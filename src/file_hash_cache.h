@@ -0,0 +1,78 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "crypto/digest_cache.h"
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! the maximum size of an encoded cache record: identity, hash type, digest size and the digest itself
+  const size_t kMaxCacheRecordSize = 4 * 8 + 2 + digest::maxSize;
+
+  //! encode the entry for the file, returns the record size
+  size_t encode_cache_record( const file_identity& identity_, const digest& digest_, std::uint8_t* pRecord_ );
+
+  //! decode a record, returns the number of bytes consumed or 0 if the record is invalid or incomplete
+  size_t decode_cache_record( const std::uint8_t* pRecord_,
+                              size_t sz_,
+                              file_identity& identity_,
+                              digest& digest_ );
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the digest cache handling of a single get_file_hash call
+  class cached_file_hash
+  {
+  public:
+    cached_file_hash( const std::string& path_, hash::type type_, const hash::config& cfg_ );
+
+    //! whether a cache is configured at all
+    bool enabled() const { return m_pCache != nullptr; }
+
+    //! look up the file before hashing, returns true if the cached digest is the result
+    //! identity_ is the identity of the opened file, valid_ is false for files that can't be cached
+    bool lookup( const file_identity& identity_, bool valid_, hash& result_ );
+
+    //! store the computed hash if the file didn't change while it was hashed
+    //! throws if verifying the cached digest failed
+    void store( const file_identity& identityAfter_, bool valid_, const hash& hash_ );
+
+  private:
+    const std::string& m_path;
+    hash::type m_type;
+    digest_cache* m_pCache;
+    bool m_verify;
+
+    bool m_valid = false;
+    file_identity m_identity;        //!< the identity before hashing
+    std::int64_t m_startTimeNs = 0;  //!< the time hashing started
+    bool m_hasCachedDigest = false;
+    digest m_cachedDigest;
+  };
+
+}  // namespace crypto
+}  // namespace ll
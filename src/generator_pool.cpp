@@ -0,0 +1,88 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "generator_pool.h"
+
+#include <vector>
+
+#include "../support/environment.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+#if LL_HAS_THREAD_LOCAL()
+
+    //! one idle generator per hash type
+    typedef std::vector< std::unique_ptr< hash_generator > > generator_pool;
+
+    generator_pool& get_thread_pool()
+    {
+      static thread_local generator_pool t_pool;
+      return t_pool;
+    }
+
+#endif
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  pooled_hash_generator::pooled_hash_generator( hash::type type_ ) : m_type( type_ )
+  {
+#if LL_HAS_THREAD_LOCAL()
+    auto& pool = get_thread_pool();
+    auto index = static_cast< size_t >( type_ );
+    if ( ( index < pool.size() ) && pool[index] )
+    {
+      m_pGenerator = std::move( pool[index] );
+      m_pGenerator->reset();
+      return;
+    }
+#endif
+
+    m_pGenerator.reset( new hash_generator( type_ ) );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  pooled_hash_generator::~pooled_hash_generator()
+  {
+#if LL_HAS_THREAD_LOCAL()
+    try
+    {
+      auto& pool = get_thread_pool();
+      auto index = static_cast< size_t >( m_type );
+      if ( index >= pool.size() )
+        pool.resize( index + 1 );
+      if ( !pool[index] )
+        pool[index] = std::move( m_pGenerator );
+    }
+    catch ( ... )
+    {
+      // the generator is simply dropped if it can't be pooled
+    }
+#endif
+  }
+
+}  // namespace crypto
+}  // namespace ll
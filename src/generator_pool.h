@@ -0,0 +1,50 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <memory>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! borrows a generator from the per-thread pool of the calling thread (or creates one if the pool has none
+  //! for the type) and hands it back on destruction, so hot paths don't construct a generator per message
+  class pooled_hash_generator
+  {
+  public:
+    explicit pooled_hash_generator( hash::type type_ );
+    ~pooled_hash_generator();
+
+    pooled_hash_generator( const pooled_hash_generator& ) = delete;
+    pooled_hash_generator& operator=( const pooled_hash_generator& ) = delete;
+
+    hash_generator& operator*() { return *m_pGenerator; }
+    hash_generator* operator->() { return m_pGenerator.get(); }
+
+  private:
+    hash::type m_type;
+    std::unique_ptr< hash_generator > m_pGenerator;
+  };
+
+}  // namespace crypto
+}  // namespace ll
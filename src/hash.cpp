@@ -17,6 +17,7 @@
 *************************************************************************************************************/
 
 #include "crypto/hash.h"
+#include "crypto/basic_hash_generator.h"
 
 #include <map>
 #include <algorithm>
@@ -24,17 +25,36 @@
 
 #include "crypto/exception.h"
 #include "internal_utils.h"
+#include "blake3.h"
+#include "crc32c.h"
+#include "sha.h"
+#include "xxh3.h"
+#include "generator_pool.h"
+#include "processing_block.h"
+#include "hash_multibuffer.h"
+#include "openssl_backend.h"
+#include "read_ahead_reader.h"
+#include "metrics_registry.h"
+#include "tracing.h"
 
 #include "../support/debug_helpers.h"
 
 
-#define LL_HASHTYPE_TABLE()                          \
-  LL_TRANSLATE_ENUM( hash::type::md4, "md4" )        \
-  LL_TRANSLATE_ENUM( hash::type::md5, "md5" )        \
-  LL_TRANSLATE_ENUM( hash::type::sha1, "sha-1" )     \
-  LL_TRANSLATE_ENUM( hash::type::sha256, "sha-256" ) \
-  LL_TRANSLATE_ENUM( hash::type::sha384, "sha-384" ) \
-  LL_TRANSLATE_ENUM( hash::type::sha512, "sha-512" )
+#define LL_HASHTYPE_TABLE()                              \
+  LL_TRANSLATE_ENUM( hash::type::md4, "md4" )            \
+  LL_TRANSLATE_ENUM( hash::type::md5, "md5" )            \
+  LL_TRANSLATE_ENUM( hash::type::sha1, "sha-1" )         \
+  LL_TRANSLATE_ENUM( hash::type::sha256, "sha-256" )     \
+  LL_TRANSLATE_ENUM( hash::type::sha384, "sha-384" )     \
+  LL_TRANSLATE_ENUM( hash::type::sha512, "sha-512" )     \
+  LL_TRANSLATE_ENUM( hash::type::blake3, "blake3" )      \
+  LL_TRANSLATE_ENUM( hash::type::sha3_256, "sha3-256" )  \
+  LL_TRANSLATE_ENUM( hash::type::sha3_512, "sha3-512" )  \
+  LL_TRANSLATE_ENUM( hash::type::shake128, "shake128" )  \
+  LL_TRANSLATE_ENUM( hash::type::shake256, "shake256" )  \
+  LL_TRANSLATE_ENUM( hash::type::crc32c, "crc32c" )      \
+  LL_TRANSLATE_ENUM( hash::type::xxh3_64, "xxh3-64" )    \
+  LL_TRANSLATE_ENUM( hash::type::xxh3_128, "xxh3-128" )
 
 
 namespace ll
@@ -48,22 +68,77 @@ namespace crypto
 
   namespace
   {
+    // the header of the exported generator state (see hash_generator::export_state)
+    const std::uint8_t kStateMagic[4] = { 'L', 'L', 'H', 'S' };
+    const std::uint8_t kStateVersion = 1;
+    const size_t kStateHeaderSize = 14;
+
+
+    // ---------------------------------------------------------------------------------------------------------
+
+    void feed_hash_generator( hash_generator& calculator_,
+                              const uint8_t* pBuffer,
+                              size_t szBufferInBytes_,
+                              size_t blockSize_ )
+    {
+      while ( szBufferInBytes_ >= blockSize_ )
+      {
+        calculator_.add_data( pBuffer, blockSize_ );
+        pBuffer += blockSize_;
+        szBufferInBytes_ -= blockSize_;
+      }
+      calculator_.add_data( pBuffer, szBufferInBytes_ );
+    }
+
+    //! only needed by the instrumentation, which may be compiled out
+    inline std::uint64_t total_size( const buffer_ref* pBuffers_, size_t numBuffers_ )
+    {
+      std::uint64_t sz = 0;
+      for ( size_t i = 0; i < numBuffers_; ++i )
+        sz += pBuffers_[i].szBufferInBytes;
+      return sz;
+    }
+
+    //! the subtrees of the blake3 tree are hashed on several threads, so the buffer is passed at once
+    bool use_blake3_threads( hash::type type_, const hash::config& cfg_ )
+    {
+      return ( type_ == hash::type::blake3 ) && ( cfg_.numHashThreads > 1 );
+    }
+
+    void hash_blake3_parallel( const uint8_t* pBuffer_,
+                               size_t szBufferInBytes_,
+                               size_t numThreads_,
+                               std::uint8_t* pDigest_ )
+    {
+      blake3::hasher hasher;
+      blake3::init( hasher );
+      blake3::update( hasher, pBuffer_, szBufferInBytes_, numThreads_ );
+      blake3::finalize( hasher, pDigest_, blake3::kOutSize );
+    }
+
+
+    // ---------------------------------------------------------------------------------------------------------
+
     hash invoke_hash_generator( const uint8_t* pBuffer,
                           size_t szBufferInBytes_,
                           hash::type type_,
                           const hash::config& cfg_ )
     {
-      hash_generator calculator( type_ );
-
-      while ( szBufferInBytes_ >= cfg_.processingBlockSize )
+      if ( use_blake3_threads( type_, cfg_ ) )
       {
-        calculator.add_data( pBuffer, cfg_.processingBlockSize );
-        pBuffer += cfg_.processingBlockSize;
-        szBufferInBytes_ -= cfg_.processingBlockSize;
+        hash h;
+        h.hashType = type_;
+        h.inputSize = szBufferInBytes_;
+        h.binary.resize( blake3::kOutSize );
+        hash_blake3_parallel( pBuffer, szBufferInBytes_, cfg_.numHashThreads, h.binary.data() );
+        h.string = string_from_binary( h.binary );
+        return h;
       }
-      calculator.add_data( pBuffer, szBufferInBytes_ );
 
-      return calculator.retrieve_hash();
+      pooled_hash_generator calculator( type_ );
+      auto blockSize = get_processing_block_size( type_, hash::source::memory, cfg_ );
+      feed_hash_generator( *calculator, pBuffer, szBufferInBytes_, blockSize );
+      return calculator->retrieve_hash();
     }
 
 
@@ -71,29 +146,213 @@ namespace crypto
 
     hash invoke_hash_generator( std::istream& stream_, hash::type type_, const hash::config& cfg_ )
     {
-      hash_generator calculator( type_ );
+      pooled_hash_generator calculator( type_ );
+      auto blockSize = get_processing_block_size( type_, hash::source::stream, cfg_ );
+
+      if ( cfg_.numReadAheadBuffers > 0 )
+      {
+        read_ahead_reader reader( stream_, cfg_.numReadAheadBuffers, blockSize );
+
+        const std::uint8_t* pData = nullptr;
+        size_t sz = 0;
+        while ( reader.acquire( pData, sz ) )
+        {
+          calculator->add_data( pData, sz );
+          reader.release();
+        }
+
+        return calculator->retrieve_hash();
+      }
 
-      std::vector< std::uint8_t > data( cfg_.processingBlockSize );
+      pooled_block_buffer data( blockSize );
 
 	  std::uint64_t bytesRead = 0;
       std::uint64_t bytesTotal = 0;
       while ( stream_.good() )
       {
-        stream_.read( reinterpret_cast< char* >( data.data() ), cfg_.processingBlockSize );
+        stream_.read( reinterpret_cast< char* >( data.data() ), data.size() );
         bytesRead = stream_.gcount();
-        calculator.add_data( data.data(), static_cast< size_t >( bytesRead ) );
+        calculator->add_data( data.data(), static_cast< size_t >( bytesRead ) );
         bytesTotal += bytesRead;
       }
 
-      return calculator.retrieve_hash();
+      return calculator->retrieve_hash();
     }
+
+
+    // ---------------------------------------------------------------------------------------------------------
+
+    //! the variable output size is only available for extendable-output types, the others throw
+    template < hash::type type_, bool isXof_ = basic_hash_generator< type_ >::isXof >
+    struct xof_output
+    {
+      static hash retrieve_hash( basic_hash_generator< type_ >& generator_, size_t outputSize_ )
+      {
+        return generator_.retrieve_hash( outputSize_ );
+      }
+
+      static void retrieve_output( basic_hash_generator< type_ >& generator_,
+                                   std::uint8_t* pOutput_,
+                                   size_t outputSize_ )
+      {
+        generator_.retrieve_output( pOutput_, outputSize_ );
+      }
+    };
+
+    template < hash::type type_ >
+    struct xof_output< type_, false >
+    {
+      static hash retrieve_hash( basic_hash_generator< type_ >&, size_t )
+      {
+        throw exception( error::invalid_request, "not an extendable-output hash type" );
+      }
+
+      static void retrieve_output( basic_hash_generator< type_ >&, std::uint8_t*, size_t )
+      {
+        throw exception( error::invalid_request, "not an extendable-output hash type" );
+      }
+    };
   }
 
 
+  // ---------------------------------------------------------------------------------------------------------
+  // hash_generator::concrete_hash_generator
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! type-erased adapter over the statically typed generator
+  template < hash::type type_ >
+  class hash_generator::concrete_hash_generator : public hash_generator
+  {
+  public:
+    concrete_hash_generator()
+    {
+      LL_PROBE2( generator_create, static_cast< const void* >( this ), static_cast< int >( type_ ) );
+    }
+
+    concrete_hash_generator( const concrete_hash_generator& other_ )
+      : hash_generator()
+      , m_generator( other_.m_generator )
+    {
+      LL_PROBE2( generator_create, static_cast< const void* >( this ), static_cast< int >( type_ ) );
+    }
+
+    void add_data( const std::uint8_t* pBuffer_, size_t sz_ ) override
+    {
+      LL_METRICS_DATA( hash_generator, type_, sz_ );
+      LL_PROBE3( generator_add_data, static_cast< const void* >( this ), static_cast< int >( type_ ), sz_ );
+      m_generator.add_data( pBuffer_, sz_ );
+    }
+
+    void add_segments( const buffer_ref* pSegments_, size_t numSegments_ ) override
+    {
+      LL_METRICS_DATA( hash_generator, type_, total_size( pSegments_, numSegments_ ) );
+      LL_PROBE3( generator_add_data, static_cast< const void* >( this ), static_cast< int >( type_ ),
+                 total_size( pSegments_, numSegments_ ) );
+      m_generator.add_segments( pSegments_, numSegments_ );
+    }
+
+    hash retrieve_hash() override
+    {
+      LL_METRICS_CALL( hash_generator, type_, 0 );
+      LL_PROBE2( generator_retrieve, static_cast< const void* >( this ), static_cast< int >( type_ ) );
+      return m_generator.retrieve_hash();
+    }
+
+    digest retrieve_digest() override
+    {
+      LL_METRICS_CALL( hash_generator, type_, 0 );
+      LL_PROBE2( generator_retrieve, static_cast< const void* >( this ), static_cast< int >( type_ ) );
+      return m_generator.retrieve_digest();
+    }
+
+    void reset() override { m_generator.reset(); }
+
+    hash retrieve_hash( size_t outputSize_ ) override
+    {
+      LL_METRICS_CALL( hash_generator, type_, 0 );
+      LL_PROBE2( generator_retrieve, static_cast< const void* >( this ), static_cast< int >( type_ ) );
+      return xof_output< type_ >::retrieve_hash( m_generator, outputSize_ );
+    }
+
+    void retrieve_output( std::uint8_t* pOutput_, size_t outputSize_ ) override
+    {
+      LL_METRICS_CALL( hash_generator, type_, 0 );
+      LL_PROBE2( generator_retrieve, static_cast< const void* >( this ), static_cast< int >( type_ ) );
+      xof_output< type_ >::retrieve_output( m_generator, pOutput_, outputSize_ );
+    }
+
+    std::vector< std::uint8_t > export_state() const override { return m_generator.export_state(); }
+
+    void import_state( const void* pState_, size_t sz_ ) override
+    {
+      m_generator.import_state( pState_, sz_ );
+    }
+
+  private:
+    std::unique_ptr< hash_generator > clone_impl() const override
+    {
+      return std::unique_ptr< hash_generator >( new concrete_hash_generator( *this ) );
+    }
+
+    basic_hash_generator< type_ > m_generator;
+  };
+
+
   // ---------------------------------------------------------------------------------------------------------
   // hash_generator Implementation
   // ---------------------------------------------------------------------------------------------------------
 
+  hash_generator::hash_generator( hash::type type_ )
+  {
+    switch ( type_ )
+    {
+      case hash::type::md4:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::md4 >() );
+        break;
+      case hash::type::md5:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::md5 >() );
+        break;
+      case hash::type::sha1:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::sha1 >() );
+        break;
+      case hash::type::sha256:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::sha256 >() );
+        break;
+      case hash::type::sha384:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::sha384 >() );
+        break;
+      case hash::type::sha512:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::sha512 >() );
+        break;
+      case hash::type::blake3:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::blake3 >() );
+        break;
+      case hash::type::sha3_256:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::sha3_256 >() );
+        break;
+      case hash::type::sha3_512:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::sha3_512 >() );
+        break;
+      case hash::type::shake128:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::shake128 >() );
+        break;
+      case hash::type::shake256:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::shake256 >() );
+        break;
+      case hash::type::crc32c:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::crc32c >() );
+        break;
+      case hash::type::xxh3_64:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::xxh3_64 >() );
+        break;
+      case hash::type::xxh3_128:
+        m_pImpl.reset( new concrete_hash_generator< hash::type::xxh3_128 >() );
+        break;
+      default:
+        throw exception( error::invalid_parameter, "Unsupported hash type" );
+    }
+  }
+
   hash_generator::~hash_generator() = default;
 
   hash_generator::hash_generator( hash_generator&& other_ )
@@ -113,11 +372,138 @@ namespace crypto
     m_pImpl->add_data( pBuffer_, sz_ );
   }
 
+  void hash_generator::add_segments( const buffer_ref* pSegments_, size_t numSegments_ )
+  {
+    if ( !pSegments_ && ( numSegments_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer list" );
+
+    for ( size_t i = 0; i < numSegments_; ++i )
+    {
+      if ( !pSegments_[i].pBuffer && ( pSegments_[i].szBufferInBytes > 0 ) )
+        throw exception( error::invalid_parameter, "invalid buffer" );
+    }
+
+    m_pImpl->add_segments( pSegments_, numSegments_ );
+  }
+
   hash hash_generator::retrieve_hash()
   {
-    auto h = m_pImpl->retrieve_hash();
-    h.string = string_from_binary( h.binary );
-    return h;
+    return m_pImpl->retrieve_hash();
+  }
+
+  digest hash_generator::retrieve_digest()
+  {
+    return m_pImpl->retrieve_digest();
+  }
+
+  hash hash_generator::retrieve_hash( size_t outputSize_ )
+  {
+    return m_pImpl->retrieve_hash( outputSize_ );
+  }
+
+  void hash_generator::retrieve_output( std::uint8_t* pOutput_, size_t outputSize_ )
+  {
+    LL_PRECONDITION( ( pOutput_ != nullptr ) || ( outputSize_ == 0 ) );
+    m_pImpl->retrieve_output( pOutput_, outputSize_ );
+  }
+
+  void hash_generator::reset()
+  {
+    m_pImpl->reset();
+  }
+
+  hash_generator hash_generator::clone() const
+  {
+    hash_generator result;
+    result.m_pImpl = clone_impl();
+    return result;
+  }
+
+  std::unique_ptr< hash_generator > hash_generator::clone_impl() const
+  {
+    return m_pImpl->clone_impl();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< std::uint8_t > hash_generator::export_state() const
+  {
+    return m_pImpl->export_state();
+  }
+
+  void hash_generator::import_state( const void* pState_, size_t sz_ )
+  {
+    m_pImpl->import_state( pState_, sz_ );
+  }
+
+  hash_generator hash_generator::from_state( const void* pState_, size_t sz_ )
+  {
+    if ( !pState_ || ( sz_ < kStateHeaderSize ) )
+      throw exception( error::invalid_parameter, "invalid hash state" );
+
+    auto type = static_cast< hash::type >( static_cast< const std::uint8_t* >( pState_ )[5] );
+    if ( ( type == hash::type::unknown ) || ( to_string( type ) == "unknown" ) )
+      throw exception( error::invalid_parameter, "invalid hash state" );
+
+    hash_generator result( type );
+    result.import_state( pState_, sz_ );
+    return result;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::string detail::to_hex_string( const std::vector< std::uint8_t >& binary_ )
+  {
+    return string_from_binary( binary_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< std::uint8_t > detail::encode_state( hash::type type_,
+                                                    std::uint64_t inputSize_,
+                                                    const std::uint8_t* pNativeState_,
+                                                    size_t sz_ )
+  {
+    std::vector< std::uint8_t > state( kStateHeaderSize + sz_ );
+    std::copy( kStateMagic, kStateMagic + 4, state.begin() );
+    state[4] = kStateVersion;
+    state[5] = static_cast< std::uint8_t >( type_ );
+    for ( size_t i = 0; i < 8; ++i )
+      state[6 + i] = static_cast< std::uint8_t >( inputSize_ >> ( 8 * i ) );
+
+    std::copy( pNativeState_, pNativeState_ + sz_, state.begin() + kStateHeaderSize );
+    return state;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void detail::decode_state( hash::type type_,
+                             const void* pState_,
+                             size_t sz_,
+                             std::uint64_t& inputSize_,
+                             const std::uint8_t*& pNativeState_,
+                             size_t& nativeStateSize_ )
+  {
+    auto pState = static_cast< const std::uint8_t* >( pState_ );
+    if ( !pState || ( sz_ < kStateHeaderSize ) || !std::equal( kStateMagic, kStateMagic + 4, pState ) )
+      throw exception( error::invalid_parameter, "invalid hash state" );
+
+    if ( pState[4] != kStateVersion )
+      throw exception( error::invalid_parameter, "unsupported hash state version" );
+
+    if ( pState[5] != static_cast< std::uint8_t >( type_ ) )
+      throw exception( error::invalid_parameter, "hash state of a different hash type" );
+
+    inputSize_ = 0;
+    for ( size_t i = 0; i < 8; ++i )
+      inputSize_ |= std::uint64_t( pState[6 + i] ) << ( 8 * i );
+
+    pNativeState_ = pState + kStateHeaderSize;
+    nativeStateSize_ = sz_ - kStateHeaderSize;
   }
 
 
@@ -161,9 +547,131 @@ namespace crypto
     }
   }
 
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool is_cryptographic( hash::type type_ ) LL_NOEXCEPT
+  {
+    switch ( type_ )
+    {
+      case hash::type::unknown:
+      case hash::type::crc32c:
+      case hash::type::xxh3_64:
+      case hash::type::xxh3_128:
+        return false;
+      default:
+        return true;
+    }
+  }
+
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::string get_implementation( hash::type type_ )
+  {
+    switch ( type_ )
+    {
+      case hash::type::md4:
+      case hash::type::md5:
+#if LL_IS_WINDOWS()
+        return "bcrypt";
+#elif LL_IS_OSX()
+        return "commoncrypto";
+#elif LL_CRYPTO_OPENSSL_EVP
+        return "openssl-evp";
+#else
+        return "openssl";
+#endif
+      case hash::type::sha1:
+        return sha::get_kernels().sha1Name.load();
+      case hash::type::sha256:
+        return sha::get_kernels().sha256Name.load();
+      case hash::type::sha384:
+      case hash::type::sha512:
+        return sha::get_kernels().sha512Name.load();
+      case hash::type::blake3:
+        return blake3::kernel_name();
+      case hash::type::sha3_256:
+      case hash::type::sha3_512:
+      case hash::type::shake128:
+      case hash::type::shake256:
+        return "portable";
+      case hash::type::crc32c:
+        return crc32c::kernel_name();
+      case hash::type::xxh3_64:
+      case hash::type::xxh3_128:
+        return xxh3::kernel_name();
+      default:
+        throw exception( error::invalid_parameter, "unknown hash type" );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< std::string > get_implementations( hash::type type_ )
+  {
+    switch ( type_ )
+    {
+      case hash::type::sha1:
+      case hash::type::sha256:
+      case hash::type::sha384:
+      case hash::type::sha512:
+        return sha::get_kernel_names( type_ );
+      default:
+        return std::vector< std::string >( 1, get_implementation( type_ ) );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void set_implementation( hash::type type_, const std::string& name_ )
+  {
+    switch ( type_ )
+    {
+      case hash::type::sha1:
+      case hash::type::sha256:
+      case hash::type::sha384:
+      case hash::type::sha512:
+        sha::set_kernel( type_, name_ );
+        break;
+      default:
+        if ( name_ != get_implementation( type_ ) )
+          throw exception( error::invalid_parameter, "implementation not available: " + name_ );
+    }
+  }
+
 #undef M_HASHTYPE_TABLE
 
 
+  // ---------------------------------------------------------------------------------------------------------
+
+  LL_CONSTEXPR size_t digest::maxSize;
+
+  std::string to_string( const digest& digest_ )
+  {
+    return string_from_binary( digest_.data(), digest_.size );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  digest to_digest( const hash& hash_ )
+  {
+    if ( hash_.binary.size() > digest::maxSize )
+      throw exception( error::invalid_parameter, "hash too large" );
+
+    digest d;
+    d.hashType = hash_.hashType;
+    d.size = static_cast< std::uint8_t >( hash_.binary.size() );
+    std::copy( hash_.binary.begin(), hash_.binary.end(), d.bytes.begin() );
+    return d;
+  }
+
+
+
   hash get_hash( const std::string& str_, hash::type type_, const hash::config& cfg_ )
   {
     return get_hash( str_.data(), str_.size(), type_, cfg_ );
@@ -180,11 +688,64 @@ namespace crypto
     if ( type_ == hash::type::unknown )
       throw exception( error::invalid_parameter, "invalid hash type" );
 
-
+    LL_METRICS_CALL( get_hash, type_, szBufferInBytes_ );
     return invoke_hash_generator( static_cast< const uint8_t* >( pBuffer_ ), szBufferInBytes_, type_, cfg_ );    
   }
 
 
+  // ---------------------------------------------------------------------------------------------------------
+
+  digest get_digest( const void* pBuffer_, size_t szBufferInBytes_, hash::type type_, const hash::config& cfg_ )
+  {
+    if ( !pBuffer_ && ( szBufferInBytes_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    LL_METRICS_CALL( get_digest, type_, szBufferInBytes_ );
+
+    if ( use_blake3_threads( type_, cfg_ ) )
+    {
+      digest d;
+      d.hashType = type_;
+      d.size = blake3::kOutSize;
+      hash_blake3_parallel( static_cast< const uint8_t* >( pBuffer_ ), szBufferInBytes_, cfg_.numHashThreads,
+                            d.bytes.data() );
+      return d;
+    }
+
+    pooled_hash_generator calculator( type_ );
+    auto blockSize = get_processing_block_size( type_, hash::source::memory, cfg_ );
+    feed_hash_generator( *calculator, static_cast< const uint8_t* >( pBuffer_ ), szBufferInBytes_, blockSize );
+    return calculator->retrieve_digest();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  hash get_segmented_hash( const buffer_ref* pSegments_, size_t numSegments_, hash::type type_ )
+  {
+    if ( !pSegments_ && ( numSegments_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer list" );
+
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    for ( size_t i = 0; i < numSegments_; ++i )
+    {
+      if ( !pSegments_[i].pBuffer && ( pSegments_[i].szBufferInBytes > 0 ) )
+        throw exception( error::invalid_parameter, "invalid buffer" );
+    }
+
+    LL_METRICS_CALL( get_hash, type_, total_size( pSegments_, numSegments_ ) );
+
+    pooled_hash_generator calculator( type_ );
+    calculator->add_segments( pSegments_, numSegments_ );
+    return calculator->retrieve_hash();
+  }
+
+
   // ---------------------------------------------------------------------------------------------------------
 
   hash get_hash( std::istream& stream_, hash::type type_, const hash::config& cfg_ )
@@ -195,9 +756,79 @@ namespace crypto
     if ( type_ == hash::type::unknown )
       throw exception( error::invalid_parameter, "invalid hash type" );
 
-
+    LL_METRICS_STREAMED_CALL( get_hash_stream, type_ );
     return invoke_hash_generator( stream_, type_, cfg_ );    
   }
 
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  hash_batch get_hashes( const buffer_ref* pBuffers_, size_t numBuffers_, hash::type type_ )
+  {
+    if ( !pBuffers_ && ( numBuffers_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer list" );
+
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    for ( size_t i = 0; i < numBuffers_; ++i )
+    {
+      if ( !pBuffers_[i].pBuffer && ( pBuffers_[i].szBufferInBytes > 0 ) )
+        throw exception( error::invalid_parameter, "invalid buffer" );
+    }
+
+    LL_METRICS_CALL( get_hashes, type_, total_size( pBuffers_, numBuffers_ ) );
+
+    hash_batch batch;
+    batch.hashType = type_;
+    batch.digestSize = digest_size( type_ );
+    batch.binary.resize( numBuffers_ * batch.digestSize );
+
+    if ( hash_multibuffer( pBuffers_, numBuffers_, type_, batch.binary.data() ) )
+      return batch;
+
+    for ( size_t i = 0; i < numBuffers_; ++i )
+    {
+      pooled_hash_generator calculator( type_ );
+      calculator->add_data( static_cast< const std::uint8_t* >( pBuffers_[i].pBuffer ),
+                           pBuffers_[i].szBufferInBytes );
+      auto h = calculator->retrieve_hash();
+      std::copy( h.binary.begin(), h.binary.end(), batch.binary.begin() + i * batch.digestSize );
+    }
+
+    return batch;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  hash_batch get_hashes( const std::vector< buffer_ref >& buffers_, hash::type type_ )
+  {
+    return get_hashes( buffers_.data(), buffers_.size(), type_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< std::string > get_batch_implementations( hash::type type_ )
+  {
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    return get_multibuffer_kernel_names( type_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void set_batch_implementation( hash::type type_, const std::string& name_ )
+  {
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    set_multibuffer_kernel( type_, name_ );
+  }
+
 }  // namespace crypto
 }  // namespace ll
@@ -0,0 +1,423 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/hash_directory.h"
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+
+#include "crypto/codec.h"
+#include "crypto/exception.h"
+#include "directory_listing.h"
+#include "internal_utils.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    const char kManifestHeader[] = "ll_crypto_manifest";
+    const int kManifestVersion = 1;
+
+    enum class verify_result
+    {
+      match,
+      modified,
+      unreadable
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! a work-stealing scheduler for a fixed set of tasks (identified by their index)
+    //! every worker takes tasks from the front of its own deque and steals from the back of the others
+    //! when it runs dry, so the expensive tasks (scheduled first) are spread over all workers and the cheap
+    //! ones fill the gaps at the end
+    class work_stealing_queues
+    {
+    public:
+      work_stealing_queues( size_t numWorkers_ ) : m_queues( numWorkers_ ) {}
+
+      //! distribute the tasks round robin, in the given order of priority
+      void assign( const std::vector< size_t >& tasks_ )
+      {
+        for ( size_t i = 0; i < tasks_.size(); ++i )
+          m_queues[i % m_queues.size()].tasks.push_back( tasks_[i] );
+      }
+
+      bool pop( size_t worker_, size_t& task_ )
+      {
+        {
+          auto& own = m_queues[worker_];
+          std::lock_guard< std::mutex > lock( own.mutex );
+          if ( !own.tasks.empty() )
+          {
+            task_ = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+          }
+        }
+
+        for ( size_t i = 1; i < m_queues.size(); ++i )
+        {
+          auto& victim = m_queues[( worker_ + i ) % m_queues.size()];
+          std::lock_guard< std::mutex > lock( victim.mutex );
+          if ( !victim.tasks.empty() )
+          {
+            task_ = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+    private:
+      struct queue
+      {
+        std::mutex mutex;
+        std::deque< size_t > tasks;
+      };
+
+      std::vector< queue > m_queues;
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! run fn_( task ) for all tasks on numThreads_ threads (including the calling one)
+    //! the first exception thrown by a task is rethrown after all workers have finished, the tasks handle
+    //! the errors of single files themselves, so only fatal ones (e.g. out of memory) end up here
+    template < typename func_t >
+    void run_parallel( const std::vector< size_t >& tasks_, size_t numThreads_, func_t fn_ )
+    {
+      if ( numThreads_ == 0 )
+        numThreads_ = std::max( 1u, std::thread::hardware_concurrency() );
+      numThreads_ = std::max( size_t( 1 ), std::min( numThreads_, tasks_.size() ) );
+
+      work_stealing_queues queues( numThreads_ );
+      queues.assign( tasks_ );
+
+      std::exception_ptr pError;
+      std::mutex errorMutex;
+
+      auto worker = [&]( size_t index_ )
+      {
+        try
+        {
+          size_t task = 0;
+          while ( queues.pop( index_, task ) )
+            fn_( task );
+        }
+        catch ( ... )
+        {
+          std::lock_guard< std::mutex > lock( errorMutex );
+          if ( !pError )
+            pError = std::current_exception();
+        }
+      };
+
+      std::vector< std::thread > threads;
+      for ( size_t i = 1; i < numThreads_; ++i )
+        threads.emplace_back( worker, i );
+
+      worker( 0 );
+      for ( auto& t : threads )
+        t.join();
+
+      if ( pError )
+        std::rethrow_exception( pError );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the task order: largest files first
+    std::vector< size_t > by_size_descending( const std::vector< std::uint64_t >& sizes_ )
+    {
+      std::vector< size_t > order( sizes_.size() );
+      for ( size_t i = 0; i < order.size(); ++i )
+        order[i] = i;
+
+      std::stable_sort( order.begin(), order.end(), [&]( size_t lhs_, size_t rhs_ )
+      {
+        return sizes_[lhs_] > sizes_[rhs_];
+      } );
+      return order;
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  manifest hash_directory( const std::string& root_, hash::type type_, const directory_hash_config& cfg_ )
+  {
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    manifest result;
+    result.hashType = type_;
+
+    std::vector< directory_entry > files;
+    list_files( root_, files, result.unreadable );
+    result.entries.resize( files.size() );
+
+    std::vector< std::uint64_t > sizes( files.size() );
+    for ( size_t i = 0; i < files.size(); ++i )
+      sizes[i] = files[i].size;
+
+    // the results are collected per file, so the workers don't have to synchronize
+    std::vector< char > unreadable( files.size(), 0 );
+
+    run_parallel( by_size_descending( sizes ), cfg_.numThreads, [&]( size_t index_ )
+    {
+      auto& entry = result.entries[index_];
+      entry.path = files[index_].path;
+      try
+      {
+        auto h = get_file_hash( join_path( root_, entry.path ), type_, cfg_.hashConfig );
+        entry.size = h.inputSize;
+        entry.fileDigest = to_digest( h );
+      }
+      catch ( const exception& )
+      {
+        unreadable[index_] = 1;
+      }
+    } );
+
+    size_t numRead = 0;
+    for ( size_t i = 0; i < files.size(); ++i )
+    {
+      if ( unreadable[i] )
+        result.unreadable.push_back( result.entries[i].path );
+      else if ( numRead++ != i )
+        result.entries[numRead - 1] = std::move( result.entries[i] );
+    }
+    result.entries.resize( numRead );
+
+    auto byPath = []( const manifest_entry& lhs_, const manifest_entry& rhs_ )
+    {
+      return lhs_.path < rhs_.path;
+    };
+    std::sort( result.entries.begin(), result.entries.end(), byPath );
+    std::sort( result.unreadable.begin(), result.unreadable.end() );
+    return result;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< manifest_mismatch > verify_manifest( const std::string& root_,
+                                                    const manifest& manifest_,
+                                                    const directory_hash_config& cfg_ )
+  {
+    if ( manifest_.hashType == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    std::vector< directory_entry > files;
+    std::vector< std::string > unreadableTree;
+    list_files( root_, files, unreadableTree );
+
+    std::unordered_map< std::string, std::uint64_t > treeSizes;
+    for ( const auto& file : files )
+      treeSizes[file.path] = file.size;
+
+    std::vector< manifest_mismatch > mismatches;
+    auto add_mismatch = [&]( manifest_mismatch::kind kind_, const std::string& path_ )
+    {
+      manifest_mismatch m;
+      m.mismatchKind = kind_;
+      m.path = path_;
+      mismatches.push_back( m );
+    };
+
+    // the parts of the tree that couldn't be listed hide the manifest entries at or below them
+    for ( const auto& path : unreadableTree )
+      add_mismatch( manifest_mismatch::kind::unreadable, path );
+
+    auto hidden_by = [&]( const std::string& path_ ) -> const std::string*
+    {
+      for ( const auto& unreadable : unreadableTree )
+      {
+        if ( ( path_.compare( 0, unreadable.size(), unreadable ) == 0 )
+             && ( ( path_.size() == unreadable.size() ) || ( path_[unreadable.size()] == '/' ) ) )
+          return &unreadable;
+      }
+      return nullptr;
+    };
+
+    // only files with matching sizes have to be hashed
+    std::vector< size_t > candidates;
+    std::vector< std::uint64_t > sizes;
+    for ( size_t i = 0; i < manifest_.entries.size(); ++i )
+    {
+      const auto& entry = manifest_.entries[i];
+      auto it = treeSizes.find( entry.path );
+      if ( it == treeSizes.end() )
+      {
+        auto pHidden = hidden_by( entry.path );
+        if ( !pHidden )
+          add_mismatch( manifest_mismatch::kind::missing, entry.path );
+        else if ( *pHidden != entry.path )
+          add_mismatch( manifest_mismatch::kind::unreadable, entry.path );
+        continue;
+      }
+
+      if ( it->second != entry.size )
+        add_mismatch( manifest_mismatch::kind::modified, entry.path );
+      else
+      {
+        candidates.push_back( i );
+        sizes.push_back( entry.size );
+      }
+      treeSizes.erase( it );
+    }
+
+    for ( const auto& file : treeSizes )
+      add_mismatch( manifest_mismatch::kind::unexpected, file.first );
+
+    // the results are collected per candidate, so the workers don't have to synchronize
+    std::vector< verify_result > results( candidates.size(), verify_result::match );
+
+    run_parallel( by_size_descending( sizes ), cfg_.numThreads, [&]( size_t index_ )
+    {
+      const auto& entry = manifest_.entries[candidates[index_]];
+      try
+      {
+        auto h = get_file_hash( join_path( root_, entry.path ), manifest_.hashType, cfg_.hashConfig );
+        results[index_]
+          = ( to_digest( h ) == entry.fileDigest ) ? verify_result::match : verify_result::modified;
+      }
+      catch ( const exception& )
+      {
+        results[index_] = verify_result::unreadable;
+      }
+    } );
+
+    for ( size_t i = 0; i < candidates.size(); ++i )
+    {
+      const auto& path = manifest_.entries[candidates[i]].path;
+      if ( results[i] == verify_result::modified )
+        add_mismatch( manifest_mismatch::kind::modified, path );
+      else if ( results[i] == verify_result::unreadable )
+        add_mismatch( manifest_mismatch::kind::unreadable, path );
+    }
+
+    auto byPath = []( const manifest_mismatch& lhs_, const manifest_mismatch& rhs_ )
+    {
+      return lhs_.path < rhs_.path;
+    };
+    std::sort( mismatches.begin(), mismatches.end(), byPath );
+    return mismatches;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void write_manifest( std::ostream& stream_, const manifest& manifest_ )
+  {
+    if ( manifest_.hashType == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    stream_ << kManifestHeader << ' ' << kManifestVersion << ' ' << to_string( manifest_.hashType ) << '\n';
+
+    char hex[2 * digest::maxSize];
+    for ( const auto& entry : manifest_.entries )
+    {
+      if ( entry.path.find_first_of( "\r\n" ) != std::string::npos )
+        throw exception( error::invalid_parameter, "path with line break: " + entry.path );
+
+      hex_encode( entry.fileDigest.data(), entry.fileDigest.size, hex );
+      stream_.write( hex, static_cast< std::streamsize >( hex_encoded_size( entry.fileDigest.size ) ) );
+      stream_ << ' ' << entry.size << ' ' << entry.path << '\n';
+    }
+
+    if ( !stream_ )
+      throw exception( error::internal, "can't write manifest" );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  manifest read_manifest( std::istream& stream_ )
+  {
+    std::string header;
+    int version = 0;
+    std::string type;
+    if ( !( stream_ >> header >> version >> type ) || ( header != kManifestHeader ) )
+      throw exception( error::invalid_parameter, "invalid manifest" );
+
+    if ( version != kManifestVersion )
+      throw exception( error::invalid_parameter, "unsupported manifest version" );
+
+    manifest result;
+    result.hashType = to_hash_type( type );
+    if ( result.hashType == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    const auto encodedSize = hex_encoded_size( digest_size( result.hashType ) );
+
+    std::string line;
+    std::getline( stream_, line );  // the rest of the header line
+    while ( std::getline( stream_, line ) )
+    {
+      // manifests that went through a windows text mode stream end their lines with "\r\n"
+      if ( !line.empty() && ( line.back() == '\r' ) )
+        line.pop_back();
+      if ( line.empty() )
+        continue;
+
+      // <hex digest> <size> <path>
+      auto sizeEnd = line.find( ' ', encodedSize + 1 );
+      if ( ( line.size() < encodedSize + 4 ) || ( line[encodedSize] != ' ' ) || ( sizeEnd == std::string::npos )
+           || ( sizeEnd == encodedSize + 1 ) || ( sizeEnd + 1 == line.size() ) )
+        throw exception( error::invalid_parameter, "invalid manifest line: " + line );
+
+      manifest_entry entry;
+      hex_decode( line.data(), encodedSize, 1, result.hashType, &entry.fileDigest );
+
+      for ( size_t i = encodedSize + 1; i < sizeEnd; ++i )
+      {
+        if ( ( line[i] < '0' ) || ( line[i] > '9' ) )
+          throw exception( error::invalid_parameter, "invalid manifest line: " + line );
+
+        auto digit = static_cast< std::uint64_t >( line[i] - '0' );
+        if ( entry.size > ( std::numeric_limits< std::uint64_t >::max() - digit ) / 10 )
+          throw exception( error::invalid_parameter, "invalid manifest line: " + line );
+        entry.size = entry.size * 10 + digit;
+      }
+
+      entry.path = line.substr( sizeEnd + 1 );
+      result.entries.push_back( entry );
+    }
+
+    return result;
+  }
+
+}  // namespace crypto
+}  // namespace ll
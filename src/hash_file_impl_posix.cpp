@@ -0,0 +1,288 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/hash.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <vector>
+
+#include "crypto/exception.h"
+#include "internal_utils.h"
+#include "file_hash_cache.h"
+#include "generator_pool.h"
+#include "processing_block.h"
+#include "metrics_registry.h"
+#include "tracing.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    //! the maximum size of a single mapped view, bounds the address space used for huge files
+    const std::uint64_t kMaxViewSize = 1024 * 1024 * 1024;
+
+    //! the amount of data we ask the kernel to prefetch ahead of the hashing position
+    const size_t kReadAheadWindow = 8 * 1024 * 1024;
+
+    //! files modified more recently are likely still being written, they are read instead of mapped as
+    //! accessing a mapped page beyond the end of a file that was truncated in the meantime raises SIGBUS
+    const std::int64_t kSettleTimeNs = 2000000000;
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    class file_descriptor
+    {
+    public:
+      explicit file_descriptor( int fd_ ) : m_fd( fd_ ) {}
+      ~file_descriptor()
+      {
+        if ( m_fd >= 0 )
+          ::close( m_fd );
+      }
+
+      file_descriptor( const file_descriptor& ) = delete;
+      file_descriptor& operator=( const file_descriptor& ) = delete;
+
+      int get() const { return m_fd; }
+
+    private:
+      int m_fd;
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    file_identity identity_from_stat( const struct stat& st_ )
+    {
+      file_identity identity;
+      identity.device = static_cast< std::uint64_t >( st_.st_dev );
+      identity.inode = static_cast< std::uint64_t >( st_.st_ino );
+      identity.size = static_cast< std::uint64_t >( st_.st_size );
+#if LL_IS_OSX()
+      const auto& mtime = st_.st_mtimespec;
+#else
+      const auto& mtime = st_.st_mtim;
+#endif
+      identity.modificationTimeNs = static_cast< std::int64_t >( mtime.tv_sec ) * 1000000000
+                                    + static_cast< std::int64_t >( mtime.tv_nsec );
+      return identity;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    bool recently_modified( const struct stat& st_ )
+    {
+      auto now = std::chrono::duration_cast< std::chrono::nanoseconds >(
+                   std::chrono::system_clock::now().time_since_epoch() ).count();
+      auto age = static_cast< std::int64_t >( now ) - identity_from_stat( st_ ).modificationTimeNs;
+      return age < kSettleTimeNs;
+    }
+
+    bool same_version( const struct stat& before_, const struct stat& after_ )
+    {
+      auto before = identity_from_stat( before_ );
+      auto after = identity_from_stat( after_ );
+      return ( before.size == after.size ) && ( before.modificationTimeNs == after.modificationTimeNs );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! hash the file by mapping it view by view, returns false if the file can't be mapped
+    bool hash_mapped( int fd_,
+                      std::uint64_t fileSize_,
+                      hash_generator& calculator_,
+                      size_t blockSize_ )
+    {
+      const std::uint64_t pageSize = static_cast< std::uint64_t >( ::sysconf( _SC_PAGESIZE ) );
+      const std::uint64_t viewSize = kMaxViewSize - ( kMaxViewSize % pageSize );
+
+      for ( std::uint64_t viewOffset = 0; viewOffset < fileSize_; viewOffset += viewSize )
+      {
+        auto sz = static_cast< size_t >( std::min( viewSize, fileSize_ - viewOffset ) );
+        void* pView = ::mmap( nullptr, sz, PROT_READ, MAP_PRIVATE, fd_, static_cast< off_t >( viewOffset ) );
+        if ( pView == MAP_FAILED )
+        {
+          if ( viewOffset == 0 )
+            return false;
+          throw exception( error::internal, errno );
+        }
+
+        auto pData = static_cast< const std::uint8_t* >( pView );
+        ::madvise( pView, sz, MADV_SEQUENTIAL );
+
+        size_t adviseEnd = 0;
+        for ( size_t offset = 0; offset < sz; )
+        {
+          // keep the window ahead of us in flight (offsets are page aligned as the window is)
+          if ( ( offset + kReadAheadWindow > adviseEnd ) && ( adviseEnd < sz ) )
+          {
+            auto adviseSize = std::min( kReadAheadWindow, sz - adviseEnd );
+            ::madvise( const_cast< std::uint8_t* >( pData ) + adviseEnd, adviseSize, MADV_WILLNEED );
+            adviseEnd += adviseSize;
+          }
+
+          auto chunk = std::min( blockSize_, sz - offset );
+          try
+          {
+            calculator_.add_data( pData + offset, chunk );
+          }
+          catch ( ... )
+          {
+            ::munmap( pView, sz );
+            throw;
+          }
+          offset += chunk;
+        }
+
+        ::munmap( pView, sz );
+      }
+
+      return true;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! returns the number of bytes read
+    std::uint64_t hash_read( int fd_, hash_generator& calculator_, size_t blockSize_ )
+    {
+      pooled_block_buffer data( blockSize_ );
+
+      off_t offset = 0;
+      for ( ;; )
+      {
+        auto bytesRead = ::pread( fd_, data.data(), data.size(), offset );
+        if ( bytesRead < 0 )
+        {
+          if ( errno == EINTR )
+            continue;
+
+          // pipes and other unseekable files can't be read with pread
+          if ( errno == ESPIPE )
+            break;
+          throw exception( error::internal, errno );
+        }
+
+        if ( bytesRead == 0 )
+          return static_cast< std::uint64_t >( offset );
+
+        calculator_.add_data( data.data(), static_cast< size_t >( bytesRead ) );
+        offset += bytesRead;
+      }
+
+      for ( ;; )
+      {
+        auto bytesRead = ::read( fd_, data.data(), data.size() );
+        if ( bytesRead < 0 )
+        {
+          if ( errno == EINTR )
+            continue;
+          throw exception( error::internal, errno );
+        }
+
+        if ( bytesRead == 0 )
+          return static_cast< std::uint64_t >( offset );
+
+        calculator_.add_data( data.data(), static_cast< size_t >( bytesRead ) );
+        offset += bytesRead;
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  hash get_file_hash( const std::string& path_, hash::type type_, const hash::config& cfg_ )
+  {
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    file_descriptor fd( ::open( path_.c_str(), O_RDONLY | O_CLOEXEC ) );
+    if ( fd.get() < 0 )
+      throw exception( error::invalid_parameter, "could not open file" );
+
+    LL_METRICS_STREAMED_CALL( get_file_hash, type_ );
+    LL_PROBE2( file_hash_begin, path_.c_str(), static_cast< int >( type_ ) );
+
+    struct stat st;
+    if ( ::fstat( fd.get(), &st ) != 0 )
+      throw exception( error::internal, errno );
+
+    cached_file_hash cache( path_, type_, cfg_ );
+
+    hash cached;
+    if ( cache.enabled() && cache.lookup( identity_from_stat( st ), S_ISREG( st.st_mode ), cached ) )
+    {
+      LL_PROBE4( file_hash_end, path_.c_str(), static_cast< int >( type_ ), std::uint64_t( 0 ), 1 );
+      return cached;
+    }
+
+    pooled_hash_generator calculator( type_ );
+
+    // procfs & co. report a size of 0, so only non-empty regular files are candidates for mapping
+    bool mapped = false;
+    std::uint64_t bytesHashed = 0;
+    if ( cfg_.mapFiles && S_ISREG( st.st_mode ) && ( st.st_size > 0 ) && !recently_modified( st ) )
+    {
+      auto blockSize = get_processing_block_size( type_, hash::source::memory, cfg_ );
+      bytesHashed = static_cast< std::uint64_t >( st.st_size );
+      mapped = hash_mapped( fd.get(), bytesHashed, *calculator, blockSize );
+
+      // the mapping may have shown a mix of old and new content, the file is hashed again with read()
+      struct stat stAfter;
+      if ( mapped && ( ( ::fstat( fd.get(), &stAfter ) != 0 ) || !same_version( st, stAfter ) ) )
+      {
+        calculator->reset();
+        mapped = false;
+      }
+    }
+
+    if ( !mapped )
+    {
+      auto blockSize = get_processing_block_size( type_, hash::source::stream, cfg_ );
+      bytesHashed = hash_read( fd.get(), *calculator, blockSize );
+    }
+
+    auto result = calculator->retrieve_hash();
+
+    if ( cache.enabled() )
+    {
+      struct stat stAfter;
+      bool valid = ( ::fstat( fd.get(), &stAfter ) == 0 ) && S_ISREG( stAfter.st_mode );
+      cache.store( identity_from_stat( valid ? stAfter : st ), valid, result );
+    }
+
+    LL_PROBE4( file_hash_end, path_.c_str(), static_cast< int >( type_ ), bytesHashed, 0 );
+    return result;
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,222 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/hash.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "crypto/exception.h"
+#include "internal_utils.h"
+#include "file_hash_cache.h"
+#include "generator_pool.h"
+#include "processing_block.h"
+#include "metrics_registry.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    //! the maximum size of a single mapped view, bounds the address space used for huge files
+    const std::uint64_t kMaxViewSize = 256 * 1024 * 1024;
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    class handle
+    {
+    public:
+      explicit handle( HANDLE h_ ) : m_handle( h_ ) {}
+      ~handle()
+      {
+        if ( valid() )
+          ::CloseHandle( m_handle );
+      }
+
+      handle( const handle& ) = delete;
+      handle& operator=( const handle& ) = delete;
+
+      HANDLE get() const { return m_handle; }
+      bool valid() const { return ( m_handle != NULL ) && ( m_handle != INVALID_HANDLE_VALUE ); }
+
+    private:
+      HANDLE m_handle;
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the identity of a file on disk, returns false for other files (pipes, consoles, ...)
+    bool get_file_identity( HANDLE file_, file_identity& identity_ )
+    {
+      BY_HANDLE_FILE_INFORMATION info;
+      if ( ( ::GetFileType( file_ ) != FILE_TYPE_DISK ) || !::GetFileInformationByHandle( file_, &info ) )
+        return false;
+
+      // the last write time counts 100ns intervals since 1601
+      const std::int64_t kUnixEpoch = 116444736000000000;
+      auto lastWrite = ( static_cast< std::int64_t >( info.ftLastWriteTime.dwHighDateTime ) << 32 )
+                       | info.ftLastWriteTime.dwLowDateTime;
+
+      identity_.device = info.dwVolumeSerialNumber;
+      identity_.inode = ( static_cast< std::uint64_t >( info.nFileIndexHigh ) << 32 ) | info.nFileIndexLow;
+      identity_.size = ( static_cast< std::uint64_t >( info.nFileSizeHigh ) << 32 ) | info.nFileSizeLow;
+      identity_.modificationTimeNs = ( lastWrite - kUnixEpoch ) * 100;
+      return true;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! hash the file by mapping it view by view, returns false if the file can't be mapped
+    bool hash_mapped( HANDLE hFile_,
+                      std::uint64_t fileSize_,
+                      hash_generator& calculator_,
+                      size_t blockSize_ )
+    {
+      handle mapping( ::CreateFileMappingW( hFile_, NULL, PAGE_READONLY, 0, 0, NULL ) );
+      if ( !mapping.valid() )
+        return false;
+
+      SYSTEM_INFO info;
+      ::GetSystemInfo( &info );
+      const std::uint64_t granularity = info.dwAllocationGranularity;
+      const std::uint64_t viewSize = kMaxViewSize - ( kMaxViewSize % granularity );
+
+      for ( std::uint64_t viewOffset = 0; viewOffset < fileSize_; viewOffset += viewSize )
+      {
+        auto sz = static_cast< size_t >( std::min< std::uint64_t >( viewSize, fileSize_ - viewOffset ) );
+        auto pView = ::MapViewOfFile( mapping.get(), FILE_MAP_READ, static_cast< DWORD >( viewOffset >> 32 ),
+                                      static_cast< DWORD >( viewOffset & 0xffffffff ), sz );
+        if ( pView == NULL )
+        {
+          if ( viewOffset == 0 )
+            return false;
+          throw exception( error::internal, static_cast< int >( ::GetLastError() ) );
+        }
+
+        auto pData = static_cast< const std::uint8_t* >( pView );
+        try
+        {
+          for ( size_t offset = 0; offset < sz; )
+          {
+            auto chunk = std::min< size_t >( blockSize_, sz - offset );
+            calculator_.add_data( pData + offset, chunk );
+            offset += chunk;
+          }
+        }
+        catch ( ... )
+        {
+          ::UnmapViewOfFile( pView );
+          throw;
+        }
+
+        ::UnmapViewOfFile( pView );
+      }
+
+      return true;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void hash_read( HANDLE hFile_, hash_generator& calculator_, size_t blockSize_ )
+    {
+      pooled_block_buffer data( blockSize_ );
+      auto chunk = static_cast< DWORD >( std::min< size_t >( data.size(), MAXDWORD ) );
+
+      for ( ;; )
+      {
+        DWORD bytesRead = 0;
+        if ( !::ReadFile( hFile_, data.data(), chunk, &bytesRead, NULL ) )
+        {
+          // the write end of a pipe was closed
+          if ( ::GetLastError() == ERROR_BROKEN_PIPE )
+            return;
+          throw exception( error::internal, static_cast< int >( ::GetLastError() ) );
+        }
+
+        if ( bytesRead == 0 )
+          return;
+
+        calculator_.add_data( data.data(), bytesRead );
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  hash get_file_hash( const std::string& path_, hash::type type_, const hash::config& cfg_ )
+  {
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    handle file( ::CreateFileW( to_wide_string( path_ ).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL ) );
+    if ( !file.valid() )
+      throw exception( error::invalid_parameter, "could not open file" );
+
+    LL_METRICS_STREAMED_CALL( get_file_hash, type_ );
+
+    cached_file_hash cache( path_, type_, cfg_ );
+
+    if ( cache.enabled() )
+    {
+      file_identity identity;
+      bool valid = get_file_identity( file.get(), identity );
+
+      hash cached;
+      if ( cache.lookup( identity, valid, cached ) )
+        return cached;
+    }
+
+    pooled_hash_generator calculator( type_ );
+
+    bool mapped = false;
+    LARGE_INTEGER fileSize;
+    if ( cfg_.mapFiles && ( ::GetFileType( file.get() ) == FILE_TYPE_DISK )
+         && ::GetFileSizeEx( file.get(), &fileSize ) && ( fileSize.QuadPart > 0 ) )
+    {
+      auto fileSize64 = static_cast< std::uint64_t >( fileSize.QuadPart );
+      auto blockSize = get_processing_block_size( type_, hash::source::memory, cfg_ );
+      mapped = hash_mapped( file.get(), fileSize64, *calculator, blockSize );
+    }
+
+    if ( !mapped )
+      hash_read( file.get(), *calculator, get_processing_block_size( type_, hash::source::stream, cfg_ ) );
+
+    auto result = calculator->retrieve_hash();
+
+    if ( cache.enabled() )
+    {
+      file_identity identity;
+      bool valid = get_file_identity( file.get(), identity );
+      cache.store( identity, valid, result );
+    }
+
+    return result;
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -16,223 +16,287 @@
 
 *************************************************************************************************************/
 
-#include "crypto/hash.h"
+#include "crypto/basic_hash_generator.h"
 
-#include <iostream>
-#include <map>
-#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
 
 #include "../support/environment.h"
 
 #if LL_IS_OSX()
 #define COMMON_DIGEST_FOR_OPENSSL 1
 #include <CommonCrypto/CommonDigest.h>
-#else  // linux
+#elif !LL_CRYPTO_OPENSSL_EVP  // linux
 #include <openssl/md4.h>
 #include <openssl/md5.h>
-#include <openssl/sha.h>
 #endif
 
 #include "crypto/exception.h"
 #include "internal_utils.h"
+#include "openssl_backend.h"
 
 
 namespace ll
 {
 namespace crypto
 {
-  // ---------------------------------------------------------------------------------------------------------
-  // hash_generator::concrete_hash_generator
-  // ---------------------------------------------------------------------------------------------------------
-
-  class hash_generator::concrete_hash_generator : public hash_generator
+  namespace
   {
-  public:
-    concrete_hash_generator( hash::type type_ );
-    virtual ~concrete_hash_generator() = default;
+    //! CommonCrypto takes 32bit lengths, so larger buffers are fed in chunks
+    const size_t kMaxUpdateSize = 0x40000000;
 
-    void add_data( const std::uint8_t* pBuffer_, size_t sz_ ) override;
-    hash retrieve_hash() override;
 
-  private:
-    // the concept declares the interface requirements on the templated models
-    struct context_concept_t
-    {
-      virtual ~context_concept_t() {}
-      virtual void update( const std::uint8_t* pBuffer_, size_t numBytes_ ) = 0;
-      virtual void get_hash_binary( std::vector< std::uint8_t >& buffer_ ) = 0;
-    };
+    // -------------------------------------------------------------------------------------------------------
 
-    // templated model to hold the actual context
-    template < typename context_type_t >
-    struct context_model_t : context_concept_t
+    inline void check_result( int result_ )
     {
-      context_model_t( hash::type type_ = hash::type::unknown );
+      if ( result_ != 1 )
+        throw crypto::exception( error::internal );
+    }
 
-      void update( const std::uint8_t* pBuffer_, size_t numBytes_ ) override
-      {
-        if ( !m_fnFinal )
-          throw exception( error::invalid_request );
-      
-        //! \todo check that numBytes fits in 32bit and throw exception otherwise
-        auto result = m_fnUpdate( pBuffer_, static_cast< std::uint32_t >( numBytes_ ) );
-        if( result != 1 )
-        {
-          throw crypto::exception( error::internal );
-        }
-      }
-
-      void get_hash_binary( std::vector< std::uint8_t >& buffer_ ) override
+
+    // -------------------------------------------------------------------------------------------------------
+
+    template < typename context_type_t, typename update_func_t >
+    void update_in_chunks( void* pContext_,
+                           update_func_t fnUpdate_,
+                           const std::uint8_t* pBuffer_,
+                           size_t sz_ )
+    {
+      auto pContext = static_cast< context_type_t* >( pContext_ );
+      do
       {
-        if ( !m_fnFinal )
-          throw exception( error::invalid_request );
-      
-        buffer_.resize( m_szHash );
-        auto result = m_fnFinal( reinterpret_cast< unsigned char* >( buffer_.data() ) );
-        if( result != 1 )
-        {
-          throw crypto::exception( error::internal );
-        }
-        m_fnFinal = final_func_t();  // reset the function to emulate behaviour on windows
-      }
-
-    private:
-      using update_func_t = std::function< int( const void*, std::uint32_t ) >;
-      using final_func_t = std::function< int(std::uint8_t*)>;
-
-      context_type_t m_context;
-      size_t m_szHash;
-      update_func_t m_fnUpdate;
-      final_func_t m_fnFinal;
-    };
-
-    hash::type m_type = hash::type::unknown;
-    std::uint64_t m_inputSize = 0;
-
-    std::unique_ptr< context_concept_t > m_pImpl;
-  };
+        auto chunk = std::min( sz_, kMaxUpdateSize );
+        check_result( fnUpdate_( pContext, pBuffer_, chunk ) );
+        pBuffer_ += chunk;
+        sz_ -= chunk;
+      } while ( sz_ > 0 );
+    }
 
+    // -------------------------------------------------------------------------------------------------------
+    // state export / import
+    // the exported state is the chaining value (little endian words) followed by the buffered bytes of the
+    // incomplete block, the message length is restored from the input size
+    // -------------------------------------------------------------------------------------------------------
 
-  // ---------------------------------------------------------------------------------------------------------
+    template < typename word_t >
+    void store_le( std::uint8_t* p_, word_t v_ )
+    {
+      for ( size_t i = 0; i < sizeof( word_t ); ++i )
+        p_[i] = static_cast< std::uint8_t >( v_ >> ( 8 * i ) );
+    }
 
-  template <>
-  hash_generator::concrete_hash_generator::context_model_t< MD4_CTX >::context_model_t( hash::type )
-    : m_context( MD4_CTX() ), m_szHash( MD4_DIGEST_LENGTH )
-  {
-    MD4_Init( &m_context );
-    m_fnUpdate = std::bind( MD4_Update, &m_context, std::placeholders::_1, std::placeholders::_2 );
-    m_fnFinal = std::bind( MD4_Final, std::placeholders::_1, &m_context );
-  }
+    template < typename word_t >
+    word_t load_le( const std::uint8_t* p_ )
+    {
+      word_t v = 0;
+      for ( size_t i = 0; i < sizeof( word_t ); ++i )
+        v |= static_cast< word_t >( p_[i] ) << ( 8 * i );
+      return v;
+    }
 
-  template <>
-  hash_generator::concrete_hash_generator::context_model_t< MD5_CTX >::context_model_t( hash::type )
-    : m_context( MD5_CTX() ), m_szHash( MD5_DIGEST_LENGTH )
-  {
-    MD5_Init( &m_context );
-    m_fnUpdate = std::bind( MD5_Update, &m_context, std::placeholders::_1, std::placeholders::_2 );
-    m_fnFinal = std::bind( MD5_Final, std::placeholders::_1, &m_context );
-  }
+#if !LL_IS_OSX()
 
-  template <>
-  hash_generator::concrete_hash_generator::context_model_t< SHA_CTX >::context_model_t( hash::type )
-    : m_context( SHA_CTX() ), m_szHash( SHA_DIGEST_LENGTH )
-  {
-    SHA1_Init( &m_context );
-    m_fnUpdate = std::bind( SHA1_Update, &m_context, std::placeholders::_1, std::placeholders::_2 );
-    m_fnFinal = std::bind( SHA1_Final, std::placeholders::_1, &m_context );
-  }
+    // the chaining values of the OpenSSL contexts
 
-  template <>
-  hash_generator::concrete_hash_generator::context_model_t< SHA256_CTX >::context_model_t( hash::type )
-    : m_context( SHA256_CTX() ), m_szHash( SHA256_DIGEST_LENGTH )
-  {
-    SHA256_Init( &m_context );
-    m_fnUpdate = std::bind( SHA256_Update, &m_context, std::placeholders::_1, std::placeholders::_2 );
-    m_fnFinal = std::bind( SHA256_Final, std::placeholders::_1, &m_context );
-  }
+    template < typename context_type_t >
+    auto md_chain( context_type_t& c_ ) -> decltype( &c_.A )
+    {
+      static_assert( offsetof( context_type_t, D ) == 3 * sizeof( c_.A ), "unexpected context layout" );
+      return &c_.A;
+    }
 
-  template <>
-  hash_generator::concrete_hash_generator::context_model_t< SHA512_CTX >::context_model_t( hash::type type_ )
-    : m_context( SHA512_CTX() )
-    , m_szHash( ( type_ == hash::type::sha384 ) ? SHA384_DIGEST_LENGTH : SHA512_DIGEST_LENGTH )
-  {
-    if ( type_ == hash::type::sha384 )
+    template < typename context_type_t >
+    std::uint8_t* md_buffer( context_type_t& c_ )
+    {
+      return reinterpret_cast< std::uint8_t* >( c_.data );
+    }
+
+    // the message length in bits, split into two halves of the word size
+    template < typename context_type_t >
+    void set_md_length( context_type_t& c_, std::uint64_t inputSize_ )
+    {
+      c_.Nl = static_cast< std::uint32_t >( inputSize_ << 3 );
+      c_.Nh = static_cast< std::uint32_t >( inputSize_ >> 29 );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    template < typename context_type_t, size_t numWords_ >
+    size_t export_context( const void* pContext_, std::uint8_t* pState_ )
     {
-      SHA384_Init( &m_context );
-      m_fnUpdate = std::bind( SHA384_Update, &m_context, std::placeholders::_1, std::placeholders::_2 );
-      m_fnFinal = std::bind( SHA384_Final, std::placeholders::_1, &m_context );
+      auto& c = *static_cast< context_type_t* >( const_cast< void* >( pContext_ ) );
+      auto pChain = md_chain( c );
+      const size_t wordSize = sizeof( pChain[0] );
+
+      for ( size_t i = 0; i < numWords_; ++i )
+        store_le( pState_ + i * wordSize, pChain[i] );
+
+      std::memcpy( pState_ + numWords_ * wordSize, md_buffer( c ), c.num );
+      return numWords_ * wordSize + c.num;
     }
-    else
+
+    template < typename context_type_t, size_t numWords_, size_t blockSize_ >
+    void import_context( void* pContext_, const std::uint8_t* pState_, size_t sz_, std::uint64_t inputSize_ )
     {
-      SHA512_Init( &m_context );
-      m_fnUpdate = std::bind( SHA512_Update, &m_context, std::placeholders::_1, std::placeholders::_2 );
-      m_fnFinal = std::bind( SHA512_Final, std::placeholders::_1, &m_context );
+      auto& c = *static_cast< context_type_t* >( pContext_ );
+      auto pChain = md_chain( c );
+      typedef typename std::remove_reference< decltype( *pChain ) >::type word_t;
+
+      const size_t buffered = static_cast< size_t >( inputSize_ % blockSize_ );
+      if ( sz_ != numWords_ * sizeof( word_t ) + buffered )
+        throw exception( error::invalid_parameter, "invalid hash state" );
+
+      for ( size_t i = 0; i < numWords_; ++i )
+        pChain[i] = load_le< word_t >( pState_ + i * sizeof( word_t ) );
+
+      std::memcpy( md_buffer( c ), pState_ + numWords_ * sizeof( word_t ), buffered );
+      c.num = static_cast< unsigned int >( buffered );
+      set_md_length( c, inputSize_ );
     }
+
+#define LL_EXPORT_CONTEXT( context_type_, numWords_ ) \
+  return export_context< context_type_, numWords_ >( pContext_, pState_ );
+#define LL_IMPORT_CONTEXT( context_type_, numWords_ ) \
+  import_context< context_type_, numWords_, blockSize >( pContext_, pState_, sz_, inputSize_ );
+
+#else
+
+    // the CommonCrypto contexts are opaque
+#define LL_EXPORT_CONTEXT( context_type_, numWords_ ) \
+  throw exception( error::invalid_request, "state export not supported by CommonCrypto" );
+#define LL_IMPORT_CONTEXT( context_type_, numWords_ ) \
+  throw exception( error::invalid_request, "state import not supported by CommonCrypto" );
+
+#endif
   }
 
 
   // ---------------------------------------------------------------------------------------------------------
-  // hash_generator Implementation
+  // hash backends
+  // the native contexts are plain structs without pointers, so they can be copied bytewise
   // ---------------------------------------------------------------------------------------------------------
 
-  hash_generator::hash_generator( hash::type type_ )
-    : m_pImpl( new hash_generator::concrete_hash_generator( type_ ) )
-  {
+#define LL_IMPLEMENT_HASH_BACKEND( type_, context_type_, numWords_, init_, update_, final_ )            \
+  static_assert( sizeof( context_type_ ) <= detail::hash_backend< type_ >::contextSize,                 \
+                 "context storage too small for " #context_type_ );                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::init( void* pContext_ )                                           \
+  {                                                                                                     \
+    check_result( init_( static_cast< context_type_* >( pContext_ ) ) );                                \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::update( void* pContext_, const std::uint8_t* pBuffer_, size_t sz_ ) \
+  {                                                                                                     \
+    update_in_chunks< context_type_ >( pContext_, update_, pBuffer_, sz_ );                             \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::final( void* pContext_, std::uint8_t* pDigest_ )                  \
+  {                                                                                                     \
+    check_result( final_( pDigest_, static_cast< context_type_* >( pContext_ ) ) );                     \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::copy( void* pTarget_, const void* pSource_ )                      \
+  {                                                                                                     \
+    std::memcpy( pTarget_, pSource_, sizeof( context_type_ ) );                                         \
+  }                                                                                                     \
+                                                                                                        \
+  size_t detail::hash_backend< type_ >::export_state( const void* pContext_, std::uint8_t* pState_ )    \
+  {                                                                                                     \
+    LL_EXPORT_CONTEXT( context_type_, numWords_ )                                                       \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::import_state( void* pContext_,                                    \
+                                                    const std::uint8_t* pState_,                        \
+                                                    size_t sz_,                                         \
+                                                    std::uint64_t inputSize_ )                          \
+  {                                                                                                     \
+    LL_IMPORT_CONTEXT( context_type_, numWords_ )                                                       \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::destroy( void* ) LL_NOEXCEPT                                      \
+  {                                                                                                     \
   }
 
-  
+#if !LL_CRYPTO_OPENSSL_EVP
+
+  LL_IMPLEMENT_HASH_BACKEND( hash::type::md4, MD4_CTX, 4, MD4_Init, MD4_Update, MD4_Final )
+  LL_IMPLEMENT_HASH_BACKEND( hash::type::md5, MD5_CTX, 4, MD5_Init, MD5_Update, MD5_Final )
+
+#else
+
   // ---------------------------------------------------------------------------------------------------------
-  // hash_generator::concrete_hash_generator Implementation
+  // EVP backends
+  // the context storage holds a digest context of the per-thread pool (null while none is acquired, so a
+  // failed init or copy isn't released again by destroy)
   // ---------------------------------------------------------------------------------------------------------
 
-  hash_generator::concrete_hash_generator::concrete_hash_generator( hash::type type_ ) : m_type( type_ )
+  namespace
   {
-    switch ( m_type )
+    inline EVP_MD_CTX*& evp_context( void* pContext_ )
     {
-      case hash::type::md4:
-        m_pImpl = std::unique_ptr< context_concept_t >( new context_model_t< MD4_CTX >() );
-        break;
-      case hash::type::md5:
-        m_pImpl = std::unique_ptr< context_concept_t >( new context_model_t< MD5_CTX >() );
-        break;
-      case hash::type::sha1:
-        m_pImpl = std::unique_ptr< context_concept_t >( new context_model_t< SHA_CTX >() );
-        break;
-      case hash::type::sha256:
-        m_pImpl = std::unique_ptr< context_concept_t >( new context_model_t< SHA256_CTX >() );
-        break;
-      case hash::type::sha384:
-        m_pImpl = std::unique_ptr< context_concept_t >( new context_model_t< SHA512_CTX >( m_type ) );
-        break;
-      case hash::type::sha512:
-        m_pImpl = std::unique_ptr< context_concept_t >( new context_model_t< SHA512_CTX >() );
-        break;
-      default:
-        throw exception( error::invalid_parameter, "Unsupported hash type" );
+      return *static_cast< EVP_MD_CTX** >( pContext_ );
     }
-  }
 
+    inline const EVP_MD_CTX* evp_context( const void* pContext_ )
+    {
+      return *static_cast< EVP_MD_CTX* const* >( pContext_ );
+    }
+  }
 
-  // ---------------------------------------------------------------------------------------------------------
-
-  void hash_generator::concrete_hash_generator::add_data( const std::uint8_t* pBuffer_, size_t numBytes_ )
-  {
-    m_pImpl->update( pBuffer_, numBytes_ );
-    m_inputSize += numBytes_;
+#define LL_IMPLEMENT_EVP_HASH_BACKEND( type_ )                                                         \
+  void detail::hash_backend< type_ >::init( void* pContext_ )                                           \
+  {                                                                                                     \
+    evp_context( pContext_ ) = nullptr;                                                                 \
+    evp_context( pContext_ ) = openssl::acquire_digest_context( type_ );                                \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::update( void* pContext_, const std::uint8_t* pBuffer_, size_t sz_ ) \
+  {                                                                                                     \
+    check_result( EVP_DigestUpdate( evp_context( pContext_ ), pBuffer_, sz_ ) );                        \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::final( void* pContext_, std::uint8_t* pDigest_ )                  \
+  {                                                                                                     \
+    check_result( EVP_DigestFinal_ex( evp_context( pContext_ ), pDigest_, nullptr ) );                  \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::copy( void* pTarget_, const void* pSource_ )                      \
+  {                                                                                                     \
+    evp_context( pTarget_ ) = nullptr;                                                                  \
+    evp_context( pTarget_ ) = openssl::acquire_digest_context( type_, evp_context( pSource_ ) );         \
+  }                                                                                                     \
+                                                                                                        \
+  size_t detail::hash_backend< type_ >::export_state( const void*, std::uint8_t* )                      \
+  {                                                                                                     \
+    throw exception( error::invalid_request, "state export not supported by the EVP backend" );         \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::import_state( void*, const std::uint8_t*, size_t, std::uint64_t ) \
+  {                                                                                                     \
+    throw exception( error::invalid_request, "state import not supported by the EVP backend" );         \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::destroy( void* pContext_ ) LL_NOEXCEPT                            \
+  {                                                                                                     \
+    if ( evp_context( pContext_ ) )                                                                     \
+      openssl::release_digest_context( type_, evp_context( pContext_ ) );                               \
+    evp_context( pContext_ ) = nullptr;                                                                 \
   }
 
+  LL_IMPLEMENT_EVP_HASH_BACKEND( hash::type::md4 )
+  LL_IMPLEMENT_EVP_HASH_BACKEND( hash::type::md5 )
 
-  // ---------------------------------------------------------------------------------------------------------
+#undef LL_IMPLEMENT_EVP_HASH_BACKEND
 
-  hash hash_generator::concrete_hash_generator::retrieve_hash()
-  {
-    hash h;
-    h.hashType = m_type;
-    h.inputSize = m_inputSize;
-    m_pImpl->get_hash_binary( h.binary );
-    return h;
-  }
+#endif
 
+#undef LL_IMPLEMENT_HASH_BACKEND
+#undef LL_EXPORT_CONTEXT
+#undef LL_IMPORT_CONTEXT
 
 }  // namespace crypto
 }  // namespace ll
@@ -16,13 +16,14 @@
 
 *************************************************************************************************************/
 
-#include "crypto/hash.h"
+#include "crypto/basic_hash_generator.h"
 
 #include <Windows.h>
 #include <bcrypt.h>
 
-#include <map>
 #include <algorithm>
+#include <cstddef>
+#include <mutex>
 
 #include "crypto/exception.h"
 #include "internal_utils.h"
@@ -32,134 +33,190 @@ namespace ll
 {
 namespace crypto
 {
-  // ---------------------------------------------------------------------------------------------------------
-  // hash_generator::concrete_hash_generator
-  // ---------------------------------------------------------------------------------------------------------
-
-  class hash_generator::concrete_hash_generator : public hash_generator
+  namespace
   {
-  public:
-    concrete_hash_generator( hash::type type_ );
-    virtual ~concrete_hash_generator();
+    //! the layout of the context storage: the hash handle followed by the hash object it refers to
+    struct bcrypt_context
+    {
+      BCRYPT_HASH_HANDLE hHash;
+      UCHAR hashObject[1];
+    };
 
-    void add_data( const std::uint8_t* pBuffer_, size_t sz_ ) override;
-    hash retrieve_hash() override;
 
-  private:
-    hash::type m_type = hash::type::unknown;
-    std::uint64_t m_inputSize = 0;
+    // -------------------------------------------------------------------------------------------------------
 
-    BCRYPT_ALG_HANDLE m_hAlgorithm = NULL;
-    BCRYPT_HASH_HANDLE m_hHash2 = NULL;
-    std::vector< char > m_hashData;
+    //! the algorithm providers are opened once per process and shared by all generators
+    struct algorithm_provider
+    {
+      BCRYPT_ALG_HANDLE hAlgorithm = NULL;
+      ULONG hashObjectLength = 0;
+      NTSTATUS status = 0;
+    };
 
-    HCRYPTPROV m_hProvider = NULL;  // nullptr cannot be used here
-    HCRYPTHASH m_hHash = NULL;
-  };
 
+    // -------------------------------------------------------------------------------------------------------
 
-  // ---------------------------------------------------------------------------------------------------------
-  // hash_generator Implementation
-  // ---------------------------------------------------------------------------------------------------------
-
-  hash_generator::hash_generator( hash::type type_ )
-    : m_pImpl( new hash_generator::concrete_hash_generator( type_ ) )
-  {
-  }
+    const algorithm_provider& get_algorithm_provider( hash::type type_ )
+    {
+      static algorithm_provider s_providers[8];
+      static std::once_flag s_flags[8];
+
+      auto index = static_cast< size_t >( type_ );
+      std::call_once( s_flags[index], [&]()
+      {
+        auto& provider = s_providers[index];
+        provider.status
+          = ::BCryptOpenAlgorithmProvider( &provider.hAlgorithm, to_windows_hash_type( type_ ), NULL, 0 );
+        if ( !BCRYPT_SUCCESS( provider.status ) )
+          return;
+
+        ULONG resultSize = 0;
+        provider.status = ::BCryptGetProperty( provider.hAlgorithm, BCRYPT_OBJECT_LENGTH,
+                                               reinterpret_cast< PUCHAR >( &provider.hashObjectLength ),
+                                               sizeof( provider.hashObjectLength ), &resultSize, 0 );
+      } );
+
+      const auto& provider = s_providers[index];
+      if ( !BCRYPT_SUCCESS( provider.status ) )
+        throw exception( error::internal, provider.status );
+
+      return provider;
+    }
 
 
-  // ---------------------------------------------------------------------------------------------------------
-  // hash_generator::concrete_hash_generator Implementation
-  // ---------------------------------------------------------------------------------------------------------
+    // -------------------------------------------------------------------------------------------------------
 
-  hash_generator::concrete_hash_generator::concrete_hash_generator( hash::type type_ ) : m_type( type_ )
-  {
-    auto result = ::BCryptOpenAlgorithmProvider( &m_hAlgorithm, to_windows_hash_type( m_type ), NULL, 0 );
-    if ( !BCRYPT_SUCCESS( result ) )
+    void init_context( hash::type type_, void* pContext_, size_t contextSize_ )
     {
-      throw exception( error::internal, result );
-    }
+      const auto& provider = get_algorithm_provider( type_ );
+      if ( provider.hashObjectLength > contextSize_ - offsetof( bcrypt_context, hashObject ) )
+        throw exception( error::internal, "hash object exceeds the context storage" );
 
-    ULONG hashObjectLength = 0;
-    ULONG resultSize = 0;
-    result = ::BCryptGetProperty( m_hAlgorithm, BCRYPT_OBJECT_LENGTH,
-                                  reinterpret_cast< PUCHAR >( &hashObjectLength ), sizeof( hashObjectLength ),
-                                  &resultSize, 0 );
-    if ( !BCRYPT_SUCCESS( result ) )
-    {
-      throw exception( error::internal, result );
+      auto pContext = static_cast< bcrypt_context* >( pContext_ );
+      pContext->hHash = NULL;
+
+      auto result = ::BCryptCreateHash( provider.hAlgorithm, &pContext->hHash, pContext->hashObject,
+                                        provider.hashObjectLength, NULL, 0, 0 );
+      if ( !BCRYPT_SUCCESS( result ) )
+        throw exception( error::internal, result );
     }
 
-    m_hashData.resize( hashObjectLength, 0 );
-    result = ::BCryptCreateHash( m_hAlgorithm, &m_hHash2, reinterpret_cast< PUCHAR >( m_hashData.data() ),
-                                 static_cast< ULONG >( m_hashData.size() ), NULL, 0, 0 );
-    if ( !BCRYPT_SUCCESS( result ) )
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void update_context( void* pContext_, const std::uint8_t* pBuffer_, size_t sz_ )
     {
-      throw exception( error::internal, result );
+      auto pContext = static_cast< bcrypt_context* >( pContext_ );
+
+      // BCrypt takes 32bit lengths, so larger buffers are fed in chunks
+      do
+      {
+        auto chunk = static_cast< ULONG >( std::min< size_t >( sz_, 0x40000000 ) );
+        auto result = ::BCryptHashData( pContext->hHash, const_cast< PUCHAR >( pBuffer_ ), chunk, 0 );
+        if ( !BCRYPT_SUCCESS( result ) )
+        {
+          if ( result == STATUS_INVALID_HANDLE )
+            throw exception( error::invalid_request );
+          else
+            throw exception( error::internal, result );
+        }
+        pBuffer_ += chunk;
+        sz_ -= chunk;
+      } while ( sz_ > 0 );
     }
-  }
 
 
-  // ---------------------------------------------------------------------------------------------------------
+    // -------------------------------------------------------------------------------------------------------
 
-  hash_generator::concrete_hash_generator::~concrete_hash_generator()
-  {
-    if ( m_hHash2 != NULL )
-      BCryptDestroyHash( m_hHash2 );
-    if ( m_hAlgorithm )
-      BCryptCloseAlgorithmProvider( m_hAlgorithm, 0 );
-  }
+    void final_context( void* pContext_, std::uint8_t* pDigest_, size_t digestSize_ )
+    {
+      auto pContext = static_cast< bcrypt_context* >( pContext_ );
+
+      auto result = ::BCryptFinishHash( pContext->hHash, pDigest_, static_cast< ULONG >( digestSize_ ), 0 );
+      if ( !BCRYPT_SUCCESS( result ) )
+      {
+        if ( result == STATUS_INVALID_HANDLE )
+          throw exception( error::invalid_request );
+        else
+          throw exception( error::internal, result );
+      }
+    }
 
 
-  // ---------------------------------------------------------------------------------------------------------
+    // -------------------------------------------------------------------------------------------------------
 
-  void hash_generator::concrete_hash_generator::add_data( const std::uint8_t* pBuffer_, size_t numBytes_ )
-  {
-    auto result = ::BCryptHashData( m_hHash2, reinterpret_cast< PUCHAR >( const_cast< uint8_t* >( pBuffer_ ) ),
-                                    static_cast< ULONG >( numBytes_ ), 0 );
-    if ( !BCRYPT_SUCCESS( result ) )
+    void copy_context( hash::type type_, void* pTarget_, const void* pSource_ )
     {
-      if( result == STATUS_INVALID_HANDLE )
-        throw exception( error::invalid_request );
-      else
+      const auto& provider = get_algorithm_provider( type_ );
+
+      // the hash object refers to its own memory, so it has to be duplicated by BCrypt
+      auto pTarget = static_cast< bcrypt_context* >( pTarget_ );
+      auto pSource = static_cast< const bcrypt_context* >( pSource_ );
+      pTarget->hHash = NULL;
+
+      auto result = ::BCryptDuplicateHash(
+        pSource->hHash, &pTarget->hHash, pTarget->hashObject, provider.hashObjectLength, 0 );
+      if ( !BCRYPT_SUCCESS( result ) )
         throw exception( error::internal, result );
     }
 
-    m_inputSize += numBytes_;
-  }
 
+    // -------------------------------------------------------------------------------------------------------
 
-  // ---------------------------------------------------------------------------------------------------------
-
-  hash hash_generator::concrete_hash_generator::retrieve_hash()
-  {
-    hash h;
-    h.hashType = m_type;
-    h.inputSize = m_inputSize;
-
-    std::uint32_t hashLength = 0;
-    ULONG resultSize = 0;
-    auto result
-      = ::BCryptGetProperty( m_hAlgorithm, BCRYPT_HASH_LENGTH, reinterpret_cast< PUCHAR >( &hashLength ),
-                             sizeof( hashLength ), &resultSize, 0 );
-    if ( !BCRYPT_SUCCESS( result ) )
+    void destroy_context( void* pContext_ ) LL_NOEXCEPT
     {
-      throw exception( error::internal, result );
+      auto pContext = static_cast< bcrypt_context* >( pContext_ );
+      if ( pContext->hHash != NULL )
+        ::BCryptDestroyHash( pContext->hHash );
+      pContext->hHash = NULL;
     }
+  }
 
-    h.binary.resize( hashLength );
-    result = BCryptFinishHash( m_hHash2, reinterpret_cast< PUCHAR >( h.binary.data() ), hashLength, 0 );
-    if ( !BCRYPT_SUCCESS( result ) )
-    {
-      if( result == STATUS_INVALID_HANDLE )
-        throw exception( error::invalid_request );
-      else
-        throw exception( error::internal, result );
-    }
 
-    return h;
+  // ---------------------------------------------------------------------------------------------------------
+  // hash backends
+  // ---------------------------------------------------------------------------------------------------------
+
+#define LL_IMPLEMENT_HASH_BACKEND( type_ )                                                              \
+  void detail::hash_backend< type_ >::init( void* pContext_ )                                           \
+  {                                                                                                     \
+    init_context( type_, pContext_, contextSize );                                                      \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::update( void* pContext_, const std::uint8_t* pBuffer_, size_t sz_ ) \
+  {                                                                                                     \
+    update_context( pContext_, pBuffer_, sz_ );                                                         \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::final( void* pContext_, std::uint8_t* pDigest_ )                  \
+  {                                                                                                     \
+    final_context( pContext_, pDigest_, digestSize );                                                   \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::copy( void* pTarget_, const void* pSource_ )                      \
+  {                                                                                                     \
+    copy_context( type_, pTarget_, pSource_ );                                                          \
+  }                                                                                                     \
+                                                                                                        \
+  size_t detail::hash_backend< type_ >::export_state( const void*, std::uint8_t* )                      \
+  {                                                                                                     \
+    throw exception( error::invalid_request, "state export not supported by BCrypt" );                  \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::import_state( void*, const std::uint8_t*, size_t, std::uint64_t ) \
+  {                                                                                                     \
+    throw exception( error::invalid_request, "state import not supported by BCrypt" );                  \
+  }                                                                                                     \
+                                                                                                        \
+  void detail::hash_backend< type_ >::destroy( void* pContext_ ) LL_NOEXCEPT                            \
+  {                                                                                                     \
+    destroy_context( pContext_ );                                                                       \
   }
 
+  LL_IMPLEMENT_HASH_BACKEND( hash::type::md4 )
+  LL_IMPLEMENT_HASH_BACKEND( hash::type::md5 )
+
+#undef LL_IMPLEMENT_HASH_BACKEND
 
 }  // namespace crypto
 }  // namespace ll
@@ -0,0 +1,182 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "hash_multibuffer.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "crypto/exception.h"
+#include "cpu_features.h"
+#include "keccak.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    static const size_t kNumTypes = static_cast< size_t >( hash::type::xxh3_128 ) + 1;
+
+    enum class kernel
+    {
+      automatic,  //!< the first usable kernel that takes the batch
+      single,     //!< the single-message path of the caller
+      avx2,
+      avx512
+    };
+
+    struct kernel_entry
+    {
+      kernel id;
+      const char* name;
+    };
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the kernels usable on this cpu for a hash type in the order of preference, up to the single-message
+    //! path (the kernels after it are only used if forced)
+    std::vector< kernel_entry > find_kernels( hash::type type_ )
+    {
+      const auto& features = get_cpu_features();
+      const kernel_entry single = { kernel::single, "single" };
+      const kernel_entry avx2 = { kernel::avx2, "avx2" };
+
+      std::vector< kernel_entry > k;
+      if ( keccak::find_params( type_ ) )
+      {
+        if ( features.avx2 )
+          k.push_back( avx2 );
+      }
+      else if ( ( type_ == hash::type::md5 ) || ( type_ == hash::type::sha1 ) || ( type_ == hash::type::sha256 ) )
+      {
+#if LL_HAS_AVX512()
+        if ( features.avx512f )
+          k.push_back( { kernel::avx512, "avx512" } );
+#endif
+
+        // with the SHA extensions a single sha-1 stream is as fast as eight avx2 lanes and a single sha-256
+        // stream is faster, the avx-512 lanes still beat both
+        if ( ( type_ != hash::type::md5 ) && features.sha && features.sse41 )
+          k.push_back( single );
+        if ( features.avx2 )
+          k.push_back( avx2 );
+      }
+
+      if ( std::none_of( k.begin(), k.end(), []( const kernel_entry& e_ ) { return e_.id == kernel::single; } ) )
+        k.push_back( single );
+      return k;
+    }
+
+    const std::vector< kernel_entry >& usable_kernels( hash::type type_ )
+    {
+      static const std::vector< std::vector< kernel_entry > > s_kernels = []
+      {
+        std::vector< std::vector< kernel_entry > > kernels;
+        for ( size_t i = 0; i < kNumTypes; ++i )
+          kernels.push_back( find_kernels( static_cast< hash::type >( i ) ) );
+        return kernels;
+      }();
+      return s_kernels.at( static_cast< size_t >( type_ ) );
+    }
+
+    //! the kernel forced with set_multibuffer_kernel per hash type (zero initialized, i.e. automatic)
+    std::atomic< int > g_forcedKernels[kNumTypes];
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! returns false if the kernel doesn't take the batch (e.g. too small to fill the lanes)
+    bool run_kernel( kernel kernel_,
+                     const buffer_ref* pBuffers_,
+                     size_t numBuffers_,
+                     hash::type type_,
+                     std::uint8_t* pDigests_ )
+    {
+      switch ( kernel_ )
+      {
+        case kernel::avx2:
+          if ( auto pParams = keccak::find_params( type_ ) )
+            return keccak::hash_many_avx2( pBuffers_, numBuffers_, *pParams, pDigests_ );
+          return hash_multibuffer_avx2( pBuffers_, numBuffers_, type_, pDigests_ );
+#if LL_HAS_AVX512()
+        case kernel::avx512:
+          return hash_multibuffer_avx512( pBuffers_, numBuffers_, type_, pDigests_ );
+#endif
+        default:
+          return false;
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool hash_multibuffer( const buffer_ref* pBuffers_,
+                         size_t numBuffers_,
+                         hash::type type_,
+                         std::uint8_t* pDigests_ )
+  {
+    auto forced = static_cast< kernel >( g_forcedKernels[static_cast< size_t >( type_ )].load() );
+    if ( forced != kernel::automatic )
+      return run_kernel( forced, pBuffers_, numBuffers_, type_, pDigests_ );
+
+    for ( const auto& k : usable_kernels( type_ ) )
+    {
+      if ( k.id == kernel::single )
+        return false;
+      if ( run_kernel( k.id, pBuffers_, numBuffers_, type_, pDigests_ ) )
+        return true;
+    }
+    return false;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< std::string > get_multibuffer_kernel_names( hash::type type_ )
+  {
+    std::vector< std::string > names;
+    for ( const auto& k : usable_kernels( type_ ) )
+      names.push_back( k.name );
+    return names;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void set_multibuffer_kernel( hash::type type_, const std::string& name_ )
+  {
+    const auto& kernels = usable_kernels( type_ );
+    for ( const auto& k : kernels )
+    {
+      if ( name_ == k.name )
+      {
+        // the default selects the automatic dispatch again, which falls back on small batches
+        auto id = ( &k == &kernels.front() ) ? kernel::automatic : k.id;
+        g_forcedKernels[static_cast< size_t >( type_ )] = static_cast< int >( id );
+        return;
+      }
+    }
+    throw exception( error::invalid_parameter, "implementation not available: " + name_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,65 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! hash independent messages in interleaved SIMD lanes and write their digests contiguously to pDigests_
+  //! returns false if there is no multi-buffer kernel for the type on this cpu that beats the single-message
+  //! path or the batch is too small to fill the lanes reasonably, the caller has to fall back to the
+  //! single-message path in that case
+  bool hash_multibuffer( const buffer_ref* pBuffers_,
+                         size_t numBuffers_,
+                         hash::type type_,
+                         std::uint8_t* pDigests_ );
+
+  //! the kernels usable for a hash type on this cpu, the default one first ("single" is the single-message
+  //! path, see get_batch_implementations)
+  std::vector< std::string > get_multibuffer_kernel_names( hash::type type_ );
+
+  //! makes hash_multibuffer use one of get_multibuffer_kernel_names( type_ ) for the hash type, throws
+  //! error::invalid_parameter if it isn't usable here
+  void set_multibuffer_kernel( hash::type type_, const std::string& name_ );
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // instruction set specific kernels (only to be called if the cpu supports the instruction set)
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool hash_multibuffer_avx2( const buffer_ref* pBuffers_,
+                              size_t numBuffers_,
+                              hash::type type_,
+                              std::uint8_t* pDigests_ );
+
+  bool hash_multibuffer_avx512( const buffer_ref* pBuffers_,
+                                size_t numBuffers_,
+                                hash::type type_,
+                                std::uint8_t* pDigests_ );
+
+}  // namespace crypto
+}  // namespace ll
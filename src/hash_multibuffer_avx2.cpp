@@ -0,0 +1,139 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "hash_multibuffer.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    typedef __m256i vec_t;
+    const size_t kNumLanes = 8;
+
+    inline vec_t set1( std::uint32_t v_ ) { return _mm256_set1_epi32( static_cast< int >( v_ ) ); }
+
+    inline vec_t load( const std::uint32_t* p_ )
+    {
+      return _mm256_loadu_si256( reinterpret_cast< const vec_t* >( p_ ) );
+    }
+
+    inline void store( std::uint32_t* p_, vec_t v_ )
+    {
+      _mm256_storeu_si256( reinterpret_cast< vec_t* >( p_ ), v_ );
+    }
+
+    inline vec_t add( vec_t a_, vec_t b_ ) { return _mm256_add_epi32( a_, b_ ); }
+    inline vec_t xor_( vec_t a_, vec_t b_ ) { return _mm256_xor_si256( a_, b_ ); }
+    inline vec_t and_( vec_t a_, vec_t b_ ) { return _mm256_and_si256( a_, b_ ); }
+    inline vec_t or_( vec_t a_, vec_t b_ ) { return _mm256_or_si256( a_, b_ ); }
+    inline vec_t andnot( vec_t a_, vec_t b_ ) { return _mm256_andnot_si256( a_, b_ ); }
+
+    template < int n_ >
+    inline vec_t rotl( vec_t v_ )
+    {
+      return _mm256_or_si256( _mm256_slli_epi32( v_, n_ ), _mm256_srli_epi32( v_, 32 - n_ ) );
+    }
+
+    template < int n_ >
+    inline vec_t shr( vec_t v_ )
+    {
+      return _mm256_srli_epi32( v_, n_ );
+    }
+
+    inline vec_t bswap( vec_t v_ )
+    {
+      const vec_t kShuffle = _mm256_setr_epi8( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,  //
+                                               3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+      return _mm256_shuffle_epi8( v_, kShuffle );
+    }
+
+    //! the 16 words of the blocks of all lanes, word t of every lane in pWords_[t]: two 8x8 transposes of
+    //! the block halves (unpacking 32bit then 64bit elements within the 128bit halves, then swapping halves)
+    inline void load_blocks( const std::uint8_t* const* ppBlocks_, vec_t* pWords_ )
+    {
+      for ( size_t half = 0; half < 2; ++half )
+      {
+        vec_t r[8];
+        for ( size_t l = 0; l < 8; ++l )
+          r[l] = _mm256_loadu_si256( reinterpret_cast< const vec_t* >( ppBlocks_[l] + 32 * half ) );
+
+        vec_t t[8];
+        for ( size_t i = 0; i < 8; i += 2 )
+        {
+          t[i] = _mm256_unpacklo_epi32( r[i], r[i + 1] );
+          t[i + 1] = _mm256_unpackhi_epi32( r[i], r[i + 1] );
+        }
+
+        vec_t u[8];
+        for ( size_t i = 0; i < 8; i += 4 )
+        {
+          u[i] = _mm256_unpacklo_epi64( t[i], t[i + 2] );
+          u[i + 1] = _mm256_unpackhi_epi64( t[i], t[i + 2] );
+          u[i + 2] = _mm256_unpacklo_epi64( t[i + 1], t[i + 3] );
+          u[i + 3] = _mm256_unpackhi_epi64( t[i + 1], t[i + 3] );
+        }
+
+        auto pWords = pWords_ + 8 * half;
+        for ( size_t j = 0; j < 4; ++j )
+        {
+          pWords[j] = _mm256_permute2x128_si256( u[j], u[j + 4], 0x20 );
+          pWords[j + 4] = _mm256_permute2x128_si256( u[j], u[j + 4], 0x31 );
+        }
+      }
+    }
+
+#include "hash_multibuffer_kernels.h"
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool hash_multibuffer_avx2( const buffer_ref* pBuffers_,
+                              size_t numBuffers_,
+                              hash::type type_,
+                              std::uint8_t* pDigests_ )
+  {
+    // with less than half of the lanes in use the single-message path is faster
+    if ( numBuffers_ < kNumLanes / 2 )
+      return false;
+
+    switch ( type_ )
+    {
+      case hash::type::md5:
+        mb::hash_lanes< mb::md5_kernel >( pBuffers_, numBuffers_, pDigests_ );
+        return true;
+      case hash::type::sha1:
+        mb::hash_lanes< mb::sha1_kernel >( pBuffers_, numBuffers_, pDigests_ );
+        return true;
+      case hash::type::sha256:
+        mb::hash_lanes< mb::sha256_kernel >( pBuffers_, numBuffers_, pDigests_ );
+        return true;
+      default:
+        return false;
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,138 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "hash_multibuffer.h"
+
+#if LL_HAS_AVX512()
+
+#include <immintrin.h>
+
+#include <algorithm>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    typedef __m512i vec_t;
+    const size_t kNumLanes = 16;
+
+    inline vec_t set1( std::uint32_t v_ ) { return _mm512_set1_epi32( static_cast< int >( v_ ) ); }
+    inline vec_t load( const std::uint32_t* p_ ) { return _mm512_loadu_si512( p_ ); }
+    inline void store( std::uint32_t* p_, vec_t v_ ) { _mm512_storeu_si512( p_, v_ ); }
+    inline vec_t add( vec_t a_, vec_t b_ ) { return _mm512_add_epi32( a_, b_ ); }
+    inline vec_t xor_( vec_t a_, vec_t b_ ) { return _mm512_xor_si512( a_, b_ ); }
+    inline vec_t and_( vec_t a_, vec_t b_ ) { return _mm512_and_si512( a_, b_ ); }
+    inline vec_t or_( vec_t a_, vec_t b_ ) { return _mm512_or_si512( a_, b_ ); }
+    inline vec_t andnot( vec_t a_, vec_t b_ ) { return _mm512_andnot_si512( a_, b_ ); }
+
+    template < int n_ >
+    inline vec_t rotl( vec_t v_ )
+    {
+      return _mm512_rol_epi32( v_, n_ );
+    }
+
+    template < int n_ >
+    inline vec_t shr( vec_t v_ )
+    {
+      return _mm512_srli_epi32( v_, n_ );
+    }
+
+    //! without avx512bw there is no byte shuffle, the rotations move the bytes pairwise
+    inline vec_t bswap( vec_t v_ )
+    {
+      auto bytes02 = _mm512_and_si512( _mm512_rol_epi32( v_, 8 ), _mm512_set1_epi32( 0x00ff00ff ) );
+      auto bytes13 = _mm512_and_si512( _mm512_ror_epi32( v_, 8 ), _mm512_set1_epi32( 0xff00ff00 ) );
+      return _mm512_or_si512( bytes02, bytes13 );
+    }
+
+    //! the 16 words of the blocks of all lanes, word t of every lane in pWords_[t]: a 16x16 transpose
+    //! (unpacking 32bit then 64bit elements within the 128bit quarters, then exchanging the quarters)
+    inline void load_blocks( const std::uint8_t* const* ppBlocks_, vec_t* pWords_ )
+    {
+      vec_t r[16];
+      for ( size_t l = 0; l < 16; ++l )
+        r[l] = _mm512_loadu_si512( ppBlocks_[l] );
+
+      vec_t t[16];
+      for ( size_t i = 0; i < 16; i += 2 )
+      {
+        t[i] = _mm512_unpacklo_epi32( r[i], r[i + 1] );
+        t[i + 1] = _mm512_unpackhi_epi32( r[i], r[i + 1] );
+      }
+
+      // u[4 * g + j] holds word 4 * k + j of the lanes 4 * g .. 4 * g + 3 in its quarter k
+      vec_t u[16];
+      for ( size_t i = 0; i < 16; i += 4 )
+      {
+        u[i] = _mm512_unpacklo_epi64( t[i], t[i + 2] );
+        u[i + 1] = _mm512_unpackhi_epi64( t[i], t[i + 2] );
+        u[i + 2] = _mm512_unpacklo_epi64( t[i + 1], t[i + 3] );
+        u[i + 3] = _mm512_unpackhi_epi64( t[i + 1], t[i + 3] );
+      }
+
+      for ( size_t j = 0; j < 4; ++j )
+      {
+        auto a = _mm512_shuffle_i32x4( u[j], u[j + 4], 0x44 );
+        auto b = _mm512_shuffle_i32x4( u[j], u[j + 4], 0xee );
+        auto c = _mm512_shuffle_i32x4( u[j + 8], u[j + 12], 0x44 );
+        auto d = _mm512_shuffle_i32x4( u[j + 8], u[j + 12], 0xee );
+        pWords_[j] = _mm512_shuffle_i32x4( a, c, 0x88 );
+        pWords_[j + 4] = _mm512_shuffle_i32x4( a, c, 0xdd );
+        pWords_[j + 8] = _mm512_shuffle_i32x4( b, d, 0x88 );
+        pWords_[j + 12] = _mm512_shuffle_i32x4( b, d, 0xdd );
+      }
+    }
+
+#include "hash_multibuffer_kernels.h"
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool hash_multibuffer_avx512( const buffer_ref* pBuffers_,
+                              size_t numBuffers_,
+                              hash::type type_,
+                              std::uint8_t* pDigests_ )
+  {
+    // with less than half of the lanes in use the single-message path is faster
+    if ( numBuffers_ < kNumLanes / 2 )
+      return false;
+
+    switch ( type_ )
+    {
+      case hash::type::md5:
+        mb::hash_lanes< mb::md5_kernel >( pBuffers_, numBuffers_, pDigests_ );
+        return true;
+      case hash::type::sha1:
+        mb::hash_lanes< mb::sha1_kernel >( pBuffers_, numBuffers_, pDigests_ );
+        return true;
+      case hash::type::sha256:
+        mb::hash_lanes< mb::sha256_kernel >( pBuffers_, numBuffers_, pDigests_ );
+        return true;
+      default:
+        return false;
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
+
+#endif  // LL_HAS_AVX512()
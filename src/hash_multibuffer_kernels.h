@@ -0,0 +1,444 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+// multi-buffer hash kernels, shared by the instruction set specific translation units
+//
+// This header is meant to be included (once, inside an anonymous namespace) by a translation unit that is
+// compiled for a specific instruction set. Before including it, the translation unit has to provide
+//   - the vector type vec_t holding kNumLanes 32bit lanes
+//   - set1, load, store, add, xor_, and_, or_, andnot (~a & b) for vec_t
+//   - rotl< n >( vec_t ) and shr< n >( vec_t )
+//   - bswap( vec_t ), reversing the bytes of every 32bit lane
+//   - load_blocks( ppBlocks, pWords ), transposing one 64 byte block per lane into the 16 (native endian)
+//     message words
+// Keeping everything at internal linkage ensures that the instantiations for different instruction sets
+// don't get merged by the linker.
+
+namespace mb
+{
+  inline void store_be32( std::uint8_t* p_, std::uint32_t v_ )
+  {
+    p_[0] = static_cast< std::uint8_t >( v_ >> 24 );
+    p_[1] = static_cast< std::uint8_t >( v_ >> 16 );
+    p_[2] = static_cast< std::uint8_t >( v_ >> 8 );
+    p_[3] = static_cast< std::uint8_t >( v_ );
+  }
+
+  inline void store_le32( std::uint8_t* p_, std::uint32_t v_ )
+  {
+    p_[3] = static_cast< std::uint8_t >( v_ >> 24 );
+    p_[2] = static_cast< std::uint8_t >( v_ >> 16 );
+    p_[1] = static_cast< std::uint8_t >( v_ >> 8 );
+    p_[0] = static_cast< std::uint8_t >( v_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // md5
+  // ---------------------------------------------------------------------------------------------------------
+
+  struct md5_kernel
+  {
+    static const size_t kStateWords = 4;
+    static const bool kBigEndian = false;
+
+    static void init( std::uint32_t* pState_ )
+    {
+      pState_[0] = 0x67452301;
+      pState_[1] = 0xefcdab89;
+      pState_[2] = 0x98badcfe;
+      pState_[3] = 0x10325476;
+    }
+
+    static void compress( vec_t* pState_, const vec_t* w_ )
+    {
+      static const std::uint32_t k[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+      };
+
+      vec_t a = pState_[0], b = pState_[1], c = pState_[2], d = pState_[3];
+      vec_t ones = set1( 0xffffffff );
+
+#define LL_MD5_STEP( f_, a_, b_, c_, d_, i_, g_, s_ )                         \
+  a_ = add( add( a_, f_ ), add( set1( k[i_] ), w_[g_] ) );                   \
+  a_ = add( rotl< s_ >( a_ ), b_ );
+
+#define LL_MD5_F( x_, y_, z_ ) or_( and_( x_, y_ ), andnot( x_, z_ ) )
+#define LL_MD5_G( x_, y_, z_ ) or_( and_( x_, z_ ), andnot( z_, y_ ) )
+#define LL_MD5_H( x_, y_, z_ ) xor_( xor_( x_, y_ ), z_ )
+#define LL_MD5_I( x_, y_, z_ ) xor_( y_, or_( x_, xor_( z_, ones ) ) )
+
+#define LL_MD5_ROUND4( fn_, i_, g0_, g1_, g2_, g3_, s0_, s1_, s2_, s3_ ) \
+  LL_MD5_STEP( fn_( b, c, d ), a, b, c, d, i_, g0_, s0_ )                \
+  LL_MD5_STEP( fn_( a, b, c ), d, a, b, c, i_ + 1, g1_, s1_ )            \
+  LL_MD5_STEP( fn_( d, a, b ), c, d, a, b, i_ + 2, g2_, s2_ )            \
+  LL_MD5_STEP( fn_( c, d, a ), b, c, d, a, i_ + 3, g3_, s3_ )
+
+      LL_MD5_ROUND4( LL_MD5_F, 0, 0, 1, 2, 3, 7, 12, 17, 22 )
+      LL_MD5_ROUND4( LL_MD5_F, 4, 4, 5, 6, 7, 7, 12, 17, 22 )
+      LL_MD5_ROUND4( LL_MD5_F, 8, 8, 9, 10, 11, 7, 12, 17, 22 )
+      LL_MD5_ROUND4( LL_MD5_F, 12, 12, 13, 14, 15, 7, 12, 17, 22 )
+
+      LL_MD5_ROUND4( LL_MD5_G, 16, 1, 6, 11, 0, 5, 9, 14, 20 )
+      LL_MD5_ROUND4( LL_MD5_G, 20, 5, 10, 15, 4, 5, 9, 14, 20 )
+      LL_MD5_ROUND4( LL_MD5_G, 24, 9, 14, 3, 8, 5, 9, 14, 20 )
+      LL_MD5_ROUND4( LL_MD5_G, 28, 13, 2, 7, 12, 5, 9, 14, 20 )
+
+      LL_MD5_ROUND4( LL_MD5_H, 32, 5, 8, 11, 14, 4, 11, 16, 23 )
+      LL_MD5_ROUND4( LL_MD5_H, 36, 1, 4, 7, 10, 4, 11, 16, 23 )
+      LL_MD5_ROUND4( LL_MD5_H, 40, 13, 0, 3, 6, 4, 11, 16, 23 )
+      LL_MD5_ROUND4( LL_MD5_H, 44, 9, 12, 15, 2, 4, 11, 16, 23 )
+
+      LL_MD5_ROUND4( LL_MD5_I, 48, 0, 7, 14, 5, 6, 10, 15, 21 )
+      LL_MD5_ROUND4( LL_MD5_I, 52, 12, 3, 10, 1, 6, 10, 15, 21 )
+      LL_MD5_ROUND4( LL_MD5_I, 56, 8, 15, 6, 13, 6, 10, 15, 21 )
+      LL_MD5_ROUND4( LL_MD5_I, 60, 4, 11, 2, 9, 6, 10, 15, 21 )
+
+#undef LL_MD5_ROUND4
+#undef LL_MD5_I
+#undef LL_MD5_H
+#undef LL_MD5_G
+#undef LL_MD5_F
+#undef LL_MD5_STEP
+
+      pState_[0] = add( pState_[0], a );
+      pState_[1] = add( pState_[1], b );
+      pState_[2] = add( pState_[2], c );
+      pState_[3] = add( pState_[3], d );
+    }
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // sha-1
+  // ---------------------------------------------------------------------------------------------------------
+
+  struct sha1_kernel
+  {
+    static const size_t kStateWords = 5;
+    static const bool kBigEndian = true;
+
+    static void init( std::uint32_t* pState_ )
+    {
+      pState_[0] = 0x67452301;
+      pState_[1] = 0xefcdab89;
+      pState_[2] = 0x98badcfe;
+      pState_[3] = 0x10325476;
+      pState_[4] = 0xc3d2e1f0;
+    }
+
+    static void compress( vec_t* pState_, const vec_t* w_ )
+    {
+      vec_t w[80];
+      for ( size_t t = 0; t < 16; ++t )
+        w[t] = w_[t];
+      for ( size_t t = 16; t < 80; ++t )
+        w[t] = rotl< 1 >( xor_( xor_( w[t - 3], w[t - 8] ), xor_( w[t - 14], w[t - 16] ) ) );
+
+      vec_t a = pState_[0], b = pState_[1], c = pState_[2], d = pState_[3], e = pState_[4];
+
+      for ( size_t t = 0; t < 80; ++t )
+      {
+        vec_t f, k;
+        if ( t < 20 )
+        {
+          f = or_( and_( b, c ), andnot( b, d ) );
+          k = set1( 0x5a827999 );
+        }
+        else if ( t < 40 )
+        {
+          f = xor_( xor_( b, c ), d );
+          k = set1( 0x6ed9eba1 );
+        }
+        else if ( t < 60 )
+        {
+          f = or_( or_( and_( b, c ), and_( b, d ) ), and_( c, d ) );
+          k = set1( 0x8f1bbcdc );
+        }
+        else
+        {
+          f = xor_( xor_( b, c ), d );
+          k = set1( 0xca62c1d6 );
+        }
+
+        vec_t temp = add( add( rotl< 5 >( a ), f ), add( add( e, k ), w[t] ) );
+        e = d;
+        d = c;
+        c = rotl< 30 >( b );
+        b = a;
+        a = temp;
+      }
+
+      pState_[0] = add( pState_[0], a );
+      pState_[1] = add( pState_[1], b );
+      pState_[2] = add( pState_[2], c );
+      pState_[3] = add( pState_[3], d );
+      pState_[4] = add( pState_[4], e );
+    }
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // sha-256
+  // ---------------------------------------------------------------------------------------------------------
+
+  struct sha256_kernel
+  {
+    static const size_t kStateWords = 8;
+    static const bool kBigEndian = true;
+
+    static void init( std::uint32_t* pState_ )
+    {
+      pState_[0] = 0x6a09e667;
+      pState_[1] = 0xbb67ae85;
+      pState_[2] = 0x3c6ef372;
+      pState_[3] = 0xa54ff53a;
+      pState_[4] = 0x510e527f;
+      pState_[5] = 0x9b05688c;
+      pState_[6] = 0x1f83d9ab;
+      pState_[7] = 0x5be0cd19;
+    }
+
+    static void compress( vec_t* pState_, const vec_t* w_ )
+    {
+      static const std::uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+      };
+
+      vec_t w[64];
+      for ( size_t t = 0; t < 16; ++t )
+        w[t] = w_[t];
+      for ( size_t t = 16; t < 64; ++t )
+      {
+        vec_t s0 = xor_( xor_( rotl< 25 >( w[t - 15] ), rotl< 14 >( w[t - 15] ) ), shr< 3 >( w[t - 15] ) );
+        vec_t s1 = xor_( xor_( rotl< 15 >( w[t - 2] ), rotl< 13 >( w[t - 2] ) ), shr< 10 >( w[t - 2] ) );
+        w[t] = add( add( w[t - 16], s0 ), add( w[t - 7], s1 ) );
+      }
+
+      vec_t a = pState_[0], b = pState_[1], c = pState_[2], d = pState_[3];
+      vec_t e = pState_[4], f = pState_[5], g = pState_[6], h = pState_[7];
+
+      for ( size_t t = 0; t < 64; ++t )
+      {
+        vec_t s1 = xor_( xor_( rotl< 26 >( e ), rotl< 21 >( e ) ), rotl< 7 >( e ) );
+        vec_t ch = xor_( and_( e, f ), andnot( e, g ) );
+        vec_t temp1 = add( add( add( h, s1 ), add( ch, set1( k[t] ) ) ), w[t] );
+        vec_t s0 = xor_( xor_( rotl< 30 >( a ), rotl< 19 >( a ) ), rotl< 10 >( a ) );
+        vec_t maj = xor_( xor_( and_( a, b ), and_( a, c ) ), and_( b, c ) );
+        vec_t temp2 = add( s0, maj );
+
+        h = g;
+        g = f;
+        f = e;
+        e = add( d, temp1 );
+        d = c;
+        c = b;
+        b = a;
+        a = add( temp1, temp2 );
+      }
+
+      pState_[0] = add( pState_[0], a );
+      pState_[1] = add( pState_[1], b );
+      pState_[2] = add( pState_[2], c );
+      pState_[3] = add( pState_[3], d );
+      pState_[4] = add( pState_[4], e );
+      pState_[5] = add( pState_[5], f );
+      pState_[6] = add( pState_[6], g );
+      pState_[7] = add( pState_[7], h );
+    }
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // lane scheduler
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the progress of a single message within its lane
+  struct lane_t
+  {
+    const std::uint8_t* pData = nullptr;
+    size_t numFullBlocks = 0;
+    size_t numTailBlocks = 0;
+    size_t tailBlock = 0;
+    size_t messageIndex = 0;
+    bool active = false;
+
+    std::uint8_t tail[128];  //!< the last partial block(s) of the message including padding
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  template < typename kernel_t >
+  void assign_message( lane_t& lane_, const buffer_ref& buffer_, size_t messageIndex_ )
+  {
+    auto pData = static_cast< const std::uint8_t* >( buffer_.pBuffer );
+    auto sz = buffer_.szBufferInBytes;
+    auto remainder = sz % 64;
+
+    lane_.pData = pData;
+    lane_.numFullBlocks = sz / 64;
+    lane_.numTailBlocks = ( remainder < 56 ) ? 1 : 2;
+    lane_.tailBlock = 0;
+    lane_.messageIndex = messageIndex_;
+    lane_.active = true;
+
+    // the padding: 0x80, zeros, message length in bits (big endian for sha, little endian for md5)
+    std::fill( lane_.tail, lane_.tail + sizeof( lane_.tail ), std::uint8_t( 0 ) );
+    if ( remainder > 0 )
+      std::copy( pData + sz - remainder, pData + sz, lane_.tail );
+    lane_.tail[remainder] = 0x80;
+
+    std::uint64_t numBits = static_cast< std::uint64_t >( sz ) * 8;
+    auto pLength = lane_.tail + lane_.numTailBlocks * 64 - 8;
+    for ( size_t i = 0; i < 8; ++i )
+    {
+      auto shift = kernel_t::kBigEndian ? ( 56 - 8 * i ) : ( 8 * i );
+      pLength[i] = static_cast< std::uint8_t >( numBits >> shift );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! returns the next block of the lane and advances it
+  inline const std::uint8_t* next_block( lane_t& lane_ )
+  {
+    if ( lane_.numFullBlocks > 0 )
+    {
+      auto pBlock = lane_.pData;
+      lane_.pData += 64;
+      --lane_.numFullBlocks;
+      return pBlock;
+    }
+
+    return lane_.tail + 64 * lane_.tailBlock++;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! hash all messages, keeping every lane busy until the input is exhausted
+  template < typename kernel_t >
+  void hash_lanes( const buffer_ref* pBuffers_, size_t numBuffers_, std::uint8_t* pDigests_ )
+  {
+    static const std::uint8_t s_idleBlock[64] = {};
+    const size_t kDigestSize = kernel_t::kStateWords * 4;
+
+    lane_t lanes[kNumLanes];
+    std::uint32_t state[kernel_t::kStateWords][kNumLanes];
+    std::uint32_t iv[kernel_t::kStateWords];
+    kernel_t::init( iv );
+
+    size_t nextMessage = 0;
+    for ( size_t l = 0; l < kNumLanes; ++l )
+    {
+      for ( size_t i = 0; i < kernel_t::kStateWords; ++i )
+        state[i][l] = iv[i];
+      if ( nextMessage < numBuffers_ )
+      {
+        assign_message< kernel_t >( lanes[l], pBuffers_[nextMessage], nextMessage );
+        ++nextMessage;
+      }
+    }
+
+    vec_t vState[kernel_t::kStateWords];
+    for ( size_t i = 0; i < kernel_t::kStateWords; ++i )
+      vState[i] = load( state[i] );
+
+    size_t numActive = std::min( numBuffers_, kNumLanes );
+    while ( numActive > 0 )
+    {
+      // transpose the next block of every lane into the message words
+      const std::uint8_t* blocks[kNumLanes];
+      bool anyFinished = false;
+      for ( size_t l = 0; l < kNumLanes; ++l )
+      {
+        blocks[l] = s_idleBlock;
+        if ( lanes[l].active )
+        {
+          blocks[l] = next_block( lanes[l] );
+          anyFinished |= ( lanes[l].tailBlock == lanes[l].numTailBlocks );
+        }
+      }
+
+      vec_t w[16];
+      load_blocks( blocks, w );
+      if ( kernel_t::kBigEndian )
+      {
+        for ( size_t t = 0; t < 16; ++t )
+          w[t] = bswap( w[t] );
+      }
+
+      kernel_t::compress( vState, w );
+
+      if ( !anyFinished )
+        continue;
+
+      // emit the digests of the finished messages and refill their lanes
+      for ( size_t i = 0; i < kernel_t::kStateWords; ++i )
+        store( state[i], vState[i] );
+
+      for ( size_t l = 0; l < kNumLanes; ++l )
+      {
+        auto& lane = lanes[l];
+        if ( !lane.active || ( lane.tailBlock != lane.numTailBlocks ) )
+          continue;
+
+        auto pDigest = pDigests_ + lane.messageIndex * kDigestSize;
+        for ( size_t i = 0; i < kernel_t::kStateWords; ++i )
+        {
+          if ( kernel_t::kBigEndian )
+            store_be32( pDigest + 4 * i, state[i][l] );
+          else
+            store_le32( pDigest + 4 * i, state[i][l] );
+          state[i][l] = iv[i];
+        }
+
+        if ( nextMessage < numBuffers_ )
+        {
+          assign_message< kernel_t >( lane, pBuffers_[nextMessage], nextMessage );
+          ++nextMessage;
+        }
+        else
+        {
+          lane.active = false;
+          --numActive;
+        }
+      }
+
+      for ( size_t i = 0; i < kernel_t::kStateWords; ++i )
+        vState[i] = load( state[i] );
+    }
+  }
+
+}  // namespace mb
@@ -0,0 +1,180 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/hash_tree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto/exception.h"
+#include "internal_utils.h"
+#include "generator_pool.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    const std::uint8_t kLeafPrefix = 0x00;
+    const std::uint8_t kNodePrefix = 0x01;
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! hash leaves until all of them are taken and store the results in the node list
+    void hash_leaves( const std::uint8_t* pBuffer_,
+                      size_t szBufferInBytes_,
+                      hash::type type_,
+                      size_t leafSize_,
+                      std::atomic< size_t >& nextLeaf_,
+                      size_t numLeaves_,
+                      std::vector< std::uint8_t >& nodes_ )
+    {
+      auto digestSize = digest_size( type_ );
+
+      for ( auto leaf = nextLeaf_++; leaf < numLeaves_; leaf = nextLeaf_++ )
+      {
+        auto offset = leaf * leafSize_;
+        auto sz = std::min( leafSize_, szBufferInBytes_ - offset );
+
+        pooled_hash_generator calculator( type_ );
+        calculator->add_data( &kLeafPrefix, 1 );
+        calculator->add_data( pBuffer_ + offset, sz );
+        auto h = calculator->retrieve_hash();
+        std::copy( h.binary.begin(), h.binary.end(), nodes_.begin() + leaf * digestSize );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! reduce the leaf hashes level by level to the root hash (in place)
+    hash combine_nodes( std::vector< std::uint8_t >& nodes_, size_t numNodes_, hash::type type_ )
+    {
+      auto digestSize = digest_size( type_ );
+
+      while ( numNodes_ > 1 )
+      {
+        size_t numParents = 0;
+        for ( size_t i = 0; i + 1 < numNodes_; i += 2 )
+        {
+          pooled_hash_generator calculator( type_ );
+          calculator->add_data( &kNodePrefix, 1 );
+          calculator->add_data( nodes_.data() + i * digestSize, 2 * digestSize );
+          auto h = calculator->retrieve_hash();
+          std::copy( h.binary.begin(), h.binary.end(), nodes_.begin() + numParents * digestSize );
+          ++numParents;
+        }
+
+        if ( numNodes_ % 2 )
+        {
+          std::copy( nodes_.begin() + ( numNodes_ - 1 ) * digestSize, nodes_.begin() + numNodes_ * digestSize,
+                     nodes_.begin() + numParents * digestSize );
+          ++numParents;
+        }
+
+        numNodes_ = numParents;
+      }
+
+      hash h;
+      h.hashType = type_;
+      h.binary.assign( nodes_.begin(), nodes_.begin() + digestSize );
+      h.string = string_from_binary( h.binary );
+      return h;
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  hash get_tree_hash( const void* pBuffer_,
+                      size_t szBufferInBytes_,
+                      hash::type type_,
+                      const tree_hash_config& cfg_ )
+  {
+    if ( !pBuffer_ && ( szBufferInBytes_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    if ( type_ == hash::type::unknown )
+      throw exception( error::invalid_parameter, "invalid hash type" );
+
+    if ( cfg_.leafSize == 0 )
+      throw exception( error::invalid_parameter, "invalid leaf size" );
+
+    auto pBuffer = static_cast< const std::uint8_t* >( pBuffer_ );
+    auto numLeaves = std::max( size_t( 1 ), ( szBufferInBytes_ + cfg_.leafSize - 1 ) / cfg_.leafSize );
+    std::vector< std::uint8_t > nodes( numLeaves * digest_size( type_ ) );
+
+    size_t numThreads = cfg_.numThreads;
+    if ( numThreads == 0 )
+      numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    numThreads = std::min( numThreads, numLeaves );
+
+    // the calling thread takes part in hashing, so we only need numThreads - 1 additional workers
+    std::atomic< size_t > nextLeaf( 0 );
+    std::exception_ptr pError;
+    std::mutex errorMutex;
+
+    auto worker = [&]()
+    {
+      try
+      {
+        hash_leaves( pBuffer, szBufferInBytes_, type_, cfg_.leafSize, nextLeaf, numLeaves, nodes );
+      }
+      catch ( ... )
+      {
+        std::lock_guard< std::mutex > lock( errorMutex );
+        if ( !pError )
+          pError = std::current_exception();
+        nextLeaf = numLeaves;  // let the other workers stop early
+      }
+    };
+
+    std::vector< std::thread > threads;
+    for ( size_t i = 1; i < numThreads; ++i )
+      threads.emplace_back( worker );
+
+    worker();
+
+    for ( auto& t : threads )
+      t.join();
+
+    if ( pError )
+      std::rethrow_exception( pError );
+
+    auto h = combine_nodes( nodes, numLeaves, type_ );
+    h.inputSize = szBufferInBytes_;
+    return h;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  hash get_tree_hash( const std::string& v_, hash::type type_, const tree_hash_config& cfg_ )
+  {
+    return get_tree_hash( v_.data(), v_.size(), type_, cfg_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,370 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/hmac.h"
+
+#include <cstring>
+
+#include "crypto/basic_hash_generator.h"
+#include "crypto/exception.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    const std::uint8_t kInnerPad = 0x36;
+    const std::uint8_t kOuterPad = 0x5c;
+
+
+    // ---------------------------------------------------------------------------------------------------------
+
+    //! overwrite key material, the volatile access keeps the compiler from dropping the stores
+    void wipe( std::uint8_t* p_, size_t sz_ ) LL_NOEXCEPT
+    {
+      volatile std::uint8_t* p = p_;
+      for ( size_t i = 0; i < sz_; ++i )
+        p[i] = 0;
+    }
+
+    //! the comparison time doesn't depend on the position of the first difference
+    bool equal_constant_time( const std::uint8_t* pLhs_, const std::uint8_t* pRhs_, size_t sz_ ) LL_NOEXCEPT
+    {
+      std::uint8_t difference = 0;
+      for ( size_t i = 0; i < sz_; ++i )
+        difference |= pLhs_[i] ^ pRhs_[i];
+      return difference == 0;
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // hmac_key::impl
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the keyed states of one hash type, plus the state of the message in flight (used by hmac_generator)
+  class hmac_key::impl
+  {
+  public:
+    virtual ~impl() {}
+
+    virtual hash::type hash_type() const LL_NOEXCEPT = 0;
+    virtual size_t digest_size() const LL_NOEXCEPT = 0;
+
+    //! the keyed states without the message in flight
+    virtual std::unique_ptr< impl > clone() const = 0;
+
+    //! the mac of a complete message (digest_size() bytes), the message in flight is left alone
+    virtual void sign( const std::uint8_t* pMessage_, size_t szMessage_, std::uint8_t* pMac_ ) const = 0;
+
+    virtual void add_data( const std::uint8_t* pBuffer_, size_t sz_ ) = 0;
+    virtual void retrieve_mac( std::uint8_t* pMac_ ) = 0;
+    virtual void reset() = 0;
+    virtual std::uint64_t input_size() const LL_NOEXCEPT = 0;
+
+    static std::unique_ptr< impl > create( hash::type type_, const std::uint8_t* pKey_, size_t szKey_ );
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  template < hash::type type_ >
+  class hmac_key::keyed_hash : public hmac_key::impl
+  {
+    typedef basic_hash_generator< type_ > generator_t;
+
+  public:
+    keyed_hash( const std::uint8_t* pKey_, size_t szKey_ )
+    {
+      // keys longer than a block are hashed first, shorter ones padded with zeros
+      std::uint8_t block[generator_t::blockSize] = {};
+      if ( szKey_ > generator_t::blockSize )
+      {
+        generator_t keyHash;
+        keyHash.add_data( pKey_, szKey_ );
+        keyHash.retrieve_digest( block );
+      }
+      else if ( szKey_ > 0 )
+      {
+        std::memcpy( block, pKey_, szKey_ );
+      }
+
+      for ( auto& b : block )
+        b ^= kInnerPad;
+      m_inner.add_data( block, sizeof( block ) );
+
+      for ( auto& b : block )
+        b ^= kInnerPad ^ kOuterPad;
+      m_outer.add_data( block, sizeof( block ) );
+
+      wipe( block, sizeof( block ) );
+      m_message = m_inner;
+    }
+
+    hash::type hash_type() const LL_NOEXCEPT override { return type_; }
+    size_t digest_size() const LL_NOEXCEPT override { return generator_t::digestSize; }
+
+    std::unique_ptr< hmac_key::impl > clone() const override
+    {
+      std::unique_ptr< keyed_hash > pClone( new keyed_hash( *this ) );
+      pClone->reset();
+      return pClone;
+    }
+
+    void sign( const std::uint8_t* pMessage_, size_t szMessage_, std::uint8_t* pMac_ ) const override
+    {
+      generator_t inner( m_inner );
+      inner.add_data( pMessage_, szMessage_ );
+      finish( inner, pMac_ );
+    }
+
+    void add_data( const std::uint8_t* pBuffer_, size_t sz_ ) override
+    {
+      m_message.add_data( pBuffer_, sz_ );
+    }
+
+    void retrieve_mac( std::uint8_t* pMac_ ) override { finish( m_message, pMac_ ); }
+
+    void reset() override { m_message = m_inner; }
+
+    std::uint64_t input_size() const LL_NOEXCEPT override
+    {
+      return m_message.input_size() - generator_t::blockSize;
+    }
+
+  private:
+    keyed_hash( const keyed_hash& other_ ) = default;
+
+    //! the outer hash over the inner digest
+    void finish( generator_t& inner_, std::uint8_t* pMac_ ) const
+    {
+      std::uint8_t innerDigest[generator_t::digestSize];
+      inner_.retrieve_digest( innerDigest );
+
+      generator_t outer( m_outer );
+      outer.add_data( innerDigest, sizeof( innerDigest ) );
+      outer.retrieve_digest( pMac_ );
+    }
+
+    generator_t m_inner;    //!< after the key block xor'ed with ipad
+    generator_t m_outer;    //!< after the key block xor'ed with opad
+    generator_t m_message;  //!< m_inner plus the message in flight
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::unique_ptr< hmac_key::impl > hmac_key::impl::create( hash::type type_,
+                                                             const std::uint8_t* pKey_,
+                                                             size_t szKey_ )
+  {
+    switch ( type_ )
+    {
+      case hash::type::sha1:
+        return std::unique_ptr< impl >( new keyed_hash< hash::type::sha1 >( pKey_, szKey_ ) );
+      case hash::type::sha256:
+        return std::unique_ptr< impl >( new keyed_hash< hash::type::sha256 >( pKey_, szKey_ ) );
+      case hash::type::sha384:
+        return std::unique_ptr< impl >( new keyed_hash< hash::type::sha384 >( pKey_, szKey_ ) );
+      case hash::type::sha512:
+        return std::unique_ptr< impl >( new keyed_hash< hash::type::sha512 >( pKey_, szKey_ ) );
+      case hash::type::sha3_256:
+        return std::unique_ptr< impl >( new keyed_hash< hash::type::sha3_256 >( pKey_, szKey_ ) );
+      case hash::type::sha3_512:
+        return std::unique_ptr< impl >( new keyed_hash< hash::type::sha3_512 >( pKey_, szKey_ ) );
+      default:
+        throw exception( error::invalid_parameter, "Unsupported hash type for hmac" );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // hmac_key Implementation
+  // ---------------------------------------------------------------------------------------------------------
+
+  hmac_key::hmac_key( hash::type type_, const void* pKey_, size_t szKey_ )
+  {
+    if ( ( pKey_ == nullptr ) && ( szKey_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid key" );
+
+    m_pImpl = impl::create( type_, static_cast< const std::uint8_t* >( pKey_ ), szKey_ );
+  }
+
+  hmac_key::hmac_key( hash::type type_, const std::string& key_ )
+    : hmac_key( type_, key_.data(), key_.size() )
+  {
+  }
+
+  hmac_key::~hmac_key() = default;
+
+  hmac_key::hmac_key( hmac_key&& other_ )
+  {
+    m_pImpl.reset( other_.m_pImpl.release() );
+  }
+
+  hmac_key& hmac_key::operator=( hmac_key&& other_ )
+  {
+    m_pImpl.reset( other_.m_pImpl.release() );
+    return *this;
+  }
+
+  hash::type hmac_key::hash_type() const LL_NOEXCEPT
+  {
+    return m_pImpl->hash_type();
+  }
+
+  size_t hmac_key::digest_size() const LL_NOEXCEPT
+  {
+    return m_pImpl->digest_size();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  digest hmac_key::sign( const void* pMessage_, size_t szMessage_ ) const
+  {
+    if ( ( pMessage_ == nullptr ) && ( szMessage_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    digest d;
+    d.hashType = m_pImpl->hash_type();
+    d.size = static_cast< std::uint8_t >( m_pImpl->digest_size() );
+    m_pImpl->sign( static_cast< const std::uint8_t* >( pMessage_ ), szMessage_, d.bytes.data() );
+    return d;
+  }
+
+  bool hmac_key::verify( const void* pMessage_, size_t szMessage_, const digest& mac_ ) const
+  {
+    auto expected = sign( pMessage_, szMessage_ );
+    if ( ( mac_.hashType != expected.hashType ) || ( mac_.size != expected.size ) )
+      return false;
+    return equal_constant_time( expected.data(), mac_.data(), expected.size );
+  }
+
+  std::vector< bool > hmac_key::verify( const buffer_ref* pMessages_,
+                                        const digest* pMacs_,
+                                        size_t numMessages_ ) const
+  {
+    if ( ( ( pMessages_ == nullptr ) || ( pMacs_ == nullptr ) ) && ( numMessages_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer list" );
+
+    // validate the whole batch before doing any work
+    for ( size_t i = 0; i < numMessages_; ++i )
+    {
+      if ( ( pMessages_[i].pBuffer == nullptr ) && ( pMessages_[i].szBufferInBytes > 0 ) )
+        throw exception( error::invalid_parameter, "invalid buffer" );
+    }
+
+    std::vector< bool > results( numMessages_ );
+    for ( size_t i = 0; i < numMessages_; ++i )
+      results[i] = verify( pMessages_[i].pBuffer, pMessages_[i].szBufferInBytes, pMacs_[i] );
+    return results;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // hmac_generator Implementation
+  // ---------------------------------------------------------------------------------------------------------
+
+  hmac_generator::hmac_generator( const hmac_key& key_ )
+    : m_pImpl( key_.m_pImpl->clone() )
+  {
+  }
+
+  hmac_generator::hmac_generator( hash::type type_, const void* pKey_, size_t szKey_ )
+  {
+    if ( ( pKey_ == nullptr ) && ( szKey_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid key" );
+
+    m_pImpl = hmac_key::impl::create( type_, static_cast< const std::uint8_t* >( pKey_ ), szKey_ );
+  }
+
+  hmac_generator::~hmac_generator() = default;
+
+  hmac_generator::hmac_generator( hmac_generator&& other_ )
+  {
+    m_pImpl.reset( other_.m_pImpl.release() );
+  }
+
+  hmac_generator& hmac_generator::operator=( hmac_generator&& other_ )
+  {
+    m_pImpl.reset( other_.m_pImpl.release() );
+    return *this;
+  }
+
+  void hmac_generator::add_data( const std::uint8_t* pBuffer_, size_t sz_ )
+  {
+    if ( ( pBuffer_ == nullptr ) && ( sz_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    m_pImpl->add_data( pBuffer_, sz_ );
+  }
+
+  hash hmac_generator::retrieve_hash()
+  {
+    hash h;
+    h.hashType = m_pImpl->hash_type();
+    h.inputSize = m_pImpl->input_size();
+    h.binary.resize( m_pImpl->digest_size() );
+    m_pImpl->retrieve_mac( h.binary.data() );
+    h.string = detail::to_hex_string( h.binary );
+    return h;
+  }
+
+  digest hmac_generator::retrieve_digest()
+  {
+    digest d;
+    d.hashType = m_pImpl->hash_type();
+    d.size = static_cast< std::uint8_t >( m_pImpl->digest_size() );
+    m_pImpl->retrieve_mac( d.bytes.data() );
+    return d;
+  }
+
+  void hmac_generator::reset()
+  {
+    m_pImpl->reset();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // Convenience functions
+  // ---------------------------------------------------------------------------------------------------------
+
+  hash get_hmac( const void* pKey_,
+                 size_t szKey_,
+                 const void* pMessage_,
+                 size_t szMessage_,
+                 hash::type type_ )
+  {
+    if ( ( pMessage_ == nullptr ) && ( szMessage_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    hmac_generator g( type_, pKey_, szKey_ );
+    g.add_data( static_cast< const std::uint8_t* >( pMessage_ ), szMessage_ );
+    return g.retrieve_hash();
+  }
+
+  hash get_hmac( const std::string& key_, const std::string& message_, hash::type type_ )
+  {
+    return get_hmac( key_.data(), key_.size(), message_.data(), message_.size(), type_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -29,6 +29,8 @@
 #include <cstdint>
 #include <functional>
 
+#include "crypto/hash.h"
+#include "crypto/codec.h"
 #include "crypto/exception.h"
 
 
@@ -36,19 +38,50 @@ namespace ll
 {
 namespace crypto
 {
-  inline static std::string string_from_binary( const std::vector< std::uint8_t >& binary_ ) LL_NOEXCEPT
+  inline static std::string string_from_binary( const std::uint8_t* pBinary_, size_t sz_ )
   {
-    static const char kEncodingTable[17] = "0123456789abcdef";
+    std::string result( hex_encoded_size( sz_ ), '\0' );
+    hex_encode( pBinary_, sz_, &result[0] );
+    return result;
+  }
+
+  inline static std::string string_from_binary( const std::vector< std::uint8_t >& binary_ )
+  {
+    return string_from_binary( binary_.data(), binary_.size() );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
 
-    // encode string
-    std::string result;
-    for ( auto b : binary_ )
+  //! the size of the binary digest for the given hash type in bytes
+  inline static size_t digest_size( hash::type type_ )
+  {
+    switch ( type_ )
     {
-      result += kEncodingTable[( b >> 4 ) & 0xf];
-      result += kEncodingTable[b & 0xf];
+      case hash::type::crc32c:
+        return 4;
+      case hash::type::xxh3_64:
+        return 8;
+      case hash::type::md4:
+      case hash::type::md5:
+      case hash::type::xxh3_128:
+        return 16;
+      case hash::type::sha1:
+        return 20;
+      case hash::type::sha256:
+      case hash::type::blake3:
+      case hash::type::sha3_256:
+      case hash::type::shake128:
+        return 32;
+      case hash::type::sha384:
+        return 48;
+      case hash::type::sha512:
+      case hash::type::sha3_512:
+      case hash::type::shake256:
+        return 64;
+      default:
+        throw exception( error::invalid_parameter, "Unsupported hash type" );
     }
-
-    return result;
   }
 
 
@@ -77,6 +110,42 @@ namespace crypto
     }
   }
 
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the library takes UTF-8 paths, the wide character API UTF-16
+  inline static std::wstring to_wide_string( const std::string& utf8_ )
+  {
+    if ( utf8_.empty() )
+      return std::wstring();
+
+    auto length
+      = ::MultiByteToWideChar( CP_UTF8, 0, utf8_.data(), static_cast< int >( utf8_.size() ), NULL, 0 );
+    if ( length <= 0 )
+      throw exception( error::invalid_parameter, "invalid path" );
+
+    std::wstring result( static_cast< size_t >( length ), L'\0' );
+    ::MultiByteToWideChar(
+      CP_UTF8, 0, utf8_.data(), static_cast< int >( utf8_.size() ), &result[0], length );
+    return result;
+  }
+
+  inline static std::string to_utf8_string( const std::wstring& wide_ )
+  {
+    if ( wide_.empty() )
+      return std::string();
+
+    auto length = ::WideCharToMultiByte(
+      CP_UTF8, 0, wide_.data(), static_cast< int >( wide_.size() ), NULL, 0, NULL, NULL );
+    if ( length <= 0 )
+      throw exception( error::internal, "invalid path" );
+
+    std::string result( static_cast< size_t >( length ), '\0' );
+    ::WideCharToMultiByte(
+      CP_UTF8, 0, wide_.data(), static_cast< int >( wide_.size() ), &result[0], length, NULL, NULL );
+    return result;
+  }
+
 #endif
 
 }  // namespace crypto
@@ -0,0 +1,273 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "keccak.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto/basic_hash_generator.h"
+#include "crypto/exception.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace keccak
+  {
+    const std::uint64_t kRoundConstants[kNumRounds] = {
+      0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808aull, 0x8000000080008000ull,
+      0x000000000000808bull, 0x0000000080000001ull, 0x8000000080008081ull, 0x8000000000008009ull,
+      0x000000000000008aull, 0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000aull,
+      0x000000008000808bull, 0x800000000000008bull, 0x8000000000008089ull, 0x8000000000008003ull,
+      0x8000000000008002ull, 0x8000000000000080ull, 0x000000000000800aull, 0x800000008000000aull,
+      0x8000000080008081ull, 0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull
+    };
+
+    namespace
+    {
+      // the padding appends the domain separation bits and then 10*1
+      const std::uint8_t kSha3Suffix = 0x06;
+      const std::uint8_t kShakeSuffix = 0x1f;
+
+      typedef detail::hash_backend< hash::type::sha3_256 > sha3_256_backend;
+      typedef detail::hash_backend< hash::type::sha3_512 > sha3_512_backend;
+      typedef detail::hash_backend< hash::type::shake128 > shake128_backend;
+      typedef detail::hash_backend< hash::type::shake256 > shake256_backend;
+
+      const params kSha3_256 = { sha3_256_backend::blockSize, kSha3Suffix, sha3_256_backend::digestSize };
+      const params kSha3_512 = { sha3_512_backend::blockSize, kSha3Suffix, sha3_512_backend::digestSize };
+      const params kShake128 = { shake128_backend::blockSize, kShakeSuffix, shake128_backend::digestSize };
+      const params kShake256 = { shake256_backend::blockSize, kShakeSuffix, shake256_backend::digestSize };
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      typedef std::uint64_t lane_t;
+
+      inline lane_t set1( std::uint64_t v_ ) { return v_; }
+      inline lane_t xor_( lane_t a_, lane_t b_ ) { return a_ ^ b_; }
+      inline lane_t andnot( lane_t a_, lane_t b_ ) { return ~a_ & b_; }
+
+      template < int n_ >
+      inline lane_t rotl( lane_t v_ )
+      {
+        return ( v_ << n_ ) | ( v_ >> ( 64 - n_ ) );
+      }
+
+#include "keccak_kernels.h"
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      // the state is little endian like the platforms we run on, so its bytes can be addressed directly
+
+      inline std::uint8_t* state_bytes( sponge& sponge_ )
+      {
+        return reinterpret_cast< std::uint8_t* >( sponge_.state );
+      }
+
+      inline void xor_block( std::uint64_t* pState_, const std::uint8_t* pBlock_, size_t rate_ )
+      {
+        for ( size_t i = 0; i < rate_ / 8; ++i )
+        {
+          std::uint64_t v;
+          std::memcpy( &v, pBlock_ + 8 * i, 8 );
+          pState_[i] ^= v;
+        }
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    const params* find_params( hash::type type_ ) LL_NOEXCEPT
+    {
+      switch ( type_ )
+      {
+        case hash::type::sha3_256:
+          return &kSha3_256;
+        case hash::type::sha3_512:
+          return &kSha3_512;
+        case hash::type::shake128:
+          return &kShake128;
+        case hash::type::shake256:
+          return &kShake256;
+        default:
+          return nullptr;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void permute( std::uint64_t* pState_ )
+    {
+      kc::permute( pState_ );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void init( sponge& sponge_, size_t rate_, std::uint8_t suffix_ )
+    {
+      std::fill( sponge_.state, sponge_.state + 25, std::uint64_t( 0 ) );
+      sponge_.position = 0;
+      sponge_.rate = static_cast< std::uint16_t >( rate_ );
+      sponge_.suffix = suffix_;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void absorb( sponge& sponge_, const std::uint8_t* pBuffer_, size_t sz_ )
+    {
+      const size_t rate = sponge_.rate;
+      auto pBytes = state_bytes( sponge_ );
+
+      while ( sz_ > 0 )
+      {
+        // whole blocks are xored in lane by lane
+        if ( ( sponge_.position == 0 ) && ( sz_ >= rate ) )
+        {
+          xor_block( sponge_.state, pBuffer_, rate );
+          kc::permute( sponge_.state );
+          pBuffer_ += rate;
+          sz_ -= rate;
+          continue;
+        }
+
+        auto n = std::min( rate - sponge_.position, sz_ );
+        for ( size_t i = 0; i < n; ++i )
+          pBytes[sponge_.position + i] ^= pBuffer_[i];
+
+        sponge_.position += static_cast< std::uint32_t >( n );
+        pBuffer_ += n;
+        sz_ -= n;
+
+        if ( sponge_.position == rate )
+        {
+          kc::permute( sponge_.state );
+          sponge_.position = 0;
+        }
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void finalize( sponge& sponge_, std::uint8_t* pOut_, size_t sz_ )
+    {
+      const size_t rate = sponge_.rate;
+      auto pBytes = state_bytes( sponge_ );
+
+      pBytes[sponge_.position] ^= sponge_.suffix;
+      pBytes[rate - 1] ^= 0x80;
+      kc::permute( sponge_.state );
+
+      // outputs longer than the rate are squeezed block by block
+      while ( sz_ > 0 )
+      {
+        auto n = std::min( rate, sz_ );
+        std::memcpy( pOut_, pBytes, n );
+        pOut_ += n;
+        sz_ -= n;
+
+        if ( sz_ > 0 )
+          kc::permute( sponge_.state );
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // backends
+  // ---------------------------------------------------------------------------------------------------------
+
+#define LL_IMPLEMENT_KECCAK_BACKEND( type_ )                                                                 \
+  static_assert( sizeof( keccak::sponge ) <= detail::hash_backend< type_ >::contextSize,                     \
+                 "context storage too small for keccak::sponge" );                                           \
+                                                                                                             \
+  void detail::hash_backend< type_ >::init( void* pContext_ )                                                \
+  {                                                                                                          \
+    const auto& p = *keccak::find_params( type_ );                                                           \
+    keccak::init( *static_cast< keccak::sponge* >( pContext_ ), p.rate, p.suffix );                          \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::update( void* pContext_, const std::uint8_t* pBuffer_, size_t sz_ )    \
+  {                                                                                                          \
+    keccak::absorb( *static_cast< keccak::sponge* >( pContext_ ), pBuffer_, sz_ );                           \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::final( void* pContext_, std::uint8_t* pDigest_ )                       \
+  {                                                                                                          \
+    keccak::finalize( *static_cast< keccak::sponge* >( pContext_ ), pDigest_, digestSize );                  \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::copy( void* pTarget_, const void* pSource_ )                           \
+  {                                                                                                          \
+    std::memcpy( pTarget_, pSource_, sizeof( keccak::sponge ) );                                             \
+  }                                                                                                          \
+                                                                                                             \
+  size_t detail::hash_backend< type_ >::export_state( const void* pContext_, std::uint8_t* pState_ )         \
+  {                                                                                                          \
+    std::memcpy( pState_, static_cast< const keccak::sponge* >( pContext_ )->state, keccak::kStateSize );    \
+    return keccak::kStateSize;                                                                               \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::import_state( void* pContext_,                                         \
+                                                     const std::uint8_t* pState_,                            \
+                                                     size_t sz_,                                             \
+                                                     std::uint64_t inputSize_ )                              \
+  {                                                                                                          \
+    if ( sz_ != keccak::kStateSize )                                                                         \
+      throw exception( error::invalid_parameter, "invalid hash state" );                                     \
+                                                                                                             \
+    /* the position in the block follows from the input size */                                              \
+    auto& sponge = *static_cast< keccak::sponge* >( pContext_ );                                             \
+    std::memcpy( sponge.state, pState_, keccak::kStateSize );                                                \
+    sponge.position = static_cast< std::uint32_t >( inputSize_ % blockSize );                                \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::destroy( void* ) LL_NOEXCEPT                                           \
+  {                                                                                                          \
+  }
+
+  LL_IMPLEMENT_KECCAK_BACKEND( hash::type::sha3_256 )
+  LL_IMPLEMENT_KECCAK_BACKEND( hash::type::sha3_512 )
+  LL_IMPLEMENT_KECCAK_BACKEND( hash::type::shake128 )
+  LL_IMPLEMENT_KECCAK_BACKEND( hash::type::shake256 )
+
+#undef LL_IMPLEMENT_KECCAK_BACKEND
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void detail::xof_backend< hash::type::shake128 >::final( void* pContext_, std::uint8_t* pOut_, size_t sz_ )
+  {
+    keccak::finalize( *static_cast< keccak::sponge* >( pContext_ ), pOut_, sz_ );
+  }
+
+  void detail::xof_backend< hash::type::shake256 >::final( void* pContext_, std::uint8_t* pOut_, size_t sz_ )
+  {
+    keccak::finalize( *static_cast< keccak::sponge* >( pContext_ ), pOut_, sz_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
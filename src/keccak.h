@@ -0,0 +1,90 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include "../support/environment.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  // SHA-3 and SHAKE are sponges over the keccak-f[1600] permutation: the input is xored into the first
+  // rate bytes of the 200 byte state, which is permuted after every full block. The variants differ in the
+  // rate, the domain separation suffix of the padding and the output size (arbitrary for SHAKE).
+
+  namespace keccak
+  {
+    const size_t kStateSize = 200;
+    const size_t kNumRounds = 24;
+
+    extern const std::uint64_t kRoundConstants[kNumRounds];
+
+    //! the sponge parameters of a hash type
+    struct params
+    {
+      size_t rate;            //!< the block size in bytes
+      std::uint8_t suffix;    //!< the domain separation bits, including the first bit of the padding
+      size_t digestSize;      //!< the default output size in bytes
+    };
+
+    //! the parameters of a sha-3 or shake hash type, nullptr for other types
+    const params* find_params( hash::type type_ ) LL_NOEXCEPT;
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    struct sponge
+    {
+      std::uint64_t state[25];
+      std::uint32_t position;  //!< the number of bytes absorbed into the current block
+      std::uint16_t rate;
+      std::uint8_t suffix;
+    };
+
+    void init( sponge& sponge_, size_t rate_, std::uint8_t suffix_ );
+    void absorb( sponge& sponge_, const std::uint8_t* pBuffer_, size_t sz_ );
+
+    //! pad the input and squeeze sz_ bytes of output, no more data can be absorbed afterwards
+    void finalize( sponge& sponge_, std::uint8_t* pOut_, size_t sz_ );
+
+    void permute( std::uint64_t* pState_ );
+
+
+    // -------------------------------------------------------------------------------------------------------
+    // kernels
+    // -------------------------------------------------------------------------------------------------------
+
+    //! hash independent messages in 4 interleaved states and write their digests (params_.digestSize each)
+    //! contiguously to pDigests_
+    //! returns false if the batch is too small to fill the lanes reasonably (the single-message path is
+    //! faster then), only to be called if the cpu supports avx2
+    bool hash_many_avx2( const buffer_ref* pBuffers_,
+                         size_t numBuffers_,
+                         const params& params_,
+                         std::uint8_t* pDigests_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,202 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "keccak.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    typedef __m256i lane_t;
+    const size_t kNumLanes = 4;
+
+    inline lane_t set1( std::uint64_t v_ ) { return _mm256_set1_epi64x( static_cast< long long >( v_ ) ); }
+    inline lane_t xor_( lane_t a_, lane_t b_ ) { return _mm256_xor_si256( a_, b_ ); }
+    inline lane_t andnot( lane_t a_, lane_t b_ ) { return _mm256_andnot_si256( a_, b_ ); }
+
+    template < int n_ >
+    inline lane_t rotl( lane_t v_ )
+    {
+      return _mm256_or_si256( _mm256_slli_epi64( v_, n_ ), _mm256_srli_epi64( v_, 64 - n_ ) );
+    }
+
+    // rotations by whole bytes are a single shuffle
+    template <>
+    inline lane_t rotl< 8 >( lane_t v_ )
+    {
+      return _mm256_shuffle_epi8( v_,
+                                  _mm256_setr_epi8( 7, 0, 1, 2, 3, 4, 5, 6, 15, 8, 9, 10, 11, 12, 13, 14,
+                                                    7, 0, 1, 2, 3, 4, 5, 6, 15, 8, 9, 10, 11, 12, 13, 14 ) );
+    }
+
+    template <>
+    inline lane_t rotl< 56 >( lane_t v_ )
+    {
+      return _mm256_shuffle_epi8( v_,
+                                  _mm256_setr_epi8( 1, 2, 3, 4, 5, 6, 7, 0, 9, 10, 11, 12, 13, 14, 15, 8,
+                                                    1, 2, 3, 4, 5, 6, 7, 0, 9, 10, 11, 12, 13, 14, 15, 8 ) );
+    }
+
+#include "keccak_kernels.h"
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    const size_t kMaxRate = 168;  //!< shake128
+
+    //! the progress of the message currently hashed in a lane
+    struct message_lane
+    {
+      const std::uint8_t* pData = nullptr;
+      size_t numFullBlocks = 0;
+      bool tailDone = false;
+      size_t messageIndex = 0;
+      bool active = false;
+
+      std::uint8_t tail[kMaxRate];  //!< the last partial block of the message including padding
+    };
+
+    void assign_message( message_lane& lane_,
+                         const buffer_ref& buffer_,
+                         size_t messageIndex_,
+                         const keccak::params& params_ )
+    {
+      auto pData = static_cast< const std::uint8_t* >( buffer_.pBuffer );
+      auto sz = buffer_.szBufferInBytes;
+      auto remainder = sz % params_.rate;
+
+      lane_.pData = pData;
+      lane_.numFullBlocks = sz / params_.rate;
+      lane_.tailDone = false;
+      lane_.messageIndex = messageIndex_;
+      lane_.active = true;
+
+      // the padding always fits into the block of the remaining bytes
+      std::fill( lane_.tail, lane_.tail + params_.rate, std::uint8_t( 0 ) );
+      if ( remainder > 0 )
+        std::copy( pData + sz - remainder, pData + sz, lane_.tail );
+      lane_.tail[remainder] ^= params_.suffix;
+      lane_.tail[params_.rate - 1] ^= 0x80;
+    }
+
+    //! returns the next block of the lane and advances it
+    inline const std::uint8_t* next_block( message_lane& lane_, size_t rate_ )
+    {
+      if ( lane_.numFullBlocks > 0 )
+      {
+        auto pBlock = lane_.pData;
+        lane_.pData += rate_;
+        --lane_.numFullBlocks;
+        return pBlock;
+      }
+
+      lane_.tailDone = true;
+      return lane_.tail;
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool keccak::hash_many_avx2( const buffer_ref* pBuffers_,
+                               size_t numBuffers_,
+                               const params& params_,
+                               std::uint8_t* pDigests_ )
+  {
+    // with less than half of the lanes in use the single-message path is faster
+    if ( numBuffers_ < kNumLanes / 2 )
+      return false;
+
+    // the tail blocks of the lanes are sized for the largest rate
+    if ( ( params_.rate == 0 ) || ( params_.rate > kMaxRate ) )
+      return false;
+
+    const size_t rate = params_.rate;
+
+    // the states are interleaved, so state[i] holds lane i of all messages
+    std::uint64_t state[25][kNumLanes] = {};
+    message_lane lanes[kNumLanes];
+
+    size_t nextMessage = 0;
+    for ( size_t l = 0; ( l < kNumLanes ) && ( nextMessage < numBuffers_ ); ++l, ++nextMessage )
+      assign_message( lanes[l], pBuffers_[nextMessage], nextMessage, params_ );
+
+    size_t numActive = std::min( numBuffers_, kNumLanes );
+    while ( numActive > 0 )
+    {
+      for ( size_t l = 0; l < kNumLanes; ++l )
+      {
+        if ( !lanes[l].active )
+          continue;
+
+        auto pBlock = next_block( lanes[l], rate );
+        for ( size_t i = 0; i < rate / 8; ++i )
+        {
+          std::uint64_t v;
+          std::memcpy( &v, pBlock + 8 * i, 8 );
+          state[i][l] ^= v;
+        }
+      }
+
+      lane_t v[25];
+      for ( size_t i = 0; i < 25; ++i )
+        v[i] = _mm256_loadu_si256( reinterpret_cast< const lane_t* >( state[i] ) );
+      kc::permute( v );
+      for ( size_t i = 0; i < 25; ++i )
+        _mm256_storeu_si256( reinterpret_cast< lane_t* >( state[i] ), v[i] );
+
+      // emit the digests of the finished messages and refill their lanes
+      for ( size_t l = 0; l < kNumLanes; ++l )
+      {
+        auto& lane = lanes[l];
+        if ( !lane.active || !lane.tailDone )
+          continue;
+
+        auto pDigest = pDigests_ + lane.messageIndex * params_.digestSize;
+        for ( size_t i = 0; i < params_.digestSize; ++i )
+          pDigest[i] = static_cast< std::uint8_t >( state[i / 8][l] >> ( 8 * ( i % 8 ) ) );
+
+        for ( size_t i = 0; i < 25; ++i )
+          state[i][l] = 0;
+
+        if ( nextMessage < numBuffers_ )
+        {
+          assign_message( lane, pBuffers_[nextMessage], nextMessage, params_ );
+          ++nextMessage;
+        }
+        else
+        {
+          lane.active = false;
+          --numActive;
+        }
+      }
+    }
+
+    return true;
+  }
+
+}  // namespace crypto
+}  // namespace ll
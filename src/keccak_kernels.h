@@ -0,0 +1,127 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+// keccak-f[1600] permutation, shared by the instruction set specific translation units
+//
+// This header is meant to be included (once, inside an anonymous namespace) by a translation unit that is
+// compiled for a specific instruction set. Before including it, the translation unit has to provide
+//   - the type lane_t holding one or more 64bit lanes of independent states
+//   - set1, xor_ and andnot (~a & b) for lane_t
+//   - rotl< n >( lane_t )
+// Keeping everything at internal linkage ensures that the instantiations for different instruction sets
+// don't get merged by the linker.
+
+namespace kc
+{
+  //! one round from the state a_ into e_, the state is indexed x + 5 * y
+  //! theta, rho and pi are merged into the load of every row, which chi then combines
+  inline void round( const lane_t* a_, lane_t* e_, lane_t rc_ )
+  {
+    lane_t c0 = xor_( xor_( xor_( a_[0], a_[5] ), xor_( a_[10], a_[15] ) ), a_[20] );
+    lane_t c1 = xor_( xor_( xor_( a_[1], a_[6] ), xor_( a_[11], a_[16] ) ), a_[21] );
+    lane_t c2 = xor_( xor_( xor_( a_[2], a_[7] ), xor_( a_[12], a_[17] ) ), a_[22] );
+    lane_t c3 = xor_( xor_( xor_( a_[3], a_[8] ), xor_( a_[13], a_[18] ) ), a_[23] );
+    lane_t c4 = xor_( xor_( xor_( a_[4], a_[9] ), xor_( a_[14], a_[19] ) ), a_[24] );
+
+    lane_t d0 = xor_( c4, rotl< 1 >( c1 ) );
+    lane_t d1 = xor_( c0, rotl< 1 >( c2 ) );
+    lane_t d2 = xor_( c1, rotl< 1 >( c3 ) );
+    lane_t d3 = xor_( c2, rotl< 1 >( c4 ) );
+    lane_t d4 = xor_( c3, rotl< 1 >( c0 ) );
+
+    lane_t b0, b1, b2, b3, b4;
+
+    b0 = xor_( a_[0], d0 );
+    b1 = rotl< 44 >( xor_( a_[6], d1 ) );
+    b2 = rotl< 43 >( xor_( a_[12], d2 ) );
+    b3 = rotl< 21 >( xor_( a_[18], d3 ) );
+    b4 = rotl< 14 >( xor_( a_[24], d4 ) );
+    e_[0] = xor_( xor_( b0, andnot( b1, b2 ) ), rc_ );
+    e_[1] = xor_( b1, andnot( b2, b3 ) );
+    e_[2] = xor_( b2, andnot( b3, b4 ) );
+    e_[3] = xor_( b3, andnot( b4, b0 ) );
+    e_[4] = xor_( b4, andnot( b0, b1 ) );
+
+    b0 = rotl< 28 >( xor_( a_[3], d3 ) );
+    b1 = rotl< 20 >( xor_( a_[9], d4 ) );
+    b2 = rotl< 3 >( xor_( a_[10], d0 ) );
+    b3 = rotl< 45 >( xor_( a_[16], d1 ) );
+    b4 = rotl< 61 >( xor_( a_[22], d2 ) );
+    e_[5] = xor_( b0, andnot( b1, b2 ) );
+    e_[6] = xor_( b1, andnot( b2, b3 ) );
+    e_[7] = xor_( b2, andnot( b3, b4 ) );
+    e_[8] = xor_( b3, andnot( b4, b0 ) );
+    e_[9] = xor_( b4, andnot( b0, b1 ) );
+
+    b0 = rotl< 1 >( xor_( a_[1], d1 ) );
+    b1 = rotl< 6 >( xor_( a_[7], d2 ) );
+    b2 = rotl< 25 >( xor_( a_[13], d3 ) );
+    b3 = rotl< 8 >( xor_( a_[19], d4 ) );
+    b4 = rotl< 18 >( xor_( a_[20], d0 ) );
+    e_[10] = xor_( b0, andnot( b1, b2 ) );
+    e_[11] = xor_( b1, andnot( b2, b3 ) );
+    e_[12] = xor_( b2, andnot( b3, b4 ) );
+    e_[13] = xor_( b3, andnot( b4, b0 ) );
+    e_[14] = xor_( b4, andnot( b0, b1 ) );
+
+    b0 = rotl< 27 >( xor_( a_[4], d4 ) );
+    b1 = rotl< 36 >( xor_( a_[5], d0 ) );
+    b2 = rotl< 10 >( xor_( a_[11], d1 ) );
+    b3 = rotl< 15 >( xor_( a_[17], d2 ) );
+    b4 = rotl< 56 >( xor_( a_[23], d3 ) );
+    e_[15] = xor_( b0, andnot( b1, b2 ) );
+    e_[16] = xor_( b1, andnot( b2, b3 ) );
+    e_[17] = xor_( b2, andnot( b3, b4 ) );
+    e_[18] = xor_( b3, andnot( b4, b0 ) );
+    e_[19] = xor_( b4, andnot( b0, b1 ) );
+
+    b0 = rotl< 62 >( xor_( a_[2], d2 ) );
+    b1 = rotl< 55 >( xor_( a_[8], d3 ) );
+    b2 = rotl< 39 >( xor_( a_[14], d4 ) );
+    b3 = rotl< 41 >( xor_( a_[15], d0 ) );
+    b4 = rotl< 2 >( xor_( a_[21], d1 ) );
+    e_[20] = xor_( b0, andnot( b1, b2 ) );
+    e_[21] = xor_( b1, andnot( b2, b3 ) );
+    e_[22] = xor_( b2, andnot( b3, b4 ) );
+    e_[23] = xor_( b3, andnot( b4, b0 ) );
+    e_[24] = xor_( b4, andnot( b0, b1 ) );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the 24 rounds of the permutation, in place
+  //! alternating between two copies saves moving the state after every round
+  inline void permute( lane_t* pState_ )
+  {
+    lane_t a[25];
+    lane_t e[25];
+    for ( size_t i = 0; i < 25; ++i )
+      a[i] = pState_[i];
+
+    for ( size_t r = 0; r < keccak::kNumRounds; r += 2 )
+    {
+      round( a, e, set1( keccak::kRoundConstants[r] ) );
+      round( e, a, set1( keccak::kRoundConstants[r + 1] ) );
+    }
+
+    for ( size_t i = 0; i < 25; ++i )
+      pState_[i] = a[i];
+  }
+
+}  // namespace kc
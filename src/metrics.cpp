@@ -0,0 +1,319 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/metrics.h"
+
+#include <atomic>
+#include <limits>
+
+#include "metrics_registry.h"
+#include "../support/environment.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+namespace metrics
+{
+#if LL_CRYPTO_METRICS
+
+  namespace
+  {
+#if LL_HAS_THREAD_LOCAL()
+#define LL_METRICS_THREAD_LOCAL thread_local
+#else
+#define LL_METRICS_THREAD_LOCAL __declspec( thread )
+#endif
+
+    static const size_t kNumTypes = static_cast< size_t >( hash::type::xxh3_128 ) + 1;
+
+    //! threads are distributed round robin, so up to kNumShards threads never write the same cache line
+    static const size_t kNumShards = 16;
+    static const size_t kNoShard = ~size_t( 0 );
+
+    enum value_index
+    {
+      kCalls,
+      kBytes,
+      kNanoseconds,
+      kNumValues
+    };
+
+    struct shard
+    {
+      std::atomic< std::uint64_t > values[kNumEntryPoints][kNumTypes][kNumValues];
+      char padding[64];  //!< keeps the last values of a shard and the first of the next one apart
+    };
+
+    shard g_shards[kNumShards];
+    std::atomic< size_t > g_nextShard( 0 );
+
+    LL_METRICS_THREAD_LOCAL size_t t_shard = kNoShard;
+    LL_METRICS_THREAD_LOCAL detail::scoped_call* t_pActiveCall = nullptr;
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! bucket 0 is [0, 1024) ns, then 4 buckets per power of two up to 2^40 ns (~18 min), then the overflow
+    static const unsigned kMinExponent = 10;
+    static const unsigned kMaxExponent = 40;
+    static const size_t kSubBuckets = 4;
+    static const size_t kNumBuckets = 1 + ( kMaxExponent - kMinExponent ) * kSubBuckets + 1;
+
+    //! pbkdf2 calls take milliseconds, so the histograms aren't sharded
+    struct latency_histogram
+    {
+      std::atomic< std::uint64_t > count;
+      std::atomic< std::uint64_t > sumNanoseconds;
+      std::atomic< std::uint64_t > buckets[kNumBuckets];
+    };
+
+    latency_histogram g_pbkdf2Latencies[kNumTypes];
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    size_t bucket_index( std::uint64_t ns_ )
+    {
+      if ( ns_ < ( std::uint64_t( 1 ) << kMinExponent ) )
+        return 0;
+
+      if ( ns_ >= ( std::uint64_t( 1 ) << kMaxExponent ) )
+        return kNumBuckets - 1;
+
+      unsigned exponent = kMinExponent;
+      while ( ( ns_ >> ( exponent + 1 ) ) != 0 )
+        ++exponent;
+
+      auto subBucket = static_cast< size_t >( ( ns_ >> ( exponent - 2 ) ) & ( kSubBuckets - 1 ) );
+      return 1 + ( exponent - kMinExponent ) * kSubBuckets + subBucket;
+    }
+
+    std::uint64_t bucket_upper_bound( size_t index_ )
+    {
+      if ( index_ == 0 )
+        return ( std::uint64_t( 1 ) << kMinExponent ) - 1;
+
+      if ( index_ == kNumBuckets - 1 )
+        return std::numeric_limits< std::uint64_t >::max();
+
+      auto exponent = kMinExponent + static_cast< unsigned >( ( index_ - 1 ) / kSubBuckets );
+      auto subBucket = ( index_ - 1 ) % kSubBuckets;
+      return ( static_cast< std::uint64_t >( kSubBuckets + subBucket + 1 ) << ( exponent - 2 ) ) - 1;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    shard& get_thread_shard()
+    {
+      if ( t_shard == kNoShard )
+        t_shard = g_nextShard.fetch_add( 1, std::memory_order_relaxed ) % kNumShards;
+      return g_shards[t_shard];
+    }
+
+    void record( entry_point entryPoint_, hash::type type_, bool isCall_, std::uint64_t bytes_,
+                 std::uint64_t ns_ ) LL_NOEXCEPT
+    {
+      auto typeIndex = static_cast< size_t >( type_ );
+      if ( typeIndex >= kNumTypes )
+        return;
+
+      auto& values = get_thread_shard().values[static_cast< size_t >( entryPoint_ )][typeIndex];
+      if ( isCall_ )
+        values[kCalls].fetch_add( 1, std::memory_order_relaxed );
+      if ( bytes_ != 0 )
+        values[kBytes].fetch_add( bytes_, std::memory_order_relaxed );
+      values[kNanoseconds].fetch_add( ns_, std::memory_order_relaxed );
+
+      if ( ( entryPoint_ == entry_point::pbkdf2 ) && isCall_ )
+      {
+        auto& histogram = g_pbkdf2Latencies[typeIndex];
+        histogram.count.fetch_add( 1, std::memory_order_relaxed );
+        histogram.sumNanoseconds.fetch_add( ns_, std::memory_order_relaxed );
+        histogram.buckets[bucket_index( ns_ )].fetch_add( 1, std::memory_order_relaxed );
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  namespace detail
+  {
+    scoped_call::scoped_call( entry_point entryPoint_, hash::type type_, std::uint64_t bytes_, bool isCall_ )
+      LL_NOEXCEPT
+      : m_entryPoint( entryPoint_ )
+      , m_type( type_ )
+      , m_bytes( ( bytes_ == kCollectBytes ) ? 0 : bytes_ )
+      , m_isCall( isCall_ )
+      , m_isOutermost( t_pActiveCall == nullptr )
+      , m_collectsBytes( bytes_ == kCollectBytes )
+      , m_pOuter( t_pActiveCall )
+    {
+      if ( !m_isOutermost )
+      {
+        if ( m_pOuter->m_collectsBytes && !m_collectsBytes )
+          m_pOuter->m_bytes += m_bytes;
+        return;
+      }
+
+      t_pActiveCall = this;
+      m_start = std::chrono::steady_clock::now();
+    }
+
+    scoped_call::~scoped_call()
+    {
+      if ( !m_isOutermost )
+        return;
+
+      auto elapsed = std::chrono::steady_clock::now() - m_start;
+      t_pActiveCall = nullptr;
+
+      auto ns = std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count();
+      record( m_entryPoint, m_type, m_isCall, m_bytes, static_cast< std::uint64_t >( ns ) );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool metrics_enabled() LL_NOEXCEPT
+  {
+    return true;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  snapshot get_snapshot()
+  {
+    snapshot result;
+    result.enabled = true;
+
+    for ( size_t e = 0; e < kNumEntryPoints; ++e )
+    {
+      for ( size_t t = 0; t < kNumTypes; ++t )
+      {
+        counter c;
+        c.entryPoint = static_cast< entry_point >( e );
+        c.hashType = static_cast< hash::type >( t );
+
+        for ( const auto& s : g_shards )
+        {
+          c.calls += s.values[e][t][kCalls].load( std::memory_order_relaxed );
+          c.bytes += s.values[e][t][kBytes].load( std::memory_order_relaxed );
+          c.nanoseconds += s.values[e][t][kNanoseconds].load( std::memory_order_relaxed );
+        }
+
+        if ( ( c.calls != 0 ) || ( c.bytes != 0 ) || ( c.nanoseconds != 0 ) )
+          result.counters.push_back( c );
+      }
+    }
+
+    for ( size_t t = 0; t < kNumTypes; ++t )
+    {
+      const auto& source = g_pbkdf2Latencies[t];
+      if ( source.count.load( std::memory_order_relaxed ) == 0 )
+        continue;
+
+      histogram h;
+      h.hashType = static_cast< hash::type >( t );
+      h.count = source.count.load( std::memory_order_relaxed );
+      h.sumNanoseconds = source.sumNanoseconds.load( std::memory_order_relaxed );
+      for ( size_t i = 0; i < kNumBuckets; ++i )
+      {
+        h.upperBounds.push_back( bucket_upper_bound( i ) );
+        h.counts.push_back( source.buckets[i].load( std::memory_order_relaxed ) );
+      }
+
+      result.pbkdf2Latencies.push_back( std::move( h ) );
+    }
+
+    return result;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void reset()
+  {
+    for ( auto& s : g_shards )
+    {
+      for ( auto& entryPointValues : s.values )
+        for ( auto& typeValues : entryPointValues )
+          for ( auto& value : typeValues )
+            value.store( 0, std::memory_order_relaxed );
+    }
+
+    for ( auto& h : g_pbkdf2Latencies )
+    {
+      h.count.store( 0, std::memory_order_relaxed );
+      h.sumNanoseconds.store( 0, std::memory_order_relaxed );
+      for ( auto& bucket : h.buckets )
+        bucket.store( 0, std::memory_order_relaxed );
+    }
+  }
+
+#else
+
+  bool metrics_enabled() LL_NOEXCEPT
+  {
+    return false;
+  }
+
+  snapshot get_snapshot()
+  {
+    return snapshot();
+  }
+
+  void reset()
+  {
+  }
+
+#endif
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::string to_string( entry_point entryPoint_ )
+  {
+    switch ( entryPoint_ )
+    {
+      case entry_point::get_hash:
+        return "get_hash";
+      case entry_point::get_hash_stream:
+        return "get_hash_stream";
+      case entry_point::get_digest:
+        return "get_digest";
+      case entry_point::get_hashes:
+        return "get_hashes";
+      case entry_point::get_file_hash:
+        return "get_file_hash";
+      case entry_point::hash_generator:
+        return "hash_generator";
+      case entry_point::pbkdf2:
+        return "pbkdf2";
+    }
+    return "unknown";
+  }
+
+}  // namespace metrics
+}  // namespace crypto
+}  // namespace ll
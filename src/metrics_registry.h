@@ -0,0 +1,86 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include "crypto/metrics.h"
+
+#if LL_CRYPTO_METRICS
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace ll
+{
+namespace crypto
+{
+namespace metrics
+{
+  namespace detail
+  {
+    //! times a call and records it on destruction, calls nested in another recorded call of the same thread
+    //! aren't recorded (their bytes are added to the outer call if it collects them)
+    class scoped_call
+    {
+    public:
+      //! for calls that don't know their input size upfront (streams, files): sum up the nested calls
+      static LL_CONSTEXPR std::uint64_t kCollectBytes = ~std::uint64_t( 0 );
+
+      //! isCall_ = false only adds bytes and time, e.g. for hash_generator::add_data
+      scoped_call( entry_point entryPoint_, hash::type type_, std::uint64_t bytes_, bool isCall_ ) LL_NOEXCEPT;
+      ~scoped_call();
+
+      scoped_call( const scoped_call& ) = delete;
+      scoped_call& operator=( const scoped_call& ) = delete;
+
+    private:
+      entry_point m_entryPoint;
+      hash::type m_type;
+      std::uint64_t m_bytes;
+      bool m_isCall;
+      bool m_isOutermost;
+      bool m_collectsBytes;
+      scoped_call* m_pOuter;
+      std::chrono::steady_clock::time_point m_start;
+    };
+  }
+
+}  // namespace metrics
+}  // namespace crypto
+}  // namespace ll
+
+
+#define LL_METRICS_CALL( entryPoint_, type_, bytes_ )                                                        \
+  ::ll::crypto::metrics::detail::scoped_call llMetricsCall(                                                  \
+    ::ll::crypto::metrics::entry_point::entryPoint_, type_, bytes_, true )
+
+#define LL_METRICS_STREAMED_CALL( entryPoint_, type_ )                                                       \
+  LL_METRICS_CALL( entryPoint_, type_, ::ll::crypto::metrics::detail::scoped_call::kCollectBytes )
+
+#define LL_METRICS_DATA( entryPoint_, type_, bytes_ )                                                        \
+  ::ll::crypto::metrics::detail::scoped_call llMetricsCall(                                                  \
+    ::ll::crypto::metrics::entry_point::entryPoint_, type_, bytes_, false )
+
+#else
+
+#define LL_METRICS_CALL( entryPoint_, type_, bytes_ )
+#define LL_METRICS_STREAMED_CALL( entryPoint_, type_ )
+#define LL_METRICS_DATA( entryPoint_, type_, bytes_ )
+
+#endif
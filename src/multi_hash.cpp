@@ -0,0 +1,307 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "crypto/multi_hash.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "crypto/exception.h"
+#include "processing_block.h"
+#include "read_ahead_reader.h"
+
+#include "../support/debug_helpers.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  // ---------------------------------------------------------------------------------------------------------
+  // multi_hash_generator::impl
+  // ---------------------------------------------------------------------------------------------------------
+
+  class multi_hash_generator::impl
+  {
+  public:
+    impl( const std::vector< hash::type >& types_, const hash::config& cfg_ );
+    ~impl();
+
+    void add_data( const std::uint8_t* pBuffer_, size_t sz_ );
+    std::vector< hash > retrieve_hashes();
+
+  private:
+    void worker_loop( size_t index_ );
+
+    std::vector< hash_generator > m_generators;
+
+    // the hand-off to the workers: every generation publishes one (read-only) block to all of them
+    std::vector< std::thread > m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_blockAvailable;
+    std::condition_variable m_blockProcessed;
+    std::uint64_t m_generation = 0;
+    size_t m_numPending = 0;
+    bool m_stop = false;
+    const std::uint8_t* m_pBlock = nullptr;
+    size_t m_szBlock = 0;
+    std::exception_ptr m_pError;
+  };
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  multi_hash_generator::impl::impl( const std::vector< hash::type >& types_, const hash::config& cfg_ )
+  {
+    if ( types_.empty() )
+      throw exception( error::invalid_parameter, "no hash types" );
+
+    for ( auto type : types_ )
+      m_generators.emplace_back( type );
+
+    if ( cfg_.useWorkerThreads && ( m_generators.size() > 1 ) )
+    {
+      for ( size_t i = 0; i < m_generators.size(); ++i )
+        m_workers.emplace_back( &impl::worker_loop, this, i );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  multi_hash_generator::impl::~impl()
+  {
+    {
+      std::lock_guard< std::mutex > lock( m_mutex );
+      m_stop = true;
+    }
+    m_blockAvailable.notify_all();
+
+    for ( auto& worker : m_workers )
+      worker.join();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void multi_hash_generator::impl::add_data( const std::uint8_t* pBuffer_, size_t sz_ )
+  {
+    if ( m_workers.empty() )
+    {
+      for ( auto& generator : m_generators )
+        generator.add_data( pBuffer_, sz_ );
+      return;
+    }
+
+    // the caller owns the buffer, so we have to wait until all workers are done with it
+    std::unique_lock< std::mutex > lock( m_mutex );
+    m_pBlock = pBuffer_;
+    m_szBlock = sz_;
+    m_numPending = m_workers.size();
+    ++m_generation;
+    m_blockAvailable.notify_all();
+
+    m_blockProcessed.wait( lock, [this]() { return m_numPending == 0; } );
+
+    if ( m_pError )
+    {
+      auto pError = m_pError;
+      m_pError = nullptr;
+      std::rethrow_exception( pError );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< hash > multi_hash_generator::impl::retrieve_hashes()
+  {
+    // the workers are idle between add_data calls, so the generators can be accessed directly
+    std::vector< hash > hashes;
+    for ( auto& generator : m_generators )
+      hashes.push_back( generator.retrieve_hash() );
+    return hashes;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void multi_hash_generator::impl::worker_loop( size_t index_ )
+  {
+    std::uint64_t generation = 0;
+
+    for ( ;; )
+    {
+      const std::uint8_t* pBlock = nullptr;
+      size_t szBlock = 0;
+      {
+        std::unique_lock< std::mutex > lock( m_mutex );
+        m_blockAvailable.wait( lock, [&]() { return m_stop || ( m_generation != generation ); } );
+        if ( m_stop )
+          return;
+
+        generation = m_generation;
+        pBlock = m_pBlock;
+        szBlock = m_szBlock;
+      }
+
+      std::exception_ptr pError;
+      try
+      {
+        m_generators[index_].add_data( pBlock, szBlock );
+      }
+      catch ( ... )
+      {
+        pError = std::current_exception();
+      }
+
+      {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        if ( pError && !m_pError )
+          m_pError = pError;
+        if ( --m_numPending == 0 )
+          m_blockProcessed.notify_one();
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // multi_hash_generator Implementation
+  // ---------------------------------------------------------------------------------------------------------
+
+  multi_hash_generator::multi_hash_generator( const std::vector< hash::type >& types_, const hash::config& cfg_ )
+    : m_pImpl( new impl( types_, cfg_ ) )
+  {
+  }
+
+  multi_hash_generator::~multi_hash_generator() = default;
+
+  multi_hash_generator::multi_hash_generator( multi_hash_generator&& other_ )
+  {
+    m_pImpl.reset( other_.m_pImpl.release() );
+  }
+
+  multi_hash_generator& multi_hash_generator::operator=( multi_hash_generator&& other_ )
+  {
+    m_pImpl.reset( other_.m_pImpl.release() );
+    return *this;
+  }
+
+  void multi_hash_generator::add_data( const std::uint8_t* pBuffer_, size_t sz_ )
+  {
+    LL_PRECONDITION( ( pBuffer_ != nullptr ) || ( sz_ == 0 ) );
+    m_pImpl->add_data( pBuffer_, sz_ );
+  }
+
+  std::vector< hash > multi_hash_generator::retrieve_hashes()
+  {
+    return m_pImpl->retrieve_hashes();
+  }
+
+
+  // -----------------------------------------------------------------------------------------------------------
+  // multi hash functions implementation
+  // -----------------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    //! every block is hashed by all algorithms (in turn or concurrently), so also blocks of a buffer are sized
+    //! to stay in the cache like the copied blocks of a stream, the smallest size of the types counts
+    size_t get_block_size( const std::vector< hash::type >& types_, const hash::config& cfg_ )
+    {
+      size_t blockSize = 0;
+      for ( auto type : types_ )
+      {
+        auto sz = get_processing_block_size( type, hash::source::stream, cfg_ );
+        blockSize = ( blockSize == 0 ) ? sz : std::min( blockSize, sz );
+      }
+      return std::max( blockSize, size_t( 1 ) );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< hash > get_multi_hash( const void* pBuffer_,
+                                      size_t szBufferInBytes_,
+                                      const std::vector< hash::type >& types_,
+                                      const hash::config& cfg_ )
+  {
+    if ( !pBuffer_ && ( szBufferInBytes_ > 0 ) )
+      throw exception( error::invalid_parameter, "invalid buffer" );
+
+    multi_hash_generator calculator( types_, cfg_ );
+
+    auto pBuffer = static_cast< const std::uint8_t* >( pBuffer_ );
+    auto blockSize = get_block_size( types_, cfg_ );
+    while ( szBufferInBytes_ >= blockSize )
+    {
+      calculator.add_data( pBuffer, blockSize );
+      pBuffer += blockSize;
+      szBufferInBytes_ -= blockSize;
+    }
+    calculator.add_data( pBuffer, szBufferInBytes_ );
+
+    return calculator.retrieve_hashes();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  std::vector< hash > get_multi_hash( std::istream& stream_,
+                                      const std::vector< hash::type >& types_,
+                                      const hash::config& cfg_ )
+  {
+    if ( !stream_ )
+      throw exception( error::invalid_parameter, "invalid stream" );
+
+    multi_hash_generator calculator( types_, cfg_ );
+    auto blockSize = get_block_size( types_, cfg_ );
+
+    if ( cfg_.numReadAheadBuffers > 0 )
+    {
+      read_ahead_reader reader( stream_, cfg_.numReadAheadBuffers, blockSize );
+
+      const std::uint8_t* pData = nullptr;
+      size_t sz = 0;
+      while ( reader.acquire( pData, sz ) )
+      {
+        calculator.add_data( pData, sz );
+        reader.release();
+      }
+    }
+    else
+    {
+      pooled_block_buffer data( blockSize );
+      while ( stream_.good() )
+      {
+        stream_.read( reinterpret_cast< char* >( data.data() ), data.size() );
+        calculator.add_data( data.data(), static_cast< size_t >( stream_.gcount() ) );
+      }
+    }
+
+    return calculator.retrieve_hashes();
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,434 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "openssl_backend.h"
+
+#include "crypto/exception.h"
+
+#if LL_HAS_OPENSSL3()
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <openssl/core_names.h>
+#include <openssl/err.h>
+#include <openssl/params.h>
+#include <openssl/provider.h>
+
+#endif
+
+
+namespace ll
+{
+namespace crypto
+{
+#if LL_HAS_OPENSSL3()
+
+  namespace openssl
+  {
+    namespace
+    {
+      static const size_t kNumTypes = static_cast< size_t >( hash::type::xxh3_128 ) + 1;
+
+      //! idle digest contexts kept per hash type and thread, further ones are freed on release
+      static const size_t kMaxPooledContexts = 8;
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      const char* digest_name( hash::type type_ )
+      {
+        switch ( type_ )
+        {
+          case hash::type::md4:
+            return "MD4";
+          case hash::type::md5:
+            return "MD5";
+          case hash::type::sha1:
+            return "SHA1";
+          case hash::type::sha256:
+            return "SHA2-256";
+          case hash::type::sha384:
+            return "SHA2-384";
+          case hash::type::sha512:
+            return "SHA2-512";
+          default:
+            throw exception( error::invalid_parameter, "Unsupported hash type" );
+        }
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      //! a library context with providers loaded into it, the default library context if pContext is null
+      struct library_context
+      {
+        OSSL_LIB_CTX* pContext = nullptr;
+        std::vector< OSSL_PROVIDER* > providers;
+
+        bool load( const std::vector< std::string >& names_ )
+        {
+          pContext = OSSL_LIB_CTX_new();
+          if ( !pContext )
+            return false;
+
+          for ( const auto& name : names_ )
+          {
+            auto pProvider = OSSL_PROVIDER_load( pContext, name.c_str() );
+            if ( !pProvider )
+            {
+              release();
+              return false;
+            }
+            providers.push_back( pProvider );
+          }
+
+          return true;
+        }
+
+        void release()
+        {
+          for ( auto pProvider : providers )
+            OSSL_PROVIDER_unload( pProvider );
+          providers.clear();
+
+          OSSL_LIB_CTX_free( pContext );
+          pContext = nullptr;
+        }
+      };
+
+
+      //! the fetched algorithms are kept for the lifetime of the process (as are the library contexts, the
+      //! pooled contexts of other threads may still refer to them at exit)
+      struct registry
+      {
+        std::mutex mutex;
+        library_context configured;  //!< from init_backend
+        library_context legacy;      //!< for md4 if no providers are configured
+        std::string properties;
+        bool fetched = false;
+
+        algorithms entries[kNumTypes];
+        std::atomic< bool > ready[kNumTypes];
+
+        registry()
+        {
+          for ( auto& r : ready )
+            r.store( false, std::memory_order_relaxed );
+        }
+      };
+
+      registry& get_registry()
+      {
+        static registry s_registry;
+        return s_registry;
+      }
+
+      const char* to_query( const std::string& properties_ )
+      {
+        return properties_.empty() ? nullptr : properties_.c_str();
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      //! generators held by other thread locals (e.g. the generator pool) may be destroyed after the pools
+      //! of their thread, the flag has no destructor, so it can be checked until the thread is gone
+      thread_local bool t_poolsDestroyed = false;
+
+      //! the idle digest contexts of a thread, per hash type
+      struct digest_context_pool
+      {
+        std::vector< EVP_MD_CTX* > contexts[kNumTypes];
+
+        ~digest_context_pool()
+        {
+          t_poolsDestroyed = true;
+          for ( auto& typeContexts : contexts )
+            for ( auto pContext : typeContexts )
+              EVP_MD_CTX_free( pContext );
+        }
+      };
+
+      //! null once the pool of the calling thread is destroyed
+      std::vector< EVP_MD_CTX* >* get_thread_pool( hash::type type_ )
+      {
+        if ( t_poolsDestroyed )
+          return nullptr;
+
+        static thread_local digest_context_pool t_pool;
+        return &t_pool.contexts[static_cast< size_t >( type_ )];
+      }
+
+      EVP_MD_CTX* take_digest_context( hash::type type_ )
+      {
+        auto pPool = get_thread_pool( type_ );
+        if ( pPool && !pPool->empty() )
+        {
+          auto pContext = pPool->back();
+          pPool->pop_back();
+          return pContext;
+        }
+
+        auto pContext = EVP_MD_CTX_new();
+        if ( !pContext )
+          throw exception( error::internal, "could not create digest context" );
+        return pContext;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      //! the pbkdf2 contexts of a thread, per hash type
+      struct pbkdf2_context_cache
+      {
+        EVP_KDF_CTX* contexts[kNumTypes] = {};
+
+        ~pbkdf2_context_cache()
+        {
+          t_poolsDestroyed = true;
+          for ( auto pContext : contexts )
+            EVP_KDF_CTX_free( pContext );
+        }
+      };
+
+      //! the digest is set once, as setting it fetches it again
+      EVP_KDF_CTX* get_pbkdf2_context( hash::type type_ )
+      {
+        if ( t_poolsDestroyed )
+          throw exception( error::invalid_request, "pbkdf2 called during thread exit" );
+
+        static thread_local pbkdf2_context_cache t_cache;
+
+        auto& pContext = t_cache.contexts[static_cast< size_t >( type_ )];
+        if ( pContext )
+          return pContext;
+
+        const auto& a = get_algorithms( type_ );
+        if ( !a.pPbkdf2 )
+          throw exception( error::invalid_request, "pbkdf2 not offered by the configured providers" );
+
+        auto pNew = EVP_KDF_CTX_new( a.pPbkdf2 );
+        if ( !pNew )
+          throw exception( error::internal, "could not create pbkdf2 context" );
+
+        // no SP 800-132 lower bounds for the iterations, salt and key length (like PKCS5_PBKDF2_HMAC)
+        int pkcs5 = 1;
+        auto& properties = get_registry().properties;
+        OSSL_PARAM params[] = {
+          OSSL_PARAM_construct_utf8_string( OSSL_KDF_PARAM_DIGEST, const_cast< char* >( a.digestName ), 0 ),
+          OSSL_PARAM_construct_int( OSSL_KDF_PARAM_PKCS5, &pkcs5 ),
+          OSSL_PARAM_construct_end(),
+          OSSL_PARAM_construct_end()
+        };
+        if ( !properties.empty() )
+        {
+          params[2] = OSSL_PARAM_construct_utf8_string( OSSL_KDF_PARAM_PROPERTIES,
+                                                        const_cast< char* >( properties.c_str() ), 0 );
+        }
+
+        if ( EVP_KDF_CTX_set_params( pNew, params ) != 1 )
+        {
+          EVP_KDF_CTX_free( pNew );
+          ERR_clear_error();
+          throw exception( error::internal, "could not initialize pbkdf2 context" );
+        }
+
+        pContext = pNew;
+        return pContext;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    const algorithms& get_algorithms( hash::type type_ )
+    {
+      auto& r = get_registry();
+      auto index = static_cast< size_t >( type_ );
+      if ( ( index < kNumTypes ) && r.ready[index].load( std::memory_order_acquire ) )
+        return r.entries[index];
+
+      auto name = digest_name( type_ );
+
+      std::lock_guard< std::mutex > lock( r.mutex );
+      r.fetched = true;
+
+      auto& entry = r.entries[index];
+      if ( r.ready[index].load( std::memory_order_relaxed ) )
+        return entry;
+
+      auto pLibraryContext = r.configured.pContext;
+      auto pDigest = EVP_MD_fetch( pLibraryContext, name, to_query( r.properties ) );
+
+      // md4 is only offered by the legacy provider, which isn't loaded into the default library context
+      if ( !pDigest && !pLibraryContext && ( type_ == hash::type::md4 ) )
+      {
+        if ( r.legacy.pContext || r.legacy.load( { "legacy", "default" } ) )
+        {
+          pLibraryContext = r.legacy.pContext;
+          pDigest = EVP_MD_fetch( pLibraryContext, name, to_query( r.properties ) );
+        }
+      }
+
+      if ( !pDigest )
+      {
+        ERR_clear_error();
+        throw exception( error::invalid_request, "hash type not offered by the configured providers" );
+      }
+
+      // pbkdf2 is checked when it's used, hashing doesn't need it
+      entry.pPbkdf2 = EVP_KDF_fetch( pLibraryContext, OSSL_KDF_NAME_PBKDF2, to_query( r.properties ) );
+      if ( !entry.pPbkdf2 )
+        ERR_clear_error();
+
+      entry.pDigest = pDigest;
+      entry.digestName = name;
+      r.ready[index].store( true, std::memory_order_release );
+      return entry;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void init( const backend_config& cfg_ )
+    {
+      auto& r = get_registry();
+      std::lock_guard< std::mutex > lock( r.mutex );
+      if ( r.fetched )
+        throw exception( error::invalid_request, "the algorithms have already been fetched" );
+
+      library_context configured;
+      if ( !cfg_.providers.empty() && !configured.load( cfg_.providers ) )
+      {
+        ERR_clear_error();
+        throw exception( error::invalid_parameter, "could not load the providers" );
+      }
+
+      r.configured.release();
+      r.configured = configured;
+      r.properties = cfg_.properties;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    EVP_MD_CTX* acquire_digest_context( hash::type type_ )
+    {
+      const auto& a = get_algorithms( type_ );
+      auto pContext = take_digest_context( type_ );
+
+      // a context that was used with the same digest before keeps its provider state
+      if ( EVP_DigestInit_ex2( pContext, a.pDigest, nullptr ) != 1 )
+      {
+        EVP_MD_CTX_free( pContext );
+        ERR_clear_error();
+        throw exception( error::internal, "could not initialize digest context" );
+      }
+
+      return pContext;
+    }
+
+    EVP_MD_CTX* acquire_digest_context( hash::type type_, const EVP_MD_CTX* pSource_ )
+    {
+      auto pContext = take_digest_context( type_ );
+      if ( EVP_MD_CTX_copy_ex( pContext, pSource_ ) != 1 )
+      {
+        EVP_MD_CTX_free( pContext );
+        ERR_clear_error();
+        throw exception( error::internal, "could not copy digest context" );
+      }
+
+      return pContext;
+    }
+
+    void release_digest_context( hash::type type_, EVP_MD_CTX* pContext_ ) LL_NOEXCEPT
+    {
+      try
+      {
+        auto pPool = get_thread_pool( type_ );
+        if ( pPool && ( pPool->size() < kMaxPooledContexts ) )
+        {
+          pPool->push_back( pContext_ );
+          return;
+        }
+      }
+      catch ( ... )
+      {
+      }
+
+      EVP_MD_CTX_free( pContext_ );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void derive_pbkdf2( hash::type type_,
+                        const std::string& password_,
+                        const std::string& salt_,
+                        std::uint64_t numIterations_,
+                        std::uint8_t* pOutput_,
+                        size_t sz_ )
+    {
+      auto pContext = get_pbkdf2_context( type_ );
+
+      OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string( OSSL_KDF_PARAM_PASSWORD, const_cast< char* >( password_.data() ),
+                                           password_.size() ),
+        OSSL_PARAM_construct_octet_string( OSSL_KDF_PARAM_SALT, const_cast< char* >( salt_.data() ),
+                                           salt_.size() ),
+        OSSL_PARAM_construct_uint64( OSSL_KDF_PARAM_ITER, &numIterations_ ),
+        OSSL_PARAM_construct_end()
+      };
+
+      auto result = EVP_KDF_derive( pContext, pOutput_, sz_, params );
+
+      // the context outlives the call, so it mustn't keep the password (it's cleansed on replacement)
+      char empty = 0;
+      OSSL_PARAM clear[] = {
+        OSSL_PARAM_construct_octet_string( OSSL_KDF_PARAM_PASSWORD, &empty, 0 ),
+        OSSL_PARAM_construct_end()
+      };
+      EVP_KDF_CTX_set_params( pContext, clear );
+
+      if ( result != 1 )
+      {
+        ERR_clear_error();
+        throw exception( error::internal, "pbkdf2 failed" );
+      }
+    }
+  }
+
+#endif
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void init_backend( const backend_config& cfg_ )
+  {
+#if LL_HAS_OPENSSL3()
+    openssl::init( cfg_ );
+#else
+    if ( !cfg_.providers.empty() || !cfg_.properties.empty() )
+      throw exception( error::invalid_request, "providers are only supported with OpenSSL >= 3" );
+#endif
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,102 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "crypto/hash.h"
+#include "crypto/backend.h"
+
+#include "../support/environment.h"
+
+// md4 / md5 through the EVP interface instead of the deprecated low-level functions (cmake option
+// LL_CRYPTO_OPENSSL_EVP), the EVP contexts are opaque, so their state can't be exported
+#ifndef LL_CRYPTO_OPENSSL_EVP
+#define LL_CRYPTO_OPENSSL_EVP 0
+#endif
+
+#if !LL_IS_WINDOWS() && !LL_IS_OSX()
+#include <openssl/opensslv.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#define LL_HAS_OPENSSL3() 1
+#endif
+#endif
+
+#ifndef LL_HAS_OPENSSL3
+#define LL_HAS_OPENSSL3() 0
+#endif
+
+#if LL_CRYPTO_OPENSSL_EVP && !LL_HAS_OPENSSL3()
+#error "LL_CRYPTO_OPENSSL_EVP requires OpenSSL >= 3"
+#endif
+
+
+#if LL_HAS_OPENSSL3()
+
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace openssl
+  {
+    //! the algorithms of a hash type, fetched once per process (see init_backend)
+    struct algorithms
+    {
+      EVP_MD* pDigest = nullptr;
+      EVP_KDF* pPbkdf2 = nullptr;  //!< from the same library context as the digest
+      const char* digestName = nullptr;
+    };
+
+    //! throws error::invalid_request if the configured providers don't offer the hash type
+    const algorithms& get_algorithms( hash::type type_ );
+
+    void init( const backend_config& cfg_ );
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! a digest context from the per-thread pool of the calling thread, initialized for the hash type
+    //! the pooled contexts keep their provider state, so initializing them again doesn't allocate
+    EVP_MD_CTX* acquire_digest_context( hash::type type_ );
+
+    //! a context initialized with the state of pSource_, taken from the pool
+    EVP_MD_CTX* acquire_digest_context( hash::type type_, const EVP_MD_CTX* pSource_ );
+
+    //! hand the context back to the pool of the calling thread (or free it if the pool is full)
+    void release_digest_context( hash::type type_, EVP_MD_CTX* pContext_ ) LL_NOEXCEPT;
+
+    //! derive the key with the pbkdf2 context of the calling thread for the hash type, the contexts are
+    //! created once and the password is cleared from them afterwards
+    void derive_pbkdf2( hash::type type_,
+                        const std::string& password_,
+                        const std::string& salt_,
+                        std::uint64_t numIterations_,
+                        std::uint8_t* pOutput_,
+                        size_t sz_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
+
+#endif
@@ -29,6 +29,9 @@
 #endif
 
 #include "internal_utils.h"
+#include "openssl_backend.h"
+#include "metrics_registry.h"
+#include "tracing.h"
 
 
 namespace ll
@@ -56,7 +59,7 @@ namespace crypto
       }
     }
 
-#else
+#elif !LL_HAS_OPENSSL3()
     
     inline static const EVP_MD* to_openssl_hash_type( ll::crypto::hash::type type_ )
     {
@@ -96,6 +99,9 @@ namespace crypto
       throw crypto::exception( error::invalid_parameter );
     }
 
+    LL_METRICS_CALL( pbkdf2, type_, 0 );
+    LL_PROBE3( pbkdf2_begin, static_cast< int >( type_ ), cfg_.numIterations, cfg_.outputLength );
+
     pbk pbk;
     pbk.binary.resize( cfg_.outputLength / 2 );  // cfg sets the string length, which is 2* binary
 
@@ -109,6 +115,11 @@ namespace crypto
     }
     
 
+#elif LL_HAS_OPENSSL3()
+
+    // the digest and the kdf are fetched once, the contexts are reused per thread
+    openssl::derive_pbkdf2( type_, password_, salt_, cfg_.numIterations, pbk.binary.data(), pbk.binary.size() );
+
 #else
 
     if( PKCS5_PBKDF2_HMAC( password_.c_str(), password_.size(),
@@ -123,6 +134,8 @@ namespace crypto
 
 #endif
 
+    LL_PROBE2( pbkdf2_end, static_cast< int >( type_ ), cfg_.numIterations );
+
     pbk.string = string_from_binary( pbk.binary );
     return pbk;
   }
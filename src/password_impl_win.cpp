@@ -25,6 +25,7 @@
 
 #include "crypto/exception.h"
 #include "internal_utils.h"
+#include "metrics_registry.h"
 
 
 namespace ll
@@ -52,6 +53,8 @@ namespace crypto
       throw crypto::exception( error::invalid_parameter );
     }
 
+    LL_METRICS_CALL( pbkdf2, type_, 0 );
+
     BCRYPT_ALG_HANDLE hAlgorithm = NULL;
 
     auto result = ::BCryptOpenAlgorithmProvider(
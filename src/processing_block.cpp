@@ -0,0 +1,232 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "processing_block.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#include "crypto/hash.h"
+#include "cpu_features.h"
+#include "../support/environment.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    const size_t kMinBlockSize = 64 << 10;
+    const size_t kMaxBlockSize = 4 << 20;
+
+    //! assumed if the cpu doesn't report its cache sizes
+    const size_t kDefaultL2Size = 256 << 10;
+
+    //! input hashed in place is only split to bound the size of the add_data calls
+    const size_t kMemorySliceSize = 4 << 20;
+
+    //! the input copied through the candidate block buffers by the calibration (per algorithm class)
+    const size_t kCalibrationSize = 8 << 20;
+
+    //! the calibrated stream block sizes of the regular and the fast algorithms, 0 until calibrated
+    std::atomic< size_t > s_calibratedRegular( 0 );
+    std::atomic< size_t > s_calibratedFast( 0 );
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the checksums and the simd blake3 kernels hash a cache-sized block so fast that the overhead of
+    //! every read counts, so they get larger blocks than the other algorithms
+    bool is_fast( hash::type type_ )
+    {
+      switch ( type_ )
+      {
+        case hash::type::blake3:
+        case hash::type::crc32c:
+        case hash::type::xxh3_64:
+        case hash::type::xxh3_128:
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    size_t round_block_size( size_t sz_ )
+    {
+      sz_ = ( sz_ + kBlockBufferAlignment - 1 ) / kBlockBufferAlignment * kBlockBufferAlignment;
+      return std::min( std::max( sz_, kMinBlockSize ), kMaxBlockSize );
+    }
+
+    size_t l2_size()
+    {
+      auto l2 = get_cache_geometry().l2;
+      return l2 > 0 ? l2 : kDefaultL2Size;
+    }
+
+    //! a copied block is hashed while it is still in the L2 cache, the slower algorithms only use half of
+    //! it, so their state and tables (and the next block being read) stay resident as well
+    size_t default_stream_block_size( bool fast_ )
+    {
+      return round_block_size( fast_ ? l2_size() : l2_size() / 2 );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the time it takes to copy the input through a block buffer of blockSize_ bytes and hash it, the way
+    //! the stream path does
+    double measure_stream_path( hash::type type_,
+                                const std::vector< std::uint8_t >& input_,
+                                size_t blockSize_ )
+    {
+      typedef std::chrono::steady_clock clock;
+
+      pooled_block_buffer buffer( blockSize_ );
+      hash_generator generator( type_ );
+
+      auto start = clock::now();
+      for ( size_t pos = 0; pos < input_.size(); pos += blockSize_ )
+      {
+        auto sz = std::min( blockSize_, input_.size() - pos );
+        std::memcpy( buffer.data(), input_.data() + pos, sz );
+        generator.add_data( buffer.data(), sz );
+      }
+      generator.retrieve_digest();
+      return std::chrono::duration< double >( clock::now() - start ).count();
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // pooled_block_buffer
+  // ---------------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+#if LL_HAS_THREAD_LOCAL()
+
+    //! the idle block buffer of the thread, kept at the largest size used so far
+    std::vector< std::uint8_t >& get_thread_buffer()
+    {
+      static thread_local std::vector< std::uint8_t > t_buffer;
+      return t_buffer;
+    }
+
+#endif
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  pooled_block_buffer::pooled_block_buffer( size_t sz_ ) : m_size( sz_ )
+  {
+#if LL_HAS_THREAD_LOCAL()
+    if ( sz_ <= kMaxBlockSize )
+      m_storage.swap( get_thread_buffer() );
+#endif
+
+    if ( m_storage.size() < sz_ + kBlockBufferAlignment )
+    {
+      m_storage.clear();
+      m_storage.resize( sz_ + kBlockBufferAlignment );
+    }
+
+    auto misalignment = reinterpret_cast< std::uintptr_t >( m_storage.data() ) % kBlockBufferAlignment;
+    m_pData = m_storage.data() + ( kBlockBufferAlignment - misalignment ) % kBlockBufferAlignment;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  pooled_block_buffer::~pooled_block_buffer()
+  {
+#if LL_HAS_THREAD_LOCAL()
+    // buffers for explicitly configured larger blocks are freed (and didn't take the pooled one), so a single
+    // call with a huge block size doesn't pin that memory for the lifetime of the thread
+    if ( m_size > kMaxBlockSize )
+      return;
+
+    auto& idle = get_thread_buffer();
+    if ( idle.size() < m_storage.size() )
+      idle.swap( m_storage );
+#endif
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // block size selection
+  // ---------------------------------------------------------------------------------------------------------
+
+  LL_CONSTEXPR size_t hash::config::autoBlockSize;
+
+  size_t get_processing_block_size( hash::type type_, hash::source source_, const hash::config& cfg_ )
+  {
+    if ( cfg_.processingBlockSize != hash::config::autoBlockSize )
+      return cfg_.processingBlockSize;
+
+    if ( source_ == hash::source::memory )
+      return kMemorySliceSize;
+
+    auto fast = is_fast( type_ );
+    auto calibrated = fast ? s_calibratedFast.load() : s_calibratedRegular.load();
+    return calibrated > 0 ? calibrated : default_stream_block_size( fast );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void calibrate_processing_block_size()
+  {
+    std::vector< std::uint8_t > input( kCalibrationSize );
+    for ( size_t i = 0; i < input.size(); ++i )
+      input[i] = static_cast< std::uint8_t >( ( i * 131 ) >> 3 );
+
+    std::vector< size_t > candidates;
+    for ( auto sz : { l2_size() / 4, l2_size() / 2, l2_size(), 2 * l2_size() } )
+    {
+      sz = round_block_size( sz );
+      if ( std::find( candidates.begin(), candidates.end(), sz ) == candidates.end() )
+        candidates.push_back( sz );
+    }
+
+    // one representative per class, the fastest of two runs counts (the first one may fault the pages in)
+    for ( auto fast : { false, true } )
+    {
+      auto type = fast ? hash::type::xxh3_64 : hash::type::sha256;
+
+      size_t best = 0;
+      double bestTime = 0;
+      for ( auto sz : candidates )
+      {
+        auto t = std::min( measure_stream_path( type, input, sz ), measure_stream_path( type, input, sz ) );
+        if ( ( best == 0 ) || ( t < bestTime ) )
+        {
+          best = sz;
+          bestTime = t;
+        }
+      }
+
+      ( fast ? s_calibratedFast : s_calibratedRegular ).store( best );
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
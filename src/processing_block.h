@@ -0,0 +1,60 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! the alignment of the block buffers: page alignment keeps them friendly to direct I/O and the kernels
+  //! never straddle a cache line at the start of a block
+  const size_t kBlockBufferAlignment = 4096;
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! borrows the aligned block buffer of the calling thread (grown to sz_ if needed) and hands it back on
+  //! destruction, so hashing a stream doesn't allocate a fresh block buffer per call
+  //! a nested user on the same thread gets a buffer of its own
+  //! buffers larger than the largest automatic block size (4 MiB) aren't kept
+  class pooled_block_buffer
+  {
+  public:
+    explicit pooled_block_buffer( size_t sz_ );
+    ~pooled_block_buffer();
+
+    pooled_block_buffer( const pooled_block_buffer& ) = delete;
+    pooled_block_buffer& operator=( const pooled_block_buffer& ) = delete;
+
+    std::uint8_t* data() { return m_pData; }
+    size_t size() const { return m_size; }
+
+  private:
+    std::vector< std::uint8_t > m_storage;
+    std::uint8_t* m_pData = nullptr;
+    size_t m_size = 0;
+  };
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,176 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "read_ahead_reader.h"
+
+#include "crypto/exception.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    //! page alignment keeps the buffers friendly to direct I/O and avoids false sharing between them
+    const size_t kBufferAlignment = 4096;
+
+    //! number of busy polls before a waiting side blocks
+    const unsigned kSpinCount = 64;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  //! the predicate only reads the atomics, the mutex merely orders it against notify, so a change published
+  //! between the check and the wait can't get lost
+  template < typename predicate_t >
+  void read_ahead_reader::wait_until( predicate_t predicate_ )
+  {
+    for ( unsigned spins = 0; spins < kSpinCount; ++spins )
+    {
+      if ( predicate_() )
+        return;
+    }
+
+    std::unique_lock< std::mutex > lock( m_waitMutex );
+    m_changed.wait( lock, predicate_ );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void read_ahead_reader::notify()
+  {
+    {
+      std::lock_guard< std::mutex > lock( m_waitMutex );
+    }
+    m_changed.notify_all();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  read_ahead_reader::read_ahead_reader( std::istream& stream_, size_t numBuffers_, size_t bufferSize_ )
+    : m_stream( stream_ )
+    , m_numBuffers( numBuffers_ )
+    , m_bufferSize( bufferSize_ )
+    , m_stride( ( bufferSize_ + kBufferAlignment - 1 ) / kBufferAlignment * kBufferAlignment )
+    , m_sizes( numBuffers_, 0 )
+    , m_head( 0 )
+    , m_tail( 0 )
+    , m_done( false )
+    , m_cancelled( false )
+  {
+    if ( ( numBuffers_ == 0 ) || ( bufferSize_ == 0 ) )
+      throw exception( error::invalid_parameter, "invalid read-ahead configuration" );
+
+    m_storage.resize( m_numBuffers * m_stride + kBufferAlignment );
+    auto address = reinterpret_cast< std::uintptr_t >( m_storage.data() );
+    m_pBuffers = m_storage.data() + ( kBufferAlignment - address % kBufferAlignment ) % kBufferAlignment;
+
+    m_thread = std::thread( &read_ahead_reader::read_loop, this );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  read_ahead_reader::~read_ahead_reader()
+  {
+    m_cancelled = true;
+    notify();
+    if ( m_thread.joinable() )
+      m_thread.join();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  bool read_ahead_reader::acquire( const std::uint8_t*& pData_, size_t& sz_ )
+  {
+    auto tail = m_tail.load( std::memory_order_relaxed );
+
+    // m_done has to be read before m_head, otherwise we could miss the last buffers
+    bool done = false;
+    wait_until( [&]()
+    {
+      done = m_done.load( std::memory_order_acquire );
+      return done || ( m_head.load( std::memory_order_acquire ) != tail );
+    } );
+
+    if ( m_head.load( std::memory_order_acquire ) == tail )
+    {
+      if ( m_pError )
+        std::rethrow_exception( m_pError );
+      return false;
+    }
+
+    pData_ = buffer( tail );
+    sz_ = m_sizes[tail % m_numBuffers];
+    return true;
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void read_ahead_reader::release()
+  {
+    m_tail.fetch_add( 1, std::memory_order_release );
+    notify();
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void read_ahead_reader::read_loop()
+  {
+    try
+    {
+      auto head = m_head.load( std::memory_order_relaxed );
+      while ( m_stream.good() )
+      {
+        wait_until( [&]()
+        {
+          return m_cancelled.load( std::memory_order_relaxed )
+                 || ( head - m_tail.load( std::memory_order_acquire ) < m_numBuffers );
+        } );
+
+        if ( m_cancelled.load( std::memory_order_relaxed ) )
+          break;
+
+        m_stream.read( reinterpret_cast< char* >( buffer( head ) ), m_bufferSize );
+        auto bytesRead = static_cast< size_t >( m_stream.gcount() );
+        if ( bytesRead == 0 )
+          break;
+
+        m_sizes[head % m_numBuffers] = bytesRead;
+        m_head.store( ++head, std::memory_order_release );
+        notify();
+      }
+    }
+    catch ( ... )
+    {
+      m_pError = std::current_exception();
+    }
+
+    m_done.store( true, std::memory_order_release );
+    notify();
+  }
+
+}  // namespace crypto
+}  // namespace ll
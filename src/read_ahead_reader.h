@@ -0,0 +1,87 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace ll
+{
+namespace crypto
+{
+  //! reads a stream on a background thread into a ring of aligned buffers, so that reading the next blocks
+  //! overlaps with processing the current one (single producer / single consumer, lock-free hand-off, a side
+  //! that has to wait polls briefly and then blocks until the other side filled or released a buffer)
+  class read_ahead_reader
+  {
+  public:
+    read_ahead_reader( std::istream& stream_, size_t numBuffers_, size_t bufferSize_ );
+    ~read_ahead_reader();
+
+    read_ahead_reader( const read_ahead_reader& ) = delete;
+    read_ahead_reader& operator=( const read_ahead_reader& ) = delete;
+
+    //! wait for the next filled buffer, returns false at the end of the stream
+    //! rethrows the exception if reading the stream failed
+    bool acquire( const std::uint8_t*& pData_, size_t& sz_ );
+
+    //! hand the buffer from the last acquire back to the reader
+    void release();
+
+  private:
+    void read_loop();
+
+    template < typename predicate_t >
+    void wait_until( predicate_t predicate_ );
+
+    //! wakes the other side if it is blocked in wait_until
+    void notify();
+
+    std::uint8_t* buffer( std::uint64_t index_ ) { return m_pBuffers + ( index_ % m_numBuffers ) * m_stride; }
+
+    std::istream& m_stream;
+    size_t m_numBuffers;
+    size_t m_bufferSize;
+    size_t m_stride;
+
+    std::vector< std::uint8_t > m_storage;
+    std::uint8_t* m_pBuffers = nullptr;
+    std::vector< size_t > m_sizes;
+
+    std::atomic< std::uint64_t > m_head;  //!< number of buffers filled by the reader
+    std::atomic< std::uint64_t > m_tail;  //!< number of buffers released by the consumer
+    std::atomic< bool > m_done;           //!< the reader has filled its last buffer
+    std::atomic< bool > m_cancelled;      //!< the consumer stopped early
+    std::exception_ptr m_pError;          //!< published together with m_done
+
+    std::mutex m_waitMutex;
+    std::condition_variable m_changed;  //!< a buffer was filled or released, the reader finished or was cancelled
+
+    std::thread m_thread;
+  };
+
+}  // namespace crypto
+}  // namespace ll
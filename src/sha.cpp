@@ -0,0 +1,677 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "sha.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "crypto/basic_hash_generator.h"
+#include "crypto/exception.h"
+#include "cpu_features.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace sha
+  {
+    const std::uint32_t kRoundConstants256[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    const std::uint64_t kRoundConstants512[80] = {
+      0x428a2f98d728ae22ull, 0x7137449123ef65cdull, 0xb5c0fbcfec4d3b2full, 0xe9b5dba58189dbbcull,
+      0x3956c25bf348b538ull, 0x59f111f1b605d019ull, 0x923f82a4af194f9bull, 0xab1c5ed5da6d8118ull,
+      0xd807aa98a3030242ull, 0x12835b0145706fbeull, 0x243185be4ee4b28cull, 0x550c7dc3d5ffb4e2ull,
+      0x72be5d74f27b896full, 0x80deb1fe3b1696b1ull, 0x9bdc06a725c71235ull, 0xc19bf174cf692694ull,
+      0xe49b69c19ef14ad2ull, 0xefbe4786384f25e3ull, 0x0fc19dc68b8cd5b5ull, 0x240ca1cc77ac9c65ull,
+      0x2de92c6f592b0275ull, 0x4a7484aa6ea6e483ull, 0x5cb0a9dcbd41fbd4ull, 0x76f988da831153b5ull,
+      0x983e5152ee66dfabull, 0xa831c66d2db43210ull, 0xb00327c898fb213full, 0xbf597fc7beef0ee4ull,
+      0xc6e00bf33da88fc2ull, 0xd5a79147930aa725ull, 0x06ca6351e003826full, 0x142929670a0e6e70ull,
+      0x27b70a8546d22ffcull, 0x2e1b21385c26c926ull, 0x4d2c6dfc5ac42aedull, 0x53380d139d95b3dfull,
+      0x650a73548baf63deull, 0x766a0abb3c77b2a8ull, 0x81c2c92e47edaee6ull, 0x92722c851482353bull,
+      0xa2bfe8a14cf10364ull, 0xa81a664bbc423001ull, 0xc24b8b70d0f89791ull, 0xc76c51a30654be30ull,
+      0xd192e819d6ef5218ull, 0xd69906245565a910ull, 0xf40e35855771202aull, 0x106aa07032bbd1b8ull,
+      0x19a4c116b8d2d0c8ull, 0x1e376c085141ab53ull, 0x2748774cdf8eeb99ull, 0x34b0bcb5e19b48a8ull,
+      0x391c0cb3c5c95a63ull, 0x4ed8aa4ae3418acbull, 0x5b9cca4f7763e373ull, 0x682e6ff3d6b2b8a3ull,
+      0x748f82ee5defb2fcull, 0x78a5636f43172f60ull, 0x84c87814a1f0ab72ull, 0x8cc702081a6439ecull,
+      0x90befffa23631e28ull, 0xa4506cebde82bde9ull, 0xbef9a3f7b2c67915ull, 0xc67178f2e372532bull,
+      0xca273eceea26619cull, 0xd186b8c721c0c207ull, 0xeada7dd6cde0eb1eull, 0xf57d4f7fee6ed178ull,
+      0x06f067aa72176fbaull, 0x0a637dc5a2c898a6ull, 0x113f9804bef90daeull, 0x1b710b35131c471bull,
+      0x28db77f523047d84ull, 0x32caab7b40c72493ull, 0x3c9ebe0a15c9bebcull, 0x431d67c49c100d4cull,
+      0x4cc5d4becb3e42b6ull, 0x597f299cfc657e2aull, 0x5fcb6fab3ad6faecull, 0x6c44198c4a475817ull,
+    };
+
+    namespace
+    {
+      inline std::uint32_t load_be32( const std::uint8_t* p_ )
+      {
+        return ( std::uint32_t( p_[0] ) << 24 ) | ( std::uint32_t( p_[1] ) << 16 )
+               | ( std::uint32_t( p_[2] ) << 8 ) | p_[3];
+      }
+
+      inline std::uint64_t load_be64( const std::uint8_t* p_ )
+      {
+        return ( std::uint64_t( load_be32( p_ ) ) << 32 ) | load_be32( p_ + 4 );
+      }
+
+      inline std::uint32_t rotl( std::uint32_t v_, int n_ ) { return ( v_ << n_ ) | ( v_ >> ( 32 - n_ ) ); }
+      inline std::uint32_t rotr( std::uint32_t v_, int n_ ) { return ( v_ >> n_ ) | ( v_ << ( 32 - n_ ) ); }
+      inline std::uint64_t rotr( std::uint64_t v_, int n_ ) { return ( v_ >> n_ ) | ( v_ << ( 64 - n_ ) ); }
+
+      //! one round of sha-1 (group_ selects the function of the rounds 20 * group_ to 20 * group_ + 19), the
+      //! caller rotates the roles of the working variables
+      template < int group_ >
+      inline void round_sha1( std::uint32_t a_,
+                              std::uint32_t& b_,
+                              std::uint32_t c_,
+                              std::uint32_t d_,
+                              std::uint32_t& e_,
+                              std::uint32_t w_ )
+      {
+        if ( group_ == 0 )
+          e_ += ( d_ ^ ( b_ & ( c_ ^ d_ ) ) ) + 0x5a827999;
+        else if ( group_ == 1 )
+          e_ += ( b_ ^ c_ ^ d_ ) + 0x6ed9eba1;
+        else if ( group_ == 2 )
+          e_ += ( ( b_ & c_ ) | ( d_ & ( b_ | c_ ) ) ) + 0x8f1bbcdc;
+        else
+          e_ += ( b_ ^ c_ ^ d_ ) + 0xca62c1d6;
+        e_ += rotl( a_, 5 ) + w_;
+        b_ = rotl( b_, 30 );
+      }
+
+      //! word t_ of the sha-1 message schedule, expanded in place in a ring of the last 16 words
+      inline std::uint32_t schedule_sha1( std::uint32_t* pW_, size_t t_ )
+      {
+        if ( t_ >= 16 )
+        {
+          auto w = pW_[( t_ + 13 ) & 15] ^ pW_[( t_ + 8 ) & 15] ^ pW_[( t_ + 2 ) & 15] ^ pW_[t_ & 15];
+          pW_[t_ & 15] = rotl( w, 1 );
+        }
+        return pW_[t_ & 15];
+      }
+
+      template < int group_ >
+      inline void rounds_sha1( std::uint32_t& a_,
+                               std::uint32_t& b_,
+                               std::uint32_t& c_,
+                               std::uint32_t& d_,
+                               std::uint32_t& e_,
+                               std::uint32_t* pW_ )
+      {
+        for ( size_t t = 20 * group_; t < 20 * group_ + 20; t += 5 )
+        {
+          round_sha1< group_ >( a_, b_, c_, d_, e_, schedule_sha1( pW_, t ) );
+          round_sha1< group_ >( e_, a_, b_, c_, d_, schedule_sha1( pW_, t + 1 ) );
+          round_sha1< group_ >( d_, e_, a_, b_, c_, schedule_sha1( pW_, t + 2 ) );
+          round_sha1< group_ >( c_, d_, e_, a_, b_, schedule_sha1( pW_, t + 3 ) );
+          round_sha1< group_ >( b_, c_, d_, e_, a_, schedule_sha1( pW_, t + 4 ) );
+        }
+      }
+
+      //! one round of sha-256 / sha-512, the caller rotates the roles of the working variables instead of
+      //! moving them, so 8 consecutive calls leave every variable in its original role
+      inline void round256( std::uint32_t a_, std::uint32_t b_, std::uint32_t c_, std::uint32_t& d_,
+                            std::uint32_t e_, std::uint32_t f_, std::uint32_t g_, std::uint32_t& h_,
+                            std::uint32_t wk_ )
+      {
+        h_ += ( rotr( e_, 6 ) ^ rotr( e_, 11 ) ^ rotr( e_, 25 ) ) + ( g_ ^ ( e_ & ( f_ ^ g_ ) ) ) + wk_;
+        d_ += h_;
+        h_ += ( rotr( a_, 2 ) ^ rotr( a_, 13 ) ^ rotr( a_, 22 ) ) + ( ( a_ & b_ ) | ( c_ & ( a_ | b_ ) ) );
+      }
+
+      inline void round512( std::uint64_t a_, std::uint64_t b_, std::uint64_t c_, std::uint64_t& d_,
+                            std::uint64_t e_, std::uint64_t f_, std::uint64_t g_, std::uint64_t& h_,
+                            std::uint64_t wk_ )
+      {
+        h_ += ( rotr( e_, 14 ) ^ rotr( e_, 18 ) ^ rotr( e_, 41 ) ) + ( g_ ^ ( e_ & ( f_ ^ g_ ) ) ) + wk_;
+        d_ += h_;
+        h_ += ( rotr( a_, 28 ) ^ rotr( a_, 34 ) ^ rotr( a_, 39 ) ) + ( ( a_ & b_ ) | ( c_ & ( a_ | b_ ) ) );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      template < typename compress_t >
+      struct kernel_entry
+      {
+        const char* name;
+        compress_t compress;
+      };
+
+      template < typename compress_t >
+      kernel_entry< compress_t > make_entry( const char* name_, compress_t compress_ )
+      {
+        kernel_entry< compress_t > e = { name_, compress_ };
+        return e;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      //! the kernels usable on this cpu in the order of preference
+      std::vector< kernel_entry< compress32_fn > > sha1_kernels()
+      {
+        std::vector< kernel_entry< compress32_fn > > k;
+        const auto& features = get_cpu_features();
+        if ( features.sha && features.sse41 )
+          k.push_back( make_entry( "sha-ni", &compress_sha1_shani ) );
+        k.push_back( make_entry( "portable", &compress_sha1 ) );
+        return k;
+      }
+
+      std::vector< kernel_entry< compress32_fn > > sha256_kernels()
+      {
+        std::vector< kernel_entry< compress32_fn > > k;
+        const auto& features = get_cpu_features();
+        if ( features.sha && features.sse41 )
+          k.push_back( make_entry( "sha-ni", &compress_sha256_shani ) );
+        if ( features.avx2 )
+          k.push_back( make_entry( "avx2", &compress_sha256_avx2 ) );
+        k.push_back( make_entry( "portable", &compress_sha256 ) );
+        return k;
+      }
+
+      std::vector< kernel_entry< compress64_fn > > sha512_kernels()
+      {
+        std::vector< kernel_entry< compress64_fn > > k;
+        const auto& features = get_cpu_features();
+        if ( features.avx2 && features.bmi2 )
+          k.push_back( make_entry( "avx2", &compress_sha512_avx2 ) );
+        k.push_back( make_entry( "portable", &compress_sha512 ) );
+        return k;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      template < typename compress_t >
+      std::vector< std::string > names( const std::vector< kernel_entry< compress_t > >& kernels_ )
+      {
+        std::vector< std::string > result;
+        for ( const auto& k : kernels_ )
+          result.push_back( k.name );
+        return result;
+      }
+
+      template < typename compress_t >
+      void select( const std::vector< kernel_entry< compress_t > >& kernels_,
+                   const std::string& name_,
+                   std::atomic< compress_t >& compress_,
+                   std::atomic< const char* >& selectedName_ )
+      {
+        for ( const auto& k : kernels_ )
+        {
+          if ( name_ == k.name )
+          {
+            compress_ = k.compress;
+            selectedName_ = k.name;
+            return;
+          }
+        }
+        throw exception( error::invalid_parameter, "implementation not available: " + name_ );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      struct selected_kernels_t : kernels
+      {
+        selected_kernels_t()
+        {
+          auto sha1Kernel = sha1_kernels().front();
+          auto sha256Kernel = sha256_kernels().front();
+          auto sha512Kernel = sha512_kernels().front();
+          sha1 = sha1Kernel.compress;
+          sha256 = sha256Kernel.compress;
+          sha512 = sha512Kernel.compress;
+          sha1Name = sha1Kernel.name;
+          sha256Name = sha256Kernel.name;
+          sha512Name = sha512Kernel.name;
+        }
+      };
+
+      kernels& selected_kernels()
+      {
+        static selected_kernels_t s_kernels;
+        return s_kernels;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    const kernels& get_kernels()
+    {
+      return selected_kernels();
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    std::vector< std::string > get_kernel_names( hash::type type_ )
+    {
+      switch ( type_ )
+      {
+        case hash::type::sha1:
+          return names( sha1_kernels() );
+        case hash::type::sha256:
+          return names( sha256_kernels() );
+        case hash::type::sha384:
+        case hash::type::sha512:
+          return names( sha512_kernels() );
+        default:
+          throw exception( error::invalid_parameter, "not a sha hash type" );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void set_kernel( hash::type type_, const std::string& name_ )
+    {
+      auto& k = selected_kernels();
+      switch ( type_ )
+      {
+        case hash::type::sha1:
+          select( sha1_kernels(), name_, k.sha1, k.sha1Name );
+          break;
+        case hash::type::sha256:
+          select( sha256_kernels(), name_, k.sha256, k.sha256Name );
+          break;
+        case hash::type::sha384:
+        case hash::type::sha512:
+          select( sha512_kernels(), name_, k.sha512, k.sha512Name );
+          break;
+        default:
+          throw exception( error::invalid_parameter, "not a sha hash type" );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+    // portable kernels
+    // -------------------------------------------------------------------------------------------------------
+
+    void compress_sha1( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ )
+    {
+      for ( ; numBlocks_ > 0; --numBlocks_, pBlocks_ += 64 )
+      {
+        std::uint32_t w[16];
+        for ( size_t t = 0; t < 16; ++t )
+          w[t] = load_be32( pBlocks_ + 4 * t );
+
+        auto a = pChain_[0];
+        auto b = pChain_[1];
+        auto c = pChain_[2];
+        auto d = pChain_[3];
+        auto e = pChain_[4];
+
+        rounds_sha1< 0 >( a, b, c, d, e, w );
+        rounds_sha1< 1 >( a, b, c, d, e, w );
+        rounds_sha1< 2 >( a, b, c, d, e, w );
+        rounds_sha1< 3 >( a, b, c, d, e, w );
+
+        pChain_[0] += a;
+        pChain_[1] += b;
+        pChain_[2] += c;
+        pChain_[3] += d;
+        pChain_[4] += e;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void rounds_sha256( std::uint32_t* pChain_, const std::uint32_t* pWk_, size_t stride_ )
+    {
+      auto a = pChain_[0];
+      auto b = pChain_[1];
+      auto c = pChain_[2];
+      auto d = pChain_[3];
+      auto e = pChain_[4];
+      auto f = pChain_[5];
+      auto g = pChain_[6];
+      auto h = pChain_[7];
+
+      for ( size_t t = 0; t < 64; t += 8, pWk_ += 8 * stride_ )
+      {
+        round256( a, b, c, d, e, f, g, h, pWk_[0] );
+        round256( h, a, b, c, d, e, f, g, pWk_[stride_] );
+        round256( g, h, a, b, c, d, e, f, pWk_[2 * stride_] );
+        round256( f, g, h, a, b, c, d, e, pWk_[3 * stride_] );
+        round256( e, f, g, h, a, b, c, d, pWk_[4 * stride_] );
+        round256( d, e, f, g, h, a, b, c, pWk_[5 * stride_] );
+        round256( c, d, e, f, g, h, a, b, pWk_[6 * stride_] );
+        round256( b, c, d, e, f, g, h, a, pWk_[7 * stride_] );
+      }
+
+      pChain_[0] += a;
+      pChain_[1] += b;
+      pChain_[2] += c;
+      pChain_[3] += d;
+      pChain_[4] += e;
+      pChain_[5] += f;
+      pChain_[6] += g;
+      pChain_[7] += h;
+    }
+
+    void compress_sha256( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ )
+    {
+      for ( ; numBlocks_ > 0; --numBlocks_, pBlocks_ += 64 )
+      {
+        std::uint32_t w[64];
+        for ( size_t t = 0; t < 16; ++t )
+          w[t] = load_be32( pBlocks_ + 4 * t );
+        for ( size_t t = 16; t < 64; ++t )
+        {
+          auto s0 = rotr( w[t - 15], 7 ) ^ rotr( w[t - 15], 18 ) ^ ( w[t - 15] >> 3 );
+          auto s1 = rotr( w[t - 2], 17 ) ^ rotr( w[t - 2], 19 ) ^ ( w[t - 2] >> 10 );
+          w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        std::uint32_t wk[64];
+        for ( size_t t = 0; t < 64; ++t )
+          wk[t] = w[t] + kRoundConstants256[t];
+
+        rounds_sha256( pChain_, wk, 1 );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void rounds_sha512( std::uint64_t* pChain_, const std::uint64_t* pWk_, size_t stride_ )
+    {
+      auto a = pChain_[0];
+      auto b = pChain_[1];
+      auto c = pChain_[2];
+      auto d = pChain_[3];
+      auto e = pChain_[4];
+      auto f = pChain_[5];
+      auto g = pChain_[6];
+      auto h = pChain_[7];
+
+      for ( size_t t = 0; t < 80; t += 8, pWk_ += 8 * stride_ )
+      {
+        round512( a, b, c, d, e, f, g, h, pWk_[0] );
+        round512( h, a, b, c, d, e, f, g, pWk_[stride_] );
+        round512( g, h, a, b, c, d, e, f, pWk_[2 * stride_] );
+        round512( f, g, h, a, b, c, d, e, pWk_[3 * stride_] );
+        round512( e, f, g, h, a, b, c, d, pWk_[4 * stride_] );
+        round512( d, e, f, g, h, a, b, c, pWk_[5 * stride_] );
+        round512( c, d, e, f, g, h, a, b, pWk_[6 * stride_] );
+        round512( b, c, d, e, f, g, h, a, pWk_[7 * stride_] );
+      }
+
+      pChain_[0] += a;
+      pChain_[1] += b;
+      pChain_[2] += c;
+      pChain_[3] += d;
+      pChain_[4] += e;
+      pChain_[5] += f;
+      pChain_[6] += g;
+      pChain_[7] += h;
+    }
+
+    void compress_sha512( std::uint64_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ )
+    {
+      for ( ; numBlocks_ > 0; --numBlocks_, pBlocks_ += 128 )
+      {
+        std::uint64_t w[80];
+        for ( size_t t = 0; t < 16; ++t )
+          w[t] = load_be64( pBlocks_ + 8 * t );
+        for ( size_t t = 16; t < 80; ++t )
+        {
+          auto s0 = rotr( w[t - 15], 1 ) ^ rotr( w[t - 15], 8 ) ^ ( w[t - 15] >> 7 );
+          auto s1 = rotr( w[t - 2], 19 ) ^ rotr( w[t - 2], 61 ) ^ ( w[t - 2] >> 6 );
+          w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        std::uint64_t wk[80];
+        for ( size_t t = 0; t < 80; ++t )
+          wk[t] = w[t] + kRoundConstants512[t];
+
+        rounds_sha512( pChain_, wk, 1 );
+      }
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // streaming
+  // ---------------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    template < typename word_t >
+    void store_be( std::uint8_t* p_, word_t v_ )
+    {
+      for ( size_t i = 0; i < sizeof( word_t ); ++i )
+        p_[i] = static_cast< std::uint8_t >( v_ >> ( 8 * ( sizeof( word_t ) - 1 - i ) ) );
+    }
+
+    template < typename word_t >
+    void store_le( std::uint8_t* p_, word_t v_ )
+    {
+      for ( size_t i = 0; i < sizeof( word_t ); ++i )
+        p_[i] = static_cast< std::uint8_t >( v_ >> ( 8 * i ) );
+    }
+
+    template < typename word_t >
+    word_t load_le( const std::uint8_t* p_ )
+    {
+      word_t v = 0;
+      for ( size_t i = 0; i < sizeof( word_t ); ++i )
+        v |= static_cast< word_t >( p_[i] ) << ( 8 * i );
+      return v;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! whole blocks are compressed straight from the input, only the incomplete tail is buffered
+    template < typename state_t, typename compress_t >
+    void update_state( state_t& state_, compress_t compress_, const std::uint8_t* pBuffer_, size_t sz_ )
+    {
+      if ( sz_ == 0 )
+        return;
+
+      const size_t blockSize = sizeof( state_.buffer );
+      auto buffered = static_cast< size_t >( state_.totalSize % blockSize );
+      state_.totalSize += sz_;
+
+      if ( buffered > 0 )
+      {
+        auto n = std::min( sz_, blockSize - buffered );
+        std::memcpy( state_.buffer + buffered, pBuffer_, n );
+        pBuffer_ += n;
+        sz_ -= n;
+        if ( buffered + n < blockSize )
+          return;
+        compress_( state_.chain, state_.buffer, 1 );
+      }
+
+      auto numBlocks = sz_ / blockSize;
+      if ( numBlocks > 0 )
+      {
+        compress_( state_.chain, pBuffer_, numBlocks );
+        pBuffer_ += numBlocks * blockSize;
+        sz_ -= numBlocks * blockSize;
+      }
+
+      if ( sz_ > 0 )
+        std::memcpy( state_.buffer, pBuffer_, sz_ );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! pad with 0x80, zeros and the message length in bits (big endian, 8 bytes for the 64 byte blocks and
+    //! 16 bytes for the 128 byte blocks) and write the first numWords_ words of the chaining value
+    template < typename state_t, typename compress_t >
+    void finalize_state( state_t& state_, compress_t compress_, std::uint8_t* pDigest_, size_t numWords_ )
+    {
+      const size_t blockSize = sizeof( state_.buffer );
+      const size_t lengthSize = blockSize / 8;
+
+      auto buffered = static_cast< size_t >( state_.totalSize % blockSize );
+      state_.buffer[buffered++] = 0x80;
+      if ( buffered > blockSize - lengthSize )
+      {
+        std::memset( state_.buffer + buffered, 0, blockSize - buffered );
+        compress_( state_.chain, state_.buffer, 1 );
+        buffered = 0;
+      }
+
+      std::memset( state_.buffer + buffered, 0, blockSize - buffered - 8 );
+      if ( lengthSize == 16 )
+        store_be( state_.buffer + blockSize - 16, static_cast< std::uint64_t >( state_.totalSize >> 61 ) );
+      store_be( state_.buffer + blockSize - 8, static_cast< std::uint64_t >( state_.totalSize << 3 ) );
+      compress_( state_.chain, state_.buffer, 1 );
+
+      for ( size_t i = 0; i < numWords_; ++i )
+        store_be( pDigest_ + i * sizeof( state_.chain[0] ), state_.chain[i] );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    //! the native state is the chaining value (little endian words) followed by the buffered bytes of the
+    //! incomplete block, the message length is restored from the input size
+    template < typename state_t >
+    size_t export_chain( const state_t& state_, size_t numWords_, std::uint8_t* pState_ )
+    {
+      const size_t wordSize = sizeof( state_.chain[0] );
+      auto buffered = static_cast< size_t >( state_.totalSize % sizeof( state_.buffer ) );
+
+      for ( size_t i = 0; i < numWords_; ++i )
+        store_le( pState_ + i * wordSize, state_.chain[i] );
+      std::memcpy( pState_ + numWords_ * wordSize, state_.buffer, buffered );
+      return numWords_ * wordSize + buffered;
+    }
+
+    template < typename state_t >
+    void import_chain( state_t& state_,
+                       size_t numWords_,
+                       const std::uint8_t* pState_,
+                       size_t sz_,
+                       std::uint64_t inputSize_ )
+    {
+      typedef typename std::remove_reference< decltype( state_.chain[0] ) >::type word_t;
+      auto buffered = static_cast< size_t >( inputSize_ % sizeof( state_.buffer ) );
+      if ( sz_ != numWords_ * sizeof( word_t ) + buffered )
+        throw exception( error::invalid_parameter, "invalid hash state" );
+
+      for ( size_t i = 0; i < numWords_; ++i )
+        state_.chain[i] = load_le< word_t >( pState_ + i * sizeof( word_t ) );
+      std::memcpy( state_.buffer, pState_ + numWords_ * sizeof( word_t ), buffered );
+      state_.totalSize = inputSize_;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    const std::uint32_t kInitialSha1[8]
+      = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0, 0, 0, 0 };
+
+    const std::uint32_t kInitialSha256[8]
+      = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+    const std::uint64_t kInitialSha384[8] = {
+      0xcbbb9d5dc1059ed8ull, 0x629a292a367cd507ull, 0x9159015a3070dd17ull, 0x152fecd8f70e5939ull,
+      0x67332667ffc00b31ull, 0x8eb44a8768581511ull, 0xdb0c2e0d64f98fa7ull, 0x47b5481dbefa4fa4ull,
+    };
+
+    const std::uint64_t kInitialSha512[8] = {
+      0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull, 0x3c6ef372fe94f82bull, 0xa54ff53a5f1d36f1ull,
+      0x510e527fade682d1ull, 0x9b05688c2b3e6c1full, 0x1f83d9abfb41bd6bull, 0x5be0cd19137e2179ull,
+    };
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // hash backends
+  // ---------------------------------------------------------------------------------------------------------
+
+#define LL_IMPLEMENT_SHA_BACKEND( type_, state_type_, kernel_, initialChain_, numWords_ )                  \
+  static_assert( sizeof( sha::state_type_ ) <= detail::hash_backend< type_ >::contextSize,                \
+                 "context storage too small for sha::" #state_type_ );                                    \
+                                                                                                          \
+  void detail::hash_backend< type_ >::init( void* pContext_ )                                             \
+  {                                                                                                       \
+    auto& state = *static_cast< sha::state_type_* >( pContext_ );                                         \
+    std::memcpy( state.chain, initialChain_, sizeof( state.chain ) );                                     \
+    state.totalSize = 0;                                                                                  \
+  }                                                                                                       \
+                                                                                                          \
+  void detail::hash_backend< type_ >::update( void* pContext_, const std::uint8_t* pBuffer_, size_t sz_ ) \
+  {                                                                                                       \
+    auto& state = *static_cast< sha::state_type_* >( pContext_ );                                         \
+    update_state( state, sha::get_kernels().kernel_.load(), pBuffer_, sz_ );                              \
+  }                                                                                                       \
+                                                                                                          \
+  void detail::hash_backend< type_ >::final( void* pContext_, std::uint8_t* pDigest_ )                    \
+  {                                                                                                       \
+    auto& state = *static_cast< sha::state_type_* >( pContext_ );                                         \
+    auto numWords = digestSize / sizeof( state.chain[0] );                                                \
+    finalize_state( state, sha::get_kernels().kernel_.load(), pDigest_, numWords );                       \
+  }                                                                                                       \
+                                                                                                          \
+  void detail::hash_backend< type_ >::copy( void* pTarget_, const void* pSource_ )                        \
+  {                                                                                                       \
+    std::memcpy( pTarget_, pSource_, sizeof( sha::state_type_ ) );                                        \
+  }                                                                                                       \
+                                                                                                          \
+  size_t detail::hash_backend< type_ >::export_state( const void* pContext_, std::uint8_t* pState_ )      \
+  {                                                                                                       \
+    return export_chain( *static_cast< const sha::state_type_* >( pContext_ ), numWords_, pState_ );      \
+  }                                                                                                       \
+                                                                                                          \
+  void detail::hash_backend< type_ >::import_state( void* pContext_,                                      \
+                                                    const std::uint8_t* pState_,                          \
+                                                    size_t sz_,                                           \
+                                                    std::uint64_t inputSize_ )                            \
+  {                                                                                                       \
+    import_chain( *static_cast< sha::state_type_* >( pContext_ ), numWords_, pState_, sz_, inputSize_ );  \
+  }                                                                                                       \
+                                                                                                          \
+  void detail::hash_backend< type_ >::destroy( void* ) LL_NOEXCEPT                                        \
+  {                                                                                                       \
+  }
+
+  LL_IMPLEMENT_SHA_BACKEND( hash::type::sha1, state32, sha1, kInitialSha1, 5 )
+  LL_IMPLEMENT_SHA_BACKEND( hash::type::sha256, state32, sha256, kInitialSha256, 8 )
+  LL_IMPLEMENT_SHA_BACKEND( hash::type::sha384, state64, sha512, kInitialSha384, 8 )
+  LL_IMPLEMENT_SHA_BACKEND( hash::type::sha512, state64, sha512, kInitialSha512, 8 )
+
+#undef LL_IMPLEMENT_SHA_BACKEND
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,116 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include "../support/environment.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crypto/hash.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  // SHA-1 and the SHA-2 family (FIPS 180-4) with the streaming logic in the library, only the compression
+  // function of whole blocks differs per kernel. The kernel is selected once per process from the cpu
+  // features (the SHA extensions where present, otherwise avx2). All kernels share the state, so it can be
+  // exported with any of them.
+
+  namespace sha
+  {
+    //! compress numBlocks_ consecutive blocks into the chaining value
+    typedef void ( *compress32_fn )( std::uint32_t*, const std::uint8_t*, size_t );
+    typedef void ( *compress64_fn )( std::uint64_t*, const std::uint8_t*, size_t );
+
+    //! the streaming state of sha-1 (using 5 of the chaining words) and sha-256
+    struct state32
+    {
+      std::uint32_t chain[8];
+      std::uint8_t buffer[64];
+      std::uint64_t totalSize;
+    };
+
+    //! the streaming state of sha-384 and sha-512
+    struct state64
+    {
+      std::uint64_t chain[8];
+      std::uint8_t buffer[128];
+      std::uint64_t totalSize;
+    };
+
+
+    //! the compression functions selected for this cpu and their names (see get_implementation)
+    //! atomic as set_kernel may replace them while other threads hash, a generator loads its kernel once per
+    //! update
+    struct kernels
+    {
+      std::atomic< compress32_fn > sha1;
+      std::atomic< compress32_fn > sha256;
+      std::atomic< compress64_fn > sha512;
+      std::atomic< const char* > sha1Name;
+      std::atomic< const char* > sha256Name;
+      std::atomic< const char* > sha512Name;
+    };
+
+    const kernels& get_kernels();
+
+    //! the kernels usable on this cpu for a hash type, the default one first
+    //! sha-384 and sha-512 share their kernels
+    std::vector< std::string > get_kernel_names( hash::type type_ );
+
+    //! replaces the selected kernel of a hash type, throws error::invalid_parameter if it isn't usable here
+    void set_kernel( hash::type type_, const std::string& name_ );
+
+
+    // -------------------------------------------------------------------------------------------------------
+    // kernels
+    // -------------------------------------------------------------------------------------------------------
+
+    extern const std::uint32_t kRoundConstants256[64];
+    extern const std::uint64_t kRoundConstants512[80];
+
+    //! the rounds of one block with the message schedule plus the round constants precomputed, word t of the
+    //! schedule is pWk_[t * stride_] (so the vector kernels can leave the schedules of several blocks
+    //! interleaved)
+    void rounds_sha256( std::uint32_t* pChain_, const std::uint32_t* pWk_, size_t stride_ );
+    void rounds_sha512( std::uint64_t* pChain_, const std::uint64_t* pWk_, size_t stride_ );
+
+    void compress_sha1( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ );
+    void compress_sha256( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ );
+    void compress_sha512( std::uint64_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ );
+
+    //! only to be called if the cpu supports the SHA extensions (and SSE4.1)
+    void compress_sha1_shani( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ );
+    void compress_sha256_shani( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ );
+
+    //! only to be called if the cpu supports avx2 (and bmi2 for sha-512)
+    //! the message schedules of 8 (sha-256) or 4 (sha-512) consecutive blocks are expanded at once, one block
+    //! per lane, only the rounds are scalar
+    void compress_sha256_avx2( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ );
+    void compress_sha512_avx2( std::uint64_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,245 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "sha.h"
+
+#include <immintrin.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace sha
+  {
+    namespace
+    {
+      template < int n_ >
+      inline __m256i rotr32( __m256i v_ )
+      {
+        return _mm256_or_si256( _mm256_srli_epi32( v_, n_ ), _mm256_slli_epi32( v_, 32 - n_ ) );
+      }
+
+      template < int n_ >
+      inline __m256i rotr64( __m256i v_ )
+      {
+        return _mm256_or_si256( _mm256_srli_epi64( v_, n_ ), _mm256_slli_epi64( v_, 64 - n_ ) );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      //! the schedules of 8 blocks, word t of block j is at pWk_[t * 8 + j] (plus the round constant)
+      void schedule_sha256_x8( const std::uint8_t* pBlocks_, std::uint32_t* pWk_ )
+      {
+        const auto byteSwap = _mm256_set_epi8( 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                               12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3 );
+        const auto offsets = _mm256_setr_epi32( 0, 64, 128, 192, 256, 320, 384, 448 );
+
+        __m256i w[16];
+        for ( int t = 0; t < 16; ++t )
+        {
+          auto pWords = reinterpret_cast< const int* >( pBlocks_ + 4 * t );
+          w[t] = _mm256_shuffle_epi8( _mm256_i32gather_epi32( pWords, offsets, 1 ), byteSwap );
+        }
+
+        for ( int t = 0; t < 64; ++t )
+        {
+          if ( t >= 16 )
+          {
+            auto w15 = w[( t - 15 ) & 15];
+            auto w2 = w[( t - 2 ) & 15];
+            auto s0 = _mm256_xor_si256( _mm256_xor_si256( rotr32< 7 >( w15 ), rotr32< 18 >( w15 ) ),
+                                        _mm256_srli_epi32( w15, 3 ) );
+            auto s1 = _mm256_xor_si256( _mm256_xor_si256( rotr32< 17 >( w2 ), rotr32< 19 >( w2 ) ),
+                                        _mm256_srli_epi32( w2, 10 ) );
+            w[t & 15] = _mm256_add_epi32( _mm256_add_epi32( w[t & 15], s0 ),
+                                          _mm256_add_epi32( w[( t - 7 ) & 15], s1 ) );
+          }
+
+          auto k = _mm256_set1_epi32( static_cast< int >( kRoundConstants256[t] ) );
+          auto pTarget = reinterpret_cast< __m256i* >( pWk_ + 8 * t );
+          _mm256_storeu_si256( pTarget, _mm256_add_epi32( w[t & 15], k ) );
+        }
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      //! the schedules of 4 blocks, expanded one word at a time so the expansion of the next 4 blocks can be
+      //! interleaved with the scalar rounds of the current ones. Word t of block j is written to
+      //! pWk_[t * 4 + j] (plus the round constant)
+      class schedule_sha512_x4
+      {
+      public:
+        void load( const std::uint8_t* pBlocks_ )
+        {
+          const auto offsets = _mm256_setr_epi64x( 0, 128, 256, 384 );
+          for ( int t = 0; t < 16; ++t )
+          {
+            auto pWords = reinterpret_cast< const long long* >( pBlocks_ + 8 * t );
+            m_w[t] = _mm256_shuffle_epi8( _mm256_i64gather_epi64( pWords, offsets, 1 ), byte_swap() );
+          }
+          m_t = 0;
+        }
+
+        void expand_next( std::uint64_t* pWk_ )
+        {
+          auto t = m_t++;
+          if ( t >= 16 )
+          {
+            auto w15 = m_w[( t - 15 ) & 15];
+            auto w2 = m_w[( t - 2 ) & 15];
+            auto s0 = _mm256_xor_si256( _mm256_xor_si256( rotr64< 1 >( w15 ), rotr64< 8 >( w15 ) ),
+                                        _mm256_srli_epi64( w15, 7 ) );
+            auto s1 = _mm256_xor_si256( _mm256_xor_si256( rotr64< 19 >( w2 ), rotr64< 61 >( w2 ) ),
+                                        _mm256_srli_epi64( w2, 6 ) );
+            m_w[t & 15] = _mm256_add_epi64( _mm256_add_epi64( m_w[t & 15], s0 ),
+                                            _mm256_add_epi64( m_w[( t - 7 ) & 15], s1 ) );
+          }
+
+          auto k = _mm256_set1_epi64x( static_cast< long long >( kRoundConstants512[t] ) );
+          auto pTarget = reinterpret_cast< __m256i* >( pWk_ + 4 * t );
+          _mm256_storeu_si256( pTarget, _mm256_add_epi64( m_w[t & 15], k ) );
+        }
+
+        void expand( std::uint64_t* pWk_ )
+        {
+          while ( m_t < 80 )
+            expand_next( pWk_ );
+        }
+
+      private:
+        static __m256i byte_swap()
+        {
+          return _mm256_set_epi8( 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                                  8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7 );
+        }
+
+        __m256i m_w[16];
+        int m_t;
+      };
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      inline std::uint64_t rotr( std::uint64_t v_, int n_ ) { return ( v_ >> n_ ) | ( v_ << ( 64 - n_ ) ); }
+
+      //! one round of sha-512 like sha::round512, but with the rotations compiled to rorx (which doesn't
+      //! overwrite its source) and the majority as ( ( a ^ b ) & ( b ^ c ) ) ^ b, where b ^ c is the a ^ b of
+      //! the previous round
+      inline void round512( std::uint64_t a_, std::uint64_t b_, std::uint64_t& d_, std::uint64_t e_,
+                            std::uint64_t f_, std::uint64_t g_, std::uint64_t& h_, std::uint64_t wk_,
+                            std::uint64_t& bc_ )
+      {
+        h_ += ( rotr( e_, 14 ) ^ rotr( e_, 18 ) ^ rotr( e_, 41 ) ) + ( g_ ^ ( e_ & ( f_ ^ g_ ) ) ) + wk_;
+        d_ += h_;
+        auto ab = a_ ^ b_;
+        h_ += ( rotr( a_, 28 ) ^ rotr( a_, 34 ) ^ rotr( a_, 39 ) ) + ( ( ab & bc_ ) ^ b_ );
+        bc_ = ab;
+      }
+
+      //! the rounds of one block, word t of the schedule is pWk_[t * 4]. Expands 20 words of the next
+      //! schedule on the way if there is one (the vector unit is idle during the rounds)
+      void rounds_sha512_x4( std::uint64_t* pChain_,
+                             const std::uint64_t* pWk_,
+                             schedule_sha512_x4* pNext_,
+                             std::uint64_t* pNextWk_ )
+      {
+        auto a = pChain_[0];
+        auto b = pChain_[1];
+        auto c = pChain_[2];
+        auto d = pChain_[3];
+        auto e = pChain_[4];
+        auto f = pChain_[5];
+        auto g = pChain_[6];
+        auto h = pChain_[7];
+        auto bc = b ^ c;
+
+        for ( int t = 0; t < 80; t += 8, pWk_ += 8 * 4 )
+        {
+          round512( a, b, d, e, f, g, h, pWk_[0], bc );
+          round512( h, a, c, d, e, f, g, pWk_[4], bc );
+          round512( g, h, b, c, d, e, f, pWk_[8], bc );
+          round512( f, g, a, b, c, d, e, pWk_[12], bc );
+          if ( pNext_ )
+            pNext_->expand_next( pNextWk_ );
+          round512( e, f, h, a, b, c, d, pWk_[16], bc );
+          round512( d, e, g, h, a, b, c, pWk_[20], bc );
+          round512( c, d, f, g, h, a, b, pWk_[24], bc );
+          round512( b, c, e, f, g, h, a, pWk_[28], bc );
+          if ( pNext_ )
+            pNext_->expand_next( pNextWk_ );
+        }
+
+        pChain_[0] += a;
+        pChain_[1] += b;
+        pChain_[2] += c;
+        pChain_[3] += d;
+        pChain_[4] += e;
+        pChain_[5] += f;
+        pChain_[6] += g;
+        pChain_[7] += h;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void compress_sha256_avx2( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ )
+    {
+      std::uint32_t wk[64 * 8];
+      for ( ; numBlocks_ >= 8; numBlocks_ -= 8, pBlocks_ += 8 * 64 )
+      {
+        schedule_sha256_x8( pBlocks_, wk );
+        for ( size_t j = 0; j < 8; ++j )
+          rounds_sha256( pChain_, wk + j, 8 );
+      }
+
+      compress_sha256( pChain_, pBlocks_, numBlocks_ );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void compress_sha512_avx2( std::uint64_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ )
+    {
+      // the schedules of the current and the next 4 blocks
+      std::uint64_t wk[2][80 * 4];
+      schedule_sha512_x4 schedule;
+      if ( numBlocks_ >= 4 )
+      {
+        schedule.load( pBlocks_ );
+        schedule.expand( wk[0] );
+      }
+
+      for ( size_t current = 0; numBlocks_ >= 4; numBlocks_ -= 4, pBlocks_ += 4 * 128, current ^= 1 )
+      {
+        auto pNext = numBlocks_ >= 8 ? &schedule : nullptr;
+        if ( pNext )
+          pNext->load( pBlocks_ + 4 * 128 );
+        for ( size_t j = 0; j < 4; ++j )
+          rounds_sha512_x4( pChain_, wk[current] + j, pNext, wk[current ^ 1] );
+      }
+
+      compress_sha512( pChain_, pBlocks_, numBlocks_ );
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,198 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "sha.h"
+
+#include <immintrin.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace sha
+  {
+    namespace
+    {
+      // -----------------------------------------------------------------------------------------------------
+      // sha-1: four rounds per sha1rnds4, the message words of the next rounds are expanded with
+      // sha1msg1 / xor / sha1msg2 while the current rounds run. Group g_ (rounds 4g_ to 4g_ + 3) consumes
+      // cur_ and advances the expansion of the following groups (next_ = group g_ + 1, afterNext_ = group
+      // g_ + 2, prev_ = group g_ + 3, all modulo the four message registers)
+      // -----------------------------------------------------------------------------------------------------
+
+      template < int g_ >
+      inline void sha1_rounds( __m128i& abcd_,
+                               __m128i& e_,
+                               __m128i& eNext_,
+                               __m128i& cur_,
+                               __m128i& next_,
+                               __m128i& afterNext_,
+                               __m128i& prev_ )
+      {
+        e_ = ( g_ == 0 ) ? _mm_add_epi32( e_, cur_ ) : _mm_sha1nexte_epu32( e_, cur_ );
+        eNext_ = abcd_;
+        if ( ( g_ >= 3 ) && ( g_ <= 18 ) )
+          next_ = _mm_sha1msg2_epu32( next_, cur_ );
+        abcd_ = _mm_sha1rnds4_epu32( abcd_, e_, g_ / 5 );
+        if ( ( g_ >= 2 ) && ( g_ <= 17 ) )
+          afterNext_ = _mm_xor_si128( afterNext_, cur_ );
+        if ( ( g_ >= 1 ) && ( g_ <= 16 ) )
+          prev_ = _mm_sha1msg1_epu32( prev_, cur_ );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+      // sha-256: two rounds per sha256rnds2 (the state is kept as ABEF / CDGH), the schedule is expanded with
+      // sha256msg1 / alignr / sha256msg2 four words at a time
+      // -----------------------------------------------------------------------------------------------------
+
+      template < int g_ >
+      inline void sha256_rounds( __m128i& state0_,
+                                 __m128i& state1_,
+                                 __m128i& cur_,
+                                 __m128i& next_,
+                                 __m128i& prev_ )
+      {
+        auto msg = _mm_add_epi32(
+          cur_, _mm_loadu_si128( reinterpret_cast< const __m128i* >( kRoundConstants256 + 4 * g_ ) ) );
+        state1_ = _mm_sha256rnds2_epu32( state1_, state0_, msg );
+        if ( ( g_ >= 3 ) && ( g_ <= 14 ) )
+          next_ = _mm_sha256msg2_epu32( _mm_add_epi32( next_, _mm_alignr_epi8( cur_, prev_, 4 ) ), cur_ );
+        state0_ = _mm_sha256rnds2_epu32( state0_, state1_, _mm_shuffle_epi32( msg, 0x0e ) );
+        if ( ( g_ >= 1 ) && ( g_ <= 12 ) )
+          prev_ = _mm_sha256msg1_epu32( prev_, cur_ );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      inline __m128i load_be( const std::uint8_t* p_, __m128i byteSwap_ )
+      {
+        return _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( p_ ) ), byteSwap_ );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void compress_sha1_shani( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ )
+    {
+      // the message words are loaded in reverse order (word 0 in the highest lane)
+      const auto byteSwap = _mm_set_epi64x( 0x0001020304050607ll, 0x08090a0b0c0d0e0fll );
+
+      auto abcd = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast< const __m128i* >( pChain_ ) ), 0x1b );
+      auto e0 = _mm_set_epi32( static_cast< int >( pChain_[4] ), 0, 0, 0 );
+
+      for ( ; numBlocks_ > 0; --numBlocks_, pBlocks_ += 64 )
+      {
+        auto abcdSave = abcd;
+        auto eSave = e0;
+        __m128i e1;
+
+        auto m0 = load_be( pBlocks_, byteSwap );
+        auto m1 = load_be( pBlocks_ + 16, byteSwap );
+        auto m2 = load_be( pBlocks_ + 32, byteSwap );
+        auto m3 = load_be( pBlocks_ + 48, byteSwap );
+
+        sha1_rounds< 0 >( abcd, e0, e1, m0, m1, m2, m3 );
+        sha1_rounds< 1 >( abcd, e1, e0, m1, m2, m3, m0 );
+        sha1_rounds< 2 >( abcd, e0, e1, m2, m3, m0, m1 );
+        sha1_rounds< 3 >( abcd, e1, e0, m3, m0, m1, m2 );
+        sha1_rounds< 4 >( abcd, e0, e1, m0, m1, m2, m3 );
+        sha1_rounds< 5 >( abcd, e1, e0, m1, m2, m3, m0 );
+        sha1_rounds< 6 >( abcd, e0, e1, m2, m3, m0, m1 );
+        sha1_rounds< 7 >( abcd, e1, e0, m3, m0, m1, m2 );
+        sha1_rounds< 8 >( abcd, e0, e1, m0, m1, m2, m3 );
+        sha1_rounds< 9 >( abcd, e1, e0, m1, m2, m3, m0 );
+        sha1_rounds< 10 >( abcd, e0, e1, m2, m3, m0, m1 );
+        sha1_rounds< 11 >( abcd, e1, e0, m3, m0, m1, m2 );
+        sha1_rounds< 12 >( abcd, e0, e1, m0, m1, m2, m3 );
+        sha1_rounds< 13 >( abcd, e1, e0, m1, m2, m3, m0 );
+        sha1_rounds< 14 >( abcd, e0, e1, m2, m3, m0, m1 );
+        sha1_rounds< 15 >( abcd, e1, e0, m3, m0, m1, m2 );
+        sha1_rounds< 16 >( abcd, e0, e1, m0, m1, m2, m3 );
+        sha1_rounds< 17 >( abcd, e1, e0, m1, m2, m3, m0 );
+        sha1_rounds< 18 >( abcd, e0, e1, m2, m3, m0, m1 );
+        sha1_rounds< 19 >( abcd, e1, e0, m3, m0, m1, m2 );
+
+        // e0 holds a of the last group, rotated into e by sha1nexte
+        e0 = _mm_sha1nexte_epu32( e0, eSave );
+        abcd = _mm_add_epi32( abcd, abcdSave );
+      }
+
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pChain_ ), _mm_shuffle_epi32( abcd, 0x1b ) );
+      pChain_[4] = static_cast< std::uint32_t >( _mm_extract_epi32( e0, 3 ) );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void compress_sha256_shani( std::uint32_t* pChain_, const std::uint8_t* pBlocks_, size_t numBlocks_ )
+    {
+      const auto byteSwap = _mm_set_epi64x( 0x0c0d0e0f08090a0bll, 0x0405060700010203ll );
+
+      // DCBA / HGFE to ABEF / CDGH
+      auto dcba = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pChain_ ) );
+      auto hgfe = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pChain_ + 4 ) );
+      auto cdab = _mm_shuffle_epi32( dcba, 0xb1 );
+      auto efgh = _mm_shuffle_epi32( hgfe, 0x1b );
+      auto state0 = _mm_alignr_epi8( cdab, efgh, 8 );
+      auto state1 = _mm_blend_epi16( efgh, cdab, 0xf0 );
+
+      for ( ; numBlocks_ > 0; --numBlocks_, pBlocks_ += 64 )
+      {
+        auto state0Save = state0;
+        auto state1Save = state1;
+
+        auto m0 = load_be( pBlocks_, byteSwap );
+        auto m1 = load_be( pBlocks_ + 16, byteSwap );
+        auto m2 = load_be( pBlocks_ + 32, byteSwap );
+        auto m3 = load_be( pBlocks_ + 48, byteSwap );
+
+        sha256_rounds< 0 >( state0, state1, m0, m1, m3 );
+        sha256_rounds< 1 >( state0, state1, m1, m2, m0 );
+        sha256_rounds< 2 >( state0, state1, m2, m3, m1 );
+        sha256_rounds< 3 >( state0, state1, m3, m0, m2 );
+        sha256_rounds< 4 >( state0, state1, m0, m1, m3 );
+        sha256_rounds< 5 >( state0, state1, m1, m2, m0 );
+        sha256_rounds< 6 >( state0, state1, m2, m3, m1 );
+        sha256_rounds< 7 >( state0, state1, m3, m0, m2 );
+        sha256_rounds< 8 >( state0, state1, m0, m1, m3 );
+        sha256_rounds< 9 >( state0, state1, m1, m2, m0 );
+        sha256_rounds< 10 >( state0, state1, m2, m3, m1 );
+        sha256_rounds< 11 >( state0, state1, m3, m0, m2 );
+        sha256_rounds< 12 >( state0, state1, m0, m1, m3 );
+        sha256_rounds< 13 >( state0, state1, m1, m2, m0 );
+        sha256_rounds< 14 >( state0, state1, m2, m3, m1 );
+        sha256_rounds< 15 >( state0, state1, m3, m0, m2 );
+
+        state0 = _mm_add_epi32( state0, state0Save );
+        state1 = _mm_add_epi32( state1, state1Save );
+      }
+
+      // ABEF / CDGH back to DCBA / HGFE
+      auto feba = _mm_shuffle_epi32( state0, 0x1b );
+      auto dchg = _mm_shuffle_epi32( state1, 0xb1 );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pChain_ ), _mm_blend_epi16( feba, dchg, 0xf0 ) );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pChain_ + 4 ), _mm_alignr_epi8( dchg, feba, 8 ) );
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,61 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include "../support/environment.h"
+
+// Linux USDT probes (provider ll_crypto) for attaching bpftrace / perf to a running process, see
+// support/bpftrace for example scripts. A probe is a single nop while no tracer is attached, the arguments
+// are only evaluated into registers. Without <sys/sdt.h> (systemtap-sdt-dev) the probes compile to nothing.
+//
+//  generator_create( generator, type )
+//  generator_add_data( generator, type, bytes )
+//  generator_retrieve( generator, type )
+//  file_hash_begin( path, type )
+//  file_hash_end( path, type, bytes, cached )
+//  pbkdf2_begin( type, iterations, outputLength )
+//  pbkdf2_end( type, iterations )
+//
+// types are passed as the numeric value of hash::type, paths as C strings
+
+#if LL_IS_LINUX() && defined( __has_include )
+#if __has_include( <sys/sdt.h> )
+#include <sys/sdt.h>
+#define LL_HAS_USDT() 1
+#endif
+#endif
+
+#ifndef LL_HAS_USDT
+#define LL_HAS_USDT() 0
+#endif
+
+
+#if LL_HAS_USDT()
+
+#define LL_PROBE2( name_, a1_, a2_ ) DTRACE_PROBE2( ll_crypto, name_, a1_, a2_ )
+#define LL_PROBE3( name_, a1_, a2_, a3_ ) DTRACE_PROBE3( ll_crypto, name_, a1_, a2_, a3_ )
+#define LL_PROBE4( name_, a1_, a2_, a3_, a4_ ) DTRACE_PROBE4( ll_crypto, name_, a1_, a2_, a3_, a4_ )
+
+#else
+
+#define LL_PROBE2( name_, a1_, a2_ )
+#define LL_PROBE3( name_, a1_, a2_, a3_ )
+#define LL_PROBE4( name_, a1_, a2_, a3_, a4_ )
+
+#endif
@@ -0,0 +1,663 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "xxh3.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if LL_COMPILER == LL_MSVC
+#include <intrin.h>
+#endif
+
+#include "crypto/basic_hash_generator.h"
+#include "crypto/exception.h"
+#include "cpu_features.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace xxh3
+  {
+    const std::uint8_t kSecret[kSecretSize] = {
+      0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+      0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+      0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+      0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+      0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+      0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+      0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+      0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+      0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+      0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+      0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+      0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    namespace
+    {
+      const std::uint32_t kPrime32_1 = 0x9e3779b1u;
+      const std::uint32_t kPrime32_2 = 0x85ebca77u;
+      const std::uint32_t kPrime32_3 = 0xc2b2ae3du;
+      const std::uint64_t kPrime64_1 = 0x9e3779b185ebca87ull;
+      const std::uint64_t kPrime64_2 = 0xc2b2ae3d27d4eb4full;
+      const std::uint64_t kPrime64_3 = 0x165667b19e3779f9ull;
+      const std::uint64_t kPrime64_4 = 0x85ebca77c2b2ae63ull;
+      const std::uint64_t kPrime64_5 = 0x27d4eb2f165667c5ull;
+      const std::uint64_t kPrimeMx1 = 0x165667919e3779f9ull;
+      const std::uint64_t kPrimeMx2 = 0x9fb21c651e98df25ull;
+
+      const size_t kSecretSizeMin = 136;
+      const size_t kStripesPerBlock = ( kSecretSize - kStripeSize ) / 8;
+      const size_t kSecretLimit = kSecretSize - kStripeSize;  //!< the secret of the scrambler
+      const size_t kSecretLastAccStart = 7;
+      const size_t kSecretMergeAccsStart = 11;
+      const size_t kMidSizeStartOffset = 3;
+      const size_t kMidSizeLastOffset = 17;
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      // xxh3 is little endian like the platforms we run on
+
+      inline std::uint32_t load_le32( const std::uint8_t* p_ )
+      {
+        std::uint32_t v;
+        std::memcpy( &v, p_, 4 );
+        return v;
+      }
+
+      inline std::uint64_t load_le64( const std::uint8_t* p_ )
+      {
+        std::uint64_t v;
+        std::memcpy( &v, p_, 8 );
+        return v;
+      }
+
+      inline std::uint32_t swap32( std::uint32_t v_ )
+      {
+        return ( v_ >> 24 ) | ( ( v_ >> 8 ) & 0xff00 ) | ( ( v_ << 8 ) & 0xff0000 ) | ( v_ << 24 );
+      }
+
+      inline std::uint64_t swap64( std::uint64_t v_ )
+      {
+        return ( std::uint64_t( swap32( static_cast< std::uint32_t >( v_ ) ) ) << 32 )
+               | swap32( static_cast< std::uint32_t >( v_ >> 32 ) );
+      }
+
+      inline std::uint32_t rotl32( std::uint32_t v_, int n_ ) { return ( v_ << n_ ) | ( v_ >> ( 32 - n_ ) ); }
+      inline std::uint64_t rotl64( std::uint64_t v_, int n_ ) { return ( v_ << n_ ) | ( v_ >> ( 64 - n_ ) ); }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      struct uint128
+      {
+        std::uint64_t low;
+        std::uint64_t high;
+      };
+
+      inline uint128 multiply64to128( std::uint64_t a_, std::uint64_t b_ )
+      {
+        uint128 result;
+#if LL_COMPILER == LL_MSVC
+        result.low = _umul128( a_, b_, &result.high );
+#else
+        unsigned __int128 product = static_cast< unsigned __int128 >( a_ ) * b_;
+        result.low = static_cast< std::uint64_t >( product );
+        result.high = static_cast< std::uint64_t >( product >> 64 );
+#endif
+        return result;
+      }
+
+      inline std::uint64_t multiply_fold64( std::uint64_t a_, std::uint64_t b_ )
+      {
+        auto product = multiply64to128( a_, b_ );
+        return product.low ^ product.high;
+      }
+
+      inline std::uint64_t xxh64_avalanche( std::uint64_t h_ )
+      {
+        h_ ^= h_ >> 33;
+        h_ *= kPrime64_2;
+        h_ ^= h_ >> 29;
+        h_ *= kPrime64_3;
+        return h_ ^ ( h_ >> 32 );
+      }
+
+      inline std::uint64_t avalanche( std::uint64_t h_ )
+      {
+        h_ ^= h_ >> 37;
+        h_ *= kPrimeMx1;
+        return h_ ^ ( h_ >> 32 );
+      }
+
+      inline std::uint64_t rrmxmx( std::uint64_t h_, std::uint64_t size_ )
+      {
+        h_ ^= rotl64( h_, 49 ) ^ rotl64( h_, 24 );
+        h_ *= kPrimeMx2;
+        h_ ^= ( h_ >> 35 ) + size_;
+        h_ *= kPrimeMx2;
+        return h_ ^ ( h_ >> 28 );
+      }
+
+      inline std::uint64_t mix16( const std::uint8_t* pInput_, const std::uint8_t* pSecret_ )
+      {
+        return multiply_fold64( load_le64( pInput_ ) ^ load_le64( pSecret_ ),
+                                load_le64( pInput_ + 8 ) ^ load_le64( pSecret_ + 8 ) );
+      }
+
+      inline uint128 mix32( uint128 acc_,
+                            const std::uint8_t* pInput1_,
+                            const std::uint8_t* pInput2_,
+                            const std::uint8_t* pSecret_ )
+      {
+        acc_.low += mix16( pInput1_, pSecret_ );
+        acc_.low ^= load_le64( pInput2_ ) + load_le64( pInput2_ + 8 );
+        acc_.high += mix16( pInput2_, pSecret_ + 16 );
+        acc_.high ^= load_le64( pInput1_ ) + load_le64( pInput1_ + 8 );
+        return acc_;
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+      // inputs up to kMidSizeMax bytes
+      // -----------------------------------------------------------------------------------------------------
+
+      inline std::uint32_t combine_1to3( const std::uint8_t* p_, size_t sz_ )
+      {
+        return ( std::uint32_t( p_[0] ) << 16 ) | ( std::uint32_t( p_[sz_ >> 1] ) << 24 )
+               | std::uint32_t( p_[sz_ - 1] ) | ( static_cast< std::uint32_t >( sz_ ) << 8 );
+      }
+
+
+      std::uint64_t hash64_short( const std::uint8_t* p_, size_t sz_ )
+      {
+        const std::uint8_t* s = kSecret;
+
+        if ( sz_ == 0 )
+          return xxh64_avalanche( load_le64( s + 56 ) ^ load_le64( s + 64 ) );
+
+        if ( sz_ <= 3 )
+        {
+          auto combined = combine_1to3( p_, sz_ );
+          return xxh64_avalanche( combined ^ std::uint64_t( load_le32( s ) ^ load_le32( s + 4 ) ) );
+        }
+
+        if ( sz_ <= 8 )
+        {
+          std::uint64_t input = load_le32( p_ + sz_ - 4 ) + ( std::uint64_t( load_le32( p_ ) ) << 32 );
+          return rrmxmx( input ^ ( load_le64( s + 8 ) ^ load_le64( s + 16 ) ), sz_ );
+        }
+
+        if ( sz_ <= 16 )
+        {
+          std::uint64_t low = load_le64( p_ ) ^ ( load_le64( s + 24 ) ^ load_le64( s + 32 ) );
+          std::uint64_t high = load_le64( p_ + sz_ - 8 ) ^ ( load_le64( s + 40 ) ^ load_le64( s + 48 ) );
+          return avalanche( sz_ + swap64( low ) + high + multiply_fold64( low, high ) );
+        }
+
+        std::uint64_t acc = sz_ * kPrime64_1;
+        if ( sz_ <= 128 )
+        {
+          // pairs of 16 byte blocks from both ends
+          for ( size_t i = ( sz_ - 1 ) / 32 + 1; i-- > 0; )
+          {
+            acc += mix16( p_ + 16 * i, s + 32 * i );
+            acc += mix16( p_ + sz_ - 16 * ( i + 1 ), s + 32 * i + 16 );
+          }
+          return avalanche( acc );
+        }
+
+        for ( size_t i = 0; i < 8; ++i )
+          acc += mix16( p_ + 16 * i, s + 16 * i );
+        acc = avalanche( acc );
+
+        std::uint64_t accEnd = mix16( p_ + sz_ - 16, s + kSecretSizeMin - kMidSizeLastOffset );
+        for ( size_t i = 8; i < sz_ / 16; ++i )
+          accEnd += mix16( p_ + 16 * i, s + 16 * ( i - 8 ) + kMidSizeStartOffset );
+        return avalanche( acc + accEnd );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+
+      uint128 finish128( uint128 acc_, size_t sz_ )
+      {
+        uint128 h;
+        h.low = avalanche( acc_.low + acc_.high );
+        h.high = 0 - avalanche( acc_.low * kPrime64_1 + acc_.high * kPrime64_4 + sz_ * kPrime64_2 );
+        return h;
+      }
+
+      uint128 hash128_short( const std::uint8_t* p_, size_t sz_ )
+      {
+        const std::uint8_t* s = kSecret;
+        uint128 h;
+
+        if ( sz_ == 0 )
+        {
+          h.low = xxh64_avalanche( load_le64( s + 64 ) ^ load_le64( s + 72 ) );
+          h.high = xxh64_avalanche( load_le64( s + 80 ) ^ load_le64( s + 88 ) );
+          return h;
+        }
+
+        if ( sz_ <= 3 )
+        {
+          auto combinedLow = combine_1to3( p_, sz_ );
+          std::uint32_t combinedHigh = rotl32( swap32( combinedLow ), 13 );
+          h.low = xxh64_avalanche( combinedLow ^ std::uint64_t( load_le32( s ) ^ load_le32( s + 4 ) ) );
+          h.high = xxh64_avalanche( combinedHigh
+                                    ^ std::uint64_t( load_le32( s + 8 ) ^ load_le32( s + 12 ) ) );
+          return h;
+        }
+
+        if ( sz_ <= 8 )
+        {
+          std::uint64_t input = load_le32( p_ ) + ( std::uint64_t( load_le32( p_ + sz_ - 4 ) ) << 32 );
+          std::uint64_t keyed = input ^ ( load_le64( s + 16 ) ^ load_le64( s + 24 ) );
+          h = multiply64to128( keyed, kPrime64_1 + ( sz_ << 2 ) );
+          h.high += h.low << 1;
+          h.low ^= h.high >> 3;
+          h.low ^= h.low >> 35;
+          h.low *= kPrimeMx2;
+          h.low ^= h.low >> 28;
+          h.high = avalanche( h.high );
+          return h;
+        }
+
+        if ( sz_ <= 16 )
+        {
+          std::uint64_t low = load_le64( p_ );
+          std::uint64_t high = load_le64( p_ + sz_ - 8 );
+          auto m = multiply64to128( low ^ high ^ ( load_le64( s + 32 ) ^ load_le64( s + 40 ) ), kPrime64_1 );
+          m.low += std::uint64_t( sz_ - 1 ) << 54;
+          high ^= load_le64( s + 48 ) ^ load_le64( s + 56 );
+          m.high += high + std::uint64_t( static_cast< std::uint32_t >( high ) ) * ( kPrime32_2 - 1 );
+          m.low ^= swap64( m.high );
+
+          h = multiply64to128( m.low, kPrime64_2 );
+          h.high += m.high * kPrime64_2;
+          h.low = avalanche( h.low );
+          h.high = avalanche( h.high );
+          return h;
+        }
+
+        uint128 acc = { sz_ * kPrime64_1, 0 };
+        if ( sz_ <= 128 )
+        {
+          for ( size_t i = ( sz_ - 1 ) / 32 + 1; i-- > 0; )
+            acc = mix32( acc, p_ + 16 * i, p_ + sz_ - 16 * ( i + 1 ), s + 32 * i );
+          return finish128( acc, sz_ );
+        }
+
+        for ( size_t i = 32; i < 160; i += 32 )
+          acc = mix32( acc, p_ + i - 32, p_ + i - 16, s + i - 32 );
+        acc.low = avalanche( acc.low );
+        acc.high = avalanche( acc.high );
+        for ( size_t i = 160; i <= sz_; i += 32 )
+          acc = mix32( acc, p_ + i - 32, p_ + i - 16, s + kMidSizeStartOffset + i - 160 );
+        acc = mix32( acc, p_ + sz_ - 16, p_ + sz_ - 32, s + kSecretSizeMin - kMidSizeLastOffset - 16 );
+        return finish128( acc, sz_ );
+      }
+
+
+      // -----------------------------------------------------------------------------------------------------
+      // longer inputs
+      // -----------------------------------------------------------------------------------------------------
+
+      struct kernels
+      {
+        void ( *accumulate )( std::uint64_t*, const std::uint8_t*, size_t, const std::uint8_t* );
+        void ( *scramble )( std::uint64_t*, const std::uint8_t* );
+      };
+
+      kernels select_kernels()
+      {
+        kernels k = { &xxh3::accumulate, &xxh3::scramble };
+        if ( get_cpu_features().avx2 )
+        {
+          k.accumulate = &accumulate_avx2;
+          k.scramble = &scramble_avx2;
+        }
+        return k;
+      }
+
+      //! accumulate numStripes_ stripes, scrambling the accumulators at the end of every block
+      const std::uint8_t* consume_stripes( std::uint64_t* pAcc_,
+                                           std::uint32_t& numStripesSoFar_,
+                                           const std::uint8_t* pInput_,
+                                           size_t numStripes_,
+                                           const kernels& kernels_ )
+      {
+        while ( numStripes_ > 0 )
+        {
+          auto n = std::min( numStripes_, kStripesPerBlock - numStripesSoFar_ );
+          kernels_.accumulate( pAcc_, pInput_, n, kSecret + numStripesSoFar_ * 8 );
+          pInput_ += n * kStripeSize;
+          numStripes_ -= n;
+          numStripesSoFar_ += static_cast< std::uint32_t >( n );
+
+          if ( numStripesSoFar_ == kStripesPerBlock )
+          {
+            kernels_.scramble( pAcc_, kSecret + kSecretLimit );
+            numStripesSoFar_ = 0;
+          }
+        }
+        return pInput_;
+      }
+
+      //! the accumulators including the buffered input and the last stripe
+      void digest_accumulators( const state& state_, std::uint64_t* pAcc_ )
+      {
+        auto k = select_kernels();
+        std::memcpy( pAcc_, state_.acc, sizeof( state_.acc ) );
+
+        std::uint8_t lastStripe[kStripeSize];
+        const std::uint8_t* pLastStripe = lastStripe;
+        if ( state_.bufferedSize >= kStripeSize )
+        {
+          auto numStripesSoFar = state_.numStripesSoFar;
+          auto numStripes = ( state_.bufferedSize - 1 ) / kStripeSize;
+          consume_stripes( pAcc_, numStripesSoFar, state_.buffer, numStripes, k );
+          pLastStripe = state_.buffer + state_.bufferedSize - kStripeSize;
+        }
+        else
+        {
+          // the last stripe reaches back into the input consumed before (kept at the end of the buffer)
+          auto catchUp = kStripeSize - state_.bufferedSize;
+          std::memcpy( lastStripe, state_.buffer + kBufferSize - catchUp, catchUp );
+          std::memcpy( lastStripe + catchUp, state_.buffer, state_.bufferedSize );
+        }
+
+        k.accumulate( pAcc_, pLastStripe, 1, kSecret + kSecretLimit - kSecretLastAccStart );
+      }
+
+      std::uint64_t merge_accumulators( const std::uint64_t* pAcc_,
+                                        const std::uint8_t* pSecret_,
+                                        std::uint64_t start_ )
+      {
+        auto result = start_;
+        for ( size_t i = 0; i < 4; ++i )
+        {
+          result += multiply_fold64( pAcc_[2 * i] ^ load_le64( pSecret_ + 16 * i ),
+                                     pAcc_[2 * i + 1] ^ load_le64( pSecret_ + 16 * i + 8 ) );
+        }
+        return avalanche( result );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void accumulate( std::uint64_t* pAcc_,
+                     const std::uint8_t* pInput_,
+                     size_t numStripes_,
+                     const std::uint8_t* pSecret_ )
+    {
+      for ( size_t n = 0; n < numStripes_; ++n )
+      {
+        for ( size_t i = 0; i < 8; ++i )
+        {
+          auto data = load_le64( pInput_ + n * kStripeSize + 8 * i );
+          auto dataKey = data ^ load_le64( pSecret_ + n * 8 + 8 * i );
+          pAcc_[i ^ 1] += data;
+          pAcc_[i] += ( dataKey & 0xffffffff ) * ( dataKey >> 32 );
+        }
+      }
+    }
+
+    void scramble( std::uint64_t* pAcc_, const std::uint8_t* pSecret_ )
+    {
+      for ( size_t i = 0; i < 8; ++i )
+      {
+        auto acc = pAcc_[i];
+        acc ^= acc >> 47;
+        acc ^= load_le64( pSecret_ + 8 * i );
+        pAcc_[i] = acc * kPrime32_1;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void init( state& state_ )
+    {
+      const std::uint64_t initialAcc[8]
+        = { kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_4, kPrime32_2, kPrime64_5, kPrime32_1 };
+      std::memcpy( state_.acc, initialAcc, sizeof( initialAcc ) );
+      std::memset( state_.buffer, 0, kBufferSize );
+      state_.totalSize = 0;
+      state_.bufferedSize = 0;
+      state_.numStripesSoFar = 0;
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void update( state& state_, const std::uint8_t* pBuffer_, size_t sz_ )
+    {
+      // empty input may come with a null buffer, which memcpy must not see
+      if ( sz_ == 0 )
+        return;
+
+      state_.totalSize += sz_;
+
+      if ( sz_ <= kBufferSize - state_.bufferedSize )
+      {
+        std::memcpy( state_.buffer + state_.bufferedSize, pBuffer_, sz_ );
+        state_.bufferedSize += static_cast< std::uint32_t >( sz_ );
+        return;
+      }
+
+      // there is more input, so the buffer can be consumed completely
+      auto k = select_kernels();
+      auto pEnd = pBuffer_ + sz_;
+      if ( state_.bufferedSize > 0 )
+      {
+        auto n = kBufferSize - state_.bufferedSize;
+        std::memcpy( state_.buffer + state_.bufferedSize, pBuffer_, n );
+        pBuffer_ += n;
+        consume_stripes( state_.acc, state_.numStripesSoFar, state_.buffer, kBufferSize / kStripeSize, k );
+        state_.bufferedSize = 0;
+      }
+
+      // consume the input in place, but keep at least one byte for the digest and the last stripe in case the
+      // remaining input is shorter than a stripe
+      if ( static_cast< size_t >( pEnd - pBuffer_ ) > kBufferSize )
+      {
+        auto numStripes = static_cast< size_t >( pEnd - 1 - pBuffer_ ) / kStripeSize;
+        pBuffer_ = consume_stripes( state_.acc, state_.numStripesSoFar, pBuffer_, numStripes, k );
+        std::memcpy( state_.buffer + kBufferSize - kStripeSize, pBuffer_ - kStripeSize, kStripeSize );
+      }
+
+      state_.bufferedSize = static_cast< std::uint32_t >( pEnd - pBuffer_ );
+      std::memcpy( state_.buffer, pBuffer_, state_.bufferedSize );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    std::uint64_t digest64( const state& state_ )
+    {
+      if ( state_.totalSize <= kMidSizeMax )
+        return hash64_short( state_.buffer, static_cast< size_t >( state_.totalSize ) );
+
+      std::uint64_t acc[8];
+      digest_accumulators( state_, acc );
+      return merge_accumulators( acc, kSecret + kSecretMergeAccsStart, state_.totalSize * kPrime64_1 );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    void digest128( const state& state_, std::uint64_t& low_, std::uint64_t& high_ )
+    {
+      if ( state_.totalSize <= kMidSizeMax )
+      {
+        auto h = hash128_short( state_.buffer, static_cast< size_t >( state_.totalSize ) );
+        low_ = h.low;
+        high_ = h.high;
+        return;
+      }
+
+      std::uint64_t acc[8];
+      digest_accumulators( state_, acc );
+      low_ = merge_accumulators( acc, kSecret + kSecretMergeAccsStart, state_.totalSize * kPrime64_1 );
+      auto pSecretHigh = kSecret + kSecretSize - sizeof( acc ) - kSecretMergeAccsStart;
+      high_ = merge_accumulators( acc, pSecretHigh, ~( state_.totalSize * kPrime64_2 ) );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    const char* kernel_name()
+    {
+      return get_cpu_features().avx2 ? "avx2" : "portable";
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+  // backends
+  // ---------------------------------------------------------------------------------------------------------
+
+  namespace
+  {
+    // the results are conventionally written as big endian numbers, the high half of xxh3-128 first
+    void store_be64( std::uint8_t* p_, std::uint64_t v_ )
+    {
+      for ( size_t i = 0; i < 8; ++i )
+        p_[i] = static_cast< std::uint8_t >( v_ >> ( 56 - 8 * i ) );
+    }
+
+    // the native state: accumulators (8 x 8 bytes little endian), stripes of the current block (1 byte),
+    // buffered size (2 bytes little endian) and the whole buffer (it holds the last stripe of the input)
+    const size_t kXxh3StateSize = 64 + 1 + 2 + xxh3::kBufferSize;
+
+    size_t export_xxh3_state( const void* pContext_, std::uint8_t* pState_ )
+    {
+      const auto& s = *static_cast< const xxh3::state* >( pContext_ );
+      for ( size_t i = 0; i < 8; ++i )
+      {
+        for ( size_t b = 0; b < 8; ++b )
+          pState_[8 * i + b] = static_cast< std::uint8_t >( s.acc[i] >> ( 8 * b ) );
+      }
+      pState_[64] = static_cast< std::uint8_t >( s.numStripesSoFar );
+      pState_[65] = static_cast< std::uint8_t >( s.bufferedSize );
+      pState_[66] = static_cast< std::uint8_t >( s.bufferedSize >> 8 );
+      std::memcpy( pState_ + 67, s.buffer, xxh3::kBufferSize );
+      return kXxh3StateSize;
+    }
+
+    void import_xxh3_state( void* pContext_,
+                            const std::uint8_t* pState_,
+                            size_t sz_,
+                            std::uint64_t inputSize_ )
+    {
+      if ( sz_ != kXxh3StateSize )
+        throw exception( error::invalid_parameter, "invalid hash state" );
+
+      xxh3::state s;
+      for ( size_t i = 0; i < 8; ++i )
+      {
+        s.acc[i] = 0;
+        for ( size_t b = 0; b < 8; ++b )
+          s.acc[i] |= std::uint64_t( pState_[8 * i + b] ) << ( 8 * b );
+      }
+      s.numStripesSoFar = pState_[64];
+      s.bufferedSize = pState_[65] | ( std::uint32_t( pState_[66] ) << 8 );
+      std::memcpy( s.buffer, pState_ + 67, xxh3::kBufferSize );
+      s.totalSize = inputSize_;
+
+      // the input is only consumed once more than the buffer has been added, and never completely
+      bool consumed = inputSize_ > xxh3::kBufferSize;
+      if ( ( s.numStripesSoFar >= ( xxh3::kSecretSize - xxh3::kStripeSize ) / 8 )
+           || ( s.bufferedSize > xxh3::kBufferSize ) || ( consumed && ( s.bufferedSize == 0 ) )
+           || ( !consumed && ( s.bufferedSize != inputSize_ ) ) )
+        throw exception( error::invalid_parameter, "invalid hash state" );
+
+      std::memcpy( pContext_, &s, sizeof( s ) );
+    }
+  }
+
+  static_assert( sizeof( xxh3::state ) <= detail::hash_backend< hash::type::xxh3_64 >::contextSize,
+                 "context storage too small for xxh3::state" );
+  static_assert( sizeof( xxh3::state ) <= detail::hash_backend< hash::type::xxh3_128 >::contextSize,
+                 "context storage too small for xxh3::state" );
+
+
+#define LL_IMPLEMENT_XXH3_BACKEND( type_ )                                                                   \
+  void detail::hash_backend< type_ >::init( void* pContext_ )                                                \
+  {                                                                                                          \
+    xxh3::init( *static_cast< xxh3::state* >( pContext_ ) );                                                 \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::update( void* pContext_, const std::uint8_t* pBuffer_, size_t sz_ )    \
+  {                                                                                                          \
+    xxh3::update( *static_cast< xxh3::state* >( pContext_ ), pBuffer_, sz_ );                                \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::copy( void* pTarget_, const void* pSource_ )                           \
+  {                                                                                                          \
+    std::memcpy( pTarget_, pSource_, sizeof( xxh3::state ) );                                                \
+  }                                                                                                          \
+                                                                                                             \
+  size_t detail::hash_backend< type_ >::export_state( const void* pContext_, std::uint8_t* pState_ )         \
+  {                                                                                                          \
+    return export_xxh3_state( pContext_, pState_ );                                                          \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::import_state( void* pContext_,                                         \
+                                                    const std::uint8_t* pState_,                             \
+                                                    size_t sz_,                                              \
+                                                    std::uint64_t inputSize_ )                               \
+  {                                                                                                          \
+    import_xxh3_state( pContext_, pState_, sz_, inputSize_ );                                                \
+  }                                                                                                          \
+                                                                                                             \
+  void detail::hash_backend< type_ >::destroy( void* ) LL_NOEXCEPT                                          \
+  {                                                                                                          \
+  }
+
+  LL_IMPLEMENT_XXH3_BACKEND( hash::type::xxh3_64 )
+  LL_IMPLEMENT_XXH3_BACKEND( hash::type::xxh3_128 )
+
+#undef LL_IMPLEMENT_XXH3_BACKEND
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void detail::hash_backend< hash::type::xxh3_64 >::final( void* pContext_, std::uint8_t* pDigest_ )
+  {
+    store_be64( pDigest_, xxh3::digest64( *static_cast< const xxh3::state* >( pContext_ ) ) );
+  }
+
+  void detail::hash_backend< hash::type::xxh3_128 >::final( void* pContext_, std::uint8_t* pDigest_ )
+  {
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+    xxh3::digest128( *static_cast< const xxh3::state* >( pContext_ ), low, high );
+    store_be64( pDigest_, high );
+    store_be64( pDigest_ + 8, low );
+  }
+
+}  // namespace crypto
+}  // namespace ll
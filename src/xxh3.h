@@ -0,0 +1,88 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#pragma once
+
+#include "../support/environment.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ll
+{
+namespace crypto
+{
+  // XXH3 (xxHash v0.8, default secret, seed 0): inputs up to 240 bytes are mixed directly with the secret,
+  // longer inputs are accumulated in 8 lanes of 64bit, one 64 byte stripe at a time. The accumulators are
+  // scrambled after every block of 16 stripes and merged into the 64 or 128 bit result at the end.
+
+  namespace xxh3
+  {
+    const size_t kStripeSize = 64;
+    const size_t kSecretSize = 192;
+    const size_t kBufferSize = 256;   //!< the input buffered by the streaming state (a multiple of stripes)
+    const size_t kMidSizeMax = 240;   //!< longer inputs take the accumulator path
+
+    extern const std::uint8_t kSecret[kSecretSize];
+
+    //! the streaming state, the buffer always holds at least one byte and the last stripe of the input
+    //! once the accumulators are in use
+    struct state
+    {
+      std::uint64_t acc[8];
+      std::uint8_t buffer[kBufferSize];
+      std::uint64_t totalSize;
+      std::uint32_t bufferedSize;
+      std::uint32_t numStripesSoFar;  //!< the stripes of the current block, they select the secret offset
+    };
+
+    void init( state& state_ );
+    void update( state& state_, const std::uint8_t* pBuffer_, size_t sz_ );
+
+    //! the result of the input so far, the state isn't modified
+    std::uint64_t digest64( const state& state_ );
+    void digest128( const state& state_, std::uint64_t& low_, std::uint64_t& high_ );
+
+    //! the name of the accumulate / scramble kernels used on this cpu
+    const char* kernel_name();
+
+
+    // -------------------------------------------------------------------------------------------------------
+    // kernels
+    // -------------------------------------------------------------------------------------------------------
+
+    //! accumulate numStripes_ stripes, the secret advances 8 bytes per stripe
+    void accumulate( std::uint64_t* pAcc_,
+                     const std::uint8_t* pInput_,
+                     size_t numStripes_,
+                     const std::uint8_t* pSecret_ );
+
+    void scramble( std::uint64_t* pAcc_, const std::uint8_t* pSecret_ );
+
+    //! only to be called if the cpu supports avx2
+    void accumulate_avx2( std::uint64_t* pAcc_,
+                          const std::uint8_t* pInput_,
+                          size_t numStripes_,
+                          const std::uint8_t* pSecret_ );
+
+    void scramble_avx2( std::uint64_t* pAcc_, const std::uint8_t* pSecret_ );
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,93 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include "xxh3.h"
+
+#include <immintrin.h>
+
+#include <cstring>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace
+  {
+    typedef __m256i vec_t;
+
+    inline vec_t load( const std::uint8_t* p_ )
+    {
+      return _mm256_loadu_si256( reinterpret_cast< const vec_t* >( p_ ) );
+    }
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void xxh3::accumulate_avx2( std::uint64_t* pAcc_,
+                              const std::uint8_t* pInput_,
+                              size_t numStripes_,
+                              const std::uint8_t* pSecret_ )
+  {
+    vec_t acc0 = _mm256_loadu_si256( reinterpret_cast< const vec_t* >( pAcc_ ) );
+    vec_t acc1 = _mm256_loadu_si256( reinterpret_cast< const vec_t* >( pAcc_ + 4 ) );
+
+    for ( size_t n = 0; n < numStripes_; ++n )
+    {
+      const std::uint8_t* pInput = pInput_ + n * kStripeSize;
+      const std::uint8_t* pSecret = pSecret_ + n * 8;
+
+      // acc[i ^ 1] += data[i], acc[i] += lo32( data[i] ^ key[i] ) * hi32( data[i] ^ key[i] )
+      vec_t data0 = load( pInput );
+      vec_t data1 = load( pInput + 32 );
+      vec_t dataKey0 = _mm256_xor_si256( data0, load( pSecret ) );
+      vec_t dataKey1 = _mm256_xor_si256( data1, load( pSecret + 32 ) );
+      vec_t product0 = _mm256_mul_epu32( dataKey0, _mm256_srli_epi64( dataKey0, 32 ) );
+      vec_t product1 = _mm256_mul_epu32( dataKey1, _mm256_srli_epi64( dataKey1, 32 ) );
+      acc0 = _mm256_add_epi64( acc0, _mm256_add_epi64( product0, _mm256_shuffle_epi32( data0, 0x4e ) ) );
+      acc1 = _mm256_add_epi64( acc1, _mm256_add_epi64( product1, _mm256_shuffle_epi32( data1, 0x4e ) ) );
+    }
+
+    _mm256_storeu_si256( reinterpret_cast< vec_t* >( pAcc_ ), acc0 );
+    _mm256_storeu_si256( reinterpret_cast< vec_t* >( pAcc_ + 4 ), acc1 );
+  }
+
+
+  // ---------------------------------------------------------------------------------------------------------
+
+  void xxh3::scramble_avx2( std::uint64_t* pAcc_, const std::uint8_t* pSecret_ )
+  {
+    // acc = ( acc ^ ( acc >> 47 ) ^ key ) * prime32_1, the 64bit product is composed of two 32bit ones
+    const vec_t prime = _mm256_set1_epi32( static_cast< int >( 0x9e3779b1u ) );
+
+    for ( size_t i = 0; i < 2; ++i )
+    {
+      auto pAcc = reinterpret_cast< vec_t* >( pAcc_ + 4 * i );
+      vec_t acc = _mm256_loadu_si256( pAcc );
+      acc = _mm256_xor_si256( acc, _mm256_srli_epi64( acc, 47 ) );
+      acc = _mm256_xor_si256( acc, load( pSecret_ + 32 * i ) );
+
+      vec_t productLo = _mm256_mul_epu32( acc, prime );
+      vec_t productHi = _mm256_mul_epu32( _mm256_shuffle_epi32( acc, 0x31 ), prime );
+      _mm256_storeu_si256( pAcc, _mm256_add_epi64( productLo, _mm256_slli_epi64( productHi, 32 ) ) );
+    }
+  }
+
+}  // namespace crypto
+}  // namespace ll
@@ -100,15 +100,25 @@
 #define LL_HAS_MAKE_UNIQUUE() 1
 #define LL_HAS_CONSTEXPR() 0
 #define LL_HAS_NOEXCEPT() 0
+#define LL_HAS_THREAD_LOCAL() 0
 #else
 #define LL_HAS_MAKE_UNIQUUE() 1
 #define LL_HAS_CONSTEXPR() 1
 #define LL_HAS_NOEXCEPT() 1
+#define LL_HAS_THREAD_LOCAL() 1
 #endif
 #else
 #define LL_HAS_MAKE_UNIQUUE() 0
 #define LL_HAS_CONSTEXPR() 1
 #define LL_HAS_NOEXCEPT() 1
+#define LL_HAS_THREAD_LOCAL() 1
+#endif
+
+// AVX-512 intrinsics are available from VS 2017 on
+#if LL_COMPILER == LL_MSVC && LL_COMPILER_VERSION < 1910
+#define LL_HAS_AVX512() 0
+#else
+#define LL_HAS_AVX512() 1
 #endif
 
 #if LL_HAS_CONSTEXPR()
@@ -10,13 +10,17 @@
 #include <unistd.h>
 #endif
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <vector>
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/fstream.hpp>
 
 
-boost::filesystem::path get_executable_path()
+inline boost::filesystem::path get_executable_path()
 {
 #if LL_IS_WINDOWS()
 
@@ -34,12 +38,56 @@ boost::filesystem::path get_executable_path()
 
   const size_t MAX_PATH = 1024;
   char buffer[MAX_PATH];
-  if( readlink( "/proc/self/exe", buffer, MAX_PATH ) < 0 )
+  auto length = readlink( "/proc/self/exe", buffer, MAX_PATH - 1 );
+  if( length < 0 )
     return boost::filesystem::path();
+  buffer[length] = '\0';  // readlink doesn't terminate the string
 
 #endif
 
   boost::filesystem::path p( buffer );
   p.remove_filename();
   return p;
-}
\ No newline at end of file
+}
+
+
+//! the input of the reference test vectors (blake3, sha-3, ...): byte i is i % 251
+inline std::vector< std::uint8_t > make_test_input( size_t sz_ )
+{
+  std::vector< std::uint8_t > input( sz_ );
+  for ( size_t i = 0; i < input.size(); ++i )
+    input[i] = static_cast< std::uint8_t >( i % 251 );
+  return input;
+}
+
+
+//! a temporary directory that is removed with all its content on destruction
+class temporary_directory
+{
+public:
+  temporary_directory()
+    : m_path( boost::filesystem::temp_directory_path()
+              / boost::filesystem::unique_path( "ll_crypto_test_%%%%-%%%%-%%%%" ) )
+  {
+    boost::filesystem::create_directories( m_path );
+  }
+
+  ~temporary_directory()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all( m_path, ec );
+  }
+
+  const boost::filesystem::path& path() const { return m_path; }
+
+  void write( const std::string& relativePath_, const std::string& content_ ) const
+  {
+    auto p = m_path / relativePath_;
+    boost::filesystem::create_directories( p.parent_path() );
+    boost::filesystem::ofstream file( p, std::ios::out | std::ios::binary | std::ios::trunc );
+    file.write( content_.data(), content_.size() );
+  }
+
+private:
+  boost::filesystem::path m_path;
+};
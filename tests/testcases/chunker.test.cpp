@@ -0,0 +1,239 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <catch.hpp>
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <crypto/chunker.h>
+#include <crypto/exception.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace test
+  {
+    namespace
+    {
+      std::vector< std::uint8_t > random_data( size_t sz_, unsigned seed_ )
+      {
+        std::mt19937 rng( seed_ );
+        std::vector< std::uint8_t > data( sz_ );
+        for ( auto& b : data )
+          b = static_cast< std::uint8_t >( rng() );
+        return data;
+      }
+
+      //! a straightforward FastCDC implementation of the format documented in chunker.h
+      std::vector< size_t > reference_chunk_sizes( const std::vector< std::uint8_t >& data_,
+                                                   const chunker_config& cfg_ )
+      {
+        std::uint64_t gear[256];
+        std::uint64_t state = 0x6c6c5f6372797074;
+        for ( auto& v : gear )
+        {
+          state += 0x9e3779b97f4a7c15;
+          std::uint64_t z = state;
+          z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9;
+          z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111eb;
+          v = z ^ ( z >> 31 );
+        }
+
+        unsigned bits = 0;
+        while ( ( size_t( 2 ) << bits ) <= cfg_.avgSize )
+          ++bits;
+        auto maskS = ~std::uint64_t( 0 ) << ( 64 - ( bits + 2 ) );
+        auto maskL = ~std::uint64_t( 0 ) << ( 64 - ( bits - 2 ) );
+
+        std::vector< size_t > sizes;
+        size_t start = 0;
+        while ( start < data_.size() )
+        {
+          auto remaining = data_.size() - start;
+          size_t sz = std::min( remaining, cfg_.maxSize );
+          std::uint64_t fp = 0;
+          for ( size_t i = cfg_.minSize; i < std::min( remaining, cfg_.maxSize ); ++i )
+          {
+            fp = ( fp << 1 ) + gear[data_[start + i]];
+            if ( !( fp & ( i < cfg_.avgSize ? maskS : maskL ) ) )
+            {
+              sz = i + 1;
+              break;
+            }
+          }
+          sizes.push_back( sz );
+          start += sz;
+        }
+        return sizes;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "chunker matches the reference" )
+    {
+      auto data = random_data( 1000000, 1 );
+
+      chunker_config cfg;
+      cfg.minSize = 1024;
+      cfg.avgSize = 4096;
+      cfg.maxSize = 16384;
+
+      auto expected = reference_chunk_sizes( data, cfg );
+      auto chunks = get_chunks( data.data(), data.size(), cfg );
+
+      REQUIRE( chunks.size() == expected.size() );
+      REQUIRE( chunks.size() > 100 );
+
+      std::uint64_t offset = 0;
+      for ( size_t i = 0; i < chunks.size(); ++i )
+      {
+        REQUIRE( chunks[i].offset == offset );
+        REQUIRE( chunks[i].size == expected[i] );
+        REQUIRE( chunks[i].chunkDigest
+                 == to_digest( get_hash( data.data() + offset, expected[i], cfg.hashType ) ) );
+        offset += chunks[i].size;
+      }
+      REQUIRE( offset == data.size() );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "chunker results don't depend on how the input is fed" )
+    {
+      auto data = random_data( 300000, 2 );
+
+      chunker_config cfg;
+      cfg.minSize = 512;
+      cfg.avgSize = 2048;
+      cfg.maxSize = 8192;
+      cfg.hashType = hash::type::sha1;
+
+      auto expected = get_chunks( data.data(), data.size(), cfg );
+
+      SECTION( "hash threads" )
+      {
+        cfg.numHashThreads = 3;
+        auto chunks = get_chunks( data.data(), data.size(), cfg );
+
+        REQUIRE( chunks.size() == expected.size() );
+        for ( size_t i = 0; i < chunks.size(); ++i )
+        {
+          REQUIRE( chunks[i].size == expected[i].size );
+          REQUIRE( chunks[i].chunkDigest == expected[i].chunkDigest );
+        }
+      }
+
+      SECTION( "odd block sizes" )
+      {
+        for ( size_t blockSize : { 1, 7, 1000, 65536 } )
+        {
+          std::vector< chunk > chunks;
+          content_chunker chunker( cfg, [&]( const chunk& c_ ) { chunks.push_back( c_ ); } );
+          for ( size_t pos = 0; pos < data.size(); pos += blockSize )
+            chunker.add_data( data.data() + pos, std::min( blockSize, data.size() - pos ) );
+          chunker.finish();
+
+          REQUIRE( chunks.size() == expected.size() );
+          for ( size_t i = 0; i < chunks.size(); ++i )
+          {
+            REQUIRE( chunks[i].offset == expected[i].offset );
+            REQUIRE( chunks[i].chunkDigest == expected[i].chunkDigest );
+          }
+        }
+      }
+
+      SECTION( "streams" )
+      {
+        for ( size_t numReadAheadBuffers : { 0, 3 } )
+        {
+          cfg.streamConfig.processingBlockSize = 3333;
+          cfg.streamConfig.numReadAheadBuffers = numReadAheadBuffers;
+
+          std::istringstream stream( std::string( data.begin(), data.end() ) );
+          auto chunks = get_chunks( stream, cfg );
+
+          REQUIRE( chunks.size() == expected.size() );
+          for ( size_t i = 0; i < chunks.size(); ++i )
+            REQUIRE( chunks[i].chunkDigest == expected[i].chunkDigest );
+        }
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "chunker boundaries are content defined" )
+    {
+      auto data = random_data( 500000, 3 );
+      auto chunks = get_chunks( data.data(), data.size() );
+
+      for ( size_t i = 0; i + 1 < chunks.size(); ++i )
+      {
+        REQUIRE( chunks[i].size >= chunker_config().minSize );
+        REQUIRE( chunks[i].size <= chunker_config().maxSize );
+      }
+
+      // an insertion in the middle only changes the chunks around it
+      auto modified = data;
+      modified.insert( modified.begin() + 250000, 100, 0x55 );
+      auto modifiedChunks = get_chunks( modified.data(), modified.size() );
+
+      size_t numCommon = 0;
+      for ( const auto& c : modifiedChunks )
+      {
+        for ( const auto& o : chunks )
+          if ( c.chunkDigest == o.chunkDigest )
+          {
+            ++numCommon;
+            break;
+          }
+      }
+      REQUIRE( numCommon + 3 >= chunks.size() );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "chunker invalid parameters yield exception" )
+    {
+      chunker_config cfg;
+      cfg.minSize = 0;
+      REQUIRE_THROWS_AS( get_chunks( "abc", 3, cfg ), exception );
+
+      cfg = chunker_config();
+      cfg.maxSize = cfg.avgSize / 2;
+      REQUIRE_THROWS_AS( get_chunks( "abc", 3, cfg ), exception );
+
+      cfg = chunker_config();
+      cfg.hashType = hash::type::unknown;
+      REQUIRE_THROWS_AS( get_chunks( "abc", 3, cfg ), exception );
+
+      REQUIRE_THROWS_AS( get_file_chunks( "/this/file/does/not/exist" ), exception );
+
+      REQUIRE( get_chunks( nullptr, 0 ).empty() );
+    }
+  }  // namespace test
+}  // namespace crypto
+}  // namespace ll
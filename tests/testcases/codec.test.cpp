@@ -0,0 +1,237 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <catch.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <crypto/codec.h>
+#include <crypto/exception.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace test
+  {
+    namespace
+    {
+      std::string reference_hex( const std::vector< std::uint8_t >& v_ )
+      {
+        static const char kTable[] = "0123456789abcdef";
+        std::string result;
+        for ( auto b : v_ )
+        {
+          result += kTable[b >> 4];
+          result += kTable[b & 0xf];
+        }
+        return result;
+      }
+
+      std::string reference_base64( const std::vector< std::uint8_t >& v_, bool url_ )
+      {
+        const std::string table = url_ ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+                                       : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string result;
+        size_t bits = 0;
+        std::uint32_t acc = 0;
+        for ( auto b : v_ )
+        {
+          acc = ( acc << 8 ) | b;
+          bits += 8;
+          while ( bits >= 6 )
+          {
+            bits -= 6;
+            result += table[( acc >> bits ) & 0x3f];
+          }
+        }
+        if ( bits > 0 )
+          result += table[( acc << ( 6 - bits ) ) & 0x3f];
+        while ( !url_ && ( result.size() % 4 != 0 ) )
+          result += '=';
+        return result;
+      }
+
+      std::string encode_hex( const std::vector< std::uint8_t >& v_ )
+      {
+        std::string result( hex_encoded_size( v_.size() ), '\0' );
+        hex_encode( v_.data(), v_.size(), &result[0] );
+        return result;
+      }
+
+      std::vector< std::uint8_t > decode_hex( const std::string& s_ )
+      {
+        std::vector< std::uint8_t > result( s_.size() / 2 + 1 );
+        result.resize( hex_decode( s_.data(), s_.size(), result.data() ) );
+        return result;
+      }
+
+      std::string encode_base64( const std::vector< std::uint8_t >& v_, base64_alphabet alphabet_ )
+      {
+        std::string result( base64_encoded_size( v_.size(), alphabet_ ), '\0' );
+        CHECK( base64_encode( v_.data(), v_.size(), &result[0], alphabet_ ) == result.size() );
+        return result;
+      }
+
+      std::vector< std::uint8_t > decode_base64( const std::string& s_, base64_alphabet alphabet_ )
+      {
+        std::vector< std::uint8_t > result( base64_max_decoded_size( s_.size() ) + 1 );
+        result.resize( base64_decode( s_.data(), s_.size(), result.data(), alphabet_ ) );
+        return result;
+      }
+
+      std::vector< std::uint8_t > to_bytes( const std::string& s_ )
+      {
+        return std::vector< std::uint8_t >( s_.begin(), s_.end() );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "codec matches the reference" )
+    {
+      std::mt19937 generator( 4711 );
+      std::uniform_int_distribution< int > byteDistribution( 0, 255 );
+
+      // the lengths cover all block sizes of the SIMD kernels and the scalar tails
+      for ( size_t length = 0; length < 300; ++length )
+      {
+        std::vector< std::uint8_t > data( length );
+        for ( auto& b : data )
+          b = static_cast< std::uint8_t >( byteDistribution( generator ) );
+
+        auto hex = encode_hex( data );
+        CHECK( hex == reference_hex( data ) );
+        CHECK( decode_hex( hex ) == data );
+
+        auto base64 = encode_base64( data, base64_alphabet::standard );
+        CHECK( base64 == reference_base64( data, false ) );
+        CHECK( decode_base64( base64, base64_alphabet::standard ) == data );
+
+        auto base64url = encode_base64( data, base64_alphabet::url );
+        CHECK( base64url == reference_base64( data, true ) );
+        CHECK( decode_base64( base64url, base64_alphabet::url ) == data );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "codec decoding" )
+    {
+      SECTION( "rfc 4648 test vectors" )
+      {
+        std::vector< std::pair< std::string, std::string > > vectors = {
+          { "", "" },
+          { "f", "Zg==" },
+          { "fo", "Zm8=" },
+          { "foo", "Zm9v" },
+          { "foob", "Zm9vYg==" },
+          { "fooba", "Zm9vYmE=" },
+          { "foobar", "Zm9vYmFy" }
+        };
+        for ( const auto& v : vectors )
+        {
+          CHECK( encode_base64( to_bytes( v.first ), base64_alphabet::standard ) == v.second );
+          CHECK( decode_base64( v.second, base64_alphabet::standard ) == to_bytes( v.first ) );
+        }
+      }
+
+      SECTION( "hex accepts uppercase characters" )
+      {
+        CHECK( decode_hex( "00FFaBcD" ) == std::vector< std::uint8_t >( { 0x00, 0xff, 0xab, 0xcd } ) );
+        CHECK( decode_hex( std::string( 64, 'F' ) ) == std::vector< std::uint8_t >( 32, 0xff ) );
+      }
+
+      SECTION( "base64 padding is optional" )
+      {
+        CHECK( decode_base64( "Zm9vYg", base64_alphabet::standard ) == to_bytes( "foob" ) );
+        CHECK( decode_base64( "-_8=", base64_alphabet::url ) == std::vector< std::uint8_t >( { 0xfb, 0xff } ) );
+      }
+
+      SECTION( "invalid input yields exception" )
+      {
+        // the invalid character is placed in every position to hit the SIMD blocks as well as the tails
+        for ( size_t pos = 0; pos < 100; ++pos )
+        {
+          std::string hex( 100, 'a' );
+          hex[pos] = 'g';
+          CHECK_THROWS_AS( decode_hex( hex ), exception );
+
+          std::string base64( 100, 'A' );
+          base64[pos] = '*';
+          CHECK_THROWS_AS( decode_base64( base64, base64_alphabet::standard ), exception );
+
+          base64[pos] = '+';
+          CHECK_THROWS_AS( decode_base64( base64, base64_alphabet::url ), exception );
+        }
+
+        CHECK_THROWS_AS( decode_hex( "abc" ), exception );
+        CHECK_THROWS_AS( decode_base64( "Zm9vY", base64_alphabet::standard ), exception );
+        CHECK_THROWS_AS( decode_base64( "Zm9=Yg==", base64_alphabet::standard ), exception );
+        CHECK_THROWS_AS( decode_base64( "Zh==", base64_alphabet::standard ), exception );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "codec bulk variants" )
+    {
+      std::vector< std::string > inputs = { "a", "bc", "def" };
+      std::vector< digest > digests;
+      for ( const auto& input : inputs )
+        digests.push_back( get_digest( input.data(), input.size(), hash::type::sha1 ) );
+
+      SECTION( "hex" )
+      {
+        const size_t stride = 41;
+        std::string records( digests.size() * stride, '\n' );
+        hex_encode( digests.data(), digests.size(), &records[0], stride );
+
+        for ( size_t i = 0; i < inputs.size(); ++i )
+        {
+          CHECK( records.substr( i * stride, 40 ) == get_hash( inputs[i], hash::type::sha1 ).string );
+          CHECK( records[i * stride + 40] == '\n' );
+        }
+
+        std::vector< digest > decoded( digests.size() );
+        hex_decode( records.data(), stride, decoded.size(), hash::type::sha1, decoded.data() );
+        CHECK( decoded == digests );
+      }
+
+      SECTION( "base64" )
+      {
+        const size_t stride = base64_encoded_size( 20, base64_alphabet::url );
+        std::string records( digests.size() * stride, '\0' );
+        base64_encode( digests.data(), digests.size(), &records[0], stride, base64_alphabet::url );
+
+        std::vector< digest > decoded( digests.size() );
+        base64_decode(
+          records.data(), stride, decoded.size(), hash::type::sha1, decoded.data(), base64_alphabet::url );
+        CHECK( decoded == digests );
+      }
+    }
+
+  }  // namespace test
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,162 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <catch.hpp>
+
+#include <ctime>
+#include <memory>
+
+#include <crypto/digest_cache.h>
+#include <crypto/exception.h>
+
+#include "../helpers/test_helpers.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace test
+  {
+    namespace
+    {
+      //! write the file with a modification time long enough ago to be cached
+      void write_old_file( const temporary_directory& dir_,
+                           const std::string& name_,
+                           const std::string& content_ )
+      {
+        dir_.write( name_, content_ );
+        boost::filesystem::last_write_time( dir_.path() / name_, std::time( nullptr ) - 3600 );
+      }
+
+      //! change the content without changing the identity of the file
+      void corrupt_file( const temporary_directory& dir_,
+                         const std::string& name_,
+                         const std::string& content_ )
+      {
+        auto p = dir_.path() / name_;
+        auto mtime = boost::filesystem::last_write_time( p );
+        dir_.write( name_, content_ );
+        boost::filesystem::last_write_time( p, mtime );
+      }
+
+      void check_cache( const std::shared_ptr< digest_cache >& cache_, const temporary_directory& dir_ )
+      {
+        const std::string original = "the original content";
+        const std::string modified = "the modified content";
+        const auto path = ( dir_.path() / "file" ).string();
+
+        write_old_file( dir_, "file", original );
+
+        hash::config cfg;
+        cfg.digestCache = cache_;
+
+        // the first call hashes the file and stores the digest
+        REQUIRE( get_file_hash( path, hash::type::sha256, cfg ).string
+                 == get_hash( original, hash::type::sha256 ).string );
+
+        // the cached digest is returned without reading the file
+        corrupt_file( dir_, "file", modified );
+        auto h = get_file_hash( path, hash::type::sha256, cfg );
+        REQUIRE( h.string == get_hash( original, hash::type::sha256 ).string );
+        REQUIRE( h.inputSize == original.size() );
+
+        // other hash types have their own entries
+        REQUIRE( get_file_hash( path, hash::type::md5, cfg ).string
+                 == get_hash( modified, hash::type::md5 ).string );
+
+        // verifying detects the changed content and updates the cache
+        cfg.verifyCachedDigests = true;
+        REQUIRE_THROWS_AS( get_file_hash( path, hash::type::sha256, cfg ), exception );
+        cfg.verifyCachedDigests = false;
+        REQUIRE( get_file_hash( path, hash::type::sha256, cfg ).string
+                 == get_hash( modified, hash::type::sha256 ).string );
+
+        // a changed identity invalidates the entry
+        write_old_file( dir_, "file", "another content" );
+        REQUIRE( get_file_hash( path, hash::type::sha256, cfg ).string
+                 == get_hash( "another content", hash::type::sha256 ).string );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "attribute digest cache" )
+    {
+      temporary_directory dir;
+      check_cache( std::make_shared< attribute_digest_cache >(), dir );
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "sidecar digest cache" )
+    {
+      temporary_directory dir;
+      const auto databasePath = ( dir.path() / "cache.db" ).string();
+
+      SECTION( "caching" )
+      {
+        check_cache( std::make_shared< sidecar_digest_cache >( databasePath ), dir );
+      }
+
+      SECTION( "the database is persistent" )
+      {
+        write_old_file( dir, "file", "some content" );
+        const auto path = ( dir.path() / "file" ).string();
+
+        hash::config cfg;
+        {
+          auto cache = std::make_shared< sidecar_digest_cache >( databasePath );
+          cfg.digestCache = cache;
+          get_file_hash( path, hash::type::sha1, cfg );
+          REQUIRE( cache->size() == 1 );
+          cache->flush();
+        }
+
+        corrupt_file( dir, "file", "some changes" );
+
+        auto cache = std::make_shared< sidecar_digest_cache >( databasePath );
+        REQUIRE( cache->size() == 1 );
+
+        cfg.digestCache = cache;
+        REQUIRE( get_file_hash( path, hash::type::sha1, cfg ).string
+                 == get_hash( "some content", hash::type::sha1 ).string );
+      }
+
+      SECTION( "recently modified files aren't cached" )
+      {
+        dir.write( "file", "some content" );
+
+        auto cache = std::make_shared< sidecar_digest_cache >( databasePath );
+        hash::config cfg;
+        cfg.digestCache = cache;
+        get_file_hash( ( dir.path() / "file" ).string(), hash::type::sha1, cfg );
+        REQUIRE( cache->size() == 0 );
+      }
+
+      SECTION( "other files aren't accepted as database" )
+      {
+        dir.write( "not_a_database", "some content" );
+        REQUIRE_THROWS_AS( sidecar_digest_cache( ( dir.path() / "not_a_database" ).string() ), exception );
+      }
+    }
+  }  // namespace test
+}  // namespace crypto
+}  // namespace ll
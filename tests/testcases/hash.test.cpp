@@ -18,15 +18,30 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <ctime>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <future>
 #include <condition_variable>
 #include <random>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
 
 #include <crypto/hash.h>
+#include <crypto/basic_hash_generator.h>
+#include <crypto/digest_cache.h>
 #include <crypto/exception.h>
 
+#if !LL_IS_WINDOWS()
+#include <sys/uio.h>
+#endif
+
 #include "../helpers/test_helpers.h"
 
 
@@ -59,6 +74,27 @@ namespace crypto
     };
 
 
+    //! a cache without entries that appends to the file on every lookup, i.e. after get_file_hash stat'ed
+    //! the file and before it is hashed
+    class appending_digest_cache : public digest_cache
+    {
+    public:
+      explicit appending_digest_cache( const std::string& suffix_ ) : m_suffix( suffix_ ) {}
+
+      bool lookup( const std::string& path_, const file_identity&, hash::type, digest& ) override
+      {
+        boost::filesystem::ofstream file( path_, std::ios::out | std::ios::binary | std::ios::app );
+        file.write( m_suffix.data(), m_suffix.size() );
+        return false;
+      }
+
+      void store( const std::string&, const file_identity&, const digest& ) override {}
+
+    private:
+      std::string m_suffix;
+    };
+
+
     // -------------------------------------------------------------------------------------------------------
 
     TEST_CASE( "hash type conversion" )
@@ -71,6 +107,14 @@ namespace crypto
         CHECK( hash::type::sha256 == to_hash_type( "sHA-256" ) );
         CHECK( hash::type::sha384 == to_hash_type( "SHa-384" ) );
         CHECK( hash::type::sha512 == to_hash_type( "sha-512" ) );
+        CHECK( hash::type::blake3 == to_hash_type( "BLAKE3" ) );
+        CHECK( hash::type::sha3_256 == to_hash_type( "SHA3-256" ) );
+        CHECK( hash::type::sha3_512 == to_hash_type( "sha3-512" ) );
+        CHECK( hash::type::shake128 == to_hash_type( "SHAKE128" ) );
+        CHECK( hash::type::shake256 == to_hash_type( "shake256" ) );
+        CHECK( hash::type::crc32c == to_hash_type( "CRC32C" ) );
+        CHECK( hash::type::xxh3_64 == to_hash_type( "xxh3-64" ) );
+        CHECK( hash::type::xxh3_128 == to_hash_type( "XXH3-128" ) );
       }
 
 
@@ -92,6 +136,14 @@ namespace crypto
         CHECK( std::string( "sha-256" ) == to_string( hash::type::sha256 ) );
         CHECK( std::string( "sha-384" ) == to_string( hash::type::sha384 ) );
         CHECK( std::string( "sha-512" ) == to_string( hash::type::sha512 ) );
+        CHECK( std::string( "blake3" ) == to_string( hash::type::blake3 ) );
+        CHECK( std::string( "sha3-256" ) == to_string( hash::type::sha3_256 ) );
+        CHECK( std::string( "sha3-512" ) == to_string( hash::type::sha3_512 ) );
+        CHECK( std::string( "shake128" ) == to_string( hash::type::shake128 ) );
+        CHECK( std::string( "shake256" ) == to_string( hash::type::shake256 ) );
+        CHECK( std::string( "crc32c" ) == to_string( hash::type::crc32c ) );
+        CHECK( std::string( "xxh3-64" ) == to_string( hash::type::xxh3_64 ) );
+        CHECK( std::string( "xxh3-128" ) == to_string( hash::type::xxh3_128 ) );
       }
     }
 
@@ -127,6 +179,233 @@ namespace crypto
     }
 
     
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "hash_generator is reusable" )
+    {
+      std::string input1 = "this is a test string";
+      std::string input2 = "The test input";
+
+      hash_generator g( hash::type::sha256 );
+
+      SECTION( "after retrieve_hash" )
+      {
+        g.add_data( reinterpret_cast< const uint8_t* >( input1.data() ), input1.size() );
+        CHECK( get_hash( input1, hash::type::sha256 ).string == g.retrieve_hash().string );
+
+        g.reset();
+        g.add_data( reinterpret_cast< const uint8_t* >( input2.data() ), input2.size() );
+        auto h = g.retrieve_hash();
+        CHECK( get_hash( input2, hash::type::sha256 ).string == h.string );
+        CHECK( input2.size() == h.inputSize );
+      }
+
+
+      SECTION( "in the middle of a message" )
+      {
+        g.add_data( reinterpret_cast< const uint8_t* >( input1.data() ), input1.size() );
+        g.reset();
+        g.add_data( reinterpret_cast< const uint8_t* >( input2.data() ), input2.size() );
+        CHECK( get_hash( input2, hash::type::sha256 ).string == g.retrieve_hash().string );
+      }
+
+
+      SECTION( "repeated convenience calls yield identical results" )
+      {
+        for ( int i = 0; i < 3; ++i )
+        {
+          CHECK( "f6774519d1c7a3389ef327e9c04766b999db8cdfb85d1346c471ee86d65885bc"
+                 == get_hash( input1, hash::type::sha256 ).string );
+          CHECK( "486eb65274adb86441072afa1e2289f3" == get_hash( input1, hash::type::md5 ).string );
+        }
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "hash_generator ignores empty updates" )
+    {
+      std::string input = "this is a test string";
+
+      for ( auto type : { hash::type::md5,
+                          hash::type::sha1,
+                          hash::type::sha256,
+                          hash::type::sha512,
+                          hash::type::blake3,
+                          hash::type::sha3_256,
+                          hash::type::crc32c,
+                          hash::type::xxh3_64 } )
+      {
+        // before any data, with an incomplete block buffered and at the end
+        hash_generator g( type );
+        g.add_data( nullptr, 0 );
+        g.add_data( reinterpret_cast< const uint8_t* >( input.data() ), 5 );
+        g.add_data( nullptr, 0 );
+        g.add_data( reinterpret_cast< const uint8_t* >( input.data() ) + 5, input.size() - 5 );
+        g.add_data( nullptr, 0 );
+        CHECK( get_hash( input, type ).string == g.retrieve_hash().string );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "hash_generator is cloneable" )
+    {
+      std::string prefix( 1000, 'p' );  // spans several compression blocks
+      std::vector< std::string > suffixes = { "", "a", "some longer suffix", std::string( 300, 's' ) };
+
+      std::vector< hash::type > hashTypes = {
+        hash::type::md4,
+        hash::type::md5,
+        hash::type::sha1,
+        hash::type::sha256,
+        hash::type::sha384,
+        hash::type::sha512,
+        hash::type::blake3,
+        hash::type::sha3_256,
+        hash::type::sha3_512,
+        hash::type::shake128,
+        hash::type::shake256,
+        hash::type::crc32c,
+        hash::type::xxh3_64,
+        hash::type::xxh3_128
+      };
+
+      for ( auto type : hashTypes )
+      {
+        hash_generator g( type );
+        g.add_data( reinterpret_cast< const uint8_t* >( prefix.data() ), prefix.size() );
+
+        for ( const auto& suffix : suffixes )
+        {
+          auto fork = g.clone();
+          fork.add_data( reinterpret_cast< const uint8_t* >( suffix.data() ), suffix.size() );
+          auto h = fork.retrieve_hash();
+          CHECK( get_hash( prefix + suffix, type ).string == h.string );
+          CHECK( prefix.size() + suffix.size() == h.inputSize );
+        }
+
+        // the original is not affected by its clones
+        CHECK( get_hash( prefix, type ).string == g.retrieve_hash().string );
+
+        // a clone of a finalized generator is finalized as well
+        auto finalized = g.clone();
+        CHECK_THROWS_AS( finalized.retrieve_hash(), exception );
+        finalized.reset();
+        CHECK( get_hash( "", type ).string == finalized.retrieve_hash().string );
+      }
+
+      SECTION( "basic_hash_generator is copyable" )
+      {
+        basic_hash_generator< hash::type::sha256 > g;
+        g.add_data( reinterpret_cast< const uint8_t* >( prefix.data() ), prefix.size() );
+
+        auto copy = g;
+        copy.add_data( reinterpret_cast< const uint8_t* >( suffixes[2].data() ), suffixes[2].size() );
+        CHECK( get_hash( prefix + suffixes[2], hash::type::sha256 ).string == copy.retrieve_hash().string );
+
+        copy = g;
+        CHECK( get_hash( prefix, hash::type::sha256 ).string == copy.retrieve_hash().string );
+        CHECK( get_hash( prefix, hash::type::sha256 ).string == g.retrieve_hash().string );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "hash_generator state can be exported and imported" )
+    {
+      std::string input( 1000, 'x' );
+      for ( size_t i = 0; i < input.size(); ++i )
+        input[i] = static_cast< char >( 'a' + i % 26 );
+
+      // the EVP contexts are opaque
+      std::vector< hash::type > hashTypes = {
+#if !LL_CRYPTO_OPENSSL_EVP
+        hash::type::md4,
+        hash::type::md5,
+#endif
+        hash::type::sha1,
+        hash::type::sha256,
+        hash::type::sha384,
+        hash::type::sha512,
+        hash::type::blake3,
+        hash::type::sha3_256,
+        hash::type::sha3_512,
+        hash::type::shake128,
+        hash::type::shake256,
+        hash::type::crc32c,
+        hash::type::xxh3_64,
+        hash::type::xxh3_128
+      };
+
+      // split positions around the block boundaries of all hash types
+      std::vector< size_t > splits = { 0, 1, 63, 64, 65, 127, 128, 129, 999 };
+
+      for ( auto type : hashTypes )
+      {
+        for ( auto split : splits )
+        {
+          hash_generator g( type );
+          g.add_data( reinterpret_cast< const uint8_t* >( input.data() ), split );
+          auto state = g.export_state();
+
+          REQUIRE( state.size() >= 14 );
+          CHECK( std::string( state.begin(), state.begin() + 4 ) == "LLHS" );
+          CHECK( state[4] == 1 );
+          CHECK( state[5] == static_cast< std::uint8_t >( type ) );
+
+          auto resumed = hash_generator::from_state( state.data(), state.size() );
+          resumed.add_data( reinterpret_cast< const uint8_t* >( input.data() ) + split, input.size() - split );
+          auto h = resumed.retrieve_hash();
+          CHECK( get_hash( input, type ).string == h.string );
+          CHECK( input.size() == h.inputSize );
+
+          // the exporting generator continues unchanged
+          g.add_data( reinterpret_cast< const uint8_t* >( input.data() ) + split, input.size() - split );
+          CHECK( get_hash( input, type ).string == g.retrieve_hash().string );
+        }
+      }
+
+#if LL_CRYPTO_OPENSSL_EVP
+      SECTION( "the EVP backend can't export md4 / md5" )
+      {
+        for ( auto type : { hash::type::md4, hash::type::md5 } )
+        {
+          hash_generator g( type );
+          CHECK_THROWS_AS( g.export_state(), exception );
+        }
+      }
+#endif
+
+      SECTION( "invalid states yield exception" )
+      {
+        hash_generator g( hash::type::sha256 );
+        g.add_data( reinterpret_cast< const uint8_t* >( input.data() ), 100 );
+        auto state = g.export_state();
+
+        hash_generator other( hash::type::sha1 );
+        CHECK_THROWS_AS( other.import_state( state.data(), state.size() ), exception );
+
+        CHECK_THROWS_AS( hash_generator::from_state( state.data(), 10 ), exception );
+        CHECK_THROWS_AS( hash_generator::from_state( state.data(), state.size() - 1 ), exception );
+
+        auto corrupted = state;
+        corrupted[0] = 'X';
+        CHECK_THROWS_AS( hash_generator::from_state( corrupted.data(), corrupted.size() ), exception );
+
+        corrupted = state;
+        corrupted[4] = 2;
+        CHECK_THROWS_AS( hash_generator::from_state( corrupted.data(), corrupted.size() ), exception );
+
+        g.retrieve_hash();
+        CHECK_THROWS_AS( g.export_state(), exception );
+      }
+    }
+
+
     // -------------------------------------------------------------------------------------------------------
 
     TEST_CASE( "hash_generator calculates correct hashes" )
@@ -143,7 +422,19 @@ namespace crypto
           { hash::type::sha256, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
           { hash::type::sha512,
           "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d"
-          "85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e" } 
+          "85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e" },
+          { hash::type::blake3, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+          { hash::type::sha3_256, "a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a" },
+          { hash::type::sha3_512,
+          "a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a615b2123af1"
+          "f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26" },
+          { hash::type::shake128, "7f9c2ba4e88f827d616045507605853ed73b8093f6efbc88eb1a6eacfa66ef26" },
+          { hash::type::shake256,
+          "46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762fd75dc4ddd8"
+          "c0f200cb05019d67b592f6fc821c49479ab48640292eacb3b7c4be" },
+          { hash::type::crc32c, "00000000" },
+          { hash::type::xxh3_64, "2d06800538d394c2" },
+          { hash::type::xxh3_128, "99aa06d3014798d86001c324468d497f" }
         };
 
         for ( const auto& hash : expectedHashes )
@@ -173,7 +464,18 @@ namespace crypto
           "82120b97f0dfa49ec5680c" },
           { hash::type::sha512,
           "c240dd0b1a9b00c2478ab95f2184c81d0f3f923a751c71e61af36bb34fe9f240399ca3af2f"
-          "061cbc1da2535ce93f6bcedead90cad16f14346cd34f394ee02f5e" } 
+          "061cbc1da2535ce93f6bcedead90cad16f14346cd34f394ee02f5e" },
+          { hash::type::sha3_256, "089821bd4d4049424ac9db4434884910316e6322db77f6056a2e7bcdfb443af7" },
+          { hash::type::sha3_512,
+          "a88e43eb3b3627f9864679ece6b613497caa2f55f5efa309fe02e964b7ead7722e1bba710e"
+          "d746d89962f84636c21a9a2a02a6c89d1fd99f9ac6a6fef7e6a32a" },
+          { hash::type::shake128, "44582fe7cd8856595679a75f0c24196c98787502db39dbc32ec2fbea154b307d" },
+          { hash::type::shake256,
+          "925fe521cf2ad3734bdc1d49b7cb8e952f03d44f52ba9e65d6c55c914fea3978195c0f3b8c"
+          "bd0946571aa6165d0d2d499501e8853c2e53c721f3e1196d3f061f" },
+          { hash::type::crc32c, "2dc2806a" },
+          { hash::type::xxh3_64, "e659e75d623a5afd" },
+          { hash::type::xxh3_128, "d4345bd70277874f029b56a0dfd114d7" }
         };
 
         for ( const auto& hash : expectedHashes )
@@ -205,7 +507,19 @@ namespace crypto
           "353d588b875f69740d481d" },
           { hash::type::sha512,
           "b8c65ff5961e47d09d23bb055092aa56bb30e45bd1399227d66bdfb2b5b22f02725841479e"
-          "7e540738ab5a7c4622c94eb7a13d83056a10231f1df7641462321b" }
+          "7e540738ab5a7c4622c94eb7a13d83056a10231f1df7641462321b" },
+          { hash::type::blake3, "eeaee5504346f5f1de93a91f66826031657d6b695fdf0391e18575d11a8671f3" },
+          { hash::type::sha3_256, "8837ac6fd5933c0a532a6cc5dd7454ec68a814ff9a19697b147833492b5cc178" },
+          { hash::type::sha3_512,
+          "cc155d9f16df4f1b1bcbc8ed4d726a9927a495650e733899a7c6057f9ddb97a8b54a62286b"
+          "147e985a9cef75307dee552da7fdb36bb723fb18a0be74b64bee30" },
+          { hash::type::shake128, "6a41d72a073d1d5a7c5fc0b540baead3c430aed8e37a44fcd92dca33ff2122d7" },
+          { hash::type::shake256,
+          "ad1e110638475aaa418d5bfdb774e97b027ee1c2e2998c44030f8a5089d74e9a5173d7dd07"
+          "bb7d0aff29adae4c6747c105c60aa4e6153f695f2d960d282c7090" },
+          { hash::type::crc32c, "8c34d275" },
+          { hash::type::xxh3_64, "c157e2f61a85f054" },
+          { hash::type::xxh3_128, "e4720c25c19350d7c157e2f61a85f054" }
         };
 
         for ( const auto& hash : expectedHashes )
@@ -261,6 +575,120 @@ namespace crypto
       }
 
 
+      SECTION( "stream input with read-ahead" )
+      {
+        auto p = get_executable_path();
+        p /= "/data/test.jpg";
+
+        std::string expected = "f7de7129fed4c37eb0c74e56d760e9ca69831f84ab0b6f919310ba86b6ab6045";
+
+        for ( size_t numBuffers : { 1, 2, 4, 16 } )
+        {
+          boost::filesystem::ifstream input( p, std::ios::in | std::ios::binary );
+
+          REQUIRE( input.is_open() );
+
+          hash::config cfg;
+          cfg.processingBlockSize = randomBlockSize.get();
+          cfg.numReadAheadBuffers = numBuffers;
+
+          auto result = get_hash( input, hash::type::sha256, cfg );
+
+          CHECK( expected == result.string );
+          CHECK( 3184393 == result.inputSize );
+        }
+      }
+
+
+      SECTION( "file input" )
+      {
+        auto p = get_executable_path();
+        p /= "/data/test.jpg";
+
+        std::uint64_t expectedFileSize = 3184393;
+
+        std::map< hash::type, std::string > expectedHashes = {
+          { hash::type::md4, "650bf7c77fe3e65ab81c79e4d8ae42fd" },
+          { hash::type::md5, "858760a184d74dec43cb6a5eee5bb551" },
+          { hash::type::sha1, "8e76eebc245103a1da51a9a32b5a9fb99d206b33" },
+          { hash::type::sha256, "f7de7129fed4c37eb0c74e56d760e9ca69831f84ab0b6f919310ba86b6ab6045" },
+          { hash::type::sha384,
+          "e08eaa014a5c5d5830086815d119a1f0fd8a3356cd19b9efff6139c04047008e88de0e085d"
+          "be8db1ed462ff0f634a1db" },
+          { hash::type::sha512,
+          "4dcf8be1d491844ca2267756bf70881d288e005a578efd1232cfba7eb65cab84d277e7c2ac"
+          "4c4429698ea0a3e900c42356822e997579e0668a84da8295ce141a" } 
+        };
+
+        for ( const auto& hash : expectedHashes )
+        {
+          hash::config cfg;
+          cfg.processingBlockSize = randomBlockSize.get();
+
+          auto result = get_file_hash( p.string(), hash.first, cfg );
+
+          CHECK( hash.first == result.hashType );
+          CHECK( hash.second == result.string );
+          CHECK( expectedFileSize == result.inputSize );
+        }
+      }
+
+
+#if LL_IS_LINUX()
+      SECTION( "non-mappable file input" )
+      {
+        std::ifstream stream( "/proc/self/cmdline", std::ios::in | std::ios::binary );
+        REQUIRE( stream.is_open() );
+
+        auto expected = get_hash( stream, hash::type::sha256 );
+        auto result = get_file_hash( "/proc/self/cmdline", hash::type::sha256 );
+
+        CHECK( expected.string == result.string );
+        CHECK( expected.inputSize == result.inputSize );
+        CHECK( 0 < result.inputSize );
+      }
+#endif
+
+
+      SECTION( "mapped file input" )
+      {
+        // files modified within the last seconds are read, so the file is backdated to be mapped
+        temporary_directory dir;
+        const auto content = std::string( 300000, 'x' ) + "the end";
+        dir.write( "file", content );
+        boost::filesystem::last_write_time( dir.path() / "file", std::time( nullptr ) - 3600 );
+
+        for ( bool mapFiles : { true, false } )
+        {
+          hash::config cfg;
+          cfg.processingBlockSize = randomBlockSize.get();
+          cfg.mapFiles = mapFiles;
+
+          auto result = get_file_hash( ( dir.path() / "file" ).string(), hash::type::sha256, cfg );
+          CHECK( get_hash( content, hash::type::sha256 ).string == result.string );
+          CHECK( content.size() == result.inputSize );
+        }
+      }
+
+
+      SECTION( "a file changed while it is mapped is read again" )
+      {
+        temporary_directory dir;
+        const auto content = std::string( 300000, 'x' );
+        const std::string suffix = "appended while hashing";
+        dir.write( "file", content );
+        boost::filesystem::last_write_time( dir.path() / "file", std::time( nullptr ) - 3600 );
+
+        // the mapping covers the size before the append, only reading the file again sees the suffix
+        hash::config cfg;
+        cfg.digestCache = std::make_shared< appending_digest_cache >( suffix );
+
+        auto result = get_file_hash( ( dir.path() / "file" ).string(), hash::type::sha256, cfg );
+        CHECK( get_hash( content + suffix, hash::type::sha256 ).string == result.string );
+        CHECK( content.size() + suffix.size() == result.inputSize );
+      }
+
+
       SECTION( "different string casing" )
       {
         std::string input1 = "the test input";
@@ -272,7 +700,15 @@ namespace crypto
           hash::type::sha1,
           hash::type::sha256,
           hash::type::sha384,
-          hash::type::sha512
+          hash::type::sha512,
+          hash::type::blake3,
+          hash::type::sha3_256,
+          hash::type::sha3_512,
+          hash::type::shake128,
+          hash::type::shake256,
+          hash::type::crc32c,
+          hash::type::xxh3_64,
+          hash::type::xxh3_128
         }; 
         
         for ( auto type : hashTypes )
@@ -286,6 +722,806 @@ namespace crypto
     }
 
    
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "automatic processing block size" )
+    {
+      std::vector< std::uint8_t > input( 3 * 1024 * 1024 + 4321 );
+      for ( size_t i = 0; i < input.size(); ++i )
+        input[i] = static_cast< std::uint8_t >( ( i * 7 ) % 253 );
+
+      std::vector< hash::type > hashTypes
+        = { hash::type::md5, hash::type::sha256, hash::type::blake3, hash::type::xxh3_64 };
+
+      auto checkSizes = [&]() {
+        for ( auto type : hashTypes )
+        {
+          auto streamSize = get_processing_block_size( type, hash::source::stream );
+          CHECK( 0 == streamSize % 4096 );
+          CHECK( streamSize >= 64 * 1024 );
+          CHECK( streamSize <= 4 * 1024 * 1024 );
+          CHECK( get_processing_block_size( type, hash::source::memory ) >= streamSize );
+        }
+      };
+
+      auto checkHashes = [&]() {
+        hash::config explicitCfg;
+        explicitCfg.processingBlockSize = 100000;
+
+        for ( auto type : hashTypes )
+        {
+          auto expected = get_hash( input.data(), input.size(), type, explicitCfg ).string;
+          CHECK( expected == get_hash( input.data(), input.size(), type ).string );
+
+          std::string data( input.begin(), input.end() );
+          std::istringstream stream( data );
+          CHECK( expected == get_hash( stream, type ).string );
+
+          hash::config readAheadCfg;
+          readAheadCfg.numReadAheadBuffers = 2;
+          std::istringstream readAheadStream( data );
+          CHECK( expected == get_hash( readAheadStream, type, readAheadCfg ).string );
+        }
+      };
+
+      SECTION( "the default is the automatic size" )
+      {
+        CHECK( hash::config::autoBlockSize == hash::config().processingBlockSize );
+      }
+
+      SECTION( "explicit sizes are used as they are" )
+      {
+        hash::config cfg;
+        cfg.processingBlockSize = 5;
+        CHECK( 5 == get_processing_block_size( hash::type::sha256, hash::source::stream, cfg ) );
+        CHECK( 5 == get_processing_block_size( hash::type::sha256, hash::source::memory, cfg ) );
+      }
+
+      SECTION( "derived from the cache geometry" )
+      {
+        checkSizes();
+        checkHashes();
+      }
+
+      SECTION( "calibrated" )
+      {
+        calibrate_processing_block_size();
+        checkSizes();
+        checkHashes();
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    template < hash::type type_ >
+    hash get_basic_hash( const std::string& input_, size_t blockSize_ )
+    {
+      basic_hash_generator< type_ > g;
+      auto pData = reinterpret_cast< const std::uint8_t* >( input_.data() );
+      for ( size_t offset = 0; offset < input_.size(); offset += blockSize_ )
+        g.add_data( pData + offset, std::min( blockSize_, input_.size() - offset ) );
+      return g.retrieve_hash();
+    }
+
+
+    TEST_CASE( "basic_hash_generator matches hash_generator" )
+    {
+      random_block_size randomBlockSize;
+
+      std::string input =
+#include "../data/test.string"
+      ;
+
+      auto blockSize = randomBlockSize.get();
+
+      CHECK( get_hash( input, hash::type::md4 ).string
+             == get_basic_hash< hash::type::md4 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::md5 ).string
+             == get_basic_hash< hash::type::md5 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::sha1 ).string
+             == get_basic_hash< hash::type::sha1 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::sha256 ).string
+             == get_basic_hash< hash::type::sha256 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::sha384 ).string
+             == get_basic_hash< hash::type::sha384 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::sha512 ).string
+             == get_basic_hash< hash::type::sha512 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::blake3 ).string
+             == get_basic_hash< hash::type::blake3 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::sha3_256 ).string
+             == get_basic_hash< hash::type::sha3_256 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::shake256 ).string
+             == get_basic_hash< hash::type::shake256 >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::crc32c ).string
+             == get_basic_hash< hash::type::crc32c >( input, blockSize ).string );
+      CHECK( get_hash( input, hash::type::xxh3_128 ).string
+             == get_basic_hash< hash::type::xxh3_128 >( input, blockSize ).string );
+
+      SECTION( "retrieve_digest writes the binary digest" )
+      {
+        basic_hash_generator< hash::type::sha256 > g;
+        g.add_data( reinterpret_cast< const std::uint8_t* >( input.data() ), input.size() );
+        CHECK( input.size() == g.input_size() );
+
+        std::uint8_t digest[basic_hash_generator< hash::type::sha256 >::digestSize];
+        g.retrieve_digest( digest );
+        CHECK( get_hash( input, hash::type::sha256 ).binary
+               == std::vector< std::uint8_t >( digest, digest + sizeof( digest ) ) );
+
+        CHECK_THROWS_AS( g.retrieve_digest( digest ), exception );
+        CHECK_THROWS_AS( g.add_data( digest, sizeof( digest ) ), exception );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "sha-1 and sha-2 match the reference at block boundaries" )
+    {
+      SECTION( "one-shot and streamed inputs" )
+      {
+        // the length is padded into the same block up to 55 (111) bytes, 1000 bytes take the vector kernels
+        // that expand the schedules of 8 (4) blocks at once plus the remainder
+        std::vector< std::tuple< size_t, hash::type, std::string > > vectors = {
+          std::make_tuple( 55, hash::type::sha1, "8ae2d46729cfe68ff927af5eec9c7d1b66d65ac2" ),
+          std::make_tuple( 55, hash::type::sha256,
+                           "463eb28e72f82e0a96c0a4cc53690c571281131f672aa229e0d45ae59b598b59" ),
+          std::make_tuple( 55, hash::type::sha384,
+                           "dcedb6b590edb4efa849c801e6b6490657a5c1e64f69269f"
+                           "5f63c9267f6223de24cea7aaa6b267d9bcecc15147b6c875" ),
+          std::make_tuple( 55, hash::type::sha512,
+                           "6856647f269c2ee3d8128f0b25427659d880641ef343300dd3cd4679168f58d6"
+                           "527fda70b4ebc854e2065e172b7d58c1536992c0810599259ba84a2b40c65414" ),
+          std::make_tuple( 56, hash::type::sha1, "636e2ec698dac903498e648bd2f3af641d3c88cb" ),
+          std::make_tuple( 56, hash::type::sha256,
+                           "da2ae4d6b36748f2a318f23e7ab1dfdf45acdc9d049bd80e59de82a60895f562" ),
+          std::make_tuple( 56, hash::type::sha384,
+                           "7b9132d597b8873ad55bbc30f18ed3f2c9f340e7de69fb57"
+                           "74056c71a06d9bc2b14137e9e1c68b6b645fed28b188249d" ),
+          std::make_tuple( 56, hash::type::sha512,
+                           "8b12b2f6fe400a51d29656e2b8c42a1bbfe6fcf3e425da430db05d1a2dda1479"
+                           "0dee20fa8b22d8762afffe4988a5c98a4430d22a17e41e23d90fa61ab75671a9" ),
+          std::make_tuple( 64, hash::type::sha1, "c6138d514ffa2135bfce0ed0b8fac65669917ec7" ),
+          std::make_tuple( 64, hash::type::sha256,
+                           "fdeab9acf3710362bd2658cdc9a29e8f9c757fcf9811603a8c447cd1d9151108" ),
+          std::make_tuple( 64, hash::type::sha384,
+                           "9f2c9eb7116b3d7a4ba84a74a4d4eff8a5efcf54b6d7b662"
+                           "693c38577914c73a214766f0a175339bb0895a863824fc0a" ),
+          std::make_tuple( 64, hash::type::sha512,
+                           "ee4320ebaf3fdb4f2c832b137200c08e235e0fa7bbd0eb1740c7063ba8a0d151"
+                           "da77e003398e1714a955d475b05e3e950b639503b452ec185de4229bc4873949" ),
+          std::make_tuple( 112, hash::type::sha1, "e4ce142d09a84a8645338dd6535cbfaaf800d320" ),
+          std::make_tuple( 112, hash::type::sha256,
+                           "09373f127d34e61dbbaa8bc4499c87074f2ddb10e1b465f506d7d70a15011979" ),
+          std::make_tuple( 112, hash::type::sha384,
+                           "33ba080ec0ccb378e4e95fed3b26c23aa1a280476e007519"
+                           "ee47f60cd9c5c8a65d627259a9aa2fd33ca06d3c14ee5548" ),
+          std::make_tuple( 112, hash::type::sha512,
+                           "c5fbd731d19d2ae1180f001be72c2c1aaba1d7b094b3748880e24593b8e117a7"
+                           "50e11c1bd867cc2f96dace8c8b74abd2d5c4f236be444e77d30d1916174070b9" ),
+          std::make_tuple( 128, hash::type::sha1, "e6434bc401f98603d7eda504790c98c67385d535" ),
+          std::make_tuple( 128, hash::type::sha256,
+                           "471fb943aa23c511f6f72f8d1652d9c880cfa392ad80503120547703e56a2be5" ),
+          std::make_tuple( 128, hash::type::sha384,
+                           "ca2385773319124534111a36d0581fc3f00815e907034b90"
+                           "cff9c3a861e126a741d5dfcff65a417b6d7296863ac0ec17" ),
+          std::make_tuple( 128, hash::type::sha512,
+                           "1dffd5e3adb71d45d2245939665521ae001a317a03720a45732ba1900ca3b835"
+                           "1fc5c9b4ca513eba6f80bc7b1d1fdad4abd13491cb824d61b08d8c0e1561b3f7" ),
+          std::make_tuple( 1000, hash::type::sha1, "c9c960a0b925474fab83942cc27d504fc24ac37b" ),
+          std::make_tuple( 1000, hash::type::sha256,
+                           "4e4c294b331f7a2099a379bec34b9f9fc03dc46ab465d998f4d683da53487e6d" ),
+          std::make_tuple( 1000, hash::type::sha384,
+                           "7a2f8c7f12344964a13cb9260492b845e56615d6152b9eb9"
+                           "e54b580fc88405e64f31813bfda10de2a642fdf1676c61b4" ),
+          std::make_tuple( 1000, hash::type::sha512,
+                           "5096498d96f50f9a137c4db5b8b0cd38383ad55350fb5a98805fedc31fa1262f"
+                           "1f0cf4d6f12d7ecd8dedd933a4c9126344fe22e937a8ad35fdeae1e876ae698b" ),
+          std::make_tuple( 100000, hash::type::sha1, "23a1065a0f6a485119049bf2799179dd0154efbb" ),
+          std::make_tuple( 100000, hash::type::sha256,
+                           "cd2df694e424bc7968cc37f47751019e5ca0cd1bdf2e479ea537c3a1c32ee1aa" ),
+          std::make_tuple( 100000, hash::type::sha384,
+                           "733e508f6f8e154f52b87add09a5b732df33fb64e82704ba"
+                           "62f20ecedf03faa1d73bd72e17b2b42a7265ba2223b026ce" ),
+          std::make_tuple( 100000, hash::type::sha512,
+                           "9a63314a71907982aa89ca2dfd6e22b5c5a436df3a7b55f93785d7f7971324a3"
+                           "fd500ae72e066a5367b1f2d407a820503c6e2f13df5885f83a49aedb0706db84" )
+        };
+
+        // every kernel usable on this cpu, the default one is selected again at the end
+        for ( const auto& v : vectors )
+        {
+          auto input = make_test_input( std::get< 0 >( v ) );
+          auto implementations = get_implementations( std::get< 1 >( v ) );
+          for ( const auto& implementation : implementations )
+          {
+            INFO( implementation );
+            set_implementation( std::get< 1 >( v ), implementation );
+            CHECK( implementation == get_implementation( std::get< 1 >( v ) ) );
+            CHECK( std::get< 2 >( v ) == get_hash( input.data(), input.size(), std::get< 1 >( v ) ).string );
+
+            for ( size_t chunkSize : { size_t( 1 ), size_t( 63 ), size_t( 257 ) } )
+            {
+              hash_generator g( std::get< 1 >( v ) );
+              for ( size_t pos = 0; pos < input.size(); pos += chunkSize )
+                g.add_data( input.data() + pos, std::min( chunkSize, input.size() - pos ) );
+              CHECK( std::get< 2 >( v ) == g.retrieve_hash().string );
+            }
+          }
+          set_implementation( std::get< 1 >( v ), implementations.front() );
+        }
+      }
+
+      SECTION( "the implementation can be forced" )
+      {
+        CHECK_THROWS_AS( set_implementation( hash::type::sha256, "unknown" ), exception );
+        CHECK_THROWS_AS( set_implementation( hash::type::blake3, "unknown" ), exception );
+        CHECK_NOTHROW( set_implementation( hash::type::blake3, get_implementation( hash::type::blake3 ) ) );
+        CHECK( std::vector< std::string >( 1, get_implementation( hash::type::md5 ) )
+               == get_implementations( hash::type::md5 ) );
+      }
+
+      SECTION( "the implementation is reported" )
+      {
+        for ( auto type : { hash::type::sha1, hash::type::sha256, hash::type::sha384, hash::type::sha512 } )
+          CHECK_FALSE( get_implementation( type ).empty() );
+        CHECK_FALSE( get_implementation( hash::type::blake3 ).empty() );
+        CHECK_FALSE( get_implementation( hash::type::md5 ).empty() );
+        CHECK_THROWS_AS( get_implementation( hash::type::unknown ), exception );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "blake3 matches the reference test vectors" )
+    {
+      // the input of the official test vectors: a repeating sequence of the bytes 0 to 250
+      std::vector< std::pair< size_t, std::string > > vectors = {
+          { 0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+          { 1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213" },
+          { 63, "e9bc37a594daad83be9470df7f7b3798297c3d834ce80ba85d6e207627b7db7b" },
+          { 64, "4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98" },
+          { 65, "de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee" },
+          { 1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11" },
+          { 1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+          { 1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+          { 2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a" },
+          { 2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030" },
+          { 3072, "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2" },
+          { 3073, "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3" },
+          { 4096, "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969" },
+          { 4097, "9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb995" },
+          { 5120, "9cadc15fed8b5d854562b26a9536d9707cadeda9b143978f319ab34230535833" },
+          { 5121, "628bd2cb2004694adaab7bbd778a25df25c47b9d4155a55f8fbd79f2fe154cff" },
+          { 6144, "3e2e5b74e048f3add6d21faab3f83aa44d3b2278afb83b80b3c35164ebeca205" },
+          { 6145, "f1323a8631446cc50536a9f705ee5cb619424d46887f3c376c695b70e0f0507f" },
+          { 7168, "61da957ec2499a95d6b8023e2b0e604ec7f6b50e80a9678b89d2628e99ada77a" },
+          { 7169, "a003fc7a51754a9b3c7fae0367ab3d782dccf28855a03d435f8cfe74605e7817" },
+          { 8192, "aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63" },
+          { 8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b" },
+          { 16384, "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4" },
+          { 31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47" },
+          { 102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" },
+          { 1048576, "74cb441fd087764ca9c3694da742ebe30cbeb3060a17009ca81825c7a8d10343" },
+          { 3146962, "010ba054cb4685d0f81f4c3f3b2c6e86c007175ebef63676b21ec982b0dfd0d5" }
+      };
+
+      random_block_size randomBlockSize;
+
+      for ( const auto& v : vectors )
+      {
+        auto input = make_test_input( v.first );
+
+        hash::config cfg;
+        cfg.processingBlockSize = randomBlockSize.get();
+        CHECK( v.second == get_hash( input.data(), input.size(), hash::type::blake3, cfg ).string );
+
+        // the subtrees are hashed on several threads
+        cfg.numHashThreads = 4;
+        CHECK( v.second == get_hash( input.data(), input.size(), hash::type::blake3, cfg ).string );
+        CHECK( v.second
+               == to_string( get_digest( input.data(), input.size(), hash::type::blake3, cfg ) ) );
+
+        // chunk sized pieces take the subtree path of the incremental hasher
+        hash_generator g( hash::type::blake3 );
+        for ( size_t offset = 0; offset < input.size(); offset += 4096 )
+          g.add_data( input.data() + offset, std::min< size_t >( 4096, input.size() - offset ) );
+        CHECK( v.second == g.retrieve_hash().string );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "sha-3 and shake match the reference implementation" )
+    {
+      SECTION( "inputs around the block boundaries" )
+      {
+        // the block size (rate) is 136 bytes for sha3-256 and shake256, 72 for sha3-512, 168 for shake128
+        std::vector< std::tuple< hash::type, size_t, std::string > > vectors = {
+          std::make_tuple( hash::type::sha3_256, 135,
+            "fded8fd9d6551c601eeb3b7c6bc5e5cfd8aad1d015b7e9aaa9c9b9475231d5e2" ),
+          std::make_tuple( hash::type::sha3_256, 136,
+            "cf3ccff92480a29160c2d38317c430e14749bfee1788106957dfe73f8c4930e5" ),
+          std::make_tuple( hash::type::sha3_256, 137,
+            "ce9d7dc90913ee5d92745019479a5352c6d6279bef18ed07dc0a83ee8084daca" ),
+          std::make_tuple( hash::type::sha3_256, 413,
+            "c896396cd97de6c51485537384fc93bf72d067674a45dacea27097b1e989efe1" ),
+          std::make_tuple( hash::type::sha3_512, 71,
+            "3ccc850d53a1287af7b4560b2ef0d43eb5d9a80d62a0e9cf1dbc040135921104d4395168e9"
+            "0bfc871773ebb34bca1bd67056e1cc7dc7a48ff7c3167d389f117c" ),
+          std::make_tuple( hash::type::sha3_512, 72,
+            "5d63f2bbe971a983ac6847480106e4e1264ee3a0befd79954914e1d86e795b2e18238f12fc"
+            "5e46cb9cc78efdec610a93647cc04e1c23d8caaa6a58c21dd26c07" ),
+          std::make_tuple( hash::type::sha3_512, 73,
+            "921d9b7b2b0f3066a1646dbb058c979cb3925dec0f8c269faaa7f9648e73465ae55ec52725"
+            "7d5d5e1cfdbf5d6799bea1004b6186f5108c74e3b92fe924166558" ),
+          std::make_tuple( hash::type::sha3_512, 221,
+            "732a6f8a8cf3067e35869dd05e63aec915f8497bb3f61a1d2a9098bb77ce9f9de7fac95247"
+            "0dc6fe2862d0e5c5c976d2e33f27c07bfc6e9f1c283cbfa31511fc" ),
+          std::make_tuple( hash::type::shake128, 167,
+            "1e552791cc4e93a0d4a8dc47ae49228c2faa869e40e628f6ace477aec3f1ca7a" ),
+          std::make_tuple( hash::type::shake128, 168,
+            "f15277eb61c4908d44a2853f3cde071ae2ed7a23461fbe162a1a98cf6875059c" ),
+          std::make_tuple( hash::type::shake128, 169,
+            "015be3338c986d9846affa0f94b4afc2a76bc289c709e1a596ec9eccf090a773" ),
+          std::make_tuple( hash::type::shake128, 509,
+            "b12a08af8e2d43b45244f4a41b6d2c9947ef41e8401f2798a1e8321620bf65b6" ),
+          std::make_tuple( hash::type::shake256, 135,
+            "c45dae624ad8a2f5aa7bac9d7557737fd91c96eedb70a6be5574d57a844eade07f4056bf08"
+            "1a1098101cea8132188c422136feb4687d1e2209f3fd28bedfb8f4" ),
+          std::make_tuple( hash::type::shake256, 136,
+            "b7ff4073b3f5a8eabd6e17705ca7f6761a31058f9df781a6a47e3a3063b9d67a757e8dbf04"
+            "3dac48d2154e46d59c0b9e8bc36ba035153691fbe83b9eff5dae4a" ),
+          std::make_tuple( hash::type::shake256, 137,
+            "01d90952c642a5eb2a8fc9d713f843a45d7ac05132dddcb2efc9bebc27e37bcbe42130c36f"
+            "3540250ab11796980e773683f28d07f0f838606fb9c45e452bd38f" ),
+          std::make_tuple( hash::type::shake256, 413,
+            "d018f78a0b74e9b159d858ea1604a090b5698cac23ca106d4c4ffc6acff7e76b8511e65c8e"
+            "e1a044492af0fb06fdf0494cd1896ea138e6d0734808ee2bd14636" )
+        };
+
+        for ( const auto& v : vectors )
+        {
+          auto input = make_test_input( std::get< 1 >( v ) );
+          CHECK( std::get< 2 >( v ) == get_hash( input.data(), input.size(), std::get< 0 >( v ) ).string );
+
+          // bytewise input fills the block through the partial block path
+          hash_generator g( std::get< 0 >( v ) );
+          for ( auto b : input )
+            g.add_data( &b, 1 );
+          CHECK( std::get< 2 >( v ) == g.retrieve_hash().string );
+        }
+      }
+
+      SECTION( "shake output of arbitrary size" )
+      {
+        auto input = make_test_input( 1000 );
+
+        // outputs longer than the rate are squeezed in several blocks
+        std::vector< std::pair< hash::type, std::string > > outputTails = {
+          { hash::type::shake128, "8ff8113ab877a67ca318aedccd22dfe9cb87b0b0815170e3588e8d158d8a500b" },
+          { hash::type::shake256, "3557bfcdf5953cea9757755f67ca3436cb70da0d8f43ef6356acdc69aaa4d518" }
+        };
+
+        for ( const auto& tail : outputTails )
+        {
+          hash_generator g( tail.first );
+          g.add_data( input.data(), input.size() );
+          auto h = g.retrieve_hash( 1000 );
+          CHECK( tail.first == h.hashType );
+          CHECK( 1000 == h.binary.size() );
+          CHECK( tail.second == h.string.substr( h.string.size() - 64 ) );
+
+          // shorter outputs are a prefix of longer ones, the default size included
+          auto defaultHash = get_hash( input.data(), input.size(), tail.first );
+          CHECK( 0 == h.string.compare( 0, defaultHash.string.size(), defaultHash.string ) );
+
+          std::vector< std::uint8_t > output( 7 );
+          hash_generator g2( tail.first );
+          g2.add_data( input.data(), input.size() );
+          g2.retrieve_output( output.data(), output.size() );
+          CHECK( std::equal( output.begin(), output.end(), h.binary.begin() ) );
+          CHECK_THROWS_AS( g2.retrieve_output( output.data(), output.size() ), exception );
+        }
+
+        basic_hash_generator< hash::type::shake128 > basic;
+        basic.add_data( input.data(), input.size() );
+        CHECK( basic.retrieve_hash( 1000 ).string.substr( 2000 - 64 ) == outputTails[0].second );
+      }
+
+      SECTION( "fixed size types have no variable output" )
+      {
+        hash_generator g( hash::type::sha3_256 );
+        CHECK_THROWS_AS( g.retrieve_hash( 64 ), exception );
+
+        std::uint8_t output[16];
+        hash_generator g2( hash::type::md5 );
+        CHECK_THROWS_AS( g2.retrieve_output( output, sizeof( output ) ), exception );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "checksum types match the reference implementation" )
+    {
+      SECTION( "xxh3 inputs around the size classes" )
+      {
+        // 0, 1-3, 4-8, 9-16, 17-128 and 129-240 bytes are mixed directly, longer inputs are accumulated in
+        // stripes of 64 bytes and blocks of 1024 bytes
+        std::vector< std::tuple< size_t, std::string, std::string > > vectors = {
+          std::make_tuple( 0, "2d06800538d394c2", "99aa06d3014798d86001c324468d497f" ),
+          std::make_tuple( 1, "c44bdff4074eecdb", "a6cd5e9392000f6ac44bdff4074eecdb" ),
+          std::make_tuple( 3, "5f4299fc161c9cbb", "e3b55f57945a17cf5f4299fc161c9cbb" ),
+          std::make_tuple( 4, "60dab036a58211f2", "eb70bf5fc779e9e6a6111d53e80a3db5" ),
+          std::make_tuple( 8, "3a1c2d7c85af88f8", "e1e4432a62217fe4cfd50c61c8bb98c1" ),
+          std::make_tuple( 9, "e9612598145bb9dc", "16c769d83e4aebce907931979dca3746" ),
+          std::make_tuple( 16, "8355e3a6f61770db", "72950631827607e2842812cc870dcae2" ),
+          std::make_tuple( 17, "9ef341a99de37328", "685bc458b37d057fc06e233df7729217" ),
+          std::make_tuple( 128, "85c6174c7ff4c46b", "14792fc3af88dc6c05321a0b64d67b41" ),
+          std::make_tuple( 129, "ec7642b431ba3e5a", "dd5e74ac6b45f54ebc30b63382b09a3b" ),
+          std::make_tuple( 240, "375a384d957fe865", "65b5be86da5540e7c92b68e16f83bbb6" ),
+          std::make_tuple( 241, "02e8cd95421c6d02", "1da1cb61bcb8a2a102e8cd95421c6d02" ),
+          std::make_tuple( 1024, "e5d78bafa45b2aa5", "d0ac1f7b93bf57b9e5d78bafa45b2aa5" ),
+          std::make_tuple( 1025, "e95c42288f28186e", "2882ebca04ec915ce95c42288f28186e" ),
+          std::make_tuple( 100000, "42c23aeead96750d", "54182c58bbb1337c42c23aeead96750d" )
+        };
+
+        for ( const auto& v : vectors )
+        {
+          auto input = make_test_input( std::get< 0 >( v ) );
+          CHECK( std::get< 1 >( v ) == get_hash( input.data(), input.size(), hash::type::xxh3_64 ).string );
+          CHECK( std::get< 2 >( v ) == get_hash( input.data(), input.size(), hash::type::xxh3_128 ).string );
+
+          // odd chunk sizes cross the buffer and stripe boundaries of the streaming state at every offset
+          for ( size_t chunkSize : { size_t( 1 ), size_t( 63 ), size_t( 257 ) } )
+          {
+            hash_generator g( hash::type::xxh3_128 );
+            for ( size_t pos = 0; pos < input.size(); pos += chunkSize )
+              g.add_data( input.data() + pos, std::min( chunkSize, input.size() - pos ) );
+            CHECK( std::get< 2 >( v ) == g.retrieve_hash().string );
+          }
+        }
+      }
+
+      SECTION( "crc32c matches the bitwise definition" )
+      {
+        auto crc32c = []( const std::vector< std::uint8_t >& input_ ) {
+          std::uint32_t crc = 0xffffffff;
+          for ( auto b : input_ )
+          {
+            crc ^= b;
+            for ( int i = 0; i < 8; ++i )
+              crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? 0x82f63b78 : 0 );
+          }
+          return ~crc;
+        };
+
+        CHECK( "e3069283" == get_hash( "123456789", hash::type::crc32c ).string );
+
+        // the three interleaved streams are used from 3 * 256 and 3 * 8192 bytes
+        for ( size_t sz : { 1, 7, 8, 9, 767, 768, 769, 800, 24575, 24576, 24577, 100000 } )
+        {
+          auto input = make_test_input( sz );
+          auto h = get_hash( input.data(), input.size(), hash::type::crc32c );
+          REQUIRE( 4 == h.binary.size() );
+          std::uint32_t crc = ( std::uint32_t( h.binary[0] ) << 24 ) | ( std::uint32_t( h.binary[1] ) << 16 )
+                              | ( std::uint32_t( h.binary[2] ) << 8 ) | h.binary[3];
+          CHECK( crc32c( input ) == crc );
+        }
+      }
+
+      SECTION( "checksums are not cryptographic" )
+      {
+        CHECK_FALSE( is_cryptographic( hash::type::crc32c ) );
+        CHECK_FALSE( is_cryptographic( hash::type::xxh3_64 ) );
+        CHECK_FALSE( is_cryptographic( hash::type::xxh3_128 ) );
+        CHECK_FALSE( is_cryptographic( hash::type::unknown ) );
+        CHECK( is_cryptographic( hash::type::sha256 ) );
+        CHECK( is_cryptographic( hash::type::blake3 ) );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "digest matches hash" )
+    {
+      std::string input =
+#include "../data/test.string"
+      ;
+
+      std::vector< hash::type > hashTypes = {
+        hash::type::md4,
+        hash::type::md5,
+        hash::type::sha1,
+        hash::type::sha256,
+        hash::type::sha384,
+        hash::type::sha512,
+        hash::type::blake3,
+        hash::type::sha3_256,
+        hash::type::sha3_512,
+        hash::type::shake128,
+        hash::type::shake256,
+        hash::type::crc32c,
+        hash::type::xxh3_64,
+        hash::type::xxh3_128
+      };
+
+#if !defined( __GNUC__ ) || defined( __clang__ ) || ( __GNUC__ >= 5 )
+      static_assert( std::is_trivially_copyable< digest >::value, "digest must be trivially copyable" );
+#endif
+
+      std::unordered_set< digest > digests;
+      std::set< digest > orderedDigests;
+      for ( auto type : hashTypes )
+      {
+        auto h = get_hash( input, type );
+        auto d = get_digest( input.data(), input.size(), type );
+
+        CHECK( d.hashType == type );
+        CHECK( std::vector< std::uint8_t >( d.data(), d.data() + d.size ) == h.binary );
+        CHECK( to_string( d ) == h.string );
+        CHECK( to_digest( h ) == d );
+
+        hash_generator g( type );
+        g.add_data( reinterpret_cast< const std::uint8_t* >( input.data() ), input.size() );
+        CHECK( g.retrieve_digest() == d );
+
+        digests.insert( d );
+        digests.insert( to_digest( h ) );
+        orderedDigests.insert( d );
+      }
+      CHECK( digests.size() == hashTypes.size() );
+      CHECK( orderedDigests.size() == hashTypes.size() );
+
+      SECTION( "digests of different input compare unequal" )
+      {
+        auto d1 = get_digest( input.data(), input.size(), hash::type::sha256 );
+        auto d2 = get_digest( input.data(), input.size() - 1, hash::type::sha256 );
+        CHECK( d1 != d2 );
+        CHECK( ( ( d1 < d2 ) != ( d2 < d1 ) ) );
+        CHECK( digests.count( d2 ) == 0 );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "get_hashes matches single message hashes" )
+    {
+      std::vector< hash::type > hashTypes = {
+        hash::type::md4,
+        hash::type::md5,
+        hash::type::sha1,
+        hash::type::sha256,
+        hash::type::sha384,
+        hash::type::sha512,
+        hash::type::blake3,
+        hash::type::sha3_256,
+        hash::type::sha3_512,
+        hash::type::shake128,
+        hash::type::shake256,
+        hash::type::crc32c,
+        hash::type::xxh3_64,
+        hash::type::xxh3_128
+      };
+
+      // cover the padding edge cases as well as messages spanning several blocks
+      std::mt19937 mt19937( 42 );
+      std::uniform_int_distribution< int > byteDist( 0, 255 );
+      std::vector< size_t > lengths = { 0, 1, 55, 56, 63, 64, 65, 119, 120, 127, 128, 500, 1000, 4097 };
+      for ( size_t i = 0; i < 100; ++i )
+        lengths.push_back( mt19937() % 600 );
+
+      std::vector< std::vector< std::uint8_t > > messages;
+      for ( auto length : lengths )
+      {
+        std::vector< std::uint8_t > message( length );
+        for ( auto& b : message )
+          b = static_cast< std::uint8_t >( byteDist( mt19937 ) );
+        messages.push_back( message );
+      }
+
+
+      SECTION( "for large batches" )
+      {
+        std::vector< buffer_ref > buffers;
+        for ( const auto& m : messages )
+          buffers.push_back( { m.data(), m.size() } );
+
+        for ( auto type : hashTypes )
+        {
+          auto batch = get_hashes( buffers, type );
+
+          CHECK( type == batch.hashType );
+          REQUIRE( messages.size() * batch.digestSize == batch.binary.size() );
+
+          for ( size_t i = 0; i < messages.size(); ++i )
+          {
+            auto expected = get_hash( messages[i].data(), messages[i].size(), type );
+            std::vector< std::uint8_t > digest( batch.binary.begin() + i * batch.digestSize,
+                                                batch.binary.begin() + ( i + 1 ) * batch.digestSize );
+            CHECK( expected.binary == digest );
+          }
+        }
+      }
+
+
+      SECTION( "by every batch implementation" )
+      {
+        std::vector< buffer_ref > buffers;
+        for ( const auto& m : messages )
+          buffers.push_back( { m.data(), m.size() } );
+
+        for ( auto type : hashTypes )
+        {
+          auto implementations = get_batch_implementations( type );
+          REQUIRE( !implementations.empty() );
+          CHECK( std::count( implementations.begin(), implementations.end(), "single" ) == 1 );
+
+          for ( const auto& implementation : implementations )
+          {
+            INFO( implementation );
+            set_batch_implementation( type, implementation );
+            auto batch = get_hashes( buffers, type );
+
+            REQUIRE( messages.size() * batch.digestSize == batch.binary.size() );
+            for ( size_t i = 0; i < messages.size(); ++i )
+            {
+              auto expected = get_hash( messages[i].data(), messages[i].size(), type );
+              std::vector< std::uint8_t > digest( batch.binary.begin() + i * batch.digestSize,
+                                                  batch.binary.begin() + ( i + 1 ) * batch.digestSize );
+              CHECK( expected.binary == digest );
+            }
+          }
+
+          set_batch_implementation( type, implementations.front() );
+        }
+
+        CHECK_THROWS_AS( set_batch_implementation( hash::type::md5, "no-such-kernel" ), exception );
+        CHECK_THROWS_AS( get_batch_implementations( hash::type::unknown ), exception );
+      }
+
+
+      SECTION( "for small batches" )
+      {
+        for ( auto type : hashTypes )
+        {
+          std::vector< buffer_ref > buffers = { { messages[2].data(), messages[2].size() } };
+          auto batch = get_hashes( buffers, type );
+
+          CHECK( get_hash( messages[2].data(), messages[2].size(), type ).binary == batch.binary );
+        }
+      }
+
+
+      SECTION( "for empty batches" )
+      {
+        auto batch = get_hashes( std::vector< buffer_ref >(), hash::type::sha256 );
+
+        CHECK( hash::type::sha256 == batch.hashType );
+        CHECK( 32 == batch.digestSize );
+        CHECK( batch.binary.empty() );
+      }
+    }
+
+
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "segmented input matches contiguous input" )
+    {
+      std::vector< hash::type > hashTypes = {
+        hash::type::md4,
+        hash::type::md5,
+        hash::type::sha1,
+        hash::type::sha256,
+        hash::type::sha384,
+        hash::type::sha512,
+        hash::type::blake3,
+        hash::type::sha3_256,
+        hash::type::sha3_512,
+        hash::type::shake128,
+        hash::type::shake256,
+        hash::type::crc32c,
+        hash::type::xxh3_64,
+        hash::type::xxh3_128
+      };
+
+      std::mt19937 mt19937( 7 );
+      std::vector< std::uint8_t > message( 20000 );
+      for ( auto& b : message )
+        b = static_cast< std::uint8_t >( mt19937() );
+
+      // runs of tiny fragments (more than fit into the coalescing buffer), empty ones and large ones
+      std::vector< buffer_ref > segments;
+      for ( size_t offset = 0; offset < message.size(); )
+      {
+        auto r = mt19937() % 10;
+        size_t sz = ( r < 6 ) ? mt19937() % 20 : ( ( r < 9 ) ? mt19937() % 300 : mt19937() % 3000 );
+        sz = std::min( sz, message.size() - offset );
+        segments.push_back( { message.data() + offset, sz } );
+        offset += sz;
+      }
+
+
+      SECTION( "with get_segmented_hash" )
+      {
+        for ( auto type : hashTypes )
+        {
+          auto expected = get_hash( message.data(), message.size(), type );
+          auto h = get_segmented_hash( segments.data(), segments.size(), type );
+          CHECK( expected.string == h.string );
+          CHECK( message.size() == h.inputSize );
+        }
+      }
+
+
+      SECTION( "mixed with contiguous data in a generator" )
+      {
+        for ( auto type : hashTypes )
+        {
+          // the segments start in the middle of a block
+          hash_generator g( type );
+          g.add_data( message.data(), 13 );
+
+          std::vector< buffer_ref > rest;
+          size_t skip = 13;
+          for ( auto segment : segments )
+          {
+            auto n = std::min( skip, segment.szBufferInBytes );
+            skip -= n;
+            rest.push_back( { static_cast< const std::uint8_t* >( segment.pBuffer ) + n,
+                              segment.szBufferInBytes - n } );
+          }
+
+          g.add_segments( segments.data(), 0 );
+          g.add_segments( rest.data(), rest.size() );
+
+          CHECK( get_hash( message.data(), message.size(), type ).string == g.retrieve_hash().string );
+        }
+      }
+
+
+      SECTION( "with an array of iovec" )
+      {
+#if !LL_IS_WINDOWS()
+        std::vector< struct iovec > vectors;
+        for ( const auto& segment : segments )
+          vectors.push_back( { const_cast< void* >( segment.pBuffer ), segment.szBufferInBytes } );
+
+        static_assert( sizeof( buffer_ref ) == sizeof( struct iovec ), "buffer_ref isn't iovec compatible" );
+        auto pSegments = reinterpret_cast< const buffer_ref* >( vectors.data() );
+        CHECK( get_hash( message.data(), message.size(), hash::type::sha256 ).string
+               == get_segmented_hash( pSegments, vectors.size(), hash::type::sha256 ).string );
+#endif
+      }
+
+
+      SECTION( "with invalid segments" )
+      {
+        std::vector< buffer_ref > invalid = { { message.data(), 10 }, { nullptr, 10 } };
+        CHECK_THROWS_AS( get_segmented_hash( invalid.data(), invalid.size(), hash::type::sha256 ), exception );
+        CHECK_THROWS_AS( get_segmented_hash( nullptr, 1, hash::type::sha256 ), exception );
+        CHECK( get_hash( "", 0, hash::type::sha256 ).string
+               == get_segmented_hash( nullptr, 0, hash::type::sha256 ).string );
+
+        hash_generator g( hash::type::sha256 );
+        CHECK_THROWS_AS( g.add_segments( invalid.data(), invalid.size() ), exception );
+        CHECK_THROWS_AS( g.add_segments( nullptr, 1 ), exception );
+
+        // empty segments may come without a buffer
+        std::vector< buffer_ref > empty = { { nullptr, 0 }, { message.data(), 10 }, { nullptr, 0 } };
+        g.add_segments( empty.data(), empty.size() );
+        g.add_data( nullptr, 0 );
+        CHECK( get_hash( message.data(), 10, hash::type::sha256 ).string == g.retrieve_hash().string );
+      }
+    }
+
+
     // -------------------------------------------------------------------------------------------------------
 
     TEST_CASE( "exception behaviour" )
@@ -329,6 +1565,14 @@ namespace crypto
       }
 
 
+      SECTION( "missing file yields exception" )
+      {
+        auto p = get_executable_path();
+        p /= "/data/does_not_exist.jpg";
+        CHECK_THROWS_AS( get_file_hash( p.string(), hash::type::md5 ), exception );
+      }
+
+
       SECTION( "invalid buffer yields exception" )
       {
         std::vector< hash::type > hashTypes = {
@@ -337,13 +1581,28 @@ namespace crypto
           hash::type::sha1,
           hash::type::sha256,
           hash::type::sha384,
-          hash::type::sha512
+          hash::type::sha512,
+          hash::type::blake3,
+          hash::type::sha3_256,
+          hash::type::sha3_512,
+          hash::type::shake128,
+          hash::type::shake256,
+          hash::type::crc32c,
+          hash::type::xxh3_64,
+          hash::type::xxh3_128
         };
         for ( auto type : hashTypes )
         {
           CHECK_THROWS_AS( get_hash( nullptr, 42, type ), exception );
         }
       }
+
+
+      SECTION( "invalid buffer in batch yields exception" )
+      {
+        std::vector< buffer_ref > buffers = { { input.data(), input.size() }, { nullptr, 42 } };
+        CHECK_THROWS_AS( get_hashes( buffers, hash::type::sha256 ), exception );
+      }
     }
 
 
@@ -0,0 +1,197 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <catch.hpp>
+
+#include <map>
+#include <sstream>
+
+#include <crypto/hash_directory.h>
+#include <crypto/exception.h>
+
+#include "../helpers/test_helpers.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace test
+  {
+    // -------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "directory hashing" )
+    {
+      std::map< std::string, std::string > files = {
+        { "a.txt", "some text" },
+        { "empty", "" },
+        { "name with spaces.txt", "spaces" },
+        { "sub/b.bin", std::string( 3 * 1024 * 1024 + 17, 'b' ) },
+        { "sub/deeper/c", "the c file" }
+      };
+
+      temporary_directory dir;
+      for ( const auto& f : files )
+        dir.write( f.first, f.second );
+
+      directory_hash_config cfg;
+      cfg.numThreads = 3;
+
+      auto m = hash_directory( dir.path().string(), hash::type::sha256, cfg );
+      CHECK( m.hashType == hash::type::sha256 );
+      REQUIRE( m.entries.size() == files.size() );
+
+      // the manifest is sorted like the map
+      size_t i = 0;
+      for ( const auto& f : files )
+      {
+        const auto& entry = m.entries[i++];
+        CHECK( entry.path == f.first );
+        CHECK( entry.size == f.second.size() );
+        CHECK( to_string( entry.fileDigest ) == get_hash( f.second, hash::type::sha256 ).string );
+      }
+
+      CHECK( verify_manifest( dir.path().string(), m, cfg ).empty() );
+
+
+      SECTION( "manifest text form round trip" )
+      {
+        std::stringstream stream;
+        write_manifest( stream, m );
+        CHECK( stream.str().find( "ll_crypto_manifest 1 sha-256\n" ) == 0 );
+
+        auto read = read_manifest( stream );
+        CHECK( read.hashType == m.hashType );
+        REQUIRE( read.entries.size() == m.entries.size() );
+        for ( size_t j = 0; j < m.entries.size(); ++j )
+        {
+          CHECK( read.entries[j].path == m.entries[j].path );
+          CHECK( read.entries[j].size == m.entries[j].size );
+          CHECK( read.entries[j].fileDigest == m.entries[j].fileDigest );
+        }
+      }
+
+
+      SECTION( "manifest with windows line endings" )
+      {
+        std::stringstream stream;
+        write_manifest( stream, m );
+
+        std::string crlf;
+        for ( auto c : stream.str() )
+          crlf += ( c == '\n' ) ? std::string( "\r\n" ) : std::string( 1, c );
+
+        std::stringstream crlfStream( crlf );
+        auto read = read_manifest( crlfStream );
+        REQUIRE( read.entries.size() == m.entries.size() );
+        for ( size_t j = 0; j < m.entries.size(); ++j )
+          CHECK( read.entries[j].path == m.entries[j].path );
+      }
+
+
+      SECTION( "verification reports mismatches" )
+      {
+        dir.write( "a.txt", "SOME TEXT" );         // same size, different content
+        dir.write( "sub/deeper/c", "changed" );    // different size
+        dir.write( "sub/new", "not in the manifest" );
+        boost::filesystem::remove( dir.path() / "empty" );
+
+        auto mismatches = verify_manifest( dir.path().string(), m, cfg );
+        REQUIRE( mismatches.size() == 4 );
+        CHECK( mismatches[0].path == "a.txt" );
+        CHECK( ( mismatches[0].mismatchKind == manifest_mismatch::kind::modified ) );
+        CHECK( mismatches[1].path == "empty" );
+        CHECK( ( mismatches[1].mismatchKind == manifest_mismatch::kind::missing ) );
+        CHECK( mismatches[2].path == "sub/deeper/c" );
+        CHECK( ( mismatches[2].mismatchKind == manifest_mismatch::kind::modified ) );
+        CHECK( mismatches[3].path == "sub/new" );
+        CHECK( ( mismatches[3].mismatchKind == manifest_mismatch::kind::unexpected ) );
+      }
+
+
+#if !LL_IS_WINDOWS()
+      SECTION( "unreadable files are reported" )
+      {
+        auto p = dir.path() / "a.txt";
+        boost::filesystem::permissions( p, boost::filesystem::no_perms );
+
+        // the permissions don't apply to root
+        if ( ::access( p.string().c_str(), R_OK ) != 0 )
+        {
+          auto partial = hash_directory( dir.path().string(), hash::type::sha256, cfg );
+          CHECK( partial.entries.size() == files.size() - 1 );
+          REQUIRE( partial.unreadable.size() == 1 );
+          CHECK( partial.unreadable[0] == "a.txt" );
+        }
+
+        boost::filesystem::permissions( p, boost::filesystem::owner_read | boost::filesystem::owner_write );
+      }
+
+
+      SECTION( "unreadable directories are reported" )
+      {
+        auto p = dir.path() / "sub" / "deeper";
+        boost::filesystem::permissions( p, boost::filesystem::no_perms );
+
+        // the permissions don't apply to root
+        if ( ::access( p.string().c_str(), R_OK ) != 0 )
+        {
+          auto partial = hash_directory( dir.path().string(), hash::type::sha256, cfg );
+          CHECK( partial.entries.size() == files.size() - 1 );
+          REQUIRE( partial.unreadable.size() == 1 );
+          CHECK( partial.unreadable[0] == "sub/deeper" );
+
+          // the directory and the files the manifest lists below it can't be checked, but aren't missing
+          auto mismatches = verify_manifest( dir.path().string(), m, cfg );
+          REQUIRE( mismatches.size() == 2 );
+          CHECK( mismatches[0].path == "sub/deeper" );
+          CHECK( ( mismatches[0].mismatchKind == manifest_mismatch::kind::unreadable ) );
+          CHECK( mismatches[1].path == "sub/deeper/c" );
+          CHECK( ( mismatches[1].mismatchKind == manifest_mismatch::kind::unreadable ) );
+        }
+
+        boost::filesystem::permissions( p, boost::filesystem::owner_all );
+      }
+#endif
+
+
+      SECTION( "invalid input yields exception" )
+      {
+        CHECK_THROWS_AS( hash_directory( ( dir.path() / "does_not_exist" ).string() ), exception );
+
+        std::stringstream invalidHeader( "something else\n" );
+        CHECK_THROWS_AS( read_manifest( invalidHeader ), exception );
+
+        std::stringstream invalidLine( "ll_crypto_manifest 1 md5\nabc 12 file\n" );
+        CHECK_THROWS_AS( read_manifest( invalidLine ), exception );
+
+        const std::string line = "ll_crypto_manifest 1 md5\n" + std::string( 32, 'a' );
+        std::stringstream overflowingSize( line + " 18446744073709551616 file\n" );
+        CHECK_THROWS_AS( read_manifest( overflowingSize ), exception );
+
+        std::stringstream maxSize( line + " 18446744073709551615 file\n" );
+        CHECK( read_manifest( maxSize ).entries.at( 0 ).size == 18446744073709551615ull );
+
+        std::stringstream trailingGarbage( line + " 12x file\n" );
+        CHECK_THROWS_AS( read_manifest( trailingGarbage ), exception );
+      }
+    }
+
+  }  // namespace test
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,106 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <catch.hpp>
+
+#include <iterator>
+#include <map>
+
+#include <crypto/hash_tree.h>
+#include <crypto/exception.h>
+
+#include "../helpers/test_helpers.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace test
+  {
+
+    TEST_CASE( "tree hash" )
+    {
+      auto p = get_executable_path();
+      p /= "/data/test.jpg";
+
+      boost::filesystem::ifstream file( p, std::ios::in | std::ios::binary );
+      REQUIRE( file.is_open() );
+
+      std::vector< char > input( ( std::istreambuf_iterator< char >( file ) ), std::istreambuf_iterator< char >() );
+      REQUIRE( 3184393 == input.size() );
+
+
+      SECTION( "yields expected results" )
+      {
+        std::map< hash::type, std::string > expectedHashes = {
+          { hash::type::md5, "4f12cb148a15316a1868b8f4709dfa18" },
+          { hash::type::sha1, "0a3f8dc6e996972271104f07b06408f305bf3260" },
+          { hash::type::sha256, "98de7d31ad320e522f1fd83c47a79d124ee1d59dafb7ac7550f5a2435f092ee1" }
+        };
+
+        for ( const auto& hash : expectedHashes )
+        {
+          tree_hash_config cfg;
+          cfg.leafSize = 65536;
+
+          auto result = get_tree_hash( input.data(), input.size(), hash.first, cfg );
+
+          CHECK( hash.first == result.hashType );
+          CHECK( hash.second == result.string );
+          CHECK( input.size() == result.inputSize );
+        }
+      }
+
+
+      SECTION( "is independent of the number of threads" )
+      {
+        for ( size_t numThreads : { 1, 2, 3, 8, 64 } )
+        {
+          tree_hash_config cfg;
+          cfg.numThreads = numThreads;
+
+          auto result = get_tree_hash( input.data(), input.size(), hash::type::sha256, cfg );
+          CHECK( "27ac15b62a7eccb1ebd60be65bce3905540a6809ab140ee7a5d542123c5df371" == result.string );
+        }
+      }
+
+
+      SECTION( "single leaf inputs" )
+      {
+        CHECK( "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d"
+               == get_tree_hash( std::string() ).string );
+        CHECK( "079f1b2d5d3971840ee73ee052c75ea184bac794ad3a43ff09dbee18f090da39"
+               == get_tree_hash( "this is a test string" ).string );
+      }
+
+
+      SECTION( "invalid parameters yield exception" )
+      {
+        tree_hash_config cfg;
+        cfg.leafSize = 0;
+
+        CHECK_THROWS_AS( get_tree_hash( input.data(), input.size(), hash::type::sha256, cfg ), exception );
+        CHECK_THROWS_AS( get_tree_hash( input.data(), input.size(), hash::type::unknown ), exception );
+        CHECK_THROWS_AS( get_tree_hash( nullptr, 42 ), exception );
+      }
+    }
+
+  }  // namespace test
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,214 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <crypto/hmac.h>
+#include <crypto/exception.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace test
+  {
+
+    TEST_CASE( "hmac" )
+    {
+      // RFC 4231 test cases 1, 2 and 6 (the key of case 6 is longer than the block size and hashed first)
+      std::vector< std::tuple< hash::type, std::string, std::string, std::string > > vectors = {
+        std::make_tuple( hash::type::sha1, std::string( 20, '\x0b' ), "Hi There",
+          "b617318655057264e28bc0b6fb378c8ef146be00" ),
+        std::make_tuple( hash::type::sha256, std::string( 20, '\x0b' ), "Hi There",
+          "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7" ),
+        std::make_tuple( hash::type::sha384, std::string( 20, '\x0b' ), "Hi There",
+          "afd03944d84895626b0825f4ab46907f15f9dadbe4101ec6"
+          "82aa034c7cebc59cfaea9ea9076ede7f4af152e8b2fa9cb6" ),
+        std::make_tuple( hash::type::sha512, std::string( 20, '\x0b' ), "Hi There",
+          "87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cdedaa833b7d6b8a702038b274eaea3f4"
+          "e4be9d914eeb61f1702e696c203a126854" ),
+        std::make_tuple( hash::type::sha3_256, std::string( 20, '\x0b' ), "Hi There",
+          "ba85192310dffa96e2a3a40e69774351140bb7185e1202cdcc917589f95e16bb" ),
+        std::make_tuple( hash::type::sha3_512, std::string( 20, '\x0b' ), "Hi There",
+          "eb3fbd4b2eaab8f5c504bd3a41465aacec15770a7cabac531e482f860b5ec7ba47ccb2c6f2afce8f88d22b6dc61380"
+          "f23a668fd3888bb80537c0a0b86407689e" ),
+        std::make_tuple( hash::type::sha256, "Jefe", "what do ya want for nothing?",
+          "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" ),
+        std::make_tuple( hash::type::sha512, "Jefe", "what do ya want for nothing?",
+          "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0e6"
+          "fdcaeab1a34d4a6b4b636e070a38bce737" ),
+        std::make_tuple( hash::type::sha256, std::string( 131, '\xaa' ),
+          "Test Using Larger Than Block-Size Key - Hash Key First",
+          "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54" ),
+        std::make_tuple( hash::type::sha384, std::string( 131, '\xaa' ),
+          "Test Using Larger Than Block-Size Key - Hash Key First",
+          "4ece084485813e9088d2c63a041bc5b44f9ef1012a2b588f"
+          "3cd11f05033ac4c60c2ef6ab4030fe8296248df163f44952" ),
+        std::make_tuple( hash::type::sha3_256, std::string( 131, '\xaa' ),
+          "Test Using Larger Than Block-Size Key - Hash Key First",
+          "ed73a374b96c005235f948032f09674a58c0ce555cfc1f223b02356560312c3b" ),
+        std::make_tuple( hash::type::sha3_512, std::string( 131, '\xaa' ),
+          "Test Using Larger Than Block-Size Key - Hash Key First",
+          "00f751a9e50695b090ed6911a4b65524951cdc15a73a5d58bb55215ea2cd839ac79d2b44a39bafab27e83fde9e11f6"
+          "340b11d991b1b91bf2eee7fc872426c3a4" ),
+        std::make_tuple( hash::type::sha256, "", "",
+          "b613679a0814d9ec772f95d778c35fc5ff1697c493715653c6c712144292c5ad" )
+      };
+
+      SECTION( "yields expected results" )
+      {
+        for ( const auto& v : vectors )
+        {
+          auto h = get_hmac( std::get< 1 >( v ), std::get< 2 >( v ), std::get< 0 >( v ) );
+          CHECK( std::get< 0 >( v ) == h.hashType );
+          CHECK( std::get< 3 >( v ) == h.string );
+          CHECK( std::get< 2 >( v ).size() == h.inputSize );
+        }
+      }
+
+
+      // -------------------------------------------------------------------------------------------------------
+
+      SECTION( "a prepared key signs and verifies any number of messages" )
+      {
+        for ( const auto& v : vectors )
+        {
+          hmac_key key( std::get< 0 >( v ), std::get< 1 >( v ) );
+          CHECK( std::get< 0 >( v ) == key.hash_type() );
+          CHECK( std::get< 3 >( v ).size() / 2 == key.digest_size() );
+
+          const auto& message = std::get< 2 >( v );
+          for ( int i = 0; i < 3; ++i )
+          {
+            auto mac = key.sign( message.data(), message.size() );
+            CHECK( std::get< 3 >( v ) == to_string( mac ) );
+            CHECK( key.verify( message.data(), message.size(), mac ) );
+
+            auto corrupted = mac;
+            corrupted.bytes[mac.size - 1] ^= 1;
+            CHECK_FALSE( key.verify( message.data(), message.size(), corrupted ) );
+          }
+        }
+      }
+
+
+      // -------------------------------------------------------------------------------------------------------
+
+      SECTION( "streaming matches one-shot" )
+      {
+        std::string message( 1000, 'x' );
+        for ( size_t i = 0; i < message.size(); ++i )
+          message[i] = static_cast< char >( 'a' + i % 26 );
+
+        hmac_key key( hash::type::sha512, "key" );
+        auto expected = key.sign( message.data(), message.size() );
+
+        hmac_generator g( key );
+        for ( int round = 0; round < 2; ++round )
+        {
+          for ( size_t pos = 0; pos < message.size(); pos += 77 )
+          {
+            g.add_data( reinterpret_cast< const std::uint8_t* >( message.data() ) + pos,
+                        std::min( size_t( 77 ), message.size() - pos ) );
+          }
+          auto h = g.retrieve_hash();
+          CHECK( to_string( expected ) == h.string );
+          CHECK( message.size() == h.inputSize );
+          g.reset();
+        }
+
+        hmac_generator g2( hash::type::sha512, "key", 3 );
+        g2.add_data( reinterpret_cast< const std::uint8_t* >( message.data() ), message.size() );
+        CHECK( expected == g2.retrieve_digest() );
+      }
+
+
+      // -------------------------------------------------------------------------------------------------------
+
+      SECTION( "batch verification reports every message" )
+      {
+        hmac_key key( hash::type::sha256, "batch key" );
+
+        std::vector< std::string > messages;
+        for ( size_t i = 0; i < 50; ++i )
+          messages.push_back( std::string( i * 7, static_cast< char >( 'a' + i % 26 ) ) );
+
+        std::vector< buffer_ref > refs;
+        std::vector< digest > macs;
+        for ( const auto& m : messages )
+        {
+          refs.push_back( { m.data(), m.size() } );
+          macs.push_back( key.sign( m.data(), m.size() ) );
+        }
+        macs[3].bytes[0] ^= 0x80;
+        macs[17] = hmac_key( hash::type::sha256, "other key" ).sign( messages[17].data(), messages[17].size() );
+        macs[42].hashType = hash::type::sha3_256;
+
+        auto results = key.verify( refs.data(), macs.data(), refs.size() );
+        REQUIRE( messages.size() == results.size() );
+        for ( size_t i = 0; i < results.size(); ++i )
+          CHECK( results[i] == ( ( i != 3 ) && ( i != 17 ) && ( i != 42 ) ) );
+
+        CHECK( key.verify( nullptr, nullptr, 0 ).empty() );
+      }
+
+
+      // -------------------------------------------------------------------------------------------------------
+
+      SECTION( "throws on unsupported hash types and invalid use" )
+      {
+        CHECK_THROWS_AS( hmac_key( hash::type::unknown, "key" ), crypto::exception );
+        CHECK_THROWS_AS( hmac_key( hash::type::shake128, "key" ), crypto::exception );
+        CHECK_THROWS_AS( hmac_key( hash::type::crc32c, "key" ), crypto::exception );
+        CHECK_THROWS_AS( get_hmac( "key", "message", hash::type::xxh3_64 ), crypto::exception );
+
+        hmac_generator g( hash::type::sha256, "key", 3 );
+        g.retrieve_hash();
+        CHECK_THROWS_AS( g.retrieve_hash(), crypto::exception );
+        CHECK_THROWS_AS( g.add_data( reinterpret_cast< const std::uint8_t* >( "x" ), 1 ), crypto::exception );
+      }
+
+
+      // -------------------------------------------------------------------------------------------------------
+
+      SECTION( "throws on null buffers with a size" )
+      {
+        hmac_key key( hash::type::sha256, "key" );
+        hmac_generator g( key );
+
+        CHECK_THROWS_AS( hmac_key( hash::type::sha256, nullptr, 3 ), crypto::exception );
+        CHECK_THROWS_AS( hmac_generator( hash::type::sha256, nullptr, 3 ), crypto::exception );
+        CHECK_THROWS_AS( key.sign( nullptr, 1 ), crypto::exception );
+        CHECK_THROWS_AS( key.verify( nullptr, nullptr, 1 ), crypto::exception );
+        CHECK_THROWS_AS( g.add_data( nullptr, 1 ), crypto::exception );
+        CHECK_THROWS_AS( get_hmac( "key", 3, nullptr, 1, hash::type::sha256 ), crypto::exception );
+        CHECK_THROWS_AS( get_hmac( nullptr, 3, "message", 7, hash::type::sha256 ), crypto::exception );
+
+        CHECK_NOTHROW( key.sign( nullptr, 0 ) );
+        CHECK_NOTHROW( g.add_data( nullptr, 0 ) );
+      }
+    }
+
+  }  // namespace test
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,155 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <crypto/metrics.h>
+#include <crypto/password.h>
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace test
+  {
+    namespace
+    {
+      metrics::counter find_counter( const metrics::snapshot& snapshot_,
+                                     metrics::entry_point entryPoint_,
+                                     hash::type type_ )
+      {
+        for ( const auto& c : snapshot_.counters )
+        {
+          if ( ( c.entryPoint == entryPoint_ ) && ( c.hashType == type_ ) )
+            return c;
+        }
+        return metrics::counter();
+      }
+    }
+
+
+    TEST_CASE( "metrics" )
+    {
+      metrics::reset();
+
+      std::vector< std::uint8_t > data( 1000, 0x5a );
+
+      if ( !metrics::metrics_enabled() )
+      {
+        get_hash( data.data(), data.size(), hash::type::sha256 );
+
+        auto snapshot = metrics::get_snapshot();
+        CHECK_FALSE( snapshot.enabled );
+        CHECK( snapshot.counters.empty() );
+        CHECK( snapshot.pbkdf2Latencies.empty() );
+        return;
+      }
+
+      SECTION( "only the outermost call is counted" )
+      {
+        get_hash( std::string( data.begin(), data.end() ), hash::type::sha256 );
+        get_hash( data.data(), data.size(), hash::type::sha256 );
+
+        auto snapshot = metrics::get_snapshot();
+        CHECK( snapshot.enabled );
+
+        auto c = find_counter( snapshot, metrics::entry_point::get_hash, hash::type::sha256 );
+        CHECK( c.calls == 2 );
+        CHECK( c.bytes == 2000 );
+        c = find_counter( snapshot, metrics::entry_point::hash_generator, hash::type::sha256 );
+        CHECK( c.calls == 0 );
+      }
+
+      SECTION( "generators count bytes per add_data and calls per message" )
+      {
+        hash_generator generator( hash::type::blake3 );
+        generator.add_data( data.data(), 600 );
+        generator.add_data( data.data(), 400 );
+        generator.retrieve_digest();
+
+        auto c = find_counter( metrics::get_snapshot(), metrics::entry_point::hash_generator,
+                               hash::type::blake3 );
+        CHECK( c.calls == 1 );
+        CHECK( c.bytes == 1000 );
+      }
+
+      SECTION( "streams collect the bytes of the nested calls" )
+      {
+        std::istringstream stream( std::string( data.begin(), data.end() ) );
+        get_hash( stream, hash::type::xxh3_64 );
+
+        auto c = find_counter( metrics::get_snapshot(), metrics::entry_point::get_hash_stream,
+                               hash::type::xxh3_64 );
+        CHECK( c.calls == 1 );
+        CHECK( c.bytes == 1000 );
+      }
+
+      SECTION( "the shards of all threads are summed up" )
+      {
+        std::vector< std::thread > threads;
+        for ( int i = 0; i < 4; ++i )
+        {
+          threads.emplace_back( [&data]() {
+            for ( int j = 0; j < 10; ++j )
+              get_hash( data.data(), data.size(), hash::type::crc32c );
+          } );
+        }
+        for ( auto& t : threads )
+          t.join();
+
+        auto c = find_counter( metrics::get_snapshot(), metrics::entry_point::get_hash, hash::type::crc32c );
+        CHECK( c.calls == 40 );
+        CHECK( c.bytes == 40000 );
+      }
+
+      SECTION( "pbkdf2 latencies are collected in histograms" )
+      {
+        pbkdf2( "password", "salt", hash::type::sha256 );
+        pbkdf2( "password", "salt", hash::type::sha256 );
+
+        auto snapshot = metrics::get_snapshot();
+        CHECK( find_counter( snapshot, metrics::entry_point::pbkdf2, hash::type::sha256 ).calls == 2 );
+
+        REQUIRE( snapshot.pbkdf2Latencies.size() == 1 );
+        const auto& h = snapshot.pbkdf2Latencies.front();
+        CHECK( h.hashType == hash::type::sha256 );
+        CHECK( h.count == 2 );
+        CHECK( h.sumNanoseconds > 0 );
+        REQUIRE( h.counts.size() == h.upperBounds.size() );
+        CHECK( std::is_sorted( h.upperBounds.begin(), h.upperBounds.end() ) );
+        CHECK( std::accumulate( h.counts.begin(), h.counts.end(), std::uint64_t( 0 ) ) == 2 );
+      }
+
+      SECTION( "reset clears the counters" )
+      {
+        get_hash( data.data(), data.size(), hash::type::md5 );
+        metrics::reset();
+        CHECK( metrics::get_snapshot().counters.empty() );
+      }
+    }
+
+  }  // namespace test
+}  // namespace crypto
+}  // namespace ll
@@ -0,0 +1,140 @@
+/*************************************************************************************************************
+
+ Limelight Framework - Crypto Utils
+
+
+ Copyright 2016 mvd
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in
+ compliance with the License. You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software distributed under the License is
+ distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and limitations under the License.
+
+*************************************************************************************************************/
+
+#include <catch.hpp>
+
+#include <map>
+
+#include <crypto/multi_hash.h>
+#include <crypto/exception.h>
+
+#include "../helpers/test_helpers.h"
+
+
+namespace ll
+{
+namespace crypto
+{
+  namespace test
+  {
+
+    TEST_CASE( "multi hash" )
+    {
+      std::vector< hash::type > hashTypes = {
+        hash::type::md5,
+        hash::type::sha1,
+        hash::type::sha256
+      };
+
+      std::vector< std::string > expectedHashes = {
+        "858760a184d74dec43cb6a5eee5bb551",
+        "8e76eebc245103a1da51a9a32b5a9fb99d206b33",
+        "f7de7129fed4c37eb0c74e56d760e9ca69831f84ab0b6f919310ba86b6ab6045"
+      };
+
+      auto p = get_executable_path();
+      p /= "/data/test.jpg";
+
+
+      SECTION( "yields expected results for streams" )
+      {
+        for ( auto useWorkerThreads : { false, true } )
+        {
+          for ( size_t numReadAheadBuffers : { 0, 3 } )
+          {
+            boost::filesystem::ifstream input( p, std::ios::in | std::ios::binary );
+            REQUIRE( input.is_open() );
+
+            hash::config cfg;
+            cfg.useWorkerThreads = useWorkerThreads;
+            cfg.numReadAheadBuffers = numReadAheadBuffers;
+
+            auto results = get_multi_hash( input, hashTypes, cfg );
+            REQUIRE( hashTypes.size() == results.size() );
+
+            for ( size_t i = 0; i < hashTypes.size(); ++i )
+            {
+              CHECK( hashTypes[i] == results[i].hashType );
+              CHECK( expectedHashes[i] == results[i].string );
+              CHECK( 3184393 == results[i].inputSize );
+            }
+          }
+        }
+      }
+
+
+      SECTION( "yields the same results as single hashes for buffers" )
+      {
+        std::string input = "this is a test string";
+
+        for ( auto useWorkerThreads : { false, true } )
+        {
+          hash::config cfg;
+          cfg.useWorkerThreads = useWorkerThreads;
+          cfg.processingBlockSize = 5;
+
+          auto results = get_multi_hash( input.data(), input.size(), hashTypes, cfg );
+          REQUIRE( hashTypes.size() == results.size() );
+
+          for ( size_t i = 0; i < hashTypes.size(); ++i )
+            CHECK( get_hash( input, hashTypes[i] ).string == results[i].string );
+        }
+      }
+
+
+      SECTION( "multi_hash_generator is moveable" )
+      {
+        hash::config cfg;
+        cfg.useWorkerThreads = true;
+
+        multi_hash_generator g( hashTypes, cfg );
+        multi_hash_generator h( std::move( g ) );
+
+        std::string input = "this is a test string";
+        h.add_data( reinterpret_cast< const uint8_t* >( input.data() ), input.size() );
+        CHECK( "486eb65274adb86441072afa1e2289f3" == h.retrieve_hashes()[0].string );
+      }
+
+
+      SECTION( "invalid parameters yield exception" )
+      {
+        CHECK_THROWS_AS( multi_hash_generator( std::vector< hash::type >() ), exception );
+        CHECK_THROWS_AS( multi_hash_generator( { hash::type::md5, hash::type::unknown } ), exception );
+        CHECK_THROWS_AS( get_multi_hash( nullptr, 42, hashTypes ), exception );
+      }
+
+
+      SECTION( "calling add_data after retrieve_hashes yields exception" )
+      {
+        for ( auto useWorkerThreads : { false, true } )
+        {
+          hash::config cfg;
+          cfg.useWorkerThreads = useWorkerThreads;
+
+          multi_hash_generator g( hashTypes, cfg );
+          g.retrieve_hashes();
+
+          std::uint8_t data[] = { 1, 2, 3 };
+          CHECK_THROWS_AS( g.add_data( data, sizeof( data ) ), exception );
+        }
+      }
+    }
+
+  }  // namespace test
+}  // namespace crypto
+}  // namespace ll
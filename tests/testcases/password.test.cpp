@@ -19,7 +19,10 @@
 #include <catch.hpp>
 
 #include <map>
+#include <thread>
+#include <vector>
 
+#include <crypto/backend.h>
 #include <crypto/password.h>
 #include <crypto/exception.h>
 
@@ -101,6 +104,46 @@ namespace crypto
           CHECK_THROWS_AS( pbkdf2( input, salt, hash::type::sha256, cfg ), crypto::exception );
         }
       }
+
+
+      // -------------------------------------------------------------------------------------------------------
+
+      SECTION( "yields the same key on repeated calls from several threads" )
+      {
+        std::string input = "TestPasswordWith#Numbers123";
+        std::string expected = "56bf951b15e0b6886813170029e00934";
+
+        std::vector< std::string > results( 4 * 8 );
+        std::vector< std::thread > threads;
+        for ( size_t t = 0; t < 4; ++t )
+        {
+          threads.emplace_back( [&results, &input, t]() {
+            for ( size_t i = 0; i < 8; ++i )
+              results[t * 8 + i] = pbkdf2( input, "TheSalT", hash::type::sha256 ).string;
+          } );
+        }
+        for ( auto& thread : threads )
+          thread.join();
+
+        for ( const auto& result : results )
+          CHECK( expected == result );
+
+        // a different password on the same context
+        CHECK( expected != pbkdf2( input + "!", "TheSalT", hash::type::sha256 ).string );
+        CHECK( expected == pbkdf2( input, "TheSalT", hash::type::sha256 ).string );
+      }
+    }
+
+
+    // ---------------------------------------------------------------------------------------------------------
+
+    TEST_CASE( "backend can't be configured after the first use" )
+    {
+      pbkdf2( "password", "salt", hash::type::sha256 );
+
+      backend_config cfg;
+      cfg.providers = { "default" };
+      CHECK_THROWS_AS( init_backend( cfg ), crypto::exception );
     }
 
   }  // namespace test